@@ -0,0 +1,161 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+
+#include "../test/test.h"
+#include "atom.h"
+#include "bench.h"
+
+#define BENCHMARK_ITERATIONS 100
+
+struct token {
+    const char *start;
+    size_t len;
+};
+
+typedef darray(struct token) darray_token;
+typedef darray(char *) darray_string;
+
+/*
+ * Split the file into the kinds of tokens which end up interned by
+ * xkbcomp: identifiers, <key names> and "strings". This is not a real
+ * lexer, but it's close enough for the purpose.
+ */
+static void
+tokenize(const char *s, darray_token *tokens)
+{
+    while (*s) {
+        const char *start = s;
+
+        if (is_alpha(*s) || *s == '_') {
+            while (is_alnum(*s) || *s == '_')
+                s++;
+        }
+        else if (*s == '<' || *s == '"') {
+            const char end = (*s == '<' ? '>' : '"');
+            start = ++s;
+            while (*s && *s != end && *s != '\n')
+                s++;
+            if (*s != end)
+                continue;
+        }
+        else {
+            s++;
+            continue;
+        }
+
+        darray_append(*tokens, ((struct token) { start, s - start }));
+        if (*s == '>' || *s == '"')
+            s++;
+    }
+}
+
+static void
+read_dir(const char *dir_rel, darray_string *files, darray_token *tokens)
+{
+    char *dir_path = test_get_path(dir_rel);
+    DIR *dir = opendir(dir_path);
+    struct dirent *entry;
+
+    assert(dir);
+
+    while ((entry = readdir(dir))) {
+        char *path_rel, *path, *content;
+        struct stat st;
+        int ret;
+
+        if (entry->d_name[0] == '.')
+            continue;
+
+        ret = asprintf(&path_rel, "%s/%s", dir_rel, entry->d_name);
+        assert(ret >= 0);
+        path = test_get_path(path_rel);
+        ret = stat(path, &st);
+        free(path);
+
+        if (ret == 0 && S_ISDIR(st.st_mode)) {
+            read_dir(path_rel, files, tokens);
+        }
+        else if (ret == 0 && S_ISREG(st.st_mode)) {
+            content = test_read_file(path_rel);
+            if (content) {
+                darray_append(*files, content);
+                tokenize(content, tokens);
+            }
+        }
+
+        free(path_rel);
+    }
+
+    closedir(dir);
+    free(dir_path);
+}
+
+int
+main(void)
+{
+    static const char *dirs[] = {
+        "keycodes", "types", "compat", "symbols",
+    };
+    darray_string files = darray_new();
+    darray_token tokens = darray_new();
+    struct token *token;
+    char **file;
+    struct bench bench;
+    char *elapsed;
+    size_t num_atoms = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(dirs); i++)
+        read_dir(dirs[i], &files, &tokens);
+
+    bench_start(&bench);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        struct atom_table *table = atom_table_new();
+        assert(table);
+
+        num_atoms = 0;
+        darray_foreach(token, tokens) {
+            xkb_atom_t atom = atom_intern(table, token->start, token->len,
+                                          true);
+            assert(atom != XKB_ATOM_NONE);
+            if (atom > num_atoms)
+                num_atoms = atom;
+        }
+
+        atom_table_free(table);
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "interned %u tokens (%zu distinct) %d times in %ss\n",
+            darray_size(tokens), num_atoms, BENCHMARK_ITERATIONS, elapsed);
+    free(elapsed);
+
+    darray_foreach(file, files)
+        free(*file);
+    darray_free(files);
+    darray_free(tokens);
+    return 0;
+}
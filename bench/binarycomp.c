@@ -0,0 +1,69 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include "../test/test.h"
+#include "bench.h"
+
+#define BENCHMARK_ITERATIONS 2500
+
+int
+main(int argc, char *argv[])
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    struct bench bench;
+    char *elapsed, *blob;
+    size_t size;
+
+    ctx = test_get_context(0);
+    assert(ctx);
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    keymap = test_compile_rules(ctx, "evdev", "evdev", "us", "", "");
+    assert(keymap);
+    blob = xkb_keymap_get_as_buffer(keymap, XKB_KEYMAP_FORMAT_BINARY_V1,
+                                    &size);
+    assert(blob);
+    xkb_keymap_unref(keymap);
+
+    bench_start(&bench);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        keymap = xkb_keymap_new_from_buffer(ctx, blob, size,
+                                            XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "loaded %d binary keymaps (%zu bytes) in %ss\n",
+            BENCHMARK_ITERATIONS, size, elapsed);
+    free(elapsed);
+
+    free(blob);
+    xkb_context_unref(ctx);
+    return 0;
+}
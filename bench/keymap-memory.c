@@ -0,0 +1,116 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "../test/test.h"
+#include "keymap.h"
+#include "bench.h"
+
+/*
+ * Keep many distinct keymaps alive at once, as a server with many seats
+ * does, and report how much memory their keys take, with and without the
+ * levels shared between groups (see XkbKeymapPackKeys()).
+ */
+static const char *layouts[] = {
+    "us", "de", "ru", "il", "ca", "ch", "cz", "in",
+    "us,de", "us,ru", "us,il", "de,cz", "us,il,ru,de",
+};
+
+static const char *options[] = {
+    "", "grp:alt_shift_toggle", "ctrl:nocaps,compose:ralt",
+    "grp:menu_toggle,lv3:ralt_switch,caps:escape,eurosign:e",
+};
+
+#define NUM_KEYMAPS (ARRAY_SIZE(layouts) * ARRAY_SIZE(options))
+
+/* The size of the groups, levels and keysyms of the keys, if not shared. */
+static size_t
+unshared_size(struct xkb_keymap *keymap)
+{
+    const struct xkb_key *key;
+    size_t size = 0;
+
+    xkb_keys_foreach(key, keymap) {
+        size += key->num_groups * sizeof(*key->groups);
+        for (xkb_layout_index_t i = 0; i < key->num_groups; i++) {
+            for (xkb_level_index_t j = 0; j < XkbKeyNumLevels(key, i); j++) {
+                const struct xkb_level *level = &key->groups[i].levels[j];
+
+                size += sizeof(*level);
+                if (level->num_syms > 1)
+                    size += level->num_syms * sizeof(*level->u.syms);
+            }
+        }
+    }
+
+    return size;
+}
+
+static size_t
+shared_size(struct xkb_keymap *keymap)
+{
+    return keymap->num_key_groups * sizeof(*keymap->key_groups) +
+           keymap->num_key_levels * sizeof(*keymap->key_levels) +
+           keymap->num_key_syms * sizeof(*keymap->key_syms);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymaps[NUM_KEYMAPS];
+    struct bench bench;
+    char *elapsed;
+    size_t unshared = 0, shared = 0, n = 0;
+
+    ctx = test_get_context(CONTEXT_CACHE_INCLUDES);
+    assert(ctx);
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    bench_start(&bench);
+    for (size_t i = 0; i < ARRAY_SIZE(layouts); i++) {
+        for (size_t j = 0; j < ARRAY_SIZE(options); j++) {
+            keymaps[n] = test_compile_rules(ctx, "evdev", "pc105", layouts[i],
+                                            "", options[j]);
+            assert(keymaps[n]);
+            n++;
+        }
+    }
+    bench_stop(&bench);
+
+    for (size_t i = 0; i < n; i++) {
+        unshared += unshared_size(keymaps[i]);
+        shared += shared_size(keymaps[i]);
+        xkb_keymap_unref(keymaps[i]);
+    }
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "compiled %zu keymaps in %ss\n", n, elapsed);
+    free(elapsed);
+    fprintf(stderr, "keys take %zu bytes, %zu bytes without shared levels\n",
+            shared, unshared);
+
+    xkb_context_unref(ctx);
+    return 0;
+}
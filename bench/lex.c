@@ -0,0 +1,134 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+
+#include "../test/test.h"
+#include "xkbcomp/xkbcomp-priv.h"
+#include "bench.h"
+
+#define BENCHMARK_ITERATIONS 200
+
+struct file {
+    char *name;
+    char *content;
+};
+
+typedef darray(struct file) darray_file;
+
+static void
+read_dir(const char *dir_rel, darray_file *files)
+{
+    char *dir_path = test_get_path(dir_rel);
+    DIR *dir = opendir(dir_path);
+    struct dirent *entry;
+
+    assert(dir);
+
+    while ((entry = readdir(dir))) {
+        char *path_rel, *path, *content;
+        struct stat st;
+        int ret;
+
+        if (entry->d_name[0] == '.')
+            continue;
+
+        ret = asprintf(&path_rel, "%s/%s", dir_rel, entry->d_name);
+        assert(ret >= 0);
+        path = test_get_path(path_rel);
+        ret = stat(path, &st);
+        free(path);
+
+        if (ret == 0 && S_ISDIR(st.st_mode)) {
+            read_dir(path_rel, files);
+        }
+        else if (ret == 0 && S_ISREG(st.st_mode)) {
+            content = test_read_file(path_rel);
+            if (content) {
+                darray_append(*files, ((struct file) { path_rel, content }));
+                continue;
+            }
+        }
+
+        free(path_rel);
+    }
+
+    closedir(dir);
+    free(dir_path);
+}
+
+/*
+ * Run only the lexer over every file of the data directory, to measure
+ * it without the parser and the AST.
+ */
+int
+main(void)
+{
+    static const char *dirs[] = {
+        "keycodes", "types", "compat", "symbols", "keymaps",
+    };
+    darray_file files = darray_new();
+    struct file *file;
+    struct xkb_context *ctx;
+    struct bench bench;
+    char *elapsed;
+    unsigned long num_tokens = 0;
+    size_t size = 0;
+
+    ctx = test_get_context(0);
+    assert(ctx);
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(dirs); i++)
+        read_dir(dirs[i], &files);
+
+    bench_start(&bench);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        darray_foreach(file, files) {
+            size_t len = strlen(file->content);
+            int ret = XkbLexString(ctx, file->content, len, file->name);
+
+            if (i == 0 && ret >= 0) {
+                num_tokens += ret;
+                size += len;
+            }
+        }
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "lexed %u files (%lu tokens, %zu bytes) %d times in %ss\n",
+            darray_size(files), num_tokens, size, BENCHMARK_ITERATIONS,
+            elapsed);
+    free(elapsed);
+
+    darray_foreach(file, files) {
+        free(file->name);
+        free(file->content);
+    }
+    darray_free(files);
+    xkb_context_unref(ctx);
+    return 0;
+}
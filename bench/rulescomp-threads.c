@@ -0,0 +1,104 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+
+#include "../test/test.h"
+#include "bench.h"
+
+#define BENCHMARK_ITERATIONS 1000
+#define NUM_THREADS 4
+
+static const char *layouts[] = {
+    "us", "de", "us,il", "ru,ca",
+};
+
+struct worker {
+    pthread_t thread;
+    struct xkb_context *ctx;
+    int iterations;
+};
+
+static void *
+worker_run(void *data)
+{
+    struct worker *worker = data;
+
+    for (int i = 0; i < worker->iterations; i++) {
+        struct xkb_keymap *keymap;
+
+        keymap = test_compile_rules(worker->ctx, "evdev", "evdev",
+                                    layouts[i % ARRAY_SIZE(layouts)], "", "");
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+    }
+
+    return NULL;
+}
+
+/* Compile BENCHMARK_ITERATIONS keymaps from one context in @num_threads. */
+static void
+run(struct xkb_context *ctx, int num_threads)
+{
+    struct worker workers[NUM_THREADS];
+    struct bench bench;
+    char *elapsed;
+    int ret;
+
+    bench_start(&bench);
+    for (int i = 0; i < num_threads; i++) {
+        workers[i].ctx = ctx;
+        workers[i].iterations = BENCHMARK_ITERATIONS / num_threads;
+        ret = pthread_create(&workers[i].thread, NULL, worker_run,
+                             &workers[i]);
+        assert(ret == 0);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        ret = pthread_join(workers[i].thread, NULL);
+        assert(ret == 0);
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "compiled %d keymaps in %d thread(s) in %ss\n",
+            BENCHMARK_ITERATIONS, num_threads, elapsed);
+    free(elapsed);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct xkb_context *ctx;
+
+    ctx = test_get_context(0);
+    assert(ctx);
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    run(ctx, 1);
+    run(ctx, NUM_THREADS);
+
+    xkb_context_unref(ctx);
+    return 0;
+}
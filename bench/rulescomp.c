@@ -29,9 +29,11 @@
 #include "bench.h"
 
 #define BENCHMARK_ITERATIONS 2500
+#define BENCHMARK_COLD_ITERATIONS 100
+#define BENCHMARK_MULTI_LAYOUT_ITERATIONS 1000
 
-int
-main(int argc, char *argv[])
+static void
+benchmark(enum test_context_flags flags, const char *what)
 {
     struct xkb_context *ctx;
     struct xkb_keymap *keymap;
@@ -39,7 +41,7 @@ main(int argc, char *argv[])
     char *elapsed;
     int i;
 
-    ctx = test_get_context(0);
+    ctx = test_get_context(flags);
     assert(ctx);
 
     xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
@@ -54,10 +56,94 @@ main(int argc, char *argv[])
     bench_stop(&bench);
 
     elapsed = bench_elapsed_str(&bench);
-    fprintf(stderr, "compiled %d keymaps in %ss\n",
-            BENCHMARK_ITERATIONS, elapsed);
+    fprintf(stderr, "compiled %d keymaps %s in %ss\n",
+            BENCHMARK_ITERATIONS, what, elapsed);
     free(elapsed);
 
     xkb_context_unref(ctx);
+}
+
+/*
+ * Compile a multi-layout keymap with the includes cached, so that the time
+ * goes into building the keymap: every level of every group gets its
+ * interpretation looked up, among others.
+ */
+static void
+benchmark_multi_layout(void)
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    struct bench bench;
+    char *elapsed;
+    int i;
+
+    ctx = test_get_context(CONTEXT_CACHE_INCLUDES);
+    assert(ctx);
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    bench_start(&bench);
+    for (i = 0; i < BENCHMARK_MULTI_LAYOUT_ITERATIONS; i++) {
+        keymap = test_compile_rules(ctx, "evdev", "pc105", "us,il,ru,de",
+                                    ",,phonetic,neo",
+                                    "grp:alt_shift_toggle,grp:menu_toggle");
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "compiled %d multi-layout keymaps with include cache "
+            "in %ss\n",
+            BENCHMARK_MULTI_LAYOUT_ITERATIONS, elapsed);
+    free(elapsed);
+
+    xkb_context_unref(ctx);
+}
+
+/*
+ * Compile a multi-layout keymap from fresh contexts, so that every include
+ * file is read and parsed again, as on a cold start.
+ */
+static void
+benchmark_cold(enum test_context_flags flags, const char *what)
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    struct bench bench;
+    char *elapsed;
+    int i;
+
+    bench_start(&bench);
+    for (i = 0; i < BENCHMARK_COLD_ITERATIONS; i++) {
+        ctx = test_get_context(flags);
+        assert(ctx);
+        xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+        xkb_context_set_log_verbosity(ctx, 0);
+
+        keymap = test_compile_rules(ctx, "evdev", "pc105", "us,il,ru,de",
+                                    ",,phonetic,neo",
+                                    "grp:alt_shift_toggle,grp:menu_toggle");
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+        xkb_context_unref(ctx);
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "compiled %d keymaps from fresh contexts %s in %ss\n",
+            BENCHMARK_COLD_ITERATIONS, what, elapsed);
+    free(elapsed);
+}
+
+int
+main(int argc, char *argv[])
+{
+    benchmark(CONTEXT_NO_FLAG, "without include cache");
+    benchmark(CONTEXT_CACHE_INCLUDES, "with include cache");
+    benchmark_multi_layout();
+    benchmark_cold(CONTEXT_NO_FLAG, "without parallel includes");
+    benchmark_cold(CONTEXT_PARALLEL_INCLUDES, "with parallel includes");
     return 0;
 }
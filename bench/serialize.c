@@ -0,0 +1,164 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "../test/test.h"
+#include "bench.h"
+
+#define BENCHMARK_ITERATIONS 200
+#define PARSE_ITERATIONS 20
+
+/*
+ * Serialize a set of compiled keymaps over and over, as a compositor does
+ * for every client on every layout change, then parse them back as the
+ * clients do; in the usual and in the compact form, and with and
+ * without the compiler.
+ */
+static const char *layouts[] = {
+    "us", "de", "ru", "il", "ca", "us,de", "us,il,ru,de",
+};
+
+static const char *options =
+    "grp:alt_shift_toggle,ctrl:nocaps,compose:ralt,lv3:ralt_switch";
+
+static void
+bench_serialize(struct xkb_keymap **keymaps, size_t num_keymaps,
+                enum xkb_keymap_serialize_flags flags, const char *form)
+{
+    struct bench bench;
+    char *elapsed;
+    size_t bytes = 0;
+
+    bench_start(&bench);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        for (size_t j = 0; j < num_keymaps; j++) {
+            char *str = xkb_keymap_get_as_string2(keymaps[j],
+                                                  XKB_KEYMAP_FORMAT_TEXT_V1,
+                                                  flags);
+            assert(str);
+            bytes += strlen(str);
+            free(str);
+        }
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "serialized %zu %s keymaps (%zu bytes) in %ss\n",
+            BENCHMARK_ITERATIONS * num_keymaps, form, bytes, elapsed);
+    free(elapsed);
+}
+
+/*
+ * With @compile, a flag is put in front of the keymaps, which keeps them
+ * from the loader of the canonical form, so they go through the compiler.
+ */
+static void
+bench_parse(struct xkb_context *ctx, struct xkb_keymap **keymaps,
+            size_t num_keymaps, enum xkb_keymap_serialize_flags flags,
+            bool compile, const char *form)
+{
+    char *strs[ARRAY_SIZE(layouts)];
+    struct bench bench;
+    char *elapsed;
+
+    for (size_t i = 0; i < num_keymaps; i++) {
+        char *str = xkb_keymap_get_as_string2(keymaps[i],
+                                              XKB_KEYMAP_FORMAT_TEXT_V1,
+                                              flags);
+        assert(str);
+        if (compile) {
+            int ret = asprintf(&strs[i], "default %s", str);
+            assert(ret >= 0);
+            free(str);
+        }
+        else {
+            strs[i] = str;
+        }
+    }
+
+    bench_start(&bench);
+    for (int i = 0; i < PARSE_ITERATIONS; i++) {
+        for (size_t j = 0; j < num_keymaps; j++) {
+            struct xkb_keymap *keymap;
+
+            keymap = xkb_keymap_new_from_string(ctx, strs[j],
+                                                XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+            assert(keymap);
+            xkb_keymap_unref(keymap);
+        }
+    }
+    bench_stop(&bench);
+
+    elapsed = bench_elapsed_str(&bench);
+    fprintf(stderr, "%s %zu %s keymaps in %ss\n",
+            compile ? "compiled" : "loaded",
+            PARSE_ITERATIONS * num_keymaps, form, elapsed);
+    free(elapsed);
+
+    for (size_t i = 0; i < num_keymaps; i++)
+        free(strs[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct xkb_context *ctx, *ctx_cached;
+    struct xkb_keymap *keymaps[ARRAY_SIZE(layouts)];
+
+    ctx = test_get_context(CONTEXT_CACHE_INCLUDES);
+    assert(ctx);
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(layouts); i++) {
+        keymaps[i] = test_compile_rules(ctx, "evdev", "pc105", layouts[i],
+                                        "", options);
+        assert(keymaps[i]);
+    }
+
+    bench_serialize(keymaps, ARRAY_SIZE(keymaps),
+                    XKB_KEYMAP_SERIALIZE_NO_FLAGS, "full");
+    bench_serialize(keymaps, ARRAY_SIZE(keymaps),
+                    XKB_KEYMAP_SERIALIZE_COMPACT, "compact");
+    bench_parse(ctx, keymaps, ARRAY_SIZE(keymaps),
+                XKB_KEYMAP_SERIALIZE_NO_FLAGS, true, "full");
+    bench_parse(ctx, keymaps, ARRAY_SIZE(keymaps),
+                XKB_KEYMAP_SERIALIZE_COMPACT, true, "compact");
+    bench_parse(ctx, keymaps, ARRAY_SIZE(keymaps),
+                XKB_KEYMAP_SERIALIZE_NO_FLAGS, false, "full");
+    bench_parse(ctx, keymaps, ARRAY_SIZE(keymaps),
+                XKB_KEYMAP_SERIALIZE_COMPACT, false, "compact");
+
+    /* What clients getting the same keymaps again can have. */
+    ctx_cached = test_get_context(CONTEXT_CACHE_KEYMAPS);
+    assert(ctx_cached);
+    xkb_context_set_log_level(ctx_cached, XKB_LOG_LEVEL_CRITICAL);
+    bench_parse(ctx_cached, keymaps, ARRAY_SIZE(keymaps),
+                XKB_KEYMAP_SERIALIZE_NO_FLAGS, false, "cached full");
+    xkb_context_unref(ctx_cached);
+
+    for (size_t i = 0; i < ARRAY_SIZE(keymaps); i++)
+        xkb_keymap_unref(keymaps[i]);
+    xkb_context_unref(ctx);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "../test/test.h"
+#include "bench.h"
+
+#define BENCHMARK_ITERATIONS 200
+
+/*
+ * Compile keymaps with more and more layouts stacked on top of each other,
+ * each of them merging its keys with those of the layouts before it. The
+ * include cache is on, so that this is mostly about compiling the files,
+ * not reading and parsing them.
+ */
+static const char *layouts[] = {
+    "us", "us,de", "us,de,ru", "us,de,ru,il",
+};
+
+static const char *options =
+    "grp:alt_shift_toggle,ctrl:nocaps,compose:ralt,lv3:ralt_switch,"
+    "caps:escape,altwin:swap_alt_win,terminate:ctrl_alt_bksp,eurosign:e";
+
+int
+main(int argc, char *argv[])
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    struct bench bench;
+    char *elapsed;
+
+    ctx = test_get_context(CONTEXT_CACHE_INCLUDES);
+    assert(ctx);
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(layouts); i++) {
+        bench_start(&bench);
+        for (int j = 0; j < BENCHMARK_ITERATIONS; j++) {
+            keymap = test_compile_rules(ctx, "evdev", "pc105", layouts[i],
+                                        "", options);
+            assert(keymap);
+            xkb_keymap_unref(keymap);
+        }
+        bench_stop(&bench);
+
+        elapsed = bench_elapsed_str(&bench);
+        fprintf(stderr, "compiled %d keymaps with %zu layout(s) in %ss\n",
+                BENCHMARK_ITERATIONS, i + 1, elapsed);
+        free(elapsed);
+    }
+
+    xkb_context_unref(ctx);
+    return 0;
+}
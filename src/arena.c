@@ -0,0 +1,201 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+union arena_align {
+    void *ptr;
+    long long ll;
+    long double ld;
+    void (*fn)(void);
+};
+
+#define ARENA_ALIGNMENT \
+    offsetof(struct { char c; union arena_align u; }, u)
+#define ARENA_ALIGN(size) \
+    (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+#define ARENA_MIN_CHUNK_SIZE 1024
+#define ARENA_MAX_CHUNK_SIZE (64 * 1024)
+
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;
+    size_t used;
+    union arena_align data[];
+};
+
+static struct arena_chunk *
+chunk_new(struct arena *arena, size_t size)
+{
+    struct arena_chunk *chunk;
+
+    chunk = malloc(offsetof(struct arena_chunk, data) + size);
+    if (!chunk)
+        return NULL;
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    if (arena) {
+        arena->num_chunks++;
+        arena->size += size;
+    }
+
+    return chunk;
+}
+
+/*
+ * The arena itself is the first allocation of its first chunk, so that a
+ * small arena costs a single malloc().
+ */
+struct arena *
+arena_new(void)
+{
+    struct arena_chunk *chunk;
+    struct arena *arena;
+
+    chunk = chunk_new(NULL, ARENA_MIN_CHUNK_SIZE);
+    if (!chunk)
+        return NULL;
+
+    arena = (struct arena *) chunk->data;
+    chunk->used = ARENA_ALIGN(sizeof(*arena));
+    arena->chunks = chunk;
+    arena->last = 0;
+    arena->num_allocs = 0;
+    arena->num_chunks = 1;
+    arena->size = ARENA_MIN_CHUNK_SIZE;
+
+    return arena;
+}
+
+void
+arena_free(struct arena *arena)
+{
+    struct arena_chunk *chunk, *next;
+
+    if (!arena)
+        return;
+
+    /* The arena goes away with the last chunk. */
+    for (chunk = arena->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+}
+
+void *
+arena_alloc(struct arena *arena, size_t size)
+{
+    struct arena_chunk *chunk = arena->chunks;
+    size_t chunk_size;
+
+    if (size > SIZE_MAX / 2)
+        return NULL;
+    size = (size ? ARENA_ALIGN(size) : ARENA_ALIGNMENT);
+
+    if (size > chunk->size - chunk->used) {
+        chunk_size = chunk->size * 2;
+        if (chunk_size > ARENA_MAX_CHUNK_SIZE)
+            chunk_size = ARENA_MAX_CHUNK_SIZE;
+
+        /*
+         * A large allocation gets a chunk of its own, which goes after
+         * the current one, so that the latter keeps being used.
+         */
+        if (size > chunk_size / 4) {
+            struct arena_chunk *large = chunk_new(arena, size);
+            if (!large)
+                return NULL;
+            large->used = size;
+            large->next = chunk->next;
+            chunk->next = large;
+            arena->num_allocs++;
+            return large->data;
+        }
+
+        chunk = chunk_new(arena, chunk_size);
+        if (!chunk)
+            return NULL;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    arena->last = chunk->used;
+    chunk->used += size;
+    arena->num_allocs++;
+    return (char *) chunk->data + arena->last;
+}
+
+void *
+arena_zalloc(struct arena *arena, size_t size)
+{
+    void *ptr = arena_alloc(arena, size);
+    if (ptr)
+        memset(ptr, 0, size);
+    return ptr;
+}
+
+/*
+ * If @ptr is the last allocation, it is grown in place when there is room
+ * for it; otherwise it is copied to a new allocation, and the old one is
+ * wasted until the arena is freed.
+ */
+void *
+arena_realloc(struct arena *arena, void *ptr, size_t old_size,
+              size_t new_size)
+{
+    struct arena_chunk *chunk = arena->chunks;
+    void *new_ptr;
+
+    if (!ptr)
+        return arena_alloc(arena, new_size);
+
+    if (ptr == (char *) chunk->data + arena->last && new_size <= SIZE_MAX / 2 &&
+        ARENA_ALIGN(new_size) <= chunk->size - arena->last) {
+        if (new_size > 0)
+            chunk->used = arena->last + ARENA_ALIGN(new_size);
+        return ptr;
+    }
+
+    new_ptr = arena_alloc(arena, new_size);
+    if (new_ptr)
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    return new_ptr;
+}
+
+char *
+arena_strdup(struct arena *arena, const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *copy = arena_alloc(arena, len);
+    if (copy)
+        memcpy(copy, s, len);
+    return copy;
+}
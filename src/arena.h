@@ -0,0 +1,65 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * A bump allocator: allocations are carved out of a few large chunks, and
+ * are all released at once by arena_free(). There is no way to free a
+ * single allocation.
+ */
+
+struct arena_chunk;
+
+struct arena {
+    struct arena_chunk *chunks;
+    /* The offset of the last allocation in the first chunk, for
+     * arena_realloc(). */
+    size_t last;
+    /* Statistics. */
+    unsigned int num_allocs;
+    unsigned int num_chunks;
+    size_t size;
+};
+
+struct arena *
+arena_new(void);
+
+void
+arena_free(struct arena *arena);
+
+void *
+arena_alloc(struct arena *arena, size_t size);
+
+void *
+arena_zalloc(struct arena *arena, size_t size);
+
+void *
+arena_realloc(struct arena *arena, void *ptr, size_t old_size,
+              size_t new_size);
+
+char *
+arena_strdup(struct arena *arena, const char *s);
+
+#endif /* ARENA_H */
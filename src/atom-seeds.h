@@ -0,0 +1,2063 @@
+
+/**
+ * This file comes from libxkbcommon and was generated by makeatoms
+ * from src/atom-seeds.txt; run scripts/update-atoms to regenerate it.
+ */
+
+#define NUM_SEED_ATOMS 507
+#define SEED_ATOM_INDEX_SIZE 1024
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverlength-strings"
+#endif
+static const char seed_atom_strings[] =
+    "Shift\0"
+    "Lock\0"
+    "Control\0"
+    "Mod1\0"
+    "Mod2\0"
+    "Mod3\0"
+    "Mod4\0"
+    "Mod5\0"
+    "minimum\0"
+    "maximum\0"
+    "LSGT\0"
+    "TLDE\0"
+    "AE01\0"
+    "AE02\0"
+    "AE03\0"
+    "AE04\0"
+    "AE05\0"
+    "AE06\0"
+    "AE07\0"
+    "AE08\0"
+    "AE09\0"
+    "AE10\0"
+    "AE11\0"
+    "AE12\0"
+    "BKSP\0"
+    "TAB\0"
+    "AD01\0"
+    "AD02\0"
+    "AD03\0"
+    "AD04\0"
+    "AD05\0"
+    "AD06\0"
+    "AD07\0"
+    "AD08\0"
+    "AD09\0"
+    "AD10\0"
+    "AD11\0"
+    "AD12\0"
+    "BKSL\0"
+    "AC12\0"
+    "RTRN\0"
+    "CAPS\0"
+    "AC01\0"
+    "AC02\0"
+    "AC03\0"
+    "AC04\0"
+    "AC05\0"
+    "AC06\0"
+    "AC07\0"
+    "AC08\0"
+    "AC09\0"
+    "AC10\0"
+    "AC11\0"
+    "LFSH\0"
+    "AB01\0"
+    "AB02\0"
+    "AB03\0"
+    "AB04\0"
+    "AB05\0"
+    "AB06\0"
+    "AB07\0"
+    "AB08\0"
+    "AB09\0"
+    "AB10\0"
+    "RTSH\0"
+    "LALT\0"
+    "LCTL\0"
+    "SPCE\0"
+    "RCTL\0"
+    "RALT\0"
+    "LWIN\0"
+    "RWIN\0"
+    "COMP\0"
+    "MENU\0"
+    "ESC\0"
+    "FK01\0"
+    "FK02\0"
+    "FK03\0"
+    "FK04\0"
+    "FK05\0"
+    "FK06\0"
+    "FK07\0"
+    "FK08\0"
+    "FK09\0"
+    "FK10\0"
+    "FK11\0"
+    "FK12\0"
+    "PRSC\0"
+    "SCLK\0"
+    "PAUS\0"
+    "INS\0"
+    "HOME\0"
+    "PGUP\0"
+    "DELE\0"
+    "END\0"
+    "PGDN\0"
+    "UP\0"
+    "LEFT\0"
+    "DOWN\0"
+    "RGHT\0"
+    "NMLK\0"
+    "KPDV\0"
+    "KPMU\0"
+    "KPSU\0"
+    "KP7\0"
+    "KP8\0"
+    "KP9\0"
+    "KPAD\0"
+    "KP4\0"
+    "KP5\0"
+    "KP6\0"
+    "KP1\0"
+    "KP2\0"
+    "KP3\0"
+    "KPEN\0"
+    "KP0\0"
+    "KPDL\0"
+    "KPEQ\0"
+    "FK13\0"
+    "FK14\0"
+    "FK15\0"
+    "FK16\0"
+    "FK17\0"
+    "FK18\0"
+    "FK19\0"
+    "FK20\0"
+    "FK21\0"
+    "FK22\0"
+    "FK23\0"
+    "FK24\0"
+    "HZTG\0"
+    "HKTG\0"
+    "AB11\0"
+    "HENK\0"
+    "MUHE\0"
+    "AE13\0"
+    "KATA\0"
+    "HIRA\0"
+    "JPCM\0"
+    "HNGL\0"
+    "HJCV\0"
+    "LMTA\0"
+    "RMTA\0"
+    "MUTE\0"
+    "VOL-\0"
+    "VOL+\0"
+    "POWR\0"
+    "STOP\0"
+    "AGAI\0"
+    "PROP\0"
+    "UNDO\0"
+    "FRNT\0"
+    "COPY\0"
+    "OPEN\0"
+    "PAST\0"
+    "FIND\0"
+    "CUT\0"
+    "HELP\0"
+    "LNFD\0"
+    "I120\0"
+    "I126\0"
+    "I128\0"
+    "I129\0"
+    "I147\0"
+    "I148\0"
+    "I149\0"
+    "I150\0"
+    "I151\0"
+    "I152\0"
+    "I153\0"
+    "I154\0"
+    "I155\0"
+    "I156\0"
+    "I157\0"
+    "I158\0"
+    "I159\0"
+    "I160\0"
+    "I161\0"
+    "I162\0"
+    "I163\0"
+    "I164\0"
+    "I165\0"
+    "I166\0"
+    "I167\0"
+    "I168\0"
+    "I169\0"
+    "I170\0"
+    "I171\0"
+    "I172\0"
+    "I173\0"
+    "I174\0"
+    "I175\0"
+    "I176\0"
+    "I177\0"
+    "I178\0"
+    "I179\0"
+    "I180\0"
+    "I181\0"
+    "I182\0"
+    "I183\0"
+    "I184\0"
+    "I185\0"
+    "I186\0"
+    "I187\0"
+    "I188\0"
+    "I189\0"
+    "I190\0"
+    "I208\0"
+    "I209\0"
+    "I210\0"
+    "I211\0"
+    "I212\0"
+    "I213\0"
+    "I214\0"
+    "I215\0"
+    "I216\0"
+    "I217\0"
+    "I218\0"
+    "I219\0"
+    "I220\0"
+    "I221\0"
+    "I222\0"
+    "I223\0"
+    "I224\0"
+    "I225\0"
+    "I226\0"
+    "I227\0"
+    "I228\0"
+    "I229\0"
+    "I230\0"
+    "I231\0"
+    "I232\0"
+    "I233\0"
+    "I234\0"
+    "I235\0"
+    "I236\0"
+    "I237\0"
+    "I238\0"
+    "I239\0"
+    "I240\0"
+    "I241\0"
+    "I242\0"
+    "I243\0"
+    "I244\0"
+    "I245\0"
+    "I246\0"
+    "I247\0"
+    "I248\0"
+    "I249\0"
+    "I250\0"
+    "I251\0"
+    "I252\0"
+    "I253\0"
+    "LVL3\0"
+    "MDSW\0"
+    "ALT\0"
+    "META\0"
+    "SUPR\0"
+    "HYPR\0"
+    "Caps Lock\0"
+    "Num Lock\0"
+    "Scroll Lock\0"
+    "Compose\0"
+    "Kana\0"
+    "Sleep\0"
+    "Suspend\0"
+    "Mute\0"
+    "Misc\0"
+    "Mail\0"
+    "Charging\0"
+    "ALGR\0"
+    "KPPT\0"
+    "LatQ\0"
+    "LatW\0"
+    "LatE\0"
+    "LatR\0"
+    "LatT\0"
+    "LatY\0"
+    "LatU\0"
+    "LatI\0"
+    "LatO\0"
+    "LatP\0"
+    "LatA\0"
+    "LatS\0"
+    "LatD\0"
+    "LatF\0"
+    "LatG\0"
+    "LatH\0"
+    "LatJ\0"
+    "LatK\0"
+    "LatL\0"
+    "LatZ\0"
+    "LatX\0"
+    "LatC\0"
+    "LatV\0"
+    "LatB\0"
+    "LatN\0"
+    "LatM\0"
+    "NumLock\0"
+    "ONE_LEVEL\0"
+    "modifiers\0"
+    "None\0"
+    "map\0"
+    "Level1\0"
+    "level_name\0"
+    "Any\0"
+    "TWO_LEVEL\0"
+    "Level2\0"
+    "Base\0"
+    "ALPHABETIC\0"
+    "Caps\0"
+    "Alt\0"
+    "SHIFT+ALT\0"
+    "Shift+Alt\0"
+    "LevelThree\0"
+    "LAlt\0"
+    "RAlt\0"
+    "RControl\0"
+    "LControl\0"
+    "PC_SUPER_LEVEL2\0"
+    "Super\0"
+    "PC_CONTROL_LEVEL2\0"
+    "PC_LCONTROL_LEVEL2\0"
+    "PC_RCONTROL_LEVEL2\0"
+    "PC_ALT_LEVEL2\0"
+    "PC_LALT_LEVEL2\0"
+    "PC_RALT_LEVEL2\0"
+    "CTRL+ALT\0"
+    "Level3\0"
+    "Level4\0"
+    "Level5\0"
+    "preserve\0"
+    "Alt Base\0"
+    "Shift Alt\0"
+    "Ctrl+Alt\0"
+    "LOCAL_EIGHT_LEVEL\0"
+    "Level6\0"
+    "Level7\0"
+    "Level8\0"
+    "Shift Level3\0"
+    "Ctrl\0"
+    "Shift Ctrl\0"
+    "Level3 Ctrl\0"
+    "Shift Level3 Ctrl\0"
+    "THREE_LEVEL\0"
+    "ScrollLock\0"
+    "LevelFive\0"
+    "EIGHT_LEVEL\0"
+    "X\0"
+    "X Shift\0"
+    "X Alt Base\0"
+    "X Shift Alt\0"
+    "EIGHT_LEVEL_ALPHABETIC\0"
+    "EIGHT_LEVEL_LEVEL_FIVE_LOCK\0"
+    "EIGHT_LEVEL_ALPHABETIC_LEVEL_FIVE_LOCK\0"
+    "EIGHT_LEVEL_SEMIALPHABETIC\0"
+    "FOUR_LEVEL\0"
+    "FOUR_LEVEL_ALPHABETIC\0"
+    "FOUR_LEVEL_SEMIALPHABETIC\0"
+    "FOUR_LEVEL_MIXED_KEYPAD\0"
+    "Number\0"
+    "FOUR_LEVEL_X\0"
+    "SEPARATE_CAPS_AND_SHIFT_ALPHABETIC\0"
+    "AltGr Base\0"
+    "Shift AltGr\0"
+    "FOUR_LEVEL_PLUS_LOCK\0"
+    "KEYPAD\0"
+    "FOUR_LEVEL_KEYPAD\0"
+    "Alt Number\0"
+    "AltGr\0"
+    "interpret\0"
+    "repeat\0"
+    "False\0"
+    "setMods\0"
+    "clearLocks\0"
+    "True\0"
+    "latchMods\0"
+    "latchToLock\0"
+    "AnyOf\0"
+    "action\0"
+    "LockMods\0"
+    "virtualModifier\0"
+    "useModMapMods\0"
+    "level1\0"
+    "SetGroup\0"
+    "group\0"
+    "SetMods\0"
+    "modMapMods\0"
+    "Shift Lock\0"
+    "allowExplicit\0"
+    "whichModState\0"
+    "Locked\0"
+    "LatchMods\0"
+    "LatchGroup\0"
+    "LockGroup\0"
+    "Group 2\0"
+    "groups\0"
+    "All\0"
+    "Group1\0"
+    "MovePtr\0"
+    "x\0"
+    "y\0"
+    "PointerButton\0"
+    "button\0"
+    "default\0"
+    "SetPtrDflt\0"
+    "affect\0"
+    "defaultButton\0"
+    "count\0"
+    "LockPointerButton\0"
+    "lock\0"
+    "unlock\0"
+    "LockControls\0"
+    "controls\0"
+    "MouseKeys\0"
+    "MouseKeysAccel\0"
+    "Mouse Keys\0"
+    "indicatorDrivesKeyboard\0"
+    "AccessXKeys\0"
+    "AccessXFeedback\0"
+    "RepeatKeys\0"
+    "SlowKeys\0"
+    "BounceKeys\0"
+    "StickyKeys\0"
+    "Overlay1\0"
+    "Overlay2\0"
+    "AudibleBell\0"
+    "Meta\0"
+    "Hyper\0"
+    "Terminate\0"
+    "SwitchScreen\0"
+    "Screen\0"
+    "SameServer\0"
+    "Private\0"
+    "type\0"
+    "data\0"
+    "PrGrbs\0"
+    "PrWins\0"
+    "+VMode\0"
+    "-VMode\0"
+    "*\0"
+    "Shift_L\0"
+    "Shift_R\0"
+    "Caps_Lock\0"
+    "Control_L\0"
+    "Control_R\0"
+    "Num_Lock\0"
+    "Super_L\0"
+    "Super_R\0"
+    "OUTP\0"
+    "KITG\0"
+    "KIDN\0"
+    "KIUP\0"
+    "symbols\0"
+    "overlay1\0"
+    "KO7\0"
+    "KO8\0"
+    "KO9\0"
+    "KO4\0"
+    "KO5\0"
+    "KO6\0"
+    "KO1\0"
+    "KO2\0"
+    "KO3\0"
+    "KO0\0"
+    "KODL\0"
+    "overlay2\0"
+    "Alt_L\0"
+    "Alt_R\0"
+    "Meta_L\0"
+    "Meta_R\0"
+    "name\0"
+    "I01\0"
+    "I10\0"
+    "I19\0"
+    "I20\0"
+    "I22\0"
+    "I24\0"
+    "I2E\0"
+    "I30\0"
+    "K5A\0"
+    "K6C\0"
+    "I21\0"
+    "I32\0"
+    "I65\0"
+    "I66\0"
+    "I67\0"
+    "I68\0"
+    "I69\0"
+    "I6A\0"
+    "I6B\0"
+    "I6C\0"
+    "I6D\0"
+    "I5E\0"
+    "I5F\0"
+    "I63\0"
+    "I74\0"
+    "I76\0"
+    "I16\0"
+    "RO\0"
+    "I192\0"
+    "I193\0"
+    "I194\0"
+    "I195\0"
+    "I196\0"
+    "I255\0"
+    "key\0"
+;
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+/* Indexed by atom - 1. */
+static const uint16_t seed_atom_offsets[NUM_SEED_ATOMS] = {
+    0, /* 1 Shift */
+    6, /* 2 Lock */
+    11, /* 3 Control */
+    19, /* 4 Mod1 */
+    24, /* 5 Mod2 */
+    29, /* 6 Mod3 */
+    34, /* 7 Mod4 */
+    39, /* 8 Mod5 */
+    44, /* 9 minimum */
+    52, /* 10 maximum */
+    60, /* 11 LSGT */
+    65, /* 12 TLDE */
+    70, /* 13 AE01 */
+    75, /* 14 AE02 */
+    80, /* 15 AE03 */
+    85, /* 16 AE04 */
+    90, /* 17 AE05 */
+    95, /* 18 AE06 */
+    100, /* 19 AE07 */
+    105, /* 20 AE08 */
+    110, /* 21 AE09 */
+    115, /* 22 AE10 */
+    120, /* 23 AE11 */
+    125, /* 24 AE12 */
+    130, /* 25 BKSP */
+    135, /* 26 TAB */
+    139, /* 27 AD01 */
+    144, /* 28 AD02 */
+    149, /* 29 AD03 */
+    154, /* 30 AD04 */
+    159, /* 31 AD05 */
+    164, /* 32 AD06 */
+    169, /* 33 AD07 */
+    174, /* 34 AD08 */
+    179, /* 35 AD09 */
+    184, /* 36 AD10 */
+    189, /* 37 AD11 */
+    194, /* 38 AD12 */
+    199, /* 39 BKSL */
+    204, /* 40 AC12 */
+    209, /* 41 RTRN */
+    214, /* 42 CAPS */
+    219, /* 43 AC01 */
+    224, /* 44 AC02 */
+    229, /* 45 AC03 */
+    234, /* 46 AC04 */
+    239, /* 47 AC05 */
+    244, /* 48 AC06 */
+    249, /* 49 AC07 */
+    254, /* 50 AC08 */
+    259, /* 51 AC09 */
+    264, /* 52 AC10 */
+    269, /* 53 AC11 */
+    274, /* 54 LFSH */
+    279, /* 55 AB01 */
+    284, /* 56 AB02 */
+    289, /* 57 AB03 */
+    294, /* 58 AB04 */
+    299, /* 59 AB05 */
+    304, /* 60 AB06 */
+    309, /* 61 AB07 */
+    314, /* 62 AB08 */
+    319, /* 63 AB09 */
+    324, /* 64 AB10 */
+    329, /* 65 RTSH */
+    334, /* 66 LALT */
+    339, /* 67 LCTL */
+    344, /* 68 SPCE */
+    349, /* 69 RCTL */
+    354, /* 70 RALT */
+    359, /* 71 LWIN */
+    364, /* 72 RWIN */
+    369, /* 73 COMP */
+    374, /* 74 MENU */
+    379, /* 75 ESC */
+    383, /* 76 FK01 */
+    388, /* 77 FK02 */
+    393, /* 78 FK03 */
+    398, /* 79 FK04 */
+    403, /* 80 FK05 */
+    408, /* 81 FK06 */
+    413, /* 82 FK07 */
+    418, /* 83 FK08 */
+    423, /* 84 FK09 */
+    428, /* 85 FK10 */
+    433, /* 86 FK11 */
+    438, /* 87 FK12 */
+    443, /* 88 PRSC */
+    448, /* 89 SCLK */
+    453, /* 90 PAUS */
+    458, /* 91 INS */
+    462, /* 92 HOME */
+    467, /* 93 PGUP */
+    472, /* 94 DELE */
+    477, /* 95 END */
+    481, /* 96 PGDN */
+    486, /* 97 UP */
+    489, /* 98 LEFT */
+    494, /* 99 DOWN */
+    499, /* 100 RGHT */
+    504, /* 101 NMLK */
+    509, /* 102 KPDV */
+    514, /* 103 KPMU */
+    519, /* 104 KPSU */
+    524, /* 105 KP7 */
+    528, /* 106 KP8 */
+    532, /* 107 KP9 */
+    536, /* 108 KPAD */
+    541, /* 109 KP4 */
+    545, /* 110 KP5 */
+    549, /* 111 KP6 */
+    553, /* 112 KP1 */
+    557, /* 113 KP2 */
+    561, /* 114 KP3 */
+    565, /* 115 KPEN */
+    570, /* 116 KP0 */
+    574, /* 117 KPDL */
+    579, /* 118 KPEQ */
+    584, /* 119 FK13 */
+    589, /* 120 FK14 */
+    594, /* 121 FK15 */
+    599, /* 122 FK16 */
+    604, /* 123 FK17 */
+    609, /* 124 FK18 */
+    614, /* 125 FK19 */
+    619, /* 126 FK20 */
+    624, /* 127 FK21 */
+    629, /* 128 FK22 */
+    634, /* 129 FK23 */
+    639, /* 130 FK24 */
+    644, /* 131 HZTG */
+    649, /* 132 HKTG */
+    654, /* 133 AB11 */
+    659, /* 134 HENK */
+    664, /* 135 MUHE */
+    669, /* 136 AE13 */
+    674, /* 137 KATA */
+    679, /* 138 HIRA */
+    684, /* 139 JPCM */
+    689, /* 140 HNGL */
+    694, /* 141 HJCV */
+    699, /* 142 LMTA */
+    704, /* 143 RMTA */
+    709, /* 144 MUTE */
+    714, /* 145 VOL- */
+    719, /* 146 VOL+ */
+    724, /* 147 POWR */
+    729, /* 148 STOP */
+    734, /* 149 AGAI */
+    739, /* 150 PROP */
+    744, /* 151 UNDO */
+    749, /* 152 FRNT */
+    754, /* 153 COPY */
+    759, /* 154 OPEN */
+    764, /* 155 PAST */
+    769, /* 156 FIND */
+    774, /* 157 CUT */
+    778, /* 158 HELP */
+    783, /* 159 LNFD */
+    788, /* 160 I120 */
+    793, /* 161 I126 */
+    798, /* 162 I128 */
+    803, /* 163 I129 */
+    808, /* 164 I147 */
+    813, /* 165 I148 */
+    818, /* 166 I149 */
+    823, /* 167 I150 */
+    828, /* 168 I151 */
+    833, /* 169 I152 */
+    838, /* 170 I153 */
+    843, /* 171 I154 */
+    848, /* 172 I155 */
+    853, /* 173 I156 */
+    858, /* 174 I157 */
+    863, /* 175 I158 */
+    868, /* 176 I159 */
+    873, /* 177 I160 */
+    878, /* 178 I161 */
+    883, /* 179 I162 */
+    888, /* 180 I163 */
+    893, /* 181 I164 */
+    898, /* 182 I165 */
+    903, /* 183 I166 */
+    908, /* 184 I167 */
+    913, /* 185 I168 */
+    918, /* 186 I169 */
+    923, /* 187 I170 */
+    928, /* 188 I171 */
+    933, /* 189 I172 */
+    938, /* 190 I173 */
+    943, /* 191 I174 */
+    948, /* 192 I175 */
+    953, /* 193 I176 */
+    958, /* 194 I177 */
+    963, /* 195 I178 */
+    968, /* 196 I179 */
+    973, /* 197 I180 */
+    978, /* 198 I181 */
+    983, /* 199 I182 */
+    988, /* 200 I183 */
+    993, /* 201 I184 */
+    998, /* 202 I185 */
+    1003, /* 203 I186 */
+    1008, /* 204 I187 */
+    1013, /* 205 I188 */
+    1018, /* 206 I189 */
+    1023, /* 207 I190 */
+    1028, /* 208 I208 */
+    1033, /* 209 I209 */
+    1038, /* 210 I210 */
+    1043, /* 211 I211 */
+    1048, /* 212 I212 */
+    1053, /* 213 I213 */
+    1058, /* 214 I214 */
+    1063, /* 215 I215 */
+    1068, /* 216 I216 */
+    1073, /* 217 I217 */
+    1078, /* 218 I218 */
+    1083, /* 219 I219 */
+    1088, /* 220 I220 */
+    1093, /* 221 I221 */
+    1098, /* 222 I222 */
+    1103, /* 223 I223 */
+    1108, /* 224 I224 */
+    1113, /* 225 I225 */
+    1118, /* 226 I226 */
+    1123, /* 227 I227 */
+    1128, /* 228 I228 */
+    1133, /* 229 I229 */
+    1138, /* 230 I230 */
+    1143, /* 231 I231 */
+    1148, /* 232 I232 */
+    1153, /* 233 I233 */
+    1158, /* 234 I234 */
+    1163, /* 235 I235 */
+    1168, /* 236 I236 */
+    1173, /* 237 I237 */
+    1178, /* 238 I238 */
+    1183, /* 239 I239 */
+    1188, /* 240 I240 */
+    1193, /* 241 I241 */
+    1198, /* 242 I242 */
+    1203, /* 243 I243 */
+    1208, /* 244 I244 */
+    1213, /* 245 I245 */
+    1218, /* 246 I246 */
+    1223, /* 247 I247 */
+    1228, /* 248 I248 */
+    1233, /* 249 I249 */
+    1238, /* 250 I250 */
+    1243, /* 251 I251 */
+    1248, /* 252 I252 */
+    1253, /* 253 I253 */
+    1258, /* 254 LVL3 */
+    1263, /* 255 MDSW */
+    1268, /* 256 ALT */
+    1272, /* 257 META */
+    1277, /* 258 SUPR */
+    1282, /* 259 HYPR */
+    1287, /* 260 Caps Lock */
+    1297, /* 261 Num Lock */
+    1306, /* 262 Scroll Lock */
+    1318, /* 263 Compose */
+    1326, /* 264 Kana */
+    1331, /* 265 Sleep */
+    1337, /* 266 Suspend */
+    1345, /* 267 Mute */
+    1350, /* 268 Misc */
+    1355, /* 269 Mail */
+    1360, /* 270 Charging */
+    1369, /* 271 ALGR */
+    1374, /* 272 KPPT */
+    1379, /* 273 LatQ */
+    1384, /* 274 LatW */
+    1389, /* 275 LatE */
+    1394, /* 276 LatR */
+    1399, /* 277 LatT */
+    1404, /* 278 LatY */
+    1409, /* 279 LatU */
+    1414, /* 280 LatI */
+    1419, /* 281 LatO */
+    1424, /* 282 LatP */
+    1429, /* 283 LatA */
+    1434, /* 284 LatS */
+    1439, /* 285 LatD */
+    1444, /* 286 LatF */
+    1449, /* 287 LatG */
+    1454, /* 288 LatH */
+    1459, /* 289 LatJ */
+    1464, /* 290 LatK */
+    1469, /* 291 LatL */
+    1474, /* 292 LatZ */
+    1479, /* 293 LatX */
+    1484, /* 294 LatC */
+    1489, /* 295 LatV */
+    1494, /* 296 LatB */
+    1499, /* 297 LatN */
+    1504, /* 298 LatM */
+    1509, /* 299 NumLock */
+    1517, /* 300 ONE_LEVEL */
+    1527, /* 301 modifiers */
+    1537, /* 302 None */
+    1542, /* 303 map */
+    1546, /* 304 Level1 */
+    1553, /* 305 level_name */
+    1564, /* 306 Any */
+    1568, /* 307 TWO_LEVEL */
+    1578, /* 308 Level2 */
+    1585, /* 309 Base */
+    1590, /* 310 ALPHABETIC */
+    1601, /* 311 Caps */
+    1606, /* 312 Alt */
+    1610, /* 313 SHIFT+ALT */
+    1620, /* 314 Shift+Alt */
+    1630, /* 315 LevelThree */
+    1641, /* 316 LAlt */
+    1646, /* 317 RAlt */
+    1651, /* 318 RControl */
+    1660, /* 319 LControl */
+    1669, /* 320 PC_SUPER_LEVEL2 */
+    1685, /* 321 Super */
+    1691, /* 322 PC_CONTROL_LEVEL2 */
+    1709, /* 323 PC_LCONTROL_LEVEL2 */
+    1728, /* 324 PC_RCONTROL_LEVEL2 */
+    1747, /* 325 PC_ALT_LEVEL2 */
+    1761, /* 326 PC_LALT_LEVEL2 */
+    1776, /* 327 PC_RALT_LEVEL2 */
+    1791, /* 328 CTRL+ALT */
+    1800, /* 329 Level3 */
+    1807, /* 330 Level4 */
+    1814, /* 331 Level5 */
+    1821, /* 332 preserve */
+    1830, /* 333 Alt Base */
+    1839, /* 334 Shift Alt */
+    1849, /* 335 Ctrl+Alt */
+    1858, /* 336 LOCAL_EIGHT_LEVEL */
+    1876, /* 337 Level6 */
+    1883, /* 338 Level7 */
+    1890, /* 339 Level8 */
+    1897, /* 340 Shift Level3 */
+    1910, /* 341 Ctrl */
+    1915, /* 342 Shift Ctrl */
+    1926, /* 343 Level3 Ctrl */
+    1938, /* 344 Shift Level3 Ctrl */
+    1956, /* 345 THREE_LEVEL */
+    1968, /* 346 ScrollLock */
+    1979, /* 347 LevelFive */
+    1989, /* 348 EIGHT_LEVEL */
+    2001, /* 349 X */
+    2003, /* 350 X Shift */
+    2011, /* 351 X Alt Base */
+    2022, /* 352 X Shift Alt */
+    2034, /* 353 EIGHT_LEVEL_ALPHABETIC */
+    2057, /* 354 EIGHT_LEVEL_LEVEL_FIVE_LOCK */
+    2085, /* 355 EIGHT_LEVEL_ALPHABETIC_LEVEL_FIVE_LOCK */
+    2124, /* 356 EIGHT_LEVEL_SEMIALPHABETIC */
+    2151, /* 357 FOUR_LEVEL */
+    2162, /* 358 FOUR_LEVEL_ALPHABETIC */
+    2184, /* 359 FOUR_LEVEL_SEMIALPHABETIC */
+    2210, /* 360 FOUR_LEVEL_MIXED_KEYPAD */
+    2234, /* 361 Number */
+    2241, /* 362 FOUR_LEVEL_X */
+    2254, /* 363 SEPARATE_CAPS_AND_SHIFT_ALPHABETIC */
+    2289, /* 364 AltGr Base */
+    2300, /* 365 Shift AltGr */
+    2312, /* 366 FOUR_LEVEL_PLUS_LOCK */
+    2333, /* 367 KEYPAD */
+    2340, /* 368 FOUR_LEVEL_KEYPAD */
+    2358, /* 369 Alt Number */
+    2369, /* 370 AltGr */
+    2375, /* 371 interpret */
+    2385, /* 372 repeat */
+    2392, /* 373 False */
+    2398, /* 374 setMods */
+    2406, /* 375 clearLocks */
+    2417, /* 376 True */
+    2422, /* 377 latchMods */
+    2432, /* 378 latchToLock */
+    2444, /* 379 AnyOf */
+    2450, /* 380 action */
+    2457, /* 381 LockMods */
+    2466, /* 382 virtualModifier */
+    2482, /* 383 useModMapMods */
+    2496, /* 384 level1 */
+    2503, /* 385 SetGroup */
+    2512, /* 386 group */
+    2518, /* 387 SetMods */
+    2526, /* 388 modMapMods */
+    2537, /* 389 Shift Lock */
+    2548, /* 390 allowExplicit */
+    2562, /* 391 whichModState */
+    2576, /* 392 Locked */
+    2583, /* 393 LatchMods */
+    2593, /* 394 LatchGroup */
+    2604, /* 395 LockGroup */
+    2614, /* 396 Group 2 */
+    2622, /* 397 groups */
+    2629, /* 398 All */
+    2633, /* 399 Group1 */
+    2640, /* 400 MovePtr */
+    2648, /* 401 x */
+    2650, /* 402 y */
+    2652, /* 403 PointerButton */
+    2666, /* 404 button */
+    2673, /* 405 default */
+    2681, /* 406 SetPtrDflt */
+    2692, /* 407 affect */
+    2699, /* 408 defaultButton */
+    2713, /* 409 count */
+    2719, /* 410 LockPointerButton */
+    2737, /* 411 lock */
+    2742, /* 412 unlock */
+    2749, /* 413 LockControls */
+    2762, /* 414 controls */
+    2771, /* 415 MouseKeys */
+    2781, /* 416 MouseKeysAccel */
+    2796, /* 417 Mouse Keys */
+    2807, /* 418 indicatorDrivesKeyboard */
+    2831, /* 419 AccessXKeys */
+    2843, /* 420 AccessXFeedback */
+    2859, /* 421 RepeatKeys */
+    2870, /* 422 SlowKeys */
+    2879, /* 423 BounceKeys */
+    2890, /* 424 StickyKeys */
+    2901, /* 425 Overlay1 */
+    2910, /* 426 Overlay2 */
+    2919, /* 427 AudibleBell */
+    2931, /* 428 Meta */
+    2936, /* 429 Hyper */
+    2942, /* 430 Terminate */
+    2952, /* 431 SwitchScreen */
+    2965, /* 432 Screen */
+    2972, /* 433 SameServer */
+    2983, /* 434 Private */
+    2991, /* 435 type */
+    2996, /* 436 data */
+    3001, /* 437 PrGrbs */
+    3008, /* 438 PrWins */
+    3015, /* 439 +VMode */
+    3022, /* 440 -VMode */
+    3029, /* 441 * */
+    3031, /* 442 Shift_L */
+    3039, /* 443 Shift_R */
+    3047, /* 444 Caps_Lock */
+    3057, /* 445 Control_L */
+    3067, /* 446 Control_R */
+    3077, /* 447 Num_Lock */
+    3086, /* 448 Super_L */
+    3094, /* 449 Super_R */
+    3102, /* 450 OUTP */
+    3107, /* 451 KITG */
+    3112, /* 452 KIDN */
+    3117, /* 453 KIUP */
+    3122, /* 454 symbols */
+    3130, /* 455 overlay1 */
+    3139, /* 456 KO7 */
+    3143, /* 457 KO8 */
+    3147, /* 458 KO9 */
+    3151, /* 459 KO4 */
+    3155, /* 460 KO5 */
+    3159, /* 461 KO6 */
+    3163, /* 462 KO1 */
+    3167, /* 463 KO2 */
+    3171, /* 464 KO3 */
+    3175, /* 465 KO0 */
+    3179, /* 466 KODL */
+    3184, /* 467 overlay2 */
+    3193, /* 468 Alt_L */
+    3199, /* 469 Alt_R */
+    3205, /* 470 Meta_L */
+    3212, /* 471 Meta_R */
+    3219, /* 472 name */
+    3224, /* 473 I01 */
+    3228, /* 474 I10 */
+    3232, /* 475 I19 */
+    3236, /* 476 I20 */
+    3240, /* 477 I22 */
+    3244, /* 478 I24 */
+    3248, /* 479 I2E */
+    3252, /* 480 I30 */
+    3256, /* 481 K5A */
+    3260, /* 482 K6C */
+    3264, /* 483 I21 */
+    3268, /* 484 I32 */
+    3272, /* 485 I65 */
+    3276, /* 486 I66 */
+    3280, /* 487 I67 */
+    3284, /* 488 I68 */
+    3288, /* 489 I69 */
+    3292, /* 490 I6A */
+    3296, /* 491 I6B */
+    3300, /* 492 I6C */
+    3304, /* 493 I6D */
+    3308, /* 494 I5E */
+    3312, /* 495 I5F */
+    3316, /* 496 I63 */
+    3320, /* 497 I74 */
+    3324, /* 498 I76 */
+    3328, /* 499 I16 */
+    3332, /* 500 RO */
+    3335, /* 501 I192 */
+    3340, /* 502 I193 */
+    3345, /* 503 I194 */
+    3350, /* 504 I195 */
+    3355, /* 505 I196 */
+    3360, /* 506 I255 */
+    3365, /* 507 key */
+};
+
+static const struct atom_slot seed_atom_index[SEED_ATOM_INDEX_SIZE] = {
+    { 0x8b10c000, 182 }, /* I165 */
+    { 0x5cf10400, 420 }, /* AccessXFeedback */
+    { 0x8aed8c01, 468 }, /* Alt_L */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb93f6c09, 64 }, /* AB10 */
+    { 0x4bc64409, 112 }, /* KP1 */
+    { 0, XKB_ATOM_NONE },
+    { 0xddf4600c, 79 }, /* FK04 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xffb6040f, 279 }, /* LatU */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x3312ec12, 42 }, /* CAPS */
+    { 0x81694c13, 46 }, /* AC04 */
+    { 0x854e4813, 507 }, /* key */
+    { 0, XKB_ATOM_NONE },
+    { 0xb932a016, 22 }, /* AE10 */
+    { 0xcfac0017, 188 }, /* I171 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xac3ea81a, 98 }, /* LEFT */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x95db901d, 91 }, /* INS */
+    { 0x0050641e, 17 }, /* AE05 */
+    { 0xbeead81f, 370 }, /* AltGr */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x0652ac27, 31 }, /* AD05 */
+    { 0x4c61c428, 83 }, /* FK08 */
+    { 0x2c5af827, 129 }, /* FK23 */
+    { 0xd5def82a, 21 }, /* AE09 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb7bee82e, 1 }, /* Shift */
+    { 0xc4a9b02f, 221 }, /* I221 */
+    { 0xf9d3a82f, 347 }, /* LevelFive */
+    { 0xffc94c2f, 399 }, /* Group1 */
+    { 0x09cb1032, 343 }, /* Level3 Ctrl */
+    { 0x19df8033, 396 }, /* Group 2 */
+    { 0x29333833, 418 }, /* indicatorDrivesKeyboard */
+    { 0xc89d7c35, 110 }, /* KP5 */
+    { 0xddb64436, 421 }, /* RepeatKeys */
+    { 0xe1a6cc33, 436 }, /* data */
+    { 0xc4a9b02f, 483 }, /* I21 */
+    { 0, XKB_ATOM_NONE },
+    { 0x2e99303a, 6 }, /* Mod3 */
+    { 0x268ba83b, 170 }, /* I153 */
+    { 0x2542cc3c, 186 }, /* I169 */
+    { 0x325b6c3c, 493 }, /* I6D */
+    { 0x7fc7783e, 403 }, /* PointerButton */
+    { 0, XKB_ATOM_NONE },
+    { 0x9a044840, 416 }, /* MouseKeysAccel */
+    { 0x12dc9041, 330 }, /* Level4 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x3b40b047, 229 }, /* I229 */
+    { 0xe4814c47, 351 }, /* X Alt Base */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x8443984b, 439 }, /* +VMode */
+    { 0x74fbd84c, 373 }, /* False */
+    { 0xbcf8e04d, 179 }, /* I162 */
+    { 0x0ca5ec4d, 236 }, /* I236 */
+    { 0x88d3344f, 7 }, /* Mod4 */
+    { 0xe6402050, 204 }, /* I187 */
+    { 0x96931450, 253 }, /* I253 */
+    { 0xab2b6c50, 300 }, /* ONE_LEVEL */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x218ba05c, 200 }, /* I183 */
+    { 0xb79bf45c, 282 }, /* LatP */
+    { 0x6627485d, 301 }, /* modifiers */
+    { 0xea7cb05d, 339 }, /* Level8 */
+    { 0xff252c5e, 463 }, /* KO2 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x26f13866, 222 }, /* I222 */
+    { 0x26f13866, 477 }, /* I22 */
+    { 0, XKB_ATOM_NONE },
+    { 0x9d00bc69, 326 }, /* PC_LALT_LEVEL2 */
+    { 0x1dbc8869, 369 }, /* Alt Number */
+    { 0x417dd869, 447 }, /* Num_Lock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb794286e, 303 }, /* map */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x5c4f2871, 471 }, /* Meta_R */
+    { 0x77c80872, 311 }, /* Caps */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x06541076, 422 }, /* SlowKeys */
+    { 0x9e509476, 497 }, /* I74 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xcbbd747e, 318 }, /* RControl */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xc79cc082, 286 }, /* LatF */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x9410a885, 5 }, /* Mod2 */
+    { 0x36b30486, 208 }, /* I208 */
+    { 0x6bca1c87, 320 }, /* PC_SUPER_LEVEL2 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x4e04708a, 372 }, /* repeat */
+    { 0x77a38c8b, 94 }, /* DELE */
+    { 0x18e86c8c, 156 }, /* FIND */
+    { 0x3fe6a88d, 323 }, /* PC_LCONTROL_LEVEL2 */
+    { 0x18dd588e, 336 }, /* LOCAL_EIGHT_LEVEL */
+    { 0xc724d08a, 451 }, /* KITG */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x9cc06094, 382 }, /* virtualModifier */
+    { 0x7dfe3495, 315 }, /* LevelThree */
+    { 0xb4e17096, 81 }, /* FK06 */
+    { 0x1494fc94, 449 }, /* Super_R */
+    { 0x48f26c98, 255 }, /* MDSW */
+    { 0, XKB_ATOM_NONE },
+    { 0xe2df089a, 240 }, /* I240 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x7eac9c9f, 154 }, /* OPEN */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x222b48a5, 437 }, /* PrGrbs */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x5fa8e8aa, 299 }, /* NumLock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x0db370ae, 45 }, /* AC03 */
+    { 0, XKB_ATOM_NONE },
+    { 0x880e7cb0, 235 }, /* I235 */
+    { 0xadf8c8b0, 501 }, /* I192 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x13b5b8b7, 57 }, /* AB03 */
+    { 0, XKB_ATOM_NONE },
+    { 0x8e10c4b9, 172 }, /* I155 */
+    { 0x287be8b9, 404 }, /* button */
+    { 0xdddf00bb, 230 }, /* I230 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xc231a0bf, 379 }, /* AnyOf */
+    { 0xb3e730c0, 390 }, /* allowExplicit */
+    { 0, XKB_ATOM_NONE },
+    { 0x53563cc2, 49 }, /* AC07 */
+    { 0xa46f54c3, 85 }, /* FK10 */
+    { 0, XKB_ATOM_NONE },
+    { 0xc8b018c5, 205 }, /* I188 */
+    { 0, XKB_ATOM_NONE },
+    { 0xf34034c7, 174 }, /* I157 */
+    { 0x47977cc8, 86 }, /* FK11 */
+    { 0, XKB_ATOM_NONE },
+    { 0x4b8e84ca, 428 }, /* Meta */
+    { 0x595884cb, 61 }, /* AB07 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb92f3ccf, 356 }, /* EIGHT_LEVEL_SEMIALPHABETIC */
+    { 0x830cbccf, 431 }, /* SwitchScreen */
+    { 0x7e89f4d1, 72 }, /* RWIN */
+    { 0x6156d4d1, 346 }, /* ScrollLock */
+    { 0xe4478cd3, 278 }, /* LatY */
+    { 0x5f5accd4, 19 }, /* AE07 */
+    { 0x5babb8d4, 417 }, /* Mouse Keys */
+    { 0, XKB_ATOM_NONE },
+    { 0x297b14d7, 355 }, /* EIGHT_LEVEL_ALPHABETIC_LEVEL_FIVE_LOCK */
+    { 0xc6aff0d8, 316 }, /* LAlt */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa273e0dc, 104 }, /* KPSU */
+    { 0x655d14dd, 33 }, /* AD07 */
+    { 0xa988a4dd, 496 }, /* I63 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x53dbe8e6, 167 }, /* I150 */
+    { 0x9663ace6, 259 }, /* HYPR */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xcd0918ea, 364 }, /* AltGr Base */
+    { 0x44a6b4ea, 394 }, /* LatchGroup */
+    { 0xbd41b0ec, 52 }, /* AC10 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa736ccef, 489 }, /* I69 */
+    { 0, XKB_ATOM_NONE },
+    { 0xa54194f1, 201 }, /* I184 */
+    { 0x1f195cf2, 304 }, /* Level1 */
+    { 0xd189bcf3, 84 }, /* FK09 */
+    { 0x6ee5c8f3, 114 }, /* KP3 */
+    { 0x2842d0f5, 176 }, /* I159 */
+    { 0x39cb78f6, 368 }, /* FOUR_LEVEL_KEYPAD */
+    { 0x55cc60f3, 406 }, /* SetPtrDflt */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x610938fe, 62 }, /* AB08 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa56b5504, 68 }, /* SPCE */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x78c8cd07, 359 }, /* FOUR_LEVEL_SEMIALPHABETIC */
+    { 0, XKB_ATOM_NONE },
+    { 0xc2a9ad09, 241 }, /* I241 */
+    { 0x0347a90a, 413 }, /* LockControls */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xdc50550d, 386 }, /* group */
+    { 0x0617e10e, 331 }, /* Level5 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa0418d12, 171 }, /* I154 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xcac1f11d, 429 }, /* Hyper */
+    { 0x9873d11e, 103 }, /* KPMU */
+    { 0x29f13d1f, 252 }, /* I252 */
+    { 0x8e36791e, 340 }, /* Shift Level3 */
+    { 0x3940ad21, 249 }, /* I249 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xe3ab0924, 8 }, /* Mod5 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x0aa5e927, 216 }, /* I216 */
+    { 0xbb5fe128, 74 }, /* MENU */
+    { 0x104e9528, 113 }, /* KP2 */
+    { 0x86373d27, 423 }, /* BounceKeys */
+    { 0xed95bd2a, 433 }, /* SameServer */
+    { 0xecbd512c, 319 }, /* LControl */
+    { 0, XKB_ATOM_NONE },
+    { 0xd008fd2e, 491 }, /* I6B */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x19ea9932, 67 }, /* LCTL */
+    { 0xa7e9fd33, 435 }, /* type */
+    { 0x37dc8534, 43 }, /* AC01 */
+    { 0xacd72d35, 23 }, /* AE11 */
+    { 0x27de7135, 441 }, /* * */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xf3a8f539, 281 }, /* LatO */
+    { 0, XKB_ATOM_NONE },
+    { 0x07775d3b, 450 }, /* OUTP */
+    { 0xa143cd3c, 224 }, /* I224 */
+    { 0x3ddecd3d, 55 }, /* AB01 */
+    { 0x17b52d3e, 383 }, /* useModMapMods */
+    { 0xa143cd3c, 478 }, /* I24 */
+    { 0x7aad553c, 499 }, /* I16 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x48f5f946, 123 }, /* FK17 */
+    { 0xac2e4946, 289 }, /* LatJ */
+    { 0x05a5e148, 246 }, /* I246 */
+    { 0xea13f949, 432 }, /* Screen */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x96400552, 73 }, /* COMP */
+    { 0xd0aba152, 334 }, /* Shift Alt */
+    { 0, XKB_ATOM_NONE },
+    { 0x74eb2155, 440 }, /* -VMode */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x81050d5d, 159 }, /* LNFD */
+    { 0xa1c7f95e, 40 }, /* AC12 */
+    { 0x60dbfd5d, 197 }, /* I180 */
+    { 0x34b30160, 228 }, /* I228 */
+    { 0x8fa77161, 29 }, /* AD03 */
+    { 0x22c5495e, 296 }, /* LatB */
+    { 0, XKB_ATOM_NONE },
+    { 0xa71d8d64, 270 }, /* Charging */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa967496a, 109 }, /* KP4 */
+    { 0x0aa4616b, 136 }, /* AE13 */
+    { 0, XKB_ATOM_NONE },
+    { 0x5963816d, 401 }, /* x */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x49bfd970, 438 }, /* PrWins */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x5c656d73, 18 }, /* AE06 */
+    { 0xb13f1973, 358 }, /* FOUR_LEVEL_ALPHABETIC */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xce97c577, 313 }, /* SHIFT+ALT */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x1831157a, 77 }, /* FK02 */
+    { 0, XKB_ATOM_NONE },
+    { 0x6267b57c, 60 }, /* AB06 */
+    { 0x8ae8757d, 99 }, /* DOWN */
+    { 0x67e4b17d, 108 }, /* KPAD */
+    { 0xcbb01d7e, 175 }, /* I158 */
+    { 0x31ea657f, 275 }, /* LatE */
+    { 0x4a978181, 127 }, /* FK21 */
+    { 0x36c24181, 365 }, /* Shift AltGr */
+    { 0x4c828d80, 459 }, /* KO4 */
+    { 0, XKB_ATOM_NONE },
+    { 0x6869fd85, 48 }, /* AC06 */
+    { 0x21eb3585, 494 }, /* I5E */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x5ab5d98e, 448 }, /* Super_L */
+    { 0x0cd8a18f, 430 }, /* Terminate */
+    { 0x8205058e, 500 }, /* RO */
+    { 0x3bf95d91, 410 }, /* LockPointerButton */
+    { 0, XKB_ATOM_NONE },
+    { 0x8c10c193, 192 }, /* I175 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x4be26598, 398 }, /* All */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xbfb1e59b, 333 }, /* Alt Base */
+    { 0x076c5d9c, 30 }, /* AD04 */
+    { 0x1d18619b, 485 }, /* I65 */
+    { 0, XKB_ATOM_NONE },
+    { 0xdef4619f, 120 }, /* FK14 */
+    { 0x56dbed9f, 160 }, /* I120 */
+    { 0xf77281a0, 388 }, /* modMapMods */
+    { 0x278835a0, 427 }, /* AudibleBell */
+    { 0, XKB_ATOM_NONE },
+    { 0x821c89a4, 121 }, /* FK15 */
+    { 0x0d6ea5a5, 16 }, /* AE04 */
+    { 0x690fb1a6, 348 }, /* EIGHT_LEVEL */
+    { 0, XKB_ATOM_NONE },
+    { 0xdcfaf1a8, 34 }, /* AD08 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb4ade1ab, 149 }, /* AGAI */
+    { 0x0ebb65ab, 345 }, /* THREE_LEVEL */
+    { 0x548555ad, 353 }, /* EIGHT_LEVEL_ALPHABETIC */
+    { 0x1f1265ae, 90 }, /* PAUS */
+    { 0x2b42d5ae, 206 }, /* I189 */
+    { 0xc0312dab, 470 }, /* Meta_L */
+    { 0xe2fd39b1, 20 }, /* AE08 */
+    { 0xa6f8d1b1, 93 }, /* PGUP */
+    { 0, XKB_ATOM_NONE },
+    { 0x1bb185b4, 495 }, /* I5F */
+    { 0, XKB_ATOM_NONE },
+    { 0x61479db6, 237 }, /* I237 */
+    { 0x9a4665b7, 75 }, /* ESC */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x2d5af9ba, 119 }, /* FK13 */
+    { 0x4d61c5bb, 124 }, /* FK18 */
+    { 0x91eaddbc, 100 }, /* RGHT */
+    { 0xb88231bd, 294 }, /* LatC */
+    { 0x3d7509be, 153 }, /* COPY */
+    { 0x9197c9ba, 328 }, /* CTRL+ALT */
+    { 0x51dbe5c0, 187 }, /* I170 */
+    { 0x49f345be, 472 }, /* name */
+    { 0xc5a9b1c2, 211 }, /* I211 */
+    { 0x9c931dc2, 233 }, /* I233 */
+    { 0xa724d1c4, 158 }, /* HELP */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x6e8b89ca, 297 }, /* LatN */
+    { 0xee8081ca, 354 }, /* EIGHT_LEVEL_LEVEL_FIVE_LOCK */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xad03e5ce, 65 }, /* RTSH */
+    { 0x5459d1ce, 140 }, /* HNGL */
+    { 0x278ba9ce, 180 }, /* I163 */
+    { 0xb48fadd1, 107 }, /* KP9 */
+    { 0x2642cdcf, 196 }, /* I179 */
+    { 0xbbe10dd3, 35 }, /* AD09 */
+    { 0xd68b79d2, 384 }, /* level1 */
+    { 0x82ad61d4, 505 }, /* I196 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x3c40b1da, 219 }, /* I219 */
+    { 0, XKB_ATOM_NONE },
+    { 0x91c605dc, 457 }, /* KO8 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x9ccb4de0, 285 }, /* LatD */
+    { 0xf031e1e0, 309 }, /* Base */
+    { 0, XKB_ATOM_NONE },
+    { 0x979315e3, 243 }, /* I243 */
+    { 0x2794e9e4, 425 }, /* Overlay1 */
+    { 0x414bcde5, 290 }, /* LatK */
+    { 0, XKB_ATOM_NONE },
+    { 0x6d75f1e7, 11 }, /* LSGT */
+    { 0xe8786de8, 352 }, /* X Shift Alt */
+    { 0, XKB_ATOM_NONE },
+    { 0xd04405ea, 257 }, /* META */
+    { 0x5d58f5eb, 273 }, /* LatQ */
+    { 0x9e4189ec, 191 }, /* I174 */
+    { 0x791401ed, 349 }, /* X */
+    { 0, XKB_ATOM_NONE },
+    { 0x228ba1ef, 502 }, /* I193 */
+    { 0x2142c5f0, 163 }, /* I129 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x7dad59f5, 161 }, /* I126 */
+    { 0xa443d1f5, 214 }, /* I214 */
+    { 0x744a15f6, 342 }, /* Shift Ctrl */
+    { 0x2b7605f8, 95 }, /* END */
+    { 0xd209d9f9, 138 }, /* HIRA */
+    { 0x27f139f9, 232 }, /* I232 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x68f21e01, 266 }, /* Suspend */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb9065207, 337 }, /* Level6 */
+    { 0, XKB_ATOM_NONE },
+    { 0x65290609, 332 }, /* preserve */
+    { 0x9910d60a, 202 }, /* I185 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa7f44210, 484 }, /* I32 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa8b09e14, 424 }, /* StickyKeys */
+    { 0xfc1ea215, 467 }, /* overlay2 */
+    { 0x78ad5216, 193 }, /* I176 */
+    { 0x9a174217, 134 }, /* HENK */
+    { 0xb0d97218, 37 }, /* AD11 */
+    { 0x37b30619, 218 }, /* I218 */
+    { 0x9f43ca16, 244 }, /* I244 */
+    { 0x24025e1a, 434 }, /* Private */
+    { 0xc0b52e1c, 443 }, /* Shift_R */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa6223222, 325 }, /* PC_ALT_LEVEL2 */
+    { 0x1e490222, 357 }, /* FOUR_LEVEL */
+    { 0x8e0e8622, 506 }, /* I255 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb5e17229, 122 }, /* FK16 */
+    { 0x9c26ca29, 155 }, /* PAST */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xe3df0a2d, 250 }, /* I250 */
+    { 0x1c3eea2d, 381 }, /* LockMods */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa5d70a34, 24 }, /* AE12 */
+    { 0xca5daa34, 111 }, /* KP6 */
+    { 0, XKB_ATOM_NONE },
+    { 0xceb02237, 162 }, /* I128 */
+    { 0, XKB_ATOM_NONE },
+    { 0xd1a2f639, 374 }, /* setMods */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x20d3fa3e, 28 }, /* AD02 */
+    { 0x44bdea3f, 462 }, /* KO1 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xaef8ca43, 199 }, /* I182 */
+    { 0x890e7e43, 225 }, /* I225 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x1b618e47, 350 }, /* X Shift */
+    { 0x7a7ffe48, 361 }, /* Number */
+    { 0, XKB_ATOM_NONE },
+    { 0xf6628e4a, 32 }, /* AD06 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xbe96864d, 492 }, /* I6C */
+    { 0xd1e5324e, 70 }, /* RALT */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x6cba5e51, 287 }, /* LatG */
+    { 0x94ca8e52, 295 }, /* LatV */
+    { 0, XKB_ATOM_NONE },
+    { 0x16311254, 128 }, /* FK22 */
+    { 0, XKB_ATOM_NONE },
+    { 0xa56f5656, 126 }, /* FK20 */
+    { 0xb23caa57, 412 }, /* unlock */
+    { 0xc9b01a58, 195 }, /* I178 */
+    { 0xf1445259, 387 }, /* SetMods */
+    { 0xf440365a, 184 }, /* I167 */
+    { 0x48977e5b, 76 }, /* FK01 */
+    { 0x643d265b, 265 }, /* Sleep */
+    { 0xc9d6e65b, 481 }, /* K5A */
+    { 0xecdf5e5e, 116 }, /* KP0 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x33517665, 367 }, /* KEYPAD */
+    { 0x4d2db266, 150 }, /* PROP */
+    { 0, XKB_ATOM_NONE },
+    { 0x40d89268, 141 }, /* HJCV */
+    { 0, XKB_ATOM_NONE },
+    { 0x9b67366a, 58 }, /* AB04 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x6447a26f, 247 }, /* I247 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x1f186272, 442 }, /* Shift_L */
+    { 0, XKB_ATOM_NONE },
+    { 0x3f7da274, 385 }, /* SetGroup */
+    { 0x66bb7275, 26 }, /* TAB */
+    { 0, XKB_ATOM_NONE },
+    { 0x8092ea77, 445 }, /* Control_L */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x911ffa7a, 12 }, /* TLDE */
+    { 0x13d8a27b, 263 }, /* Compose */
+    { 0xae8e3e7a, 264 }, /* Kana */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xceabfe84, 178 }, /* I161 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xe70c4a87, 50 }, /* AC08 */
+    { 0xad432a87, 142 }, /* LMTA */
+    { 0xe6115a87, 324 }, /* PC_RCONTROL_LEVEL2 */
+    { 0xeffc2a8a, 9 }, /* minimum */
+    { 0xfd60c287, 458 }, /* KO9 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x70dc5a8f, 392 }, /* Locked */
+    { 0x5f479a90, 217 }, /* I217 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xd8e77e97, 314 }, /* Shift+Alt */
+    { 0x42488e98, 66 }, /* LALT */
+    { 0x13332a98, 102 }, /* KPDV */
+    { 0xcc6fbe99, 139 }, /* JPCM */
+    { 0xa20c029a, 335 }, /* Ctrl+Alt */
+    { 0x9a931a9c, 213 }, /* I213 */
+    { 0xc3a9ae9c, 231 }, /* I231 */
+    { 0xd92e769e, 322 }, /* PC_CONTROL_LEVEL2 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xf65182a1, 487 }, /* I67 */
+    { 0, XKB_ATOM_NONE },
+    { 0x8fa3c2a3, 71 }, /* LWIN */
+    { 0x610526a4, 293 }, /* LatX */
+    { 0xef7816a5, 262 }, /* Scroll Lock */
+    { 0xac9cf6a6, 117 }, /* KPDL */
+    { 0xe46fe2a7, 490 }, /* I6A */
+    { 0, XKB_ATOM_NONE },
+    { 0x2442caa9, 475 }, /* I19 */
+    { 0, XKB_ATOM_NONE },
+    { 0xb95a7eab, 460 }, /* KO5 */
+    { 0x194396ac, 137 }, /* KATA */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xfa44bab4, 69 }, /* RCTL */
+    { 0x3a40aeb4, 239 }, /* I239 */
+    { 0xffaaceb5, 456 }, /* KO7 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xbbf8deba, 189 }, /* I172 */
+    { 0x0ba5eaba, 226 }, /* I226 */
+    { 0xb250bebb, 308 }, /* Level2 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xf01edec3, 115 }, /* KPEN */
+    { 0, XKB_ATOM_NONE },
+    { 0x3b3586c5, 146 }, /* VOL+ */
+    { 0x72b62ec6, 144 }, /* MUTE */
+    { 0x38dc86c7, 53 }, /* AC11 */
+    { 0xc4abeec6, 198 }, /* I181 */
+    { 0x7605a2c9, 260 }, /* Caps Lock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x393c92cd, 25 }, /* BKSP */
+    { 0x13d1c6ce, 317 }, /* RAlt */
+    { 0xa243cecf, 234 }, /* I234 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x3ab30ad2, 248 }, /* I248 */
+    { 0x25f136d3, 212 }, /* I212 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x49f5fad9, 82 }, /* FK07 */
+    { 0x8eb65ada, 135 }, /* MUHE */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x4e7a0adf, 271 }, /* ALGR */
+    { 0xf005cae0, 377 }, /* latchMods */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x06b7d2e5, 363 }, /* SEPARATE_CAPS_AND_SHIFT_ALPHABETIC */
+    { 0xefdbb2e6, 267 }, /* Mute */
+    { 0, XKB_ATOM_NONE },
+    { 0x9cc5b2e8, 56 }, /* AB02 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x0c7bcef0, 157 }, /* CUT */
+    { 0xa2c7faf1, 44 }, /* AC02 */
+    { 0x76ad4ef0, 173 }, /* I156 */
+    { 0x35b302f3, 238 }, /* I238 */
+    { 0x60cc52f4, 307 }, /* TWO_LEVEL */
+    { 0xe5499af0, 329 }, /* Level3 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xeba502fc, 338 }, /* Level7 */
+    { 0, XKB_ATOM_NONE },
+    { 0x85659afe, 454 }, /* symbols */
+    { 0, XKB_ATOM_NONE },
+    { 0xc4d48b00, 256 }, /* ALT */
+    { 0x2dd58300, 408 }, /* defaultButton */
+    { 0x7b5f7302, 92 }, /* HOME */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x1931170d, 87 }, /* FK12 */
+    { 0x76979f0e, 310 }, /* ALPHABETIC */
+    { 0x46a6070f, 132 }, /* HKTG */
+    { 0, XKB_ATOM_NONE },
+    { 0xccb01f11, 165 }, /* I148 */
+    { 0xea09a312, 371 }, /* interpret */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x795c1716, 292 }, /* LatZ */
+    { 0, XKB_ATOM_NONE },
+    { 0x3138c718, 4 }, /* Mod1 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x8db0bf1b, 283 }, /* LatA */
+    { 0xb8a1731c, 10 }, /* maximum */
+    { 0x4b06a71d, 258 }, /* SUPR */
+    { 0x987ba71e, 131 }, /* HZTG */
+    { 0x8c28a71d, 400 }, /* MovePtr */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xdcdeff28, 220 }, /* I220 */
+    { 0xd3310f28, 341 }, /* Ctrl */
+    { 0x4bfceb29, 464 }, /* KO3 */
+    { 0xdcdeff28, 476 }, /* I20 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x21a2a331, 268 }, /* Misc */
+    { 0xdff46332, 130 }, /* FK24 */
+    { 0xb5305b33, 36 }, /* AD10 */
+    { 0xf2403334, 164 }, /* I147 */
+    { 0xf86a6335, 426 }, /* Overlay2 */
+    { 0x57dbef32, 474 }, /* I10 */
+    { 0x831c8b37, 80 }, /* FK05 */
+    { 0x9cdf2b33, 479 }, /* I2E */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xd1ac033d, 168 }, /* I151 */
+    { 0x7909ef3d, 366 }, /* FOUR_LEVEL_PLUS_LOCK */
+    { 0x2acfe33f, 105 }, /* KP7 */
+    { 0, XKB_ATOM_NONE },
+    { 0x47c48f41, 414 }, /* controls */
+    { 0x04e6a741, 452 }, /* KIDN */
+    { 0x3c0dc343, 88 }, /* PRSC */
+    { 0x167a5b43, 280 }, /* LatI */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xe6200347, 469 }, /* Alt_R */
+    { 0xfc415348, 47 }, /* AC05 */
+    { 0x466c2b49, 39 }, /* BKSL */
+    { 0x62479f49, 227 }, /* I227 */
+    { 0x02856b4b, 305 }, /* level_name */
+    { 0, XKB_ATOM_NONE },
+    { 0x2e5afb4d, 78 }, /* FK03 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x7bba2750, 453 }, /* KIUP */
+    { 0x02439b51, 59 }, /* AB05 */
+    { 0, XKB_ATOM_NONE },
+    { 0x52dbe753, 177 }, /* I160 */
+    { 0x7892a754, 375 }, /* clearLocks */
+    { 0x9d931f55, 223 }, /* I223 */
+    { 0x52ca2b56, 407 }, /* affect */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x18ab4f5b, 415 }, /* MouseKeys */
+    { 0x41e41f5c, 51 }, /* AC09 */
+    { 0x01217f5d, 344 }, /* Shift Level3 Ctrl */
+    { 0x33c0775e, 321 }, /* Super */
+    { 0xf91acf5f, 327 }, /* PC_RALT_LEVEL2 */
+    { 0xd089bb60, 125 }, /* FK19 */
+    { 0x288bab61, 190 }, /* I173 */
+    { 0x2742cf62, 166 }, /* I149 */
+    { 0x2f73735f, 380 }, /* action */
+    { 0x779c0762, 486 }, /* I66 */
+    { 0x47e66765, 63 }, /* AB09 */
+    { 0x3697ab66, 106 }, /* KP8 */
+    { 0x62e74367, 151 }, /* UNDO */
+    { 0x83ad6367, 203 }, /* I186 */
+    { 0x4596af68, 291 }, /* LatL */
+    { 0x19e3976a, 269 }, /* Mail */
+    { 0x05bea76b, 148 }, /* STOP */
+    { 0xc9078b65, 302 }, /* None */
+    { 0x3d40b36d, 209 }, /* I209 */
+    { 0xb195db6a, 461 }, /* KO6 */
+    { 0x72219b6f, 145 }, /* VOL- */
+    { 0xd2ae4367, 473 }, /* I01 */
+    { 0xa441935e, 503 }, /* I194 */
+    { 0x9b9bcf72, 118 }, /* KPEQ */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x90ec9b75, 143 }, /* RMTA */
+    { 0xc1a9ab76, 251 }, /* I251 */
+    { 0, XKB_ATOM_NONE },
+    { 0x345bd378, 389 }, /* Shift Lock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x37efcb7b, 405 }, /* default */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x9f418b7f, 181 }, /* I164 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x6d7c6b83, 152 }, /* FRNT */
+    { 0x62b7b383, 482 }, /* K6C */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x28f13b8c, 242 }, /* I242 */
+    { 0x85afff8d, 284 }, /* LatS */
+    { 0x789e478c, 498 }, /* I76 */
+    { 0x2afa778f, 376 }, /* True */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb9f8db94, 169 }, /* I152 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x44ccdf9a, 411 }, /* lock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x9a10d79d, 504 }, /* I195 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x757c77a0, 3 }, /* Control */
+    { 0x62f38ba0, 97 }, /* UP */
+    { 0xabd72ba2, 13 }, /* AE01 */
+    { 0x8299d7a0, 312 }, /* Alt */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xedbc9ba8, 96 }, /* PGDN */
+    { 0x79ad53a9, 183 }, /* I166 */
+    { 0x3cdecbaa, 133 }, /* AB11 */
+    { 0xb1d973ab, 27 }, /* AD01 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x69f91bb0, 277 }, /* LatT */
+    { 0xf2001bb0, 395 }, /* LockGroup */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x8f0e87b5, 245 }, /* I245 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xaedfdfb9, 466 }, /* KODL */
+    { 0xc4f92bba, 2 }, /* Lock */
+    { 0x781e5fba, 54 }, /* LFSH */
+    { 0x4ecc6fbc, 89 }, /* SCLK */
+    { 0xb3ddefbd, 409 }, /* count */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xa30c33c0, 393 }, /* LatchMods */
+    { 0x0d7603c1, 397 }, /* groups */
+    { 0xd5b027c2, 254 }, /* LVL3 */
+    { 0, XKB_ATOM_NONE },
+    { 0xab8c87c4, 455 }, /* overlay1 */
+    { 0, XKB_ATOM_NONE },
+    { 0xaefe7fc6, 391 }, /* whichModState */
+    { 0xa6d70bc7, 14 }, /* AE02 */
+    { 0xdd884bc7, 41 }, /* RTRN */
+    { 0xdb5397c7, 298 }, /* LatM */
+    { 0x5fdbfbca, 207 }, /* I190 */
+    { 0x050147ca, 272 }, /* KPPT */
+    { 0x5e8fe3c7, 306 }, /* Any */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xb745a7cf, 101 }, /* NMLK */
+    { 0xb8a943d0, 488 }, /* I68 */
+    { 0x21d3fbd1, 38 }, /* AD12 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x915cefd4, 288 }, /* LatH */
+    { 0x16ac8fd5, 446 }, /* Control_R */
+    { 0x8a0e7fd6, 215 }, /* I215 */
+    { 0xb797a7d4, 465 }, /* KO0 */
+    { 0x09a45fd8, 15 }, /* AE03 */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x2831dfdf, 378 }, /* latchToLock */
+    { 0xb6dbcbe0, 360 }, /* FOUR_LEVEL_MIXED_KEYPAD */
+    { 0xdfdf03e1, 210 }, /* I210 */
+    { 0x3a878fe1, 274 }, /* LatW */
+    { 0x903aafdf, 444 }, /* Caps_Lock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x20a093e6, 261 }, /* Num Lock */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xe5e14bea, 480 }, /* I30 */
+    { 0xcab01beb, 185 }, /* I168 */
+    { 0, XKB_ATOM_NONE },
+    { 0xf54037ed, 194 }, /* I177 */
+    { 0xf090e7ee, 276 }, /* LatR */
+    { 0x54684bef, 362 }, /* FOUR_LEVEL_X */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0x545fa7f7, 402 }, /* y */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+    { 0xf13e73fc, 419 }, /* AccessXKeys */
+    { 0xc9f82ffd, 147 }, /* POWR */
+    { 0, XKB_ATOM_NONE },
+    { 0, XKB_ATOM_NONE },
+};
@@ -73,6 +73,7 @@
 #include "config.h"
 
 #include "utils.h"
+#include "thread.h"
 #include "atom.h"
 
 /* FNV-1a (http://www.isthe.com/chongo/tech/comp/fnv/). */
@@ -90,33 +91,157 @@ hash_buf(const char *string, size_t len)
 }
 
 /*
- * The atom table is a insert-only unbalanced binary search tree
- * mapping strings to atoms.
+ * The atom table is an insert-only hash table mapping strings to atoms.
  *
- * The tree nodes are kept contiguously in the `table` array.
+ * Well-known names (see src/atom-seeds.txt) are pre-seeded in a static,
+ * read-only table shared by all atom tables, and always get the atoms
+ * 1..NUM_SEED_ATOMS. Only other strings are added to a given table.
  *
- * The atom value is the index of the tree node in the array.
+ * So that several threads can intern strings concurrently, the table is
+ * split into shards, each with its own lock; the top bits of the string's
+ * fingerprint (hash) pick the shard. A dynamic atom encodes the shard and
+ * the index of the string in the shard:
+ *      atom = FIRST_DYNAMIC_ATOM + (index << ATOM_SHARD_BITS | shard)
  *
- * As an optimization, strings are not compared by value directly,
- *      s1 < s2
- * instead, they are compared by fingerprint (hash) and the value
- * is only used to resolve collisions:
- *      (fingerprint(s1), s1) < (fingerprint(s2), s2)
- * Fingerprint are pre-calculated and saved in the tree nodes.
+ * Pointers to the strings of a shard are kept in blocks of doubling size,
+ * which are never moved once allocated, so atom_text() can be done
+ * without taking the lock. The strings themselves are NUL-terminated and
+ * packed one after the other into append-only chunks, so interning
+ * doesn't allocate for every new string, and freeing the table only needs
+ * to free the chunks.
  *
- * Why is this not just a hash table? Who knows!
+ * The `index` of a shard is an open-addressing hash table (linear probing,
+ * power of two size) from string to atom. Each slot also carries the
+ * fingerprint of its string, so probing only needs to compare the actual
+ * strings when the fingerprints match, and growing the index does not
+ * need to rehash anything. An empty slot has atom XKB_ATOM_NONE.
  */
-struct atom_node {
-    xkb_atom_t left, right;
+struct atom_slot {
     uint32_t fingerprint;
-    char *string;
+    xkb_atom_t atom;
+};
+
+#include "atom-seeds.h"
+
+#define FIRST_DYNAMIC_ATOM (NUM_SEED_ATOMS + 1)
+
+#define ATOM_SHARD_BITS 3
+#define ATOM_NUM_SHARDS (1u << ATOM_SHARD_BITS)
+
+/*
+ * Block b holds ATOM_BLOCK_BASE << b strings. The number of blocks is
+ * limited so that all atoms fit in an xkb_atom_t.
+ */
+#define ATOM_BLOCK_BASE 64
+#define ATOM_MAX_BLOCKS 22
+
+/* Must be a power of two. */
+#define ATOM_INDEX_INITIAL_SIZE 64
+#define ATOM_CHUNK_SIZE 2048
+
+struct atom_chunk {
+    struct atom_chunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct atom_shard {
+    xkb_mutex_t lock;
+    struct atom_slot *index;
+    size_t index_size;
+    size_t num_strings;
+    const char **blocks[ATOM_MAX_BLOCKS];
+    /* The chunk currently being filled is first. */
+    struct atom_chunk *chunks;
 };
 
 struct atom_table {
-    xkb_atom_t root;
-    darray(struct atom_node) table;
+    struct atom_shard shards[ATOM_NUM_SHARDS];
 };
 
+static struct atom_chunk *
+atom_chunk_new(size_t size)
+{
+    struct atom_chunk *chunk = malloc(sizeof(*chunk) + size);
+    if (!chunk)
+        return NULL;
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+/* Copy the string into the chunks, and return the stored copy. */
+static const char *
+atom_chunk_store(struct atom_shard *shard, const char *string, size_t len)
+{
+    struct atom_chunk *chunk = shard->chunks;
+    char *copy;
+
+    if (!chunk || chunk->size - chunk->used < len + 1) {
+        if (len + 1 > ATOM_CHUNK_SIZE / 4) {
+            /*
+             * Give big strings a chunk of their own, and keep filling
+             * the current one.
+             */
+            chunk = atom_chunk_new(len + 1);
+            if (!chunk)
+                return NULL;
+            if (shard->chunks) {
+                chunk->next = shard->chunks->next;
+                shard->chunks->next = chunk;
+            }
+            else {
+                shard->chunks = chunk;
+            }
+        }
+        else {
+            chunk = atom_chunk_new(ATOM_CHUNK_SIZE);
+            if (!chunk)
+                return NULL;
+            chunk->next = shard->chunks;
+            shard->chunks = chunk;
+        }
+    }
+
+    copy = &chunk->data[chunk->used];
+    memcpy(copy, string, len);
+    copy[len] = '\0';
+    chunk->used += len + 1;
+    return copy;
+}
+
+/* Find the block and the position in it of the string at @idx. */
+static inline const char **
+atom_shard_string(struct atom_shard *shard, size_t idx)
+{
+    unsigned block = msb_pos(idx / ATOM_BLOCK_BASE + 1) - 1;
+    size_t block_start = ATOM_BLOCK_BASE * ((1u << block) - 1);
+    return &shard->blocks[block][idx - block_start];
+}
+
+static void
+atom_table_free_shards(struct atom_table *table, unsigned num_shards)
+{
+    for (unsigned i = 0; i < num_shards; i++) {
+        struct atom_shard *shard = &table->shards[i];
+        struct atom_chunk *chunk = shard->chunks;
+
+        while (chunk) {
+            struct atom_chunk *next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        for (unsigned j = 0; j < ATOM_MAX_BLOCKS; j++)
+            free(shard->blocks[j]);
+        free(shard->index);
+        mutex_destroy(&shard->lock);
+    }
+    free(table);
+}
+
 struct atom_table *
 atom_table_new(void)
 {
@@ -124,9 +249,18 @@ atom_table_new(void)
     if (!table)
         return NULL;
 
-    darray_init(table->table);
-    /* The original throw-away root is here, at the illegal atom 0. */
-    darray_resize0(table->table, 1);
+    for (unsigned i = 0; i < ATOM_NUM_SHARDS; i++) {
+        struct atom_shard *shard = &table->shards[i];
+
+        mutex_init(&shard->lock);
+        shard->index_size = ATOM_INDEX_INITIAL_SIZE;
+        shard->index = calloc(shard->index_size, sizeof(*shard->index));
+        if (!shard->index) {
+            /* Only the shards up to this one have their lock set up. */
+            atom_table_free_shards(table, i + 1);
+            return NULL;
+        }
+    }
 
     return table;
 }
@@ -137,61 +271,156 @@ atom_table_free(struct atom_table *table)
     if (!table)
         return;
 
-    struct atom_node *node;
-    darray_foreach(node, table->table)
-        free(node->string);
-    darray_free(table->table);
-    free(table);
+    atom_table_free_shards(table, ATOM_NUM_SHARDS);
 }
 
 const char *
 atom_text(struct atom_table *table, xkb_atom_t atom)
 {
-    assert(atom < darray_size(table->table));
-    return darray_item(table->table, atom).string;
+    if (atom == XKB_ATOM_NONE)
+        return NULL;
+
+    if (atom < FIRST_DYNAMIC_ATOM)
+        return &seed_atom_strings[seed_atom_offsets[atom - 1]];
+
+    atom -= FIRST_DYNAMIC_ATOM;
+    return *atom_shard_string(&table->shards[atom % ATOM_NUM_SHARDS],
+                              atom >> ATOM_SHARD_BITS);
 }
 
-xkb_atom_t
-atom_intern(struct atom_table *table, const char *string, size_t len, bool add)
+static xkb_atom_t
+seed_atom_lookup(uint32_t fingerprint, const char *string, size_t len)
 {
-    uint32_t fingerprint = hash_buf(string, len);
+    const size_t mask = SEED_ATOM_INDEX_SIZE - 1;
+    size_t pos = fingerprint & mask;
 
-    xkb_atom_t *atomp = &table->root;
-    while (*atomp != XKB_ATOM_NONE) {
-        struct atom_node *node = &darray_item(table->table, *atomp);
+    for (;;) {
+        const struct atom_slot *slot = &seed_atom_index[pos];
 
-        if (fingerprint > node->fingerprint) {
-            atomp = &node->right;
-        }
-        else if (fingerprint < node->fingerprint) {
-            atomp = &node->left;
+        if (slot->atom == XKB_ATOM_NONE)
+            return XKB_ATOM_NONE;
+
+        if (slot->fingerprint == fingerprint) {
+            const char *existing =
+                &seed_atom_strings[seed_atom_offsets[slot->atom - 1]];
+            if (strncmp(string, existing, len) == 0 && existing[len] == '\0')
+                return slot->atom;
         }
-        else {
-            /* Now start testing the strings. */
-            const int cmp = strncmp(string, node->string, len);
-            if (likely(cmp == 0 && node->string[len] == '\0')) {
-                return *atomp;
-            }
-            else if (cmp > 0) {
-                atomp = &node->right;
-            }
-            else {
-                atomp = &node->left;
-            }
+
+        pos = (pos + 1) & mask;
+    }
+}
+
+static bool
+atom_index_grow(struct atom_shard *shard)
+{
+    size_t new_size = shard->index_size * 2;
+    size_t mask = new_size - 1;
+    struct atom_slot *new_index = calloc(new_size, sizeof(*new_index));
+    if (!new_index)
+        return false;
+
+    for (size_t i = 0; i < shard->index_size; i++) {
+        const struct atom_slot *slot = &shard->index[i];
+        if (slot->atom == XKB_ATOM_NONE)
+            continue;
+
+        size_t pos = slot->fingerprint & mask;
+        while (new_index[pos].atom != XKB_ATOM_NONE)
+            pos = (pos + 1) & mask;
+        new_index[pos] = *slot;
+    }
+
+    free(shard->index);
+    shard->index = new_index;
+    shard->index_size = new_size;
+    return true;
+}
+
+static xkb_atom_t
+atom_shard_intern(struct atom_shard *shard, unsigned shard_num,
+                  uint32_t fingerprint, const char *string, size_t len,
+                  bool add)
+{
+    size_t mask = shard->index_size - 1;
+    size_t pos = fingerprint & mask;
+    const char *copy;
+    const char **blockp;
+    unsigned block;
+    size_t idx;
+
+    for (;;) {
+        const struct atom_slot *slot = &shard->index[pos];
+
+        if (slot->atom == XKB_ATOM_NONE)
+            break;
+
+        if (slot->fingerprint == fingerprint) {
+            xkb_atom_t existing_idx =
+                (slot->atom - FIRST_DYNAMIC_ATOM) >> ATOM_SHARD_BITS;
+            const char *existing = *atom_shard_string(shard, existing_idx);
+            if (likely(strncmp(string, existing, len) == 0 &&
+                       existing[len] == '\0'))
+                return slot->atom;
         }
+
+        pos = (pos + 1) & mask;
     }
 
     if (!add)
         return XKB_ATOM_NONE;
 
-    struct atom_node node;
-    node.string = strndup(string, len);
-    assert(node.string != NULL);
-    node.left = node.right = XKB_ATOM_NONE;
-    node.fingerprint = fingerprint;
-    xkb_atom_t atom = darray_size(table->table);
-    /* Do this before the append, as it may realloc and change the offsets. */
-    *atomp = atom;
-    darray_append(table->table, node);
+    idx = shard->num_strings;
+
+    /* Keep the load factor at most 3/4, so probe sequences stay short. */
+    if ((idx + 1) * 4 > shard->index_size * 3) {
+        if (!atom_index_grow(shard))
+            return XKB_ATOM_NONE;
+        mask = shard->index_size - 1;
+        pos = fingerprint & mask;
+        while (shard->index[pos].atom != XKB_ATOM_NONE)
+            pos = (pos + 1) & mask;
+    }
+
+    block = msb_pos(idx / ATOM_BLOCK_BASE + 1) - 1;
+    if (block >= ATOM_MAX_BLOCKS)
+        return XKB_ATOM_NONE;
+    if (!shard->blocks[block]) {
+        shard->blocks[block] =
+            calloc((size_t) ATOM_BLOCK_BASE << block, sizeof(const char *));
+        if (!shard->blocks[block])
+            return XKB_ATOM_NONE;
+    }
+
+    copy = atom_chunk_store(shard, string, len);
+    if (!copy)
+        return XKB_ATOM_NONE;
+
+    blockp = atom_shard_string(shard, idx);
+    *blockp = copy;
+    shard->num_strings++;
+
+    shard->index[pos].fingerprint = fingerprint;
+    shard->index[pos].atom =
+        FIRST_DYNAMIC_ATOM + (xkb_atom_t) (idx << ATOM_SHARD_BITS | shard_num);
+    return shard->index[pos].atom;
+}
+
+xkb_atom_t
+atom_intern(struct atom_table *table, const char *string, size_t len, bool add)
+{
+    uint32_t fingerprint = hash_buf(string, len);
+    unsigned shard_num = fingerprint >> (32 - ATOM_SHARD_BITS);
+    struct atom_shard *shard = &table->shards[shard_num];
+    xkb_atom_t atom;
+
+    atom = seed_atom_lookup(fingerprint, string, len);
+    if (atom != XKB_ATOM_NONE)
+        return atom;
+
+    mutex_lock(&shard->lock);
+    atom = atom_shard_intern(shard, shard_num, fingerprint, string, len, add);
+    mutex_unlock(&shard->lock);
+
     return atom;
 }
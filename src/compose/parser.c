@@ -126,9 +126,9 @@ lex(struct scanner *s, union lvalue *val)
 {
 skip_more_whitespace_and_comments:
     /* Skip spaces. */
-    while (is_space(peek(s)))
-        if (next(s) == '\n')
-            return TOK_END_OF_LINE;
+    s->pos += span_space(s, false);
+    if (chr(s, '\n'))
+        return TOK_END_OF_LINE;
 
     /* Skip comments. */
     if (chr(s, '#')) {
@@ -140,8 +140,7 @@ skip_more_whitespace_and_comments:
     if (eof(s)) return TOK_END_OF_FILE;
 
     /* New token. */
-    s->token_line = s->line;
-    s->token_column = s->column;
+    scanner_token_start(s);
     s->buf_pos = 0;
 
     /* LHS Keysym. */
@@ -171,30 +170,28 @@ skip_more_whitespace_and_comments:
 
     /* String literal. */
     if (chr(s, '\"')) {
-        while (!eof(s) && !eol(s) && peek(s) != '\"') {
+        uint8_t o;
+
+        /* Copy up to the end of the string or the next escape. */
+        while (buf_append_span(s, span_string(s)), chr(s, '\\')) {
             if (chr(s, '\\')) {
-                uint8_t o;
-                if (chr(s, '\\')) {
-                    buf_append(s, '\\');
-                }
-                else if (chr(s, '"')) {
-                    buf_append(s, '"');
-                }
-                else if (chr(s, 'x') || chr(s, 'X')) {
-                    if (hex(s, &o))
-                        buf_append(s, (char) o);
-                    else
-                        scanner_warn(s, "illegal hexadecimal escape sequence in string literal");
-                }
-                else if (oct(s, &o)) {
+                buf_append(s, '\\');
+            }
+            else if (chr(s, '"')) {
+                buf_append(s, '"');
+            }
+            else if (chr(s, 'x') || chr(s, 'X')) {
+                if (hex(s, &o))
                     buf_append(s, (char) o);
-                }
-                else {
-                    scanner_warn(s, "unknown escape sequence (%c) in string literal", peek(s));
-                    /* Ignore. */
-                }
-            } else {
-                buf_append(s, next(s));
+                else
+                    scanner_warn(s, "illegal hexadecimal escape sequence in string literal");
+            }
+            else if (oct(s, &o)) {
+                buf_append(s, (char) o);
+            }
+            else {
+                scanner_warn(s, "unknown escape sequence (%c) in string literal", peek(s));
+                /* Ignore. */
             }
         }
         if (!chr(s, '\"')) {
@@ -217,9 +214,7 @@ skip_more_whitespace_and_comments:
     /* Identifier or include. */
     if (is_alpha(peek(s)) || peek(s) == '_') {
         s->buf_pos = 0;
-        while (is_alnum(peek(s)) || peek(s) == '_')
-            buf_append(s, next(s));
-        if (!buf_append(s, '\0')) {
+        if (!buf_append_span(s, span_ident(s)) || !buf_append(s, '\0')) {
             scanner_err(s, "identifier is too long");
             return TOK_ERROR;
         }
@@ -247,8 +242,7 @@ lex_include_string(struct scanner *s, struct xkb_compose_table *table,
         if (next(s) == '\n')
             return TOK_END_OF_LINE;
 
-    s->token_line = s->line;
-    s->token_column = s->column;
+    scanner_token_start(s);
     s->buf_pos = 0;
 
     if (!chr(s, '\"')) {
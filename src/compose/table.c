@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include "utils.h"
+#include "thread.h"
 #include "table.h"
 #include "parser.h"
 #include "paths.h"
@@ -73,14 +74,14 @@ xkb_compose_table_new(struct xkb_context *ctx,
 XKB_EXPORT struct xkb_compose_table *
 xkb_compose_table_ref(struct xkb_compose_table *table)
 {
-    table->refcnt++;
+    refcnt_inc(&table->refcnt);
     return table;
 }
 
 XKB_EXPORT void
 xkb_compose_table_unref(struct xkb_compose_table *table)
 {
-    if (!table || --table->refcnt > 0)
+    if (!table || refcnt_dec(&table->refcnt) > 0)
         return;
     free(table->locale);
     darray_free(table->nodes);
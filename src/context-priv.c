@@ -32,6 +32,7 @@
 
 #include "xkbcommon/xkbcommon.h"
 #include "utils.h"
+#include "thread.h"
 #include "context.h"
 
 unsigned int
@@ -68,6 +69,17 @@ xkb_atom_text(struct xkb_context *ctx, xkb_atom_t atom)
     return atom_text(ctx->atom_table, atom);
 }
 
+/*
+ * See xkb_log_capture_start(). Without thread-local storage, the capture
+ * is per context, like the text buffer.
+ */
+#ifdef HAVE_THREAD_LOCAL
+static THREAD_LOCAL darray_log_message *log_capture;
+#define LOG_CAPTURE(ctx) log_capture
+#else
+#define LOG_CAPTURE(ctx) ((ctx)->log_capture)
+#endif
+
 void
 xkb_log(struct xkb_context *ctx, enum xkb_log_level level, int verbosity,
         const char *fmt, ...)
@@ -78,27 +90,88 @@ xkb_log(struct xkb_context *ctx, enum xkb_log_level level, int verbosity,
         return;
 
     va_start(args, fmt);
-    ctx->log_fn(ctx, level, fmt, args);
+    if (LOG_CAPTURE(ctx)) {
+        struct xkb_log_message message = { .level = level };
+        if (vasprintf(&message.text, fmt, args) >= 0)
+            darray_append(*LOG_CAPTURE(ctx), message);
+    }
+    else {
+        ctx->log_fn(ctx, level, fmt, args);
+    }
     va_end(args);
 }
 
+darray_log_message *
+xkb_log_capture_start(struct xkb_context *ctx, darray_log_message *messages)
+{
+    darray_log_message *previous = LOG_CAPTURE(ctx);
+
+    LOG_CAPTURE(ctx) = messages;
+    return previous;
+}
+
+void
+xkb_log_capture_stop(struct xkb_context *ctx, darray_log_message *previous)
+{
+    LOG_CAPTURE(ctx) = previous;
+}
+
+void
+xkb_log_replay(struct xkb_context *ctx, darray_log_message *messages)
+{
+    struct xkb_log_message *message;
+
+    darray_foreach(message, *messages)
+        xkb_log(ctx, message->level, 0, "%s", message->text);
+    xkb_log_discard(messages);
+}
+
+void
+xkb_log_discard(darray_log_message *messages)
+{
+    struct xkb_log_message *message;
+
+    darray_foreach(message, *messages)
+        free(message->text);
+    darray_free(*messages);
+}
+
+/*
+ * Buffer for the *Text() functions. It is per thread rather than per
+ * context, so that several threads can use the same context. Without
+ * thread-local storage, it falls back to being per context, which then
+ * must not be used by several threads, but other contexts still may.
+ */
+#ifdef HAVE_THREAD_LOCAL
+static THREAD_LOCAL char text_buffer[2048];
+static THREAD_LOCAL size_t text_next;
+#else
+#define text_buffer (ctx->text_buffer)
+#define text_next (ctx->text_next)
+#endif
+
 char *
 xkb_context_get_buffer(struct xkb_context *ctx, size_t size)
 {
     char *rtrn;
 
-    if (size >= sizeof(ctx->text_buffer))
+    if (size >= sizeof(text_buffer))
         return NULL;
 
-    if (sizeof(ctx->text_buffer) - ctx->text_next <= size)
-        ctx->text_next = 0;
+    if (sizeof(text_buffer) - text_next <= size)
+        text_next = 0;
 
-    rtrn = &ctx->text_buffer[ctx->text_next];
-    ctx->text_next += size;
+    rtrn = &text_buffer[text_next];
+    text_next += size;
 
     return rtrn;
 }
 
+#ifndef HAVE_THREAD_LOCAL
+#undef text_buffer
+#undef text_next
+#endif
+
 #ifndef DEFAULT_XKB_VARIANT
 #define DEFAULT_XKB_VARIANT NULL
 #endif
@@ -183,3 +256,39 @@ xkb_context_sanitize_rule_names(struct xkb_context *ctx,
     if (rmlvo->options == NULL)
         rmlvo->options = xkb_context_get_default_options(ctx);
 }
+
+/*
+ * Appends to @key a string which identifies what @rmlvo (sanitized)
+ * resolves to in @ctx: the names, followed by the include path of the
+ * context. Each string is NUL-terminated.
+ */
+void
+xkb_context_rule_names_key(struct xkb_context *ctx,
+                           const struct xkb_rule_names *rmlvo,
+                           darray_char *key)
+{
+    const char *names[] = {
+        rmlvo->rules, rmlvo->model, rmlvo->layout,
+        rmlvo->variant, rmlvo->options,
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+        darray_append_string(*key, names[i] ? names[i] : "");
+        darray_append(*key, '\0');
+    }
+
+    xkb_context_include_paths_key(ctx, key);
+}
+
+/*
+ * Appends the include path of @ctx to @key, each directory NUL-terminated,
+ * for keys of what a keymap compiled in @ctx may depend on.
+ */
+void
+xkb_context_include_paths_key(struct xkb_context *ctx, darray_char *key)
+{
+    for (unsigned i = 0; i < xkb_context_num_include_paths(ctx); i++) {
+        darray_append_string(*key, xkb_context_include_path_get(ctx, i));
+        darray_append(*key, '\0');
+    }
+}
@@ -41,6 +41,7 @@
 
 #include "xkbcommon/xkbcommon.h"
 #include "utils.h"
+#include "thread.h"
 #include "context.h"
 
 /**
@@ -184,7 +185,7 @@ xkb_context_include_path_get(struct xkb_context *ctx, unsigned int idx)
 XKB_EXPORT struct xkb_context *
 xkb_context_ref(struct xkb_context *ctx)
 {
-    ctx->refcnt++;
+    refcnt_inc(&ctx->refcnt);
     return ctx;
 }
 
@@ -195,14 +196,41 @@ xkb_context_ref(struct xkb_context *ctx)
 XKB_EXPORT void
 xkb_context_unref(struct xkb_context *ctx)
 {
-    if (!ctx || --ctx->refcnt > 0)
+    int refcnt;
+
+    if (!ctx)
+        return;
+
+    /* This drops the cached keymaps if they hold the last references. */
+    if (ctx->keymap_cache)
+        refcnt = keymap_cache_unref_context(ctx->keymap_cache, &ctx->refcnt);
+    else
+        refcnt = refcnt_dec(&ctx->refcnt);
+    if (refcnt > 0)
         return;
 
     xkb_context_include_path_clear(ctx);
+    include_cache_free(ctx->include_cache);
+    keymap_cache_free(ctx->keymap_cache);
+    rules_cache_free(ctx->rules_cache);
     atom_table_free(ctx->atom_table);
     free(ctx);
 }
 
+/**
+ * Drop the keymaps and files cached by the context.
+ */
+XKB_EXPORT void
+xkb_context_clear_cache(struct xkb_context *ctx)
+{
+    if (ctx->include_cache)
+        include_cache_clear(ctx->include_cache);
+    if (ctx->keymap_cache)
+        keymap_cache_clear(ctx->keymap_cache);
+    if (ctx->rules_cache)
+        rules_cache_clear(ctx->rules_cache);
+}
+
 static const char *
 log_level_to_prefix(enum xkb_log_level level)
 {
@@ -311,6 +339,33 @@ xkb_context_new(enum xkb_context_flags flags)
         return NULL;
     }
 
+    ctx->parallel_includes = !!(flags & XKB_CONTEXT_PARALLEL_INCLUDES);
+
+    if (flags & (XKB_CONTEXT_CACHE_INCLUDES | XKB_CONTEXT_PARALLEL_INCLUDES)) {
+        ctx->include_cache = include_cache_new();
+        if (!ctx->include_cache) {
+            xkb_context_unref(ctx);
+            return NULL;
+        }
+    }
+
+    if (flags & XKB_CONTEXT_CACHE_KEYMAPS) {
+        ctx->keymap_cache = keymap_cache_new();
+        if (!ctx->keymap_cache) {
+            xkb_context_unref(ctx);
+            return NULL;
+        }
+    }
+
+    if (flags & (XKB_CONTEXT_CACHE_INCLUDES | XKB_CONTEXT_CACHE_KEYMAPS |
+                 XKB_CONTEXT_PARALLEL_INCLUDES)) {
+        ctx->rules_cache = rules_cache_new();
+        if (!ctx->rules_cache) {
+            xkb_context_unref(ctx);
+            return NULL;
+        }
+    }
+
     return ctx;
 }
 
@@ -27,6 +27,13 @@
 #define CONTEXT_H
 
 #include "atom.h"
+#include "thread.h"
+
+struct xkb_log_message {
+    enum xkb_log_level level;
+    char *text;
+};
+typedef darray(struct xkb_log_message) darray_log_message;
 
 struct xkb_context {
     int refcnt;
@@ -45,13 +52,58 @@ struct xkb_context {
 
     struct atom_table *atom_table;
 
-    /* Buffer for the *Text() functions. */
-    char text_buffer[2048];
-    size_t text_next;
+    /* Parsed include files, if XKB_CONTEXT_CACHE_INCLUDES; see include.c. */
+    struct include_cache *include_cache;
+    /* Keymaps compiled from names, if XKB_CONTEXT_CACHE_KEYMAPS; see keymap.c. */
+    struct keymap_cache *keymap_cache;
+    /* Rules files read so far, if any caching flag; see rules.c. */
+    struct rules_cache *rules_cache;
 
     unsigned int use_environment_names : 1;
+    /* XKB_CONTEXT_PARALLEL_INCLUDES; see XkbPrefetchIncludes(). */
+    unsigned int parallel_includes : 1;
+
+#ifndef HAVE_THREAD_LOCAL
+    /*
+     * Without thread-local storage, see xkb_context_get_buffer() and
+     * xkb_log_capture_start().
+     */
+    char text_buffer[2048];
+    size_t text_next;
+    darray_log_message *log_capture;
+#endif
 };
 
+struct include_cache *
+include_cache_new(void);
+
+void
+include_cache_clear(struct include_cache *cache);
+
+void
+include_cache_free(struct include_cache *cache);
+
+struct keymap_cache *
+keymap_cache_new(void);
+
+int
+keymap_cache_unref_context(struct keymap_cache *cache, int *refcnt);
+
+void
+keymap_cache_clear(struct keymap_cache *cache);
+
+void
+keymap_cache_free(struct keymap_cache *cache);
+
+struct rules_cache *
+rules_cache_new(void);
+
+void
+rules_cache_clear(struct rules_cache *cache);
+
+void
+rules_cache_free(struct rules_cache *cache);
+
 unsigned int
 xkb_context_num_failed_include_paths(struct xkb_context *ctx);
 
@@ -94,10 +146,40 @@ ATTR_PRINTF(4, 5) void
 xkb_log(struct xkb_context *ctx, enum xkb_log_level level, int verbosity,
         const char *fmt, ...);
 
+/*
+ * Until xkb_log_capture_stop(), the messages logged from the calling
+ * thread are appended to @messages, instead of being passed to the log
+ * function. This is for work done in other threads than the caller's, or
+ * to find out whether some work logged anything: xkb_log_replay() then
+ * logs the messages from the caller's thread.
+ *
+ * Captures nest: xkb_log_capture_start() returns the capture it replaces,
+ * which xkb_log_capture_stop() must be passed to restore it.
+ */
+darray_log_message *
+xkb_log_capture_start(struct xkb_context *ctx, darray_log_message *messages);
+
+void
+xkb_log_capture_stop(struct xkb_context *ctx, darray_log_message *previous);
+
+void
+xkb_log_replay(struct xkb_context *ctx, darray_log_message *messages);
+
+void
+xkb_log_discard(darray_log_message *messages);
+
 void
 xkb_context_sanitize_rule_names(struct xkb_context *ctx,
                                 struct xkb_rule_names *rmlvo);
 
+void
+xkb_context_rule_names_key(struct xkb_context *ctx,
+                           const struct xkb_rule_names *rmlvo,
+                           darray_char *key);
+
+void
+xkb_context_include_paths_key(struct xkb_context *ctx, darray_char *key);
+
 /*
  * The format is not part of the argument list in order to avoid the
  * "ISO C99 requires rest arguments to be used" warning when only the
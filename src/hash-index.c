@@ -0,0 +1,159 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "hash-index.h"
+
+#define HASH_INDEX_MIN_SIZE 16
+#define EMPTY HASH_INDEX_END
+
+/* Keys are often small consecutive numbers, so mix them first. */
+static inline uint32_t
+hash_pos(const struct hash_index *index, uint32_t key)
+{
+    key ^= key >> 16;
+    key *= UINT32_C(0x7feb352d);
+    key ^= key >> 15;
+    key *= UINT32_C(0x846ca68b);
+    key ^= key >> 16;
+    return key & (index->size - 1);
+}
+
+void
+hash_index_init(struct hash_index *index)
+{
+    index->entries = NULL;
+    index->size = index->count = 0;
+}
+
+void
+hash_index_free(struct hash_index *index)
+{
+    free(index->entries);
+    hash_index_init(index);
+}
+
+void
+hash_index_steal(struct hash_index *into, struct hash_index *from)
+{
+    hash_index_free(into);
+    *into = *from;
+    hash_index_init(from);
+}
+
+static void
+insert(struct hash_index *index, uint32_t key, uint32_t item)
+{
+    uint32_t pos = hash_pos(index, key);
+
+    while (index->entries[pos].item != EMPTY)
+        pos = (pos + 1) & (index->size - 1);
+    index->entries[pos].key = key;
+    index->entries[pos].item = item;
+    index->count++;
+}
+
+static bool
+grow(struct hash_index *index, uint32_t size)
+{
+    struct hash_index old = *index;
+
+    index->entries = malloc(size * sizeof(*index->entries));
+    if (!index->entries) {
+        index->entries = old.entries;
+        return false;
+    }
+    index->size = size;
+    index->count = 0;
+    for (uint32_t i = 0; i < size; i++)
+        index->entries[i].item = EMPTY;
+
+    /*
+     * Start after an empty entry, so that every run of entries is added
+     * back from its start, wrapping around. Then the entries of a key are
+     * still found in the order they were added.
+     */
+    if (old.size > 0) {
+        uint32_t start = 0;
+        while (old.entries[start].item != EMPTY)
+            start++;
+        for (uint32_t i = 1; i <= old.size; i++) {
+            const struct hash_index_entry *entry =
+                &old.entries[(start + i) & (old.size - 1)];
+            if (entry->item != EMPTY)
+                insert(index, entry->key, entry->item);
+        }
+    }
+
+    free(old.entries);
+    return true;
+}
+
+/* Keep the load factor under 1/2. */
+bool
+hash_index_reserve(struct hash_index *index, uint32_t count)
+{
+    uint32_t size = index->size ? index->size : HASH_INDEX_MIN_SIZE;
+
+    while (count * 2 > size)
+        size *= 2;
+
+    return size == index->size || grow(index, size);
+}
+
+bool
+hash_index_add(struct hash_index *index, uint32_t key, uint32_t item)
+{
+    if (!hash_index_reserve(index, index->count + 1))
+        return false;
+
+    insert(index, key, item);
+    return true;
+}
+
+static uint32_t
+find_from(const struct hash_index *index, uint32_t key, uint32_t pos)
+{
+    for (; index->entries[pos].item != EMPTY;
+         pos = (pos + 1) & (index->size - 1))
+        if (index->entries[pos].key == key)
+            return pos;
+
+    return HASH_INDEX_END;
+}
+
+uint32_t
+hash_index_first(const struct hash_index *index, uint32_t key)
+{
+    if (index->size == 0)
+        return HASH_INDEX_END;
+
+    return find_from(index, key, hash_pos(index, key));
+}
+
+uint32_t
+hash_index_next(const struct hash_index *index, uint32_t key, uint32_t pos)
+{
+    return find_from(index, key, (pos + 1) & (index->size - 1));
+}
@@ -0,0 +1,86 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A hash index of the items of an array, by a 32-bit key of theirs, such
+ * as the name atom of a key or the keysym of an interpretation.
+ *
+ * The index only maps keys to item numbers. Several items may be added
+ * with the same key, and entries are never removed: a lookup goes through
+ * all of the items added with the key, in the order they were added, and
+ * it's up to the caller to check that the item is the one it looks for,
+ * e.g. that it still has that name.
+ */
+
+struct hash_index_entry {
+    uint32_t key;
+    uint32_t item;
+};
+
+struct hash_index {
+    /* Open addressing with linear probing; the size is a power of 2. */
+    struct hash_index_entry *entries;
+    uint32_t size;
+    uint32_t count;
+};
+
+#define HASH_INDEX_END UINT32_MAX
+
+void
+hash_index_init(struct hash_index *index);
+
+void
+hash_index_free(struct hash_index *index);
+
+/* Move the index from @from to @into, leaving @from empty. */
+void
+hash_index_steal(struct hash_index *into, struct hash_index *from);
+
+/* Make room for @count entries in all, to avoid growing while adding. */
+bool
+hash_index_reserve(struct hash_index *index, uint32_t count);
+
+bool
+hash_index_add(struct hash_index *index, uint32_t key, uint32_t item);
+
+/*
+ * Look up the items added with @key. Returns the position of the first
+ * entry, or HASH_INDEX_END; the next one is found with
+ * hash_index_next(). The item of an entry is index->entries[pos].item.
+ */
+uint32_t
+hash_index_first(const struct hash_index *index, uint32_t key);
+
+uint32_t
+hash_index_next(const struct hash_index *index, uint32_t key, uint32_t pos);
+
+#define hash_index_foreach(pos, index, key) \
+    for ((pos) = hash_index_first((index), (key)); \
+         (pos) != HASH_INDEX_END; \
+         (pos) = hash_index_next((index), (key), (pos)))
+
+#endif /* HASH_INDEX_H */
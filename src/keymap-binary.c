@@ -0,0 +1,1091 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * XKB_KEYMAP_FORMAT_BINARY_V1: a compiled keymap, dumped as is.
+ *
+ * The blob is a header followed by sections, each an array of fixed-size
+ * records. Everything refers to everything else by index, so the blob can
+ * be loaded from anywhere (typically straight from a mapped file); loading
+ * it is a matter of checking the indices and copying the records into a
+ * struct xkb_keymap.
+ *
+ * Strings are stored once in a string table, and referred to by their
+ * index in it plus one (0 is no string). Atoms are stored as strings and
+ * interned again when loading, since atoms are local to a context.
+ *
+ * The records use the native byte order and are 4-byte aligned; the
+ * blob is only meant to be loaded on the machine (or at least the kind
+ * of machine) which produced it. A blob of the wrong byte order or
+ * version is rejected.
+ */
+
+#include "config.h"
+
+#include "keymap.h"
+
+#define BIN_MAGIC "xkbcbin"
+#define BIN_VERSION 1
+#define BIN_BYTE_ORDER 0x01020304
+
+enum bin_section_id {
+    BIN_STRING_DATA,    /* char */
+    BIN_STRINGS,        /* uint32_t offset into BIN_STRING_DATA */
+    BIN_ATOM_LISTS,     /* uint32_t string ref */
+    BIN_MODS,
+    BIN_TYPES,
+    BIN_TYPE_ENTRIES,
+    BIN_INTERPRETS,
+    BIN_LEDS,
+    BIN_ALIASES,
+    BIN_KEYS,
+    BIN_GROUPS,
+    BIN_LEVELS,
+    BIN_KEYSYMS,        /* xkb_keysym_t */
+    _BIN_NUM_SECTIONS
+};
+
+struct bin_section {
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct bin_header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint32_t size;
+    uint32_t enabled_ctrls;
+    uint32_t min_key_code;
+    uint32_t max_key_code;
+    uint32_t num_groups;
+    uint32_t num_group_names;
+    uint32_t group_names;       /* index in BIN_ATOM_LISTS */
+    uint32_t keycodes_section_name;
+    uint32_t symbols_section_name;
+    uint32_t types_section_name;
+    uint32_t compat_section_name;
+    struct bin_section sections[_BIN_NUM_SECTIONS];
+};
+
+struct bin_mod {
+    uint32_t name;
+    uint32_t type;
+    uint32_t mapping;
+};
+
+struct bin_type {
+    uint32_t name;
+    uint32_t mods;
+    uint32_t mask;
+    uint32_t num_levels;
+    uint32_t num_level_names;
+    uint32_t level_names;       /* index in BIN_ATOM_LISTS */
+    uint32_t num_entries;
+    uint32_t entries;           /* index in BIN_TYPE_ENTRIES */
+};
+
+struct bin_type_entry {
+    uint32_t level;
+    uint32_t mods;
+    uint32_t mask;
+    uint32_t preserve_mods;
+    uint32_t preserve_mask;
+};
+
+/* The arguments depend on the type, see write_action(). */
+struct bin_action {
+    uint32_t type;
+    uint32_t flags;
+    int32_t args[2];
+};
+
+struct bin_interpret {
+    uint32_t sym;
+    uint32_t match;
+    uint32_t mods;
+    uint32_t virtual_mod;
+    uint32_t level_one_only;
+    uint32_t repeat;
+    struct bin_action action;
+};
+
+struct bin_led {
+    uint32_t name;
+    uint32_t which_groups;
+    uint32_t groups;
+    uint32_t which_mods;
+    uint32_t mods;
+    uint32_t mask;
+    uint32_t ctrls;
+};
+
+struct bin_alias {
+    uint32_t real;
+    uint32_t alias;
+};
+
+/* One per keycode from min_key_code to max_key_code. */
+struct bin_key {
+    uint32_t name;
+    uint32_t explicit;
+    uint32_t modmap;
+    uint32_t vmodmap;
+    uint32_t repeats;
+    uint32_t out_of_range_group_action;
+    uint32_t out_of_range_group_number;
+    uint32_t num_groups;
+    uint32_t groups;            /* index in BIN_GROUPS */
+};
+
+struct bin_group {
+    uint32_t explicit_type;
+    uint32_t type;              /* index in BIN_TYPES */
+    uint32_t levels;            /* index in BIN_LEVELS, type's num_levels */
+};
+
+struct bin_level {
+    struct bin_action action;
+    uint32_t num_syms;
+    uint32_t syms;              /* the keysym if num_syms == 1, otherwise
+                                   index in BIN_KEYSYMS */
+};
+
+static const size_t bin_record_size[_BIN_NUM_SECTIONS] = {
+    [BIN_STRING_DATA] = sizeof(char),
+    [BIN_STRINGS] = sizeof(uint32_t),
+    [BIN_ATOM_LISTS] = sizeof(uint32_t),
+    [BIN_MODS] = sizeof(struct bin_mod),
+    [BIN_TYPES] = sizeof(struct bin_type),
+    [BIN_TYPE_ENTRIES] = sizeof(struct bin_type_entry),
+    [BIN_INTERPRETS] = sizeof(struct bin_interpret),
+    [BIN_LEDS] = sizeof(struct bin_led),
+    [BIN_ALIASES] = sizeof(struct bin_alias),
+    [BIN_KEYS] = sizeof(struct bin_key),
+    [BIN_GROUPS] = sizeof(struct bin_group),
+    [BIN_LEVELS] = sizeof(struct bin_level),
+    [BIN_KEYSYMS] = sizeof(xkb_keysym_t),
+};
+
+/***====================================================================***/
+
+struct atom_ref {
+    xkb_atom_t atom;
+    uint32_t ref;
+};
+
+struct bin_writer {
+    struct xkb_keymap *keymap;
+
+    /* Atoms already in the string table; open addressing. */
+    struct atom_ref *atom_refs;
+    unsigned int atom_refs_size;
+    unsigned int num_atom_refs;
+    bool alloc_failed;
+
+    darray_char sections[_BIN_NUM_SECTIONS];
+};
+
+#define bin_append(w, id, record) \
+    darray_append_items((w)->sections[id], (const char *) &(record), \
+                        sizeof(record))
+
+#define bin_count(w, id) \
+    ((uint32_t) (darray_size((w)->sections[id]) / bin_record_size[id]))
+
+static uint32_t
+write_string(struct bin_writer *w, const char *string)
+{
+    uint32_t offset;
+
+    if (!string)
+        return 0;
+
+    offset = darray_size(w->sections[BIN_STRING_DATA]);
+    darray_append_items(w->sections[BIN_STRING_DATA], string,
+                        strlen(string) + 1);
+    bin_append(w, BIN_STRINGS, offset);
+
+    return bin_count(w, BIN_STRINGS);
+}
+
+static bool
+grow_atom_refs(struct bin_writer *w)
+{
+    unsigned int new_size = w->atom_refs_size ? w->atom_refs_size * 2 : 256;
+    struct atom_ref *new_refs = calloc(new_size, sizeof(*new_refs));
+
+    if (!new_refs)
+        return false;
+
+    for (unsigned int i = 0; i < w->atom_refs_size; i++) {
+        unsigned int j;
+
+        if (w->atom_refs[i].atom == XKB_ATOM_NONE)
+            continue;
+
+        j = w->atom_refs[i].atom & (new_size - 1);
+        while (new_refs[j].atom != XKB_ATOM_NONE)
+            j = (j + 1) & (new_size - 1);
+        new_refs[j] = w->atom_refs[i];
+    }
+
+    free(w->atom_refs);
+    w->atom_refs = new_refs;
+    w->atom_refs_size = new_size;
+    return true;
+}
+
+/* Returns 0 for XKB_ATOM_NONE. */
+static uint32_t
+write_atom(struct bin_writer *w, xkb_atom_t atom)
+{
+    unsigned int i;
+
+    if (atom == XKB_ATOM_NONE)
+        return 0;
+
+    if ((w->num_atom_refs + 1) * 4 > w->atom_refs_size * 3 &&
+        !grow_atom_refs(w)) {
+        w->alloc_failed = true;
+        return 0;
+    }
+
+    i = atom & (w->atom_refs_size - 1);
+    while (w->atom_refs[i].atom != XKB_ATOM_NONE) {
+        if (w->atom_refs[i].atom == atom)
+            return w->atom_refs[i].ref;
+        i = (i + 1) & (w->atom_refs_size - 1);
+    }
+
+    w->atom_refs[i].atom = atom;
+    w->atom_refs[i].ref = write_string(w, xkb_atom_text(w->keymap->ctx, atom));
+    w->num_atom_refs++;
+    return w->atom_refs[i].ref;
+}
+
+static uint32_t
+write_atom_list(struct bin_writer *w, const xkb_atom_t *atoms,
+                unsigned int count)
+{
+    uint32_t index = bin_count(w, BIN_ATOM_LISTS);
+
+    for (unsigned int i = 0; i < count; i++) {
+        uint32_t ref = write_atom(w, atoms[i]);
+        bin_append(w, BIN_ATOM_LISTS, ref);
+    }
+
+    return index;
+}
+
+static struct bin_action
+write_action(const union xkb_action *action)
+{
+    struct bin_action bin = { .type = action->type };
+
+    switch (action->type) {
+    case ACTION_TYPE_MOD_SET:
+    case ACTION_TYPE_MOD_LATCH:
+    case ACTION_TYPE_MOD_LOCK:
+        bin.flags = action->mods.flags;
+        bin.args[0] = action->mods.mods.mods;
+        bin.args[1] = action->mods.mods.mask;
+        break;
+    case ACTION_TYPE_GROUP_SET:
+    case ACTION_TYPE_GROUP_LATCH:
+    case ACTION_TYPE_GROUP_LOCK:
+        bin.flags = action->group.flags;
+        bin.args[0] = action->group.group;
+        break;
+    case ACTION_TYPE_PTR_MOVE:
+        bin.flags = action->ptr.flags;
+        bin.args[0] = action->ptr.x;
+        bin.args[1] = action->ptr.y;
+        break;
+    case ACTION_TYPE_PTR_BUTTON:
+    case ACTION_TYPE_PTR_LOCK:
+        bin.flags = action->btn.flags;
+        bin.args[0] = action->btn.count;
+        bin.args[1] = action->btn.button;
+        break;
+    case ACTION_TYPE_PTR_DEFAULT:
+        bin.flags = action->dflt.flags;
+        bin.args[0] = action->dflt.value;
+        break;
+    case ACTION_TYPE_SWITCH_VT:
+        bin.flags = action->screen.flags;
+        bin.args[0] = action->screen.screen;
+        break;
+    case ACTION_TYPE_CTRL_SET:
+    case ACTION_TYPE_CTRL_LOCK:
+        bin.flags = action->ctrls.flags;
+        bin.args[0] = action->ctrls.ctrls;
+        break;
+    case ACTION_TYPE_NONE:
+    case ACTION_TYPE_TERMINATE:
+        break;
+    default:
+        /* ACTION_TYPE_PRIVATE and above. */
+        memcpy(bin.args, action->priv.data, sizeof(action->priv.data));
+        break;
+    }
+
+    return bin;
+}
+
+static void
+write_types(struct bin_writer *w)
+{
+    const struct xkb_keymap *keymap = w->keymap;
+
+    for (unsigned int i = 0; i < keymap->num_types; i++) {
+        const struct xkb_key_type *type = &keymap->types[i];
+        struct bin_type bin = {
+            .name = write_atom(w, type->name),
+            .mods = type->mods.mods,
+            .mask = type->mods.mask,
+            .num_levels = type->num_levels,
+            .num_level_names = type->num_level_names,
+            .level_names = write_atom_list(w, type->level_names,
+                                           type->num_level_names),
+            .num_entries = type->num_entries,
+            .entries = bin_count(w, BIN_TYPE_ENTRIES),
+        };
+
+        for (unsigned int j = 0; j < type->num_entries; j++) {
+            const struct xkb_key_type_entry *entry = &type->entries[j];
+            struct bin_type_entry bin_entry = {
+                .level = entry->level,
+                .mods = entry->mods.mods,
+                .mask = entry->mods.mask,
+                .preserve_mods = entry->preserve.mods,
+                .preserve_mask = entry->preserve.mask,
+            };
+            bin_append(w, BIN_TYPE_ENTRIES, bin_entry);
+        }
+
+        bin_append(w, BIN_TYPES, bin);
+    }
+}
+
+static void
+write_keys(struct bin_writer *w)
+{
+    const struct xkb_keymap *keymap = w->keymap;
+    const struct xkb_key *key;
+
+    xkb_keys_foreach(key, keymap) {
+        struct bin_key bin = {
+            .name = write_atom(w, key->name),
+            .explicit = key->explicit,
+            .modmap = key->modmap,
+            .vmodmap = key->vmodmap,
+            .repeats = key->repeats,
+            .out_of_range_group_action = key->out_of_range_group_action,
+            .out_of_range_group_number = key->out_of_range_group_number,
+            .num_groups = key->num_groups,
+            .groups = bin_count(w, BIN_GROUPS),
+        };
+
+        for (xkb_layout_index_t i = 0; i < key->num_groups; i++) {
+            const struct xkb_group *group = &key->groups[i];
+            struct bin_group bin_group = {
+                .explicit_type = group->explicit_type,
+                .type = group->type - keymap->types,
+                .levels = bin_count(w, BIN_LEVELS),
+            };
+
+            for (xkb_level_index_t j = 0; j < XkbKeyNumLevels(key, i); j++) {
+                const struct xkb_level *level = &group->levels[j];
+                struct bin_level bin_level = {
+                    .action = write_action(&level->action),
+                    .num_syms = level->num_syms,
+                };
+
+                if (level->num_syms == 1) {
+                    bin_level.syms = level->u.sym;
+                }
+                else if (level->num_syms > 1) {
+                    bin_level.syms = bin_count(w, BIN_KEYSYMS);
+                    darray_append_items(w->sections[BIN_KEYSYMS],
+                                        (const char *) level->u.syms,
+                                        level->num_syms * sizeof(xkb_keysym_t));
+                }
+
+                bin_append(w, BIN_LEVELS, bin_level);
+            }
+
+            bin_append(w, BIN_GROUPS, bin_group);
+        }
+
+        bin_append(w, BIN_KEYS, bin);
+    }
+}
+
+static void
+write_keymap(struct bin_writer *w, struct bin_header *header)
+{
+    const struct xkb_keymap *keymap = w->keymap;
+    const struct xkb_mod *mod;
+    const struct xkb_led *led;
+
+    header->enabled_ctrls = keymap->enabled_ctrls;
+    header->min_key_code = keymap->min_key_code;
+    header->max_key_code = keymap->max_key_code;
+    header->num_groups = keymap->num_groups;
+    header->num_group_names = keymap->num_group_names;
+    header->group_names = write_atom_list(w, keymap->group_names,
+                                          keymap->num_group_names);
+    header->keycodes_section_name =
+        write_string(w, keymap->keycodes_section_name);
+    header->symbols_section_name =
+        write_string(w, keymap->symbols_section_name);
+    header->types_section_name =
+        write_string(w, keymap->types_section_name);
+    header->compat_section_name =
+        write_string(w, keymap->compat_section_name);
+
+    xkb_mods_foreach(mod, &keymap->mods) {
+        struct bin_mod bin = {
+            .name = write_atom(w, mod->name),
+            .type = mod->type,
+            .mapping = mod->mapping,
+        };
+        bin_append(w, BIN_MODS, bin);
+    }
+
+    write_types(w);
+
+    for (unsigned int i = 0; i < keymap->num_sym_interprets; i++) {
+        const struct xkb_sym_interpret *si = &keymap->sym_interprets[i];
+        struct bin_interpret bin = {
+            .sym = si->sym,
+            .match = si->match,
+            .mods = si->mods,
+            .virtual_mod = si->virtual_mod,
+            .level_one_only = si->level_one_only,
+            .repeat = si->repeat,
+            .action = write_action(&si->action),
+        };
+        bin_append(w, BIN_INTERPRETS, bin);
+    }
+
+    xkb_leds_foreach(led, keymap) {
+        struct bin_led bin = {
+            .name = write_atom(w, led->name),
+            .which_groups = led->which_groups,
+            .groups = led->groups,
+            .which_mods = led->which_mods,
+            .mods = led->mods.mods,
+            .mask = led->mods.mask,
+            .ctrls = led->ctrls,
+        };
+        bin_append(w, BIN_LEDS, bin);
+    }
+
+    for (unsigned int i = 0; i < keymap->num_key_aliases; i++) {
+        struct bin_alias bin = {
+            .real = write_atom(w, keymap->key_aliases[i].real),
+            .alias = write_atom(w, keymap->key_aliases[i].alias),
+        };
+        bin_append(w, BIN_ALIASES, bin);
+    }
+
+    write_keys(w);
+}
+
+static char *
+binary_v1_keymap_get_as_buffer(struct xkb_keymap *keymap, size_t *length)
+{
+    struct bin_writer w = { .keymap = keymap };
+    struct bin_header header = {
+        .magic = BIN_MAGIC,
+        .byte_order = BIN_BYTE_ORDER,
+        .version = BIN_VERSION,
+    };
+    size_t size;
+    char *blob = NULL;
+
+    write_keymap(&w, &header);
+    if (w.alloc_failed)
+        goto out;
+
+    /* Lay the sections out after the header, each 4-byte aligned. */
+    size = sizeof(header);
+    for (int i = 0; i < _BIN_NUM_SECTIONS; i++) {
+        size = ROUNDUP(size, 4);
+        header.sections[i].offset = size;
+        header.sections[i].count = bin_count(&w, i);
+        size += darray_size(w.sections[i]);
+    }
+
+    if (size > UINT32_MAX) {
+        log_err(keymap->ctx, "Keymap too large for the binary format\n");
+        goto out;
+    }
+    header.size = size;
+
+    blob = calloc(1, size);
+    if (!blob)
+        goto out;
+
+    memcpy(blob, &header, sizeof(header));
+    for (int i = 0; i < _BIN_NUM_SECTIONS; i++)
+        if (!darray_empty(w.sections[i]))
+            memcpy(blob + header.sections[i].offset, w.sections[i].item,
+                   darray_size(w.sections[i]));
+
+    *length = size;
+
+out:
+    for (int i = 0; i < _BIN_NUM_SECTIONS; i++)
+        darray_free(w.sections[i]);
+    free(w.atom_refs);
+    return blob;
+}
+
+/***====================================================================***/
+
+struct bin_reader {
+    struct xkb_keymap *keymap;
+    const char *blob;
+    struct bin_header header;
+
+    /* The strings, interned; indexed by string ref. */
+    xkb_atom_t *atoms;
+};
+
+/* Copy record @index of section @id, if it exists. */
+static bool
+read_record(struct bin_reader *r, enum bin_section_id id, uint32_t index,
+            void *record)
+{
+    const struct bin_section *section = &r->header.sections[id];
+
+    if (index >= section->count)
+        return false;
+
+    memcpy(record, r->blob + section->offset + index * bin_record_size[id],
+           bin_record_size[id]);
+    return true;
+}
+
+/* Check that records @index to @index + @count of section @id exist. */
+static bool
+check_range(struct bin_reader *r, enum bin_section_id id, uint32_t index,
+            uint32_t count)
+{
+    const uint32_t section_count = r->header.sections[id].count;
+    return index <= section_count && count <= section_count - index;
+}
+
+static bool
+read_atom(struct bin_reader *r, uint32_t ref, xkb_atom_t *atom)
+{
+    if (ref > r->header.sections[BIN_STRINGS].count)
+        return false;
+
+    *atom = (ref == 0 ? XKB_ATOM_NONE : r->atoms[ref - 1]);
+    return true;
+}
+
+static bool
+read_string(struct bin_reader *r, uint32_t ref, char **string)
+{
+    xkb_atom_t atom;
+
+    if (!read_atom(r, ref, &atom))
+        return false;
+
+    *string = (atom == XKB_ATOM_NONE ? NULL :
+               strdup(xkb_atom_text(r->keymap->ctx, atom)));
+    return atom == XKB_ATOM_NONE || *string;
+}
+
+static bool
+read_atom_list(struct bin_reader *r, uint32_t index, uint32_t count,
+               xkb_atom_t **atoms_out)
+{
+    xkb_atom_t *atoms;
+
+    if (count == 0) {
+        *atoms_out = NULL;
+        return true;
+    }
+
+    if (!check_range(r, BIN_ATOM_LISTS, index, count))
+        return false;
+
+    atoms = calloc(count, sizeof(*atoms));
+    if (!atoms)
+        return false;
+    *atoms_out = atoms;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t ref;
+        if (!read_record(r, BIN_ATOM_LISTS, index + i, &ref) ||
+            !read_atom(r, ref, &atoms[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static bool
+read_action(const struct bin_action *bin, union xkb_action *action)
+{
+    memset(action, 0, sizeof(*action));
+    action->type = bin->type;
+
+    switch (bin->type) {
+    case ACTION_TYPE_NONE:
+    case ACTION_TYPE_TERMINATE:
+        break;
+    case ACTION_TYPE_MOD_SET:
+    case ACTION_TYPE_MOD_LATCH:
+    case ACTION_TYPE_MOD_LOCK:
+        action->mods.flags = bin->flags;
+        action->mods.mods.mods = bin->args[0];
+        action->mods.mods.mask = bin->args[1];
+        break;
+    case ACTION_TYPE_GROUP_SET:
+    case ACTION_TYPE_GROUP_LATCH:
+    case ACTION_TYPE_GROUP_LOCK:
+        action->group.flags = bin->flags;
+        action->group.group = bin->args[0];
+        break;
+    case ACTION_TYPE_PTR_MOVE:
+        action->ptr.flags = bin->flags;
+        action->ptr.x = bin->args[0];
+        action->ptr.y = bin->args[1];
+        break;
+    case ACTION_TYPE_PTR_BUTTON:
+    case ACTION_TYPE_PTR_LOCK:
+        action->btn.flags = bin->flags;
+        action->btn.count = bin->args[0];
+        action->btn.button = bin->args[1];
+        break;
+    case ACTION_TYPE_PTR_DEFAULT:
+        action->dflt.flags = bin->flags;
+        action->dflt.value = bin->args[0];
+        break;
+    case ACTION_TYPE_SWITCH_VT:
+        action->screen.flags = bin->flags;
+        action->screen.screen = bin->args[0];
+        break;
+    case ACTION_TYPE_CTRL_SET:
+    case ACTION_TYPE_CTRL_LOCK:
+        action->ctrls.flags = bin->flags;
+        action->ctrls.ctrls = bin->args[0];
+        break;
+    default:
+        /* Private actions have a type between ACTION_TYPE_PRIVATE and 255. */
+        if (bin->type > 255)
+            return false;
+        memcpy(action->priv.data, bin->args, sizeof(action->priv.data));
+        break;
+    }
+
+    return true;
+}
+
+static bool
+read_header(struct bin_reader *r, size_t length)
+{
+    struct bin_header *header = &r->header;
+
+    if (length < sizeof(*header))
+        return false;
+
+    memcpy(header, r->blob, sizeof(*header));
+
+    if (memcmp(header->magic, BIN_MAGIC, sizeof(header->magic)) != 0 ||
+        header->byte_order != BIN_BYTE_ORDER ||
+        header->version != BIN_VERSION ||
+        header->size > length)
+        return false;
+
+    for (int i = 0; i < _BIN_NUM_SECTIONS; i++) {
+        const struct bin_section *section = &header->sections[i];
+        uint64_t end = section->offset +
+                       (uint64_t) section->count * bin_record_size[i];
+
+        if (section->offset < sizeof(*header) || end > header->size)
+            return false;
+    }
+
+    return true;
+}
+
+static bool
+read_strings(struct bin_reader *r)
+{
+    const struct bin_section *data = &r->header.sections[BIN_STRING_DATA];
+    const uint32_t num_strings = r->header.sections[BIN_STRINGS].count;
+
+    /* All strings are terminated, since the data is. */
+    if (data->count > 0 && r->blob[data->offset + data->count - 1] != '\0')
+        return false;
+
+    if (num_strings == 0)
+        return true;
+
+    r->atoms = calloc(num_strings, sizeof(*r->atoms));
+    if (!r->atoms)
+        return false;
+
+    for (uint32_t i = 0; i < num_strings; i++) {
+        const char *string;
+        uint32_t offset;
+
+        read_record(r, BIN_STRINGS, i, &offset);
+        if (offset >= data->count)
+            return false;
+
+        string = r->blob + data->offset + offset;
+        r->atoms[i] = xkb_atom_intern(r->keymap->ctx, string, strlen(string));
+        if (r->atoms[i] == XKB_ATOM_NONE)
+            return false;
+    }
+
+    return true;
+}
+
+static bool
+read_types(struct bin_reader *r)
+{
+    struct xkb_keymap *keymap = r->keymap;
+    const uint32_t num_types = r->header.sections[BIN_TYPES].count;
+
+    if (num_types == 0)
+        return true;
+
+    keymap->types = calloc(num_types, sizeof(*keymap->types));
+    if (!keymap->types)
+        return false;
+
+    for (uint32_t i = 0; i < num_types; i++) {
+        struct xkb_key_type *type = &keymap->types[keymap->num_types];
+        struct bin_type bin;
+
+        read_record(r, BIN_TYPES, i, &bin);
+        keymap->num_types++;
+
+        if (bin.num_levels == 0 || bin.num_level_names > bin.num_levels)
+            return false;
+
+        type->mods.mods = bin.mods;
+        type->mods.mask = bin.mask;
+        type->num_levels = bin.num_levels;
+        type->num_level_names = bin.num_level_names;
+        if (!read_atom(r, bin.name, &type->name) ||
+            !read_atom_list(r, bin.level_names, bin.num_level_names,
+                            &type->level_names))
+            return false;
+
+        if (bin.num_entries == 0)
+            continue;
+
+        if (!check_range(r, BIN_TYPE_ENTRIES, bin.entries, bin.num_entries))
+            return false;
+
+        type->entries = calloc(bin.num_entries, sizeof(*type->entries));
+        if (!type->entries)
+            return false;
+        type->num_entries = bin.num_entries;
+
+        for (uint32_t j = 0; j < bin.num_entries; j++) {
+            struct xkb_key_type_entry *entry = &type->entries[j];
+            struct bin_type_entry bin_entry;
+
+            if (!read_record(r, BIN_TYPE_ENTRIES, bin.entries + j,
+                             &bin_entry) ||
+                bin_entry.level >= bin.num_levels)
+                return false;
+
+            entry->level = bin_entry.level;
+            entry->mods.mods = bin_entry.mods;
+            entry->mods.mask = bin_entry.mask;
+            entry->preserve.mods = bin_entry.preserve_mods;
+            entry->preserve.mask = bin_entry.preserve_mask;
+        }
+    }
+
+    return true;
+}
+
+static bool
+read_levels(struct bin_reader *r, struct xkb_key *key,
+            xkb_layout_index_t group_idx, uint32_t index)
+{
+    struct xkb_group *group = &key->groups[group_idx];
+    const xkb_level_index_t num_levels = XkbKeyNumLevels(key, group_idx);
+
+    if (!check_range(r, BIN_LEVELS, index, num_levels))
+        return false;
+
+    group->levels = calloc(num_levels, sizeof(*group->levels));
+    if (!group->levels)
+        return false;
+
+    for (xkb_level_index_t i = 0; i < num_levels; i++) {
+        struct xkb_level *level = &group->levels[i];
+        struct bin_level bin;
+
+        if (!read_record(r, BIN_LEVELS, index + i, &bin) ||
+            !read_action(&bin.action, &level->action))
+            return false;
+
+        if (bin.num_syms == 1) {
+            level->u.sym = bin.syms;
+        }
+        else if (bin.num_syms > 1) {
+            const struct bin_section *keysyms =
+                &r->header.sections[BIN_KEYSYMS];
+
+            if (!check_range(r, BIN_KEYSYMS, bin.syms, bin.num_syms))
+                return false;
+
+            level->u.syms = calloc(bin.num_syms, sizeof(*level->u.syms));
+            if (!level->u.syms)
+                return false;
+            memcpy(level->u.syms,
+                   r->blob + keysyms->offset + bin.syms * sizeof(xkb_keysym_t),
+                   bin.num_syms * sizeof(xkb_keysym_t));
+        }
+        level->num_syms = bin.num_syms;
+    }
+
+    return true;
+}
+
+static bool
+read_keys(struct bin_reader *r)
+{
+    struct xkb_keymap *keymap = r->keymap;
+    const struct bin_header *header = &r->header;
+
+    if (header->min_key_code > header->max_key_code ||
+        header->max_key_code > XKB_KEYCODE_MAX ||
+        header->sections[BIN_KEYS].count !=
+            header->max_key_code - header->min_key_code + 1)
+        return false;
+
+    keymap->keys = calloc(header->max_key_code + 1, sizeof(*keymap->keys));
+    if (!keymap->keys)
+        return false;
+    keymap->min_key_code = header->min_key_code;
+    keymap->max_key_code = header->max_key_code;
+
+    for (xkb_keycode_t kc = keymap->min_key_code;
+         kc <= keymap->max_key_code; kc++) {
+        struct xkb_key *key = &keymap->keys[kc];
+        struct bin_key bin;
+
+        read_record(r, BIN_KEYS, kc - keymap->min_key_code, &bin);
+
+        key->keycode = kc;
+        key->explicit = bin.explicit;
+        key->modmap = bin.modmap;
+        key->vmodmap = bin.vmodmap;
+        key->repeats = bin.repeats;
+        key->out_of_range_group_action = bin.out_of_range_group_action;
+        key->out_of_range_group_number = bin.out_of_range_group_number;
+        if (!read_atom(r, bin.name, &key->name) ||
+            bin.num_groups > keymap->num_groups ||
+            bin.out_of_range_group_action > RANGE_REDIRECT)
+            return false;
+
+        if (bin.num_groups == 0)
+            continue;
+
+        key->groups = calloc(bin.num_groups, sizeof(*key->groups));
+        if (!key->groups)
+            return false;
+
+        /* Only count the groups with a type, for xkb_keymap_unref(). */
+        for (xkb_layout_index_t i = 0; i < bin.num_groups; i++) {
+            struct bin_group bin_group;
+
+            if (!read_record(r, BIN_GROUPS, bin.groups + i, &bin_group) ||
+                bin_group.type >= keymap->num_types)
+                return false;
+
+            key->groups[i].explicit_type = bin_group.explicit_type;
+            key->groups[i].type = &keymap->types[bin_group.type];
+            key->num_groups++;
+            if (!read_levels(r, key, i, bin_group.levels))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+read_keymap(struct bin_reader *r)
+{
+    struct xkb_keymap *keymap = r->keymap;
+    const struct bin_header *header = &r->header;
+    const struct bin_section *sections = header->sections;
+
+    if (!read_strings(r))
+        return false;
+
+    keymap->enabled_ctrls = header->enabled_ctrls;
+    keymap->num_groups = header->num_groups;
+    if (header->num_groups > XKB_MAX_GROUPS ||
+        header->num_group_names > XKB_MAX_GROUPS)
+        return false;
+    keymap->num_group_names = header->num_group_names;
+    if (!read_atom_list(r, header->group_names, header->num_group_names,
+                        &keymap->group_names))
+        return false;
+
+    if (!read_string(r, header->keycodes_section_name,
+                     &keymap->keycodes_section_name) ||
+        !read_string(r, header->symbols_section_name,
+                     &keymap->symbols_section_name) ||
+        !read_string(r, header->types_section_name,
+                     &keymap->types_section_name) ||
+        !read_string(r, header->compat_section_name,
+                     &keymap->compat_section_name))
+        return false;
+
+    if (sections[BIN_MODS].count > XKB_MAX_MODS)
+        return false;
+    for (uint32_t i = 0; i < sections[BIN_MODS].count; i++) {
+        struct xkb_mod *mod = &keymap->mods.mods[i];
+        struct bin_mod bin;
+
+        read_record(r, BIN_MODS, i, &bin);
+        mod->type = bin.type;
+        mod->mapping = bin.mapping;
+        if (!read_atom(r, bin.name, &mod->name))
+            return false;
+    }
+    keymap->mods.num_mods = sections[BIN_MODS].count;
+
+    if (!read_types(r))
+        return false;
+
+    if (sections[BIN_INTERPRETS].count > 0) {
+        keymap->sym_interprets = calloc(sections[BIN_INTERPRETS].count,
+                                        sizeof(*keymap->sym_interprets));
+        if (!keymap->sym_interprets)
+            return false;
+        keymap->num_sym_interprets = sections[BIN_INTERPRETS].count;
+    }
+    for (uint32_t i = 0; i < sections[BIN_INTERPRETS].count; i++) {
+        struct xkb_sym_interpret *si = &keymap->sym_interprets[i];
+        struct bin_interpret bin;
+
+        read_record(r, BIN_INTERPRETS, i, &bin);
+        si->sym = bin.sym;
+        si->match = bin.match;
+        si->mods = bin.mods;
+        si->virtual_mod = bin.virtual_mod;
+        si->level_one_only = bin.level_one_only;
+        si->repeat = bin.repeat;
+        if (bin.match > MATCH_EXACTLY ||
+            (bin.virtual_mod != XKB_MOD_INVALID &&
+             bin.virtual_mod >= keymap->mods.num_mods) ||
+            !read_action(&bin.action, &si->action))
+            return false;
+    }
+
+    if (sections[BIN_LEDS].count > XKB_MAX_LEDS)
+        return false;
+    for (uint32_t i = 0; i < sections[BIN_LEDS].count; i++) {
+        struct xkb_led *led = &keymap->leds[i];
+        struct bin_led bin;
+
+        read_record(r, BIN_LEDS, i, &bin);
+        led->which_groups = bin.which_groups;
+        led->groups = bin.groups;
+        led->which_mods = bin.which_mods;
+        led->mods.mods = bin.mods;
+        led->mods.mask = bin.mask;
+        led->ctrls = bin.ctrls;
+        if (!read_atom(r, bin.name, &led->name))
+            return false;
+    }
+    keymap->num_leds = sections[BIN_LEDS].count;
+
+    if (sections[BIN_ALIASES].count > 0) {
+        keymap->key_aliases = calloc(sections[BIN_ALIASES].count,
+                                     sizeof(*keymap->key_aliases));
+        if (!keymap->key_aliases)
+            return false;
+        keymap->num_key_aliases = sections[BIN_ALIASES].count;
+    }
+    for (uint32_t i = 0; i < sections[BIN_ALIASES].count; i++) {
+        struct bin_alias bin;
+
+        read_record(r, BIN_ALIASES, i, &bin);
+        if (!read_atom(r, bin.real, &keymap->key_aliases[i].real) ||
+            !read_atom(r, bin.alias, &keymap->key_aliases[i].alias))
+            return false;
+    }
+
+    return read_keys(r) && XkbKeymapIndexKeyNames(keymap) &&
+           XkbKeymapPackKeys(keymap);
+}
+
+static bool
+binary_v1_keymap_new_from_string(struct xkb_keymap *keymap,
+                                 const char *string, size_t length)
+{
+    struct bin_reader r = { .keymap = keymap, .blob = string };
+    bool ok;
+
+    ok = read_header(&r, length) && read_keymap(&r);
+    if (!ok)
+        log_err(keymap->ctx, "Invalid or incompatible binary keymap\n");
+
+    free(r.atoms);
+    return ok;
+}
+
+static bool
+binary_v1_keymap_new_from_file(struct xkb_keymap *keymap, FILE *file)
+{
+    bool ok;
+    char *blob;
+    size_t size;
+
+    ok = map_file(file, &blob, &size);
+    if (!ok) {
+        log_err(keymap->ctx, "Couldn't read binary keymap file: %s\n",
+                strerror(errno));
+        return false;
+    }
+
+    ok = binary_v1_keymap_new_from_string(keymap, blob, size);
+    unmap_file(blob, size);
+    return ok;
+}
+
+const struct xkb_keymap_format_ops binary_v1_keymap_format_ops = {
+    .keymap_new_from_string = binary_v1_keymap_new_from_string,
+    .keymap_new_from_file = binary_v1_keymap_new_from_file,
+    .keymap_get_as_buffer = binary_v1_keymap_get_as_buffer,
+};
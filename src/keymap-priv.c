@@ -69,35 +69,532 @@ xkb_keymap_new(struct xkb_context *ctx,
     keymap->format = format;
     keymap->flags = flags;
 
+    keymap->fds = keymap_fds_new();
+    if (!keymap->fds) {
+        xkb_context_unref(keymap->ctx);
+        free(keymap);
+        return NULL;
+    }
+
     update_builtin_keymap_fields(keymap);
 
     return keymap;
 }
 
-struct xkb_key *
-XkbKeyByName(struct xkb_keymap *keymap, xkb_atom_t name, bool use_aliases)
+/*
+ * Index the keys and aliases of the keymap by name, once they are all
+ * there. Until then, or if this fails, key names are looked up by going
+ * through the keys and aliases.
+ */
+bool
+XkbKeymapIndexKeyNames(struct xkb_keymap *keymap)
+{
+    struct hash_index *index = &keymap->key_names_index;
+    struct xkb_key *key;
+
+    hash_index_free(index);
+
+    if (keymap->keys) {
+        xkb_keys_foreach(key, keymap)
+            if (key->name != XKB_ATOM_NONE &&
+                !hash_index_add(index, key->name, key->keycode))
+                goto err;
+    }
+
+    for (unsigned i = 0; i < keymap->num_key_aliases; i++)
+        if (!hash_index_add(index, keymap->key_aliases[i].alias,
+                            i | KEY_NAMES_INDEX_ALIAS))
+            goto err;
+
+    return true;
+
+err:
+    hash_index_free(index);
+    return false;
+}
+
+/*
+ * Only hash a few words of every level; XkbGroupsSame() sorts out the
+ * collisions.
+ */
+static uint32_t
+HashGroup(const struct xkb_group *group, xkb_level_index_t num_levels)
+{
+    uint32_t hash = (uint32_t) (uintptr_t) group->type;
+
+    for (xkb_level_index_t i = 0; i < num_levels; i++) {
+        const struct xkb_level *level = &group->levels[i];
+        const xkb_keysym_t sym = (level->num_syms <= 1 ? level->u.sym :
+                                  level->u.syms[0]);
+
+        hash = (hash ^ level->action.type) * 0x01000193;
+        hash = (hash ^ level->num_syms) * 0x01000193;
+        hash = (hash ^ sym) * 0x01000193;
+    }
+
+    return hash;
+}
+
+/*
+ * The actions are compared bytewise: that may miss that two actions are
+ * the same, but then the groups are merely not shared.
+ */
+bool
+XkbGroupsSame(const struct xkb_group *a, const struct xkb_group *b,
+              xkb_level_index_t num_levels)
+{
+    if (a->type != b->type)
+        return false;
+
+    for (xkb_level_index_t i = 0; i < num_levels; i++)
+        if (!XkbLevelsSameSyms(&a->levels[i], &b->levels[i]) ||
+            memcmp(&a->levels[i].action, &b->levels[i].action,
+                   sizeof(a->levels[i].action)) != 0)
+            return false;
+
+    return true;
+}
+
+/*
+ * Move the groups, levels and keysyms of all the keys from their separate
+ * allocations into three arrays, in key order. Groups with the same type,
+ * keysyms and actions share their levels, so the keymap must not be
+ * modified afterwards. Only the keysyms of the levels with several of them
+ * take space in keymap->key_syms.
+ */
+bool
+XkbKeymapPackKeys(struct xkb_keymap *keymap)
 {
     struct xkb_key *key;
+    struct hash_index index;
+    /* The groups with distinct levels, and where their levels go. */
+    darray(const struct xkb_group *) unique = darray_new();
+    darray(struct xkb_level *) packed = darray_new();
+    /* For every group of every key, the one in unique it shares with. */
+    darray_uint shared = darray_new();
+    size_t num_groups = 0, num_levels = 0, num_syms = 0;
+    struct xkb_group *groups = NULL;
+    struct xkb_level *levels = NULL;
+    xkb_keysym_t *syms = NULL;
+    unsigned int n = 0;
+
+    if (!keymap->keys || keymap->keys_packed)
+        return true;
+
+    hash_index_init(&index);
 
     xkb_keys_foreach(key, keymap)
-        if (key->name == name)
-            return key;
+        num_groups += key->num_groups;
+    if (num_groups > UINT32_MAX / 2 ||
+        !hash_index_reserve(&index, num_groups))
+        goto err;
+    darray_growalloc(unique, num_groups);
+    darray_growalloc(shared, num_groups);
+
+    xkb_keys_foreach(key, keymap) {
+        for (xkb_layout_index_t i = 0; i < key->num_groups; i++) {
+            const struct xkb_group *group = &key->groups[i];
+            const xkb_level_index_t count = XkbKeyNumLevels(key, i);
+            const uint32_t hash = HashGroup(group, count);
+            unsigned int u = darray_size(unique);
+            uint32_t pos;
+
+            hash_index_foreach(pos, &index, hash) {
+                const unsigned int other = index.entries[pos].item;
+                if (XkbGroupsSame(darray_item(unique, other), group, count)) {
+                    u = other;
+                    break;
+                }
+            }
+
+            if (u == darray_size(unique)) {
+                if (!hash_index_add(&index, hash, u))
+                    goto err;
+                darray_append(unique, group);
+
+                num_levels += count;
+                for (xkb_level_index_t j = 0; j < count; j++)
+                    if (group->levels[j].num_syms > 1)
+                        num_syms += group->levels[j].num_syms;
+            }
+
+            darray_append(shared, u);
+        }
+    }
+
+    if ((num_groups && !(groups = calloc(num_groups, sizeof(*groups)))) ||
+        (num_levels && !(levels = calloc(num_levels, sizeof(*levels)))) ||
+        (num_syms && !(syms = calloc(num_syms, sizeof(*syms)))))
+        goto err;
+
+    keymap->key_groups = groups;
+    keymap->key_levels = levels;
+    keymap->key_syms = syms;
+    keymap->num_key_groups = num_groups;
+    keymap->num_key_levels = num_levels;
+    keymap->num_key_syms = num_syms;
+
+    /* Copy the distinct levels, while all the groups are still there. */
+    darray_growalloc(packed, darray_size(unique));
+    for (unsigned int u = 0; u < darray_size(unique); u++) {
+        const struct xkb_group *group = darray_item(unique, u);
+        const xkb_level_index_t count = group->type->num_levels;
+
+        darray_append(packed, levels);
+        for (xkb_level_index_t j = 0; j < count; j++) {
+            levels[j] = group->levels[j];
+            if (levels[j].num_syms > 1) {
+                memcpy(syms, levels[j].u.syms,
+                       levels[j].num_syms * sizeof(*syms));
+                levels[j].u.syms = syms;
+                syms += levels[j].num_syms;
+            }
+        }
+        levels += count;
+    }
+
+    xkb_keys_foreach(key, keymap) {
+        for (xkb_layout_index_t i = 0; i < key->num_groups; i++) {
+            struct xkb_group *group = &key->groups[i];
+
+            for (xkb_level_index_t j = 0; j < XkbKeyNumLevels(key, i); j++)
+                if (group->levels[j].num_syms > 1)
+                    free(group->levels[j].u.syms);
+            free(group->levels);
+            group->levels = darray_item(packed, darray_item(shared, n++));
+        }
+
+        if (key->num_groups > 0)
+            memcpy(groups, key->groups, key->num_groups * sizeof(*groups));
+        free(key->groups);
+        key->groups = (key->num_groups > 0 ? groups : NULL);
+        groups += key->num_groups;
+    }
+
+    keymap->keys_packed = true;
+    hash_index_free(&index);
+    darray_free(unique);
+    darray_free(packed);
+    darray_free(shared);
+    return true;
+
+err:
+    free(groups);
+    free(levels);
+    free(syms);
+    keymap->key_groups = NULL;
+    keymap->key_levels = NULL;
+    keymap->key_syms = NULL;
+    hash_index_free(&index);
+    darray_free(unique);
+    darray_free(packed);
+    darray_free(shared);
+    return false;
+}
+
+/*
+ * The fingerprint is made of two 64-bit lanes, which are fed every value
+ * of the keymap through two different mixes, those of MurmurHash3 and of
+ * SplitMix64. Values are fed as integers and strings byte by byte, so the
+ * fingerprint is the same on any machine.
+ */
+struct fingerprint {
+    uint64_t a, b;
+    uint64_t count;
+};
+
+static void
+fp_value(struct fingerprint *fp, uint64_t value)
+{
+    uint64_t a = fp->a ^ value, b = fp->b + value;
+
+    a ^= a >> 33;
+    a *= UINT64_C(0xff51afd7ed558ccd);
+    a ^= a >> 33;
+    a *= UINT64_C(0xc4ceb9fe1a85ec53);
+    a ^= a >> 33;
+
+    b += UINT64_C(0x9e3779b97f4a7c15);
+    b = (b ^ (b >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    b = (b ^ (b >> 27)) * UINT64_C(0x94d049bb133111eb);
+    b ^= b >> 31;
+
+    fp->a = a;
+    fp->b = b;
+    fp->count++;
+}
+
+static void
+fp_atom(struct fingerprint *fp, struct xkb_context *ctx, xkb_atom_t atom)
+{
+    const char *text = xkb_atom_text(ctx, atom);
+    size_t len;
+
+    if (!text) {
+        fp_value(fp, UINT64_MAX);
+        return;
+    }
+
+    len = strlen(text);
+    fp_value(fp, len);
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t word = 0;
+        for (size_t j = i; j < len && j < i + 8; j++)
+            word = word << 8 | (uint8_t) text[j];
+        fp_value(fp, word);
+    }
+}
+
+/* The fields the action has, as write_action() of the binary format has. */
+static void
+fp_action(struct fingerprint *fp, const union xkb_action *action)
+{
+    fp_value(fp, action->type);
+
+    switch (action->type) {
+    case ACTION_TYPE_MOD_SET:
+    case ACTION_TYPE_MOD_LATCH:
+    case ACTION_TYPE_MOD_LOCK:
+        fp_value(fp, action->mods.flags);
+        fp_value(fp, action->mods.mods.mods);
+        fp_value(fp, action->mods.mods.mask);
+        break;
+    case ACTION_TYPE_GROUP_SET:
+    case ACTION_TYPE_GROUP_LATCH:
+    case ACTION_TYPE_GROUP_LOCK:
+        fp_value(fp, action->group.flags);
+        fp_value(fp, (uint32_t) action->group.group);
+        break;
+    case ACTION_TYPE_PTR_MOVE:
+        fp_value(fp, action->ptr.flags);
+        fp_value(fp, (uint16_t) action->ptr.x);
+        fp_value(fp, (uint16_t) action->ptr.y);
+        break;
+    case ACTION_TYPE_PTR_BUTTON:
+    case ACTION_TYPE_PTR_LOCK:
+        fp_value(fp, action->btn.flags);
+        fp_value(fp, action->btn.count);
+        fp_value(fp, action->btn.button);
+        break;
+    case ACTION_TYPE_PTR_DEFAULT:
+        fp_value(fp, action->dflt.flags);
+        fp_value(fp, (uint8_t) action->dflt.value);
+        break;
+    case ACTION_TYPE_SWITCH_VT:
+        fp_value(fp, action->screen.flags);
+        fp_value(fp, (uint8_t) action->screen.screen);
+        break;
+    case ACTION_TYPE_CTRL_SET:
+    case ACTION_TYPE_CTRL_LOCK:
+        fp_value(fp, action->ctrls.flags);
+        fp_value(fp, action->ctrls.ctrls);
+        break;
+    case ACTION_TYPE_NONE:
+    case ACTION_TYPE_TERMINATE:
+        break;
+    default:
+        /* ACTION_TYPE_PRIVATE and above. */
+        for (size_t i = 0; i < sizeof(action->priv.data); i++)
+            fp_value(fp, action->priv.data[i]);
+        break;
+    }
+}
+
+static void
+fp_keys(struct fingerprint *fp, const struct xkb_keymap *keymap)
+{
+    const struct xkb_key *key;
+
+    fp_value(fp, keymap->min_key_code);
+    fp_value(fp, keymap->max_key_code);
+
+    if (!keymap->keys)
+        return;
+
+    xkb_keys_foreach(key, keymap) {
+        fp_atom(fp, keymap->ctx, key->name);
+        fp_value(fp, key->modmap);
+        fp_value(fp, key->vmodmap);
+        fp_value(fp, key->repeats);
+        fp_value(fp, key->out_of_range_group_action);
+        fp_value(fp, key->out_of_range_group_number);
+        fp_value(fp, key->num_groups);
+
+        for (xkb_layout_index_t i = 0; i < key->num_groups; i++) {
+            const struct xkb_group *group = &key->groups[i];
+
+            /* The types come first, so they go by their index. */
+            fp_value(fp, group->type - keymap->types);
+
+            for (xkb_level_index_t j = 0; j < XkbKeyNumLevels(key, i); j++) {
+                const struct xkb_level *level = &group->levels[j];
+
+                fp_action(fp, &level->action);
+                fp_value(fp, level->num_syms);
+                if (level->num_syms <= 1)
+                    fp_value(fp, level->u.sym);
+                else
+                    for (unsigned k = 0; k < level->num_syms; k++)
+                        fp_value(fp, level->u.syms[k]);
+            }
+        }
+    }
+}
+
+/*
+ * Take the fingerprint of the keymap, once it's complete, see
+ * xkb_keymap_get_fingerprint(). Only what the keymap is made of goes into
+ * it: the names of the sections are left out, and so are what is derived
+ * from the rest, e.g. the masks of the types, and what only tells how the
+ * keymap was written, i.e. the explicit components of the keys and the
+ * explicit types of the groups.
+ */
+void
+XkbKeymapFingerprint(struct xkb_keymap *keymap)
+{
+    struct xkb_context *ctx = keymap->ctx;
+    struct fingerprint fp = { 0 };
+    const struct xkb_mod *mod;
+
+    fp_value(&fp, keymap->enabled_ctrls);
+
+    fp_value(&fp, keymap->mods.num_mods);
+    xkb_mods_foreach(mod, &keymap->mods) {
+        fp_atom(&fp, ctx, mod->name);
+        fp_value(&fp, mod->type);
+        fp_value(&fp, mod->mapping);
+    }
+
+    fp_value(&fp, keymap->num_types);
+    for (unsigned i = 0; i < keymap->num_types; i++) {
+        const struct xkb_key_type *type = &keymap->types[i];
+        unsigned num_entries;
+
+        fp_atom(&fp, ctx, type->name);
+        fp_value(&fp, type->mods.mods);
+        fp_value(&fp, type->num_levels);
+        /* Entries for the first level without preserve change nothing. */
+        num_entries = 0;
+        for (unsigned j = 0; j < type->num_entries; j++)
+            if (type->entries[j].level != 0 ||
+                type->entries[j].preserve.mods != 0)
+                num_entries++;
+        fp_value(&fp, num_entries);
+        for (unsigned j = 0; j < type->num_entries; j++) {
+            const struct xkb_key_type_entry *entry = &type->entries[j];
+
+            if (entry->level == 0 && entry->preserve.mods == 0)
+                continue;
+            fp_value(&fp, entry->level);
+            fp_value(&fp, entry->mods.mods);
+            fp_value(&fp, entry->preserve.mods);
+        }
+        fp_value(&fp, type->num_level_names);
+        for (unsigned j = 0; j < type->num_level_names; j++)
+            fp_atom(&fp, ctx, type->level_names[j]);
+    }
 
-    if (use_aliases) {
+    fp_keys(&fp, keymap);
+
+    fp_value(&fp, keymap->num_key_aliases);
+    for (unsigned i = 0; i < keymap->num_key_aliases; i++) {
+        fp_atom(&fp, ctx, keymap->key_aliases[i].alias);
+        fp_atom(&fp, ctx, keymap->key_aliases[i].real);
+    }
+
+    fp_value(&fp, keymap->num_group_names);
+    for (xkb_layout_index_t i = 0; i < keymap->num_group_names; i++)
+        fp_atom(&fp, ctx, keymap->group_names[i]);
+
+    fp_value(&fp, keymap->num_leds);
+    for (xkb_led_index_t i = 0; i < keymap->num_leds; i++) {
+        const struct xkb_led *led = &keymap->leds[i];
+
+        fp_atom(&fp, ctx, led->name);
+        fp_value(&fp, led->which_groups);
+        fp_value(&fp, led->groups);
+        fp_value(&fp, led->which_mods);
+        fp_value(&fp, led->mods.mods);
+        fp_value(&fp, led->ctrls);
+    }
+
+    fp_value(&fp, keymap->num_sym_interprets);
+    for (unsigned i = 0; i < keymap->num_sym_interprets; i++) {
+        const struct xkb_sym_interpret *si = &keymap->sym_interprets[i];
+
+        fp_value(&fp, si->sym);
+        fp_value(&fp, si->match);
+        fp_value(&fp, si->mods);
+        fp_value(&fp, si->virtual_mod);
+        fp_action(&fp, &si->action);
+        fp_value(&fp, si->level_one_only);
+        fp_value(&fp, si->repeat);
+    }
+
+    fp_value(&fp, fp.count);
+
+    for (int i = 0; i < 8; i++) {
+        keymap->fingerprint[i] = (uint8_t) (fp.a >> (8 * i));
+        keymap->fingerprint[8 + i] = (uint8_t) (fp.b >> (8 * i));
+    }
+}
+
+static struct xkb_key *
+XkbKeyByRealName(struct xkb_keymap *keymap, xkb_atom_t name)
+{
+    const struct hash_index *index = &keymap->key_names_index;
+    struct xkb_key *key;
+    uint32_t pos;
+
+    if (index->size == 0) {
+        xkb_keys_foreach(key, keymap)
+            if (key->name == name)
+                return key;
+        return NULL;
+    }
+
+    /* The entries come in the order they were added, i.e. by keycode. */
+    hash_index_foreach(pos, index, name) {
+        uint32_t item = index->entries[pos].item;
+        if (!(item & KEY_NAMES_INDEX_ALIAS))
+            return &keymap->keys[item];
+    }
+
+    return NULL;
+}
+
+struct xkb_key *
+XkbKeyByName(struct xkb_keymap *keymap, xkb_atom_t name, bool use_aliases)
+{
+    struct xkb_key *key = XkbKeyByRealName(keymap, name);
+
+    if (!key && use_aliases) {
         xkb_atom_t new_name = XkbResolveKeyAlias(keymap, name);
         if (new_name != XKB_ATOM_NONE)
-            return XkbKeyByName(keymap, new_name, false);
+            return XkbKeyByRealName(keymap, new_name);
     }
 
-    return NULL;
+    return key;
 }
 
 xkb_atom_t
 XkbResolveKeyAlias(const struct xkb_keymap *keymap, xkb_atom_t name)
 {
-    for (unsigned i = 0; i < keymap->num_key_aliases; i++)
-        if (keymap->key_aliases[i].alias == name)
-            return keymap->key_aliases[i].real;
+    const struct hash_index *index = &keymap->key_names_index;
+    uint32_t pos;
+
+    if (index->size == 0) {
+        for (unsigned i = 0; i < keymap->num_key_aliases; i++)
+            if (keymap->key_aliases[i].alias == name)
+                return keymap->key_aliases[i].real;
+        return XKB_ATOM_NONE;
+    }
+
+    hash_index_foreach(pos, index, name) {
+        uint32_t item = index->entries[pos].item;
+        if (item & KEY_NAMES_INDEX_ALIAS)
+            return keymap->key_aliases[item & ~KEY_NAMES_INDEX_ALIAS].real;
+    }
 
     return XKB_ATOM_NONE;
 }
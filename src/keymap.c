@@ -52,23 +52,32 @@
 
 #include "config.h"
 
+#ifdef HAVE_MEMFD_CREATE
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "keymap.h"
 #include "text.h"
+#include "thread.h"
+#include "xkbcomp/rules.h"
 
 XKB_EXPORT struct xkb_keymap *
 xkb_keymap_ref(struct xkb_keymap *keymap)
 {
-    keymap->refcnt++;
+    refcnt_inc(&keymap->refcnt);
     return keymap;
 }
 
 XKB_EXPORT void
 xkb_keymap_unref(struct xkb_keymap *keymap)
 {
-    if (!keymap || --keymap->refcnt > 0)
+    if (!keymap || refcnt_dec(&keymap->refcnt) > 0)
         return;
 
-    if (keymap->keys) {
+    if (keymap->keys && !keymap->keys_packed) {
         struct xkb_key *key;
         xkb_keys_foreach(key, keymap) {
             if (key->groups) {
@@ -83,8 +92,11 @@ xkb_keymap_unref(struct xkb_keymap *keymap)
                 free(key->groups);
             }
         }
-        free(keymap->keys);
     }
+    free(keymap->keys);
+    free(keymap->key_groups);
+    free(keymap->key_levels);
+    free(keymap->key_syms);
     if (keymap->types) {
         for (unsigned i = 0; i < keymap->num_types; i++) {
             free(keymap->types[i].entries);
@@ -94,6 +106,8 @@ xkb_keymap_unref(struct xkb_keymap *keymap)
     }
     free(keymap->sym_interprets);
     free(keymap->key_aliases);
+    hash_index_free(&keymap->key_names_index);
+    keymap_fds_free(keymap->fds);
     free(keymap->group_names);
     free(keymap->keycodes_section_name);
     free(keymap->symbols_section_name);
@@ -108,6 +122,7 @@ get_keymap_format_ops(enum xkb_keymap_format format)
 {
     static const struct xkb_keymap_format_ops *keymap_format_ops[] = {
         [XKB_KEYMAP_FORMAT_TEXT_V1] = &text_v1_keymap_format_ops,
+        [XKB_KEYMAP_FORMAT_BINARY_V1] = &binary_v1_keymap_format_ops,
     };
 
     if ((int) format < 0 || (int) format >= (int) ARRAY_SIZE(keymap_format_ops))
@@ -116,6 +131,300 @@ get_keymap_format_ops(enum xkb_keymap_format format)
     return keymap_format_ops[(int) format];
 }
 
+/*
+ * Cache of compiled keymaps, enabled with XKB_CONTEXT_CACHE_KEYMAPS.
+ * Keymaps are immutable once compiled, so a cached keymap is simply shared
+ * by reference.
+ *
+ * The keymaps come from RMLVO names, with the key built from the sanitized
+ * names by xkb_context_rule_names_key(), or from buffers, with the key
+ * being the include path and then the buffer itself; the source tells
+ * these apart. When the cache is full, the least recently used keymap is
+ * dropped, and the new one takes its slot.
+ *
+ * The entries are looked up through a hash index of their hash. As the
+ * index can't remove entries, a reused slot stays in it under the hash of
+ * the evicted keymap, and the index is rebuilt once there are too many of
+ * these.
+ */
+#define KEYMAP_CACHE_MAX_ENTRIES 16
+#define KEYMAP_CACHE_MAX_INDEXED (4 * KEYMAP_CACHE_MAX_ENTRIES)
+
+/* The source of keymaps from names; otherwise it's the buffer's format. */
+#define KEYMAP_CACHE_NAMES -1
+
+struct keymap_cache_entry {
+    int source;
+    uint32_t hash;
+    char *key;
+    size_t key_len;
+    unsigned long last_used;
+    struct xkb_keymap *keymap;
+};
+
+typedef darray(struct keymap_cache_entry) darray_keymap_cache_entry;
+
+struct keymap_cache {
+    xkb_mutex_t mutex;
+    darray_keymap_cache_entry entries;
+    struct hash_index index;
+    unsigned long clock;
+};
+
+struct keymap_cache *
+keymap_cache_new(void)
+{
+    struct keymap_cache *cache = calloc(1, sizeof(*cache));
+    if (!cache)
+        return NULL;
+
+    mutex_init(&cache->mutex);
+    darray_init(cache->entries);
+    hash_index_init(&cache->index);
+    return cache;
+}
+
+/* Must be called with the cache locked. */
+static darray_keymap_cache_entry
+keymap_cache_take_entries(struct keymap_cache *cache)
+{
+    darray_keymap_cache_entry entries = cache->entries;
+
+    darray_init(cache->entries);
+    hash_index_free(&cache->index);
+    return entries;
+}
+
+/*
+ * Release entries taken out of the cache. Releasing a keymap may release
+ * the context, and the cache along with it, so the cache must not be
+ * touched anymore.
+ */
+static void
+keymap_cache_release_entries(darray_keymap_cache_entry *entries)
+{
+    struct keymap_cache_entry *entry;
+
+    darray_foreach(entry, *entries) {
+        free(entry->key);
+        xkb_keymap_unref(entry->keymap);
+    }
+    darray_free(*entries);
+}
+
+void
+keymap_cache_clear(struct keymap_cache *cache)
+{
+    darray_keymap_cache_entry entries;
+
+    mutex_lock(&cache->mutex);
+    entries = keymap_cache_take_entries(cache);
+    mutex_unlock(&cache->mutex);
+
+    keymap_cache_release_entries(&entries);
+}
+
+/*
+ * Drop a reference on the context which owns @cache, and return the new
+ * count. Each cached keymap holds a reference on the context; if these are
+ * the only ones left, nobody can look the keymaps up anymore, so they are
+ * dropped, and the last one to go frees the context.
+ *
+ * The cache only changes with its lock held, so doing the decrement under
+ * it too means that exactly one caller sees the count drop to the number
+ * of cached keymaps.
+ */
+int
+keymap_cache_unref_context(struct keymap_cache *cache, int *refcnt)
+{
+    darray_keymap_cache_entry entries = darray_new();
+    int count;
+
+    mutex_lock(&cache->mutex);
+    count = refcnt_dec(refcnt);
+    if (count > 0 && (unsigned) count == darray_size(cache->entries))
+        entries = keymap_cache_take_entries(cache);
+    mutex_unlock(&cache->mutex);
+
+    keymap_cache_release_entries(&entries);
+    return count;
+}
+
+void
+keymap_cache_free(struct keymap_cache *cache)
+{
+    if (!cache)
+        return;
+
+    /* The cached keymaps hold the context, so there are none left here. */
+    darray_free(cache->entries);
+    hash_index_free(&cache->index);
+    mutex_destroy(&cache->mutex);
+    free(cache);
+}
+
+/* Must be called with the cache locked. */
+static struct keymap_cache_entry *
+keymap_cache_find(struct keymap_cache *cache, int source, uint32_t hash,
+                  const darray_char *key)
+{
+    uint32_t pos;
+
+    hash_index_foreach(pos, &cache->index, hash) {
+        struct keymap_cache_entry *entry =
+            &darray_item(cache->entries, cache->index.entries[pos].item);
+        if (entry->hash == hash && entry->source == source &&
+            entry->key_len == darray_size(*key) &&
+            memcmp(entry->key, key->item, entry->key_len) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static struct xkb_keymap *
+keymap_cache_lookup(struct keymap_cache *cache, int source, uint32_t hash,
+                    const darray_char *key)
+{
+    struct keymap_cache_entry *entry;
+    struct xkb_keymap *keymap = NULL;
+
+    mutex_lock(&cache->mutex);
+    entry = keymap_cache_find(cache, source, hash, key);
+    if (entry) {
+        entry->last_used = ++cache->clock;
+        keymap = xkb_keymap_ref(entry->keymap);
+    }
+    mutex_unlock(&cache->mutex);
+
+    return keymap;
+}
+
+/* Must be called with the cache locked. */
+static void
+keymap_cache_reindex(struct keymap_cache *cache)
+{
+    struct hash_index index;
+    struct keymap_cache_entry *entry;
+    unsigned i;
+
+    /* On failure, keep the old index: it's bigger, but still right. */
+    hash_index_init(&index);
+    if (!hash_index_reserve(&index, darray_size(cache->entries)))
+        return;
+    darray_enumerate(i, entry, cache->entries)
+        hash_index_add(&index, entry->hash, i);
+    hash_index_steal(&cache->index, &index);
+}
+
+/*
+ * With the cache, the messages logged while compiling a keymap are
+ * captured, and keymaps which logged warnings or errors are not cached:
+ * a cache hit would lose them, while they are logged every time without
+ * the cache. Stop the capture and log the messages; returns whether there
+ * were any warnings or errors.
+ */
+static bool
+keymap_cache_capture_stop(struct xkb_context *ctx,
+                          darray_log_message *previous,
+                          darray_log_message *log)
+{
+    struct xkb_log_message *message;
+    bool logged = false;
+
+    darray_foreach(message, *log)
+        if (message->level <= XKB_LOG_LEVEL_WARNING)
+            logged = true;
+
+    xkb_log_capture_stop(ctx, previous);
+    xkb_log_replay(ctx, log);
+    return logged;
+}
+
+/*
+ * Add a freshly compiled @keymap to the cache. Returns the keymap the
+ * caller should use: if another thread cached the same keymap in the
+ * meantime, @keymap is released in favor of the cached one.
+ */
+static struct xkb_keymap *
+keymap_cache_insert(struct keymap_cache *cache, int source, uint32_t hash,
+                    darray_char *key, struct xkb_keymap *keymap)
+{
+    struct keymap_cache_entry *entry;
+    struct xkb_keymap *evicted = NULL;
+    unsigned i, slot;
+
+    mutex_lock(&cache->mutex);
+
+    entry = keymap_cache_find(cache, source, hash, key);
+    if (entry) {
+        struct xkb_keymap *cached = xkb_keymap_ref(entry->keymap);
+        entry->last_used = ++cache->clock;
+        mutex_unlock(&cache->mutex);
+        xkb_keymap_unref(keymap);
+        return cached;
+    }
+
+    if (darray_size(cache->entries) >= KEYMAP_CACHE_MAX_ENTRIES) {
+        slot = 0;
+        darray_enumerate(i, entry, cache->entries)
+            if (entry->last_used < darray_item(cache->entries, slot).last_used)
+                slot = i;
+    }
+    else {
+        slot = darray_size(cache->entries);
+    }
+
+    /* If the keymap can't be indexed, just don't cache it. */
+    if (!hash_index_add(&cache->index, hash, slot))
+        goto out;
+
+    if (slot < darray_size(cache->entries)) {
+        entry = &darray_item(cache->entries, slot);
+        free(entry->key);
+        evicted = entry->keymap;
+    }
+    else {
+        darray_resize(cache->entries, slot + 1);
+        entry = &darray_item(cache->entries, slot);
+    }
+
+    *entry = (struct keymap_cache_entry) {
+        .source = source,
+        .hash = hash,
+        .key_len = darray_size(*key),
+        .last_used = ++cache->clock,
+        .keymap = xkb_keymap_ref(keymap),
+    };
+    darray_steal(*key, &entry->key, NULL);
+
+    if (cache->index.count > KEYMAP_CACHE_MAX_INDEXED)
+        keymap_cache_reindex(cache);
+
+out:
+    mutex_unlock(&cache->mutex);
+
+    /* The context is also held by @keymap, so this can't release it. */
+    xkb_keymap_unref(evicted);
+    return keymap;
+}
+
+XKB_EXPORT int
+xkb_components_names_from_rules(struct xkb_context *ctx,
+                                const struct xkb_rule_names *names,
+                                struct xkb_component_names *components)
+{
+    struct xkb_rule_names rmlvo;
+
+    if (names)
+        rmlvo = *names;
+    else
+        memset(&rmlvo, 0, sizeof(rmlvo));
+    xkb_context_sanitize_rule_names(ctx, &rmlvo);
+
+    return xkb_components_from_rules(ctx, &rmlvo, components);
+}
+
 XKB_EXPORT struct xkb_keymap *
 xkb_keymap_new_from_names(struct xkb_context *ctx,
                           const struct xkb_rule_names *rmlvo_in,
@@ -123,6 +432,11 @@ xkb_keymap_new_from_names(struct xkb_context *ctx,
 {
     struct xkb_keymap *keymap;
     struct xkb_rule_names rmlvo;
+    darray_char key = darray_new();
+    uint32_t hash = 0;
+    darray_log_message log = darray_new();
+    darray_log_message *capture = NULL;
+    bool ok, logged = false;
     const enum xkb_keymap_format format = XKB_KEYMAP_FORMAT_TEXT_V1;
     const struct xkb_keymap_format_ops *ops;
 
@@ -137,21 +451,47 @@ xkb_keymap_new_from_names(struct xkb_context *ctx,
         return NULL;
     }
 
-    keymap = xkb_keymap_new(ctx, format, flags);
-    if (!keymap)
-        return NULL;
-
     if (rmlvo_in)
         rmlvo = *rmlvo_in;
     else
         memset(&rmlvo, 0, sizeof(rmlvo));
     xkb_context_sanitize_rule_names(ctx, &rmlvo);
 
-    if (!ops->keymap_new_from_names(keymap, &rmlvo)) {
+    if (ctx->keymap_cache) {
+        xkb_context_rule_names_key(ctx, &rmlvo, &key);
+        hash = hash_fnv1a(FNV1A_INIT, key.item, darray_size(key));
+        keymap = keymap_cache_lookup(ctx->keymap_cache, KEYMAP_CACHE_NAMES,
+                                     hash, &key);
+        if (keymap) {
+            darray_free(key);
+            return keymap;
+        }
+    }
+
+    keymap = xkb_keymap_new(ctx, format, flags);
+    if (!keymap)
+        goto out;
+
+    if (ctx->keymap_cache)
+        capture = xkb_log_capture_start(ctx, &log);
+    ok = ops->keymap_new_from_names(keymap, &rmlvo);
+    if (ctx->keymap_cache)
+        logged = keymap_cache_capture_stop(ctx, capture, &log);
+
+    if (!ok) {
         xkb_keymap_unref(keymap);
-        return NULL;
+        keymap = NULL;
+        goto out;
     }
 
+    XkbKeymapFingerprint(keymap);
+
+    if (ctx->keymap_cache && !logged)
+        keymap = keymap_cache_insert(ctx->keymap_cache, KEYMAP_CACHE_NAMES,
+                                     hash, &key, keymap);
+
+out:
+    darray_free(key);
     return keymap;
 }
 
@@ -172,6 +512,11 @@ xkb_keymap_new_from_buffer(struct xkb_context *ctx,
                            enum xkb_keymap_compile_flags flags)
 {
     struct xkb_keymap *keymap;
+    darray_char key = darray_new();
+    uint32_t hash = 0;
+    darray_log_message log = darray_new();
+    darray_log_message *capture = NULL;
+    bool ok, logged = false;
     const struct xkb_keymap_format_ops *ops;
 
     ops = get_keymap_format_ops(format);
@@ -190,15 +535,46 @@ xkb_keymap_new_from_buffer(struct xkb_context *ctx,
         return NULL;
     }
 
+    /*
+     * The same buffer is often loaded again and again, e.g. by clients
+     * getting the keymap of every new seat. It may include files, so the
+     * include path is part of the key.
+     */
+    if (ctx->keymap_cache) {
+        xkb_context_include_paths_key(ctx, &key);
+        darray_append_items(key, buffer, length);
+        hash = hash_words(key.item, darray_size(key));
+        keymap = keymap_cache_lookup(ctx->keymap_cache, format, hash, &key);
+        if (keymap) {
+            darray_free(key);
+            return keymap;
+        }
+    }
+
     keymap = xkb_keymap_new(ctx, format, flags);
     if (!keymap)
-        return NULL;
+        goto out;
+
+    if (ctx->keymap_cache)
+        capture = xkb_log_capture_start(ctx, &log);
+    ok = ops->keymap_new_from_string(keymap, buffer, length);
+    if (ctx->keymap_cache)
+        logged = keymap_cache_capture_stop(ctx, capture, &log);
 
-    if (!ops->keymap_new_from_string(keymap, buffer, length)) {
+    if (!ok) {
         xkb_keymap_unref(keymap);
-        return NULL;
+        keymap = NULL;
+        goto out;
     }
 
+    XkbKeymapFingerprint(keymap);
+
+    if (ctx->keymap_cache && !logged)
+        keymap = keymap_cache_insert(ctx->keymap_cache, format, hash, &key,
+                                     keymap);
+
+out:
+    darray_free(key);
     return keymap;
 }
 
@@ -236,17 +612,30 @@ xkb_keymap_new_from_file(struct xkb_context *ctx,
         return NULL;
     }
 
+    XkbKeymapFingerprint(keymap);
+
     return keymap;
 }
 
 XKB_EXPORT char *
 xkb_keymap_get_as_string(struct xkb_keymap *keymap,
                          enum xkb_keymap_format format)
+{
+    return xkb_keymap_get_as_string2(keymap, format,
+                                     XKB_KEYMAP_SERIALIZE_NO_FLAGS);
+}
+
+XKB_EXPORT char *
+xkb_keymap_get_as_string2(struct xkb_keymap *keymap,
+                          enum xkb_keymap_format format,
+                          enum xkb_keymap_serialize_flags flags)
 {
     const struct xkb_keymap_format_ops *ops;
 
+    /* Binary keymaps can't be strings; use the text they came from. */
     if (format == XKB_KEYMAP_USE_ORIGINAL_FORMAT)
-        format = keymap->format;
+        format = keymap->format == XKB_KEYMAP_FORMAT_BINARY_V1 ?
+                 XKB_KEYMAP_FORMAT_TEXT_V1 : keymap->format;
 
     ops = get_keymap_format_ops(format);
     if (!ops || !ops->keymap_get_as_string) {
@@ -254,7 +643,197 @@ xkb_keymap_get_as_string(struct xkb_keymap *keymap,
         return NULL;
     }
 
-    return ops->keymap_get_as_string(keymap);
+    if (flags & ~(XKB_KEYMAP_SERIALIZE_COMPACT)) {
+        log_err_func(keymap->ctx, "unrecognized flags: %#x\n", flags);
+        return NULL;
+    }
+
+    return ops->keymap_get_as_string(keymap, flags);
+}
+
+static char *
+get_as_buffer(struct xkb_keymap *keymap,
+              const struct xkb_keymap_format_ops *ops,
+              enum xkb_keymap_serialize_flags flags, size_t *length)
+{
+    char *string;
+
+    if (ops->keymap_get_as_buffer)
+        return ops->keymap_get_as_buffer(keymap, length);
+
+    string = ops->keymap_get_as_string(keymap, flags);
+    if (string)
+        *length = strlen(string);
+    return string;
+}
+
+XKB_EXPORT char *
+xkb_keymap_get_as_buffer(struct xkb_keymap *keymap,
+                         enum xkb_keymap_format format,
+                         size_t *length)
+{
+    const struct xkb_keymap_format_ops *ops;
+
+    if (format == XKB_KEYMAP_USE_ORIGINAL_FORMAT)
+        format = keymap->format;
+
+    ops = get_keymap_format_ops(format);
+    if (!ops || (!ops->keymap_get_as_buffer && !ops->keymap_get_as_string)) {
+        log_err_func(keymap->ctx, "unsupported keymap format: %d\n", format);
+        return NULL;
+    }
+
+    return get_as_buffer(keymap, ops, XKB_KEYMAP_SERIALIZE_NO_FLAGS, length);
+}
+
+struct keymap_fds {
+    xkb_mutex_t mutex;
+    /* By format, then by flags. */
+    int fds[XKB_KEYMAP_FORMAT_BINARY_V1 + 1][XKB_KEYMAP_SERIALIZE_COMPACT + 1];
+};
+
+struct keymap_fds *
+keymap_fds_new(void)
+{
+    struct keymap_fds *fds = calloc(1, sizeof(*fds));
+    if (!fds)
+        return NULL;
+
+    mutex_init(&fds->mutex);
+    for (size_t i = 0; i < ARRAY_SIZE(fds->fds); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(fds->fds[i]); j++)
+            fds->fds[i][j] = -1;
+    return fds;
+}
+
+void
+keymap_fds_free(struct keymap_fds *fds)
+{
+    if (!fds)
+        return;
+
+#ifdef HAVE_MEMFD_CREATE
+    for (size_t i = 0; i < ARRAY_SIZE(fds->fds); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(fds->fds[i]); j++)
+            if (fds->fds[i][j] >= 0)
+                close(fds->fds[i][j]);
+#endif
+    mutex_destroy(&fds->mutex);
+    free(fds);
+}
+
+#ifdef HAVE_MEMFD_CREATE
+static int
+create_sealed_fd(struct xkb_keymap *keymap,
+                 const struct xkb_keymap_format_ops *ops,
+                 enum xkb_keymap_serialize_flags flags)
+{
+    char *buffer;
+    size_t length, written = 0;
+    int fd;
+
+    buffer = get_as_buffer(keymap, ops, flags, &length);
+    if (!buffer)
+        return -1;
+
+    /* Text keymaps are sent with their NUL terminator. */
+    if (!ops->keymap_get_as_buffer)
+        length++;
+
+    fd = memfd_create("xkb-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        goto err;
+
+    while (written < length) {
+        ssize_t ret = write(fd, buffer + written, length - written);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            goto err;
+        written += ret;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+                               F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+        goto err;
+
+    free(buffer);
+    return fd;
+
+err:
+    log_err(keymap->ctx, "couldn't write the keymap to a sealed file: %s\n",
+            strerror(errno));
+    if (fd >= 0)
+        close(fd);
+    free(buffer);
+    return -1;
+}
+
+/*
+ * Open the file anew rather than dup() it, so that every caller gets its
+ * own read-only file description, with its own offset.
+ */
+static int
+reopen_read_only(int fd)
+{
+    char path[64];
+    int new_fd;
+
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    new_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (new_fd >= 0)
+        return new_fd;
+
+    return fcntl(fd, F_DUPFD_CLOEXEC, 0);
+}
+#endif
+
+XKB_EXPORT int
+xkb_keymap_get_as_fd(struct xkb_keymap *keymap,
+                     enum xkb_keymap_format format,
+                     enum xkb_keymap_serialize_flags flags)
+{
+    const struct xkb_keymap_format_ops *ops;
+    int fd = -1;
+
+    if (format == XKB_KEYMAP_USE_ORIGINAL_FORMAT)
+        format = keymap->format;
+
+    ops = get_keymap_format_ops(format);
+    if (!ops || (!ops->keymap_get_as_buffer && !ops->keymap_get_as_string)) {
+        log_err_func(keymap->ctx, "unsupported keymap format: %d\n", format);
+        return -1;
+    }
+
+    if (flags & ~(XKB_KEYMAP_SERIALIZE_COMPACT)) {
+        log_err_func(keymap->ctx, "unrecognized flags: %#x\n", flags);
+        return -1;
+    }
+
+    /* The flags only apply to text formats. */
+    if (ops->keymap_get_as_buffer)
+        flags = XKB_KEYMAP_SERIALIZE_NO_FLAGS;
+
+#ifdef HAVE_MEMFD_CREATE
+    mutex_lock(&keymap->fds->mutex);
+    if (keymap->fds->fds[format][flags] < 0)
+        keymap->fds->fds[format][flags] =
+            create_sealed_fd(keymap, ops, flags);
+    if (keymap->fds->fds[format][flags] >= 0)
+        fd = reopen_read_only(keymap->fds->fds[format][flags]);
+    mutex_unlock(&keymap->fds->mutex);
+#else
+    log_err_func(keymap->ctx, "sealed files are not supported\n");
+#endif
+
+    return fd;
+}
+
+XKB_EXPORT void
+xkb_keymap_get_fingerprint(struct xkb_keymap *keymap,
+                           uint8_t fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE])
+{
+    memcpy(fingerprint, keymap->fingerprint, XKB_KEYMAP_FINGERPRINT_SIZE);
 }
 
 /**
@@ -558,12 +1137,11 @@ xkb_keymap_key_by_name(struct xkb_keymap *keymap, const char *name)
     if (!atom)
         return XKB_KEYCODE_INVALID;
 
-    xkb_keys_foreach(key, keymap) {
-        if (key->name == atom)
-            return key->keycode;
-    }
+    key = XkbKeyByName(keymap, atom, false);
+    if (!key)
+        return XKB_KEYCODE_INVALID;
 
-    return XKB_KEYCODE_INVALID;
+    return key->keycode;
 }
 
 /**
@@ -87,6 +87,7 @@
 
 #include "utils.h"
 #include "context.h"
+#include "hash-index.h"
 
 /* This limit is artificially enforced, we do not depend on it any where.
  * The reason it's still here is that the rules file format does not
@@ -376,6 +377,25 @@ struct xkb_keymap {
     unsigned int num_key_aliases;
     struct xkb_key_alias *key_aliases;
 
+    /*
+     * The keys and aliases by name, see XkbKeymapIndexKeyNames(). The item
+     * is the keycode of a key, or the index of an alias in key_aliases
+     * with KEY_NAMES_INDEX_ALIAS set.
+     */
+    struct hash_index key_names_index;
+
+    /*
+     * Once keys_packed, the groups, levels and keysyms of the keys point
+     * into these arrays, see XkbKeymapPackKeys(). Groups may share levels.
+     */
+    bool keys_packed;
+    struct xkb_group *key_groups;
+    struct xkb_level *key_levels;
+    xkb_keysym_t *key_syms;
+    size_t num_key_groups;
+    size_t num_key_levels;
+    size_t num_key_syms;
+
     struct xkb_key_type *types;
     unsigned int num_types;
 
@@ -397,6 +417,12 @@ struct xkb_keymap {
     char *symbols_section_name;
     char *types_section_name;
     char *compat_section_name;
+
+    /* The sealed files of xkb_keymap_get_as_fd(). */
+    struct keymap_fds *fds;
+
+    /* See XkbKeymapFingerprint(). */
+    uint8_t fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE];
 };
 
 #define xkb_keys_foreach(iter, keymap) \
@@ -438,6 +464,15 @@ XkbKeyNumLevels(const struct xkb_key *key, xkb_layout_index_t layout)
     return key->groups[layout].type->num_levels;
 }
 
+/* The first keysym of a level, or NoSymbol if it has none. */
+static inline xkb_keysym_t
+XkbLevelFirstSym(const struct xkb_level *level)
+{
+    if (level->num_syms == 0)
+        return XKB_KEY_NoSymbol;
+    return (level->num_syms == 1 ? level->u.sym : level->u.syms[0]);
+}
+
 /*
  * If the virtual modifiers are not bound to anything, the entry
  * is not active and should be skipped. xserver does this with
@@ -454,6 +489,23 @@ xkb_keymap_new(struct xkb_context *ctx,
                enum xkb_keymap_format format,
                enum xkb_keymap_compile_flags flags);
 
+#define KEY_NAMES_INDEX_ALIAS UINT32_C(0x80000000)
+
+bool
+XkbKeymapIndexKeyNames(struct xkb_keymap *keymap);
+
+bool
+XkbKeymapPackKeys(struct xkb_keymap *keymap);
+
+void
+XkbKeymapFingerprint(struct xkb_keymap *keymap);
+
+struct keymap_fds *
+keymap_fds_new(void);
+
+void
+keymap_fds_free(struct keymap_fds *fds);
+
 struct xkb_key *
 XkbKeyByName(struct xkb_keymap *keymap, xkb_atom_t name, bool use_aliases);
 
@@ -470,6 +522,10 @@ XkbModNameToIndex(const struct xkb_mod_set *mods, xkb_atom_t name,
 bool
 XkbLevelsSameSyms(const struct xkb_level *a, const struct xkb_level *b);
 
+bool
+XkbGroupsSame(const struct xkb_group *a, const struct xkb_group *b,
+              xkb_level_index_t num_levels);
+
 xkb_layout_index_t
 XkbWrapGroupIntoRange(int32_t group,
                       xkb_layout_index_t num_groups,
@@ -485,9 +541,12 @@ struct xkb_keymap_format_ops {
     bool (*keymap_new_from_string)(struct xkb_keymap *keymap,
                                    const char *string, size_t length);
     bool (*keymap_new_from_file)(struct xkb_keymap *keymap, FILE *file);
-    char *(*keymap_get_as_string)(struct xkb_keymap *keymap);
+    char *(*keymap_get_as_string)(struct xkb_keymap *keymap,
+                                  enum xkb_keymap_serialize_flags flags);
+    char *(*keymap_get_as_buffer)(struct xkb_keymap *keymap, size_t *length);
 };
 
 extern const struct xkb_keymap_format_ops text_v1_keymap_format_ops;
+extern const struct xkb_keymap_format_ops binary_v1_keymap_format_ops;
 
 #endif
@@ -49,19 +49,64 @@ struct scanner {
     size_t len;
     char buf[1024];
     size_t buf_pos;
+    /* The line/column of s[0]. */
     size_t line, column;
-    /* The line/column of the start of the current token. */
-    size_t token_line, token_column;
+    /*
+     * The position of the start of the current token. Lines are not
+     * counted while scanning; the line/column of the token is only worked
+     * out when a message is logged, see scanner_token_location().
+     */
+    size_t token_pos;
+    /* How far scanner_token_location() counted the lines so far. */
+    size_t counted_pos, counted_lines, counted_line_start;
     const char *file_name;
     struct xkb_context *ctx;
     void *priv;
 };
 
-#define scanner_log(scanner, level, fmt, ...) \
+/*
+ * Count the lines of @string up to @end, from @pos, adding to @lines and
+ * setting @line_start to the position after the last new line.
+ */
+static inline void
+count_lines(const char *string, size_t pos, size_t end,
+            size_t *lines, size_t *line_start)
+{
+    const char *nl;
+
+    while (pos < end && (nl = memchr(string + pos, '\n', end - pos))) {
+        pos = nl - string + 1;
+        (*lines)++;
+        *line_start = pos;
+    }
+}
+
+static inline void
+scanner_token_location(struct scanner *s, size_t *line, size_t *column)
+{
+    const size_t pos = MIN(s->token_pos, s->len);
+
+    /* Messages mostly come in order, so carry on from the last one. */
+    if (pos < s->counted_pos)
+        s->counted_pos = s->counted_lines = s->counted_line_start = 0;
+    count_lines(s->s, s->counted_pos, pos,
+                &s->counted_lines, &s->counted_line_start);
+    s->counted_pos = pos;
+
+    *line = s->line + s->counted_lines;
+    if (s->counted_lines == 0)
+        *column = s->column + pos;
+    else
+        *column = pos - s->counted_line_start + 1;
+}
+
+#define scanner_log(scanner, level, fmt, ...) do { \
+    size_t line_, column_; \
+    scanner_token_location((scanner), &line_, &column_); \
     xkb_log((scanner)->ctx, (level), 0, \
             "%s:%zu:%zu: " fmt "\n", \
-             (scanner)->file_name, \
-             (scanner)->token_line, (scanner)->token_column, ##__VA_ARGS__)
+            (scanner)->file_name, line_, column_, ##__VA_ARGS__); \
+} while (0)
 
 #define scanner_err(scanner, fmt, ...) \
     scanner_log(scanner, XKB_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
@@ -78,12 +123,20 @@ scanner_init(struct scanner *s, struct xkb_context *ctx,
     s->len = len;
     s->pos = 0;
     s->line = s->column = 1;
-    s->token_line = s->token_column = 1;
+    s->token_pos = 0;
+    s->counted_pos = s->counted_lines = s->counted_line_start = 0;
     s->file_name = file_name;
     s->ctx = ctx;
     s->priv = priv;
 }
 
+/* The current token starts here. */
+static inline void
+scanner_token_start(struct scanner *s)
+{
+    s->token_pos = s->pos;
+}
+
 static inline char
 peek(struct scanner *s)
 {
@@ -108,9 +161,7 @@ static inline void
 skip_to_eol(struct scanner *s)
 {
     const char *nl = memchr(s->s + s->pos, '\n', s->len - s->pos);
-    const size_t new_pos = nl ? (size_t) (nl - s->s) : s->len;
-    s->column += new_pos - s->pos;
-    s->pos = new_pos;
+    s->pos = nl ? (size_t) (nl - s->s) : s->len;
 }
 
 static inline char
@@ -118,13 +169,6 @@ next(struct scanner *s)
 {
     if (unlikely(eof(s)))
         return '\0';
-    if (unlikely(eol(s))) {
-        s->line++;
-        s->column = 1;
-    }
-    else {
-        s->column++;
-    }
     return s->s[s->pos++];
 }
 
@@ -133,7 +177,7 @@ chr(struct scanner *s, char ch)
 {
     if (likely(peek(s) != ch))
         return false;
-    s->pos++; s->column++;
+    s->pos++;
     return true;
 }
 
@@ -144,7 +188,7 @@ str(struct scanner *s, const char *string, size_t len)
         return false;
     if (memcmp(s->s + s->pos, string, len) != 0)
         return false;
-    s->pos += len; s->column += len;
+    s->pos += len;
     return true;
 }
 
@@ -170,6 +214,176 @@ buf_appends(struct scanner *s, const char *str)
     return true;
 }
 
+/*
+ * Spans of bytes, for the hot loops of the lexers. Where the compiler
+ * targets AVX2 or SSE2, they test 32 or 16 bytes at a time; the tail of
+ * the string, and other targets, go one byte at a time.
+ */
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define SCANNER_VEC_SIZE 32
+typedef __m256i scanner_vec;
+# define vec_load(p)        _mm256_loadu_si256((const __m256i *) (p))
+# define vec_set1(ch)       _mm256_set1_epi8(ch)
+# define vec_eq(a, b)       _mm256_cmpeq_epi8((a), (b))
+# define vec_or(a, b)       _mm256_or_si256((a), (b))
+# define vec_sub(a, b)      _mm256_sub_epi8((a), (b))
+# define vec_min_u8(a, b)   _mm256_min_epu8((a), (b))
+# define vec_mask(a)        ((uint32_t) _mm256_movemask_epi8(a))
+# define VEC_MASK_ALL       UINT32_C(0xffffffff)
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+# define SCANNER_VEC_SIZE 16
+typedef __m128i scanner_vec;
+# define vec_load(p)        _mm_loadu_si128((const __m128i *) (p))
+# define vec_set1(ch)       _mm_set1_epi8(ch)
+# define vec_eq(a, b)       _mm_cmpeq_epi8((a), (b))
+# define vec_or(a, b)       _mm_or_si128((a), (b))
+# define vec_sub(a, b)      _mm_sub_epi8((a), (b))
+# define vec_min_u8(a, b)   _mm_min_epu8((a), (b))
+# define vec_mask(a)        ((uint32_t) _mm_movemask_epi8(a))
+# define VEC_MASK_ALL       UINT32_C(0xffff)
+#endif
+
+#ifdef SCANNER_VEC_SIZE
+/* The bytes of @v which are in [@lo, @lo + @n]. */
+static inline scanner_vec
+vec_in_range(scanner_vec v, char lo, char n)
+{
+    const scanner_vec off = vec_sub(v, vec_set1(lo));
+    return vec_eq(vec_min_u8(off, vec_set1(n)), off);
+}
+
+/* The number of bytes from the start of @mask of matching bytes. */
+static inline size_t
+vec_span(uint32_t mask)
+{
+    return __builtin_ctz(~mask);
+}
+#endif
+
+/*
+ * The length of the run of spaces (see is_space()) at the position; with
+ * @newlines false, up to the next new line.
+ */
+static inline size_t
+span_space(const struct scanner *s, bool newlines)
+{
+    const char *start = s->s + s->pos, *p = start, *end = s->s + s->len;
+
+#ifdef SCANNER_VEC_SIZE
+    while (end - p >= SCANNER_VEC_SIZE) {
+        const scanner_vec v = vec_load(p);
+        const scanner_vec blank = vec_or(vec_eq(v, vec_set1(' ')),
+                                         vec_eq(v, vec_set1('\t')));
+        const uint32_t mask = vec_mask(vec_or(blank, newlines ?
+                                              vec_in_range(v, '\n', 3) :
+                                              vec_in_range(v, '\v', 2)));
+        if (mask != VEC_MASK_ALL)
+            return p - start + vec_span(mask);
+        p += SCANNER_VEC_SIZE;
+    }
+#endif
+    while (p < end && is_space(*p) && (newlines || *p != '\n'))
+        p++;
+    return p - start;
+}
+
+/* The length of the run of graphic characters but @except at the position. */
+static inline size_t
+span_graph(const struct scanner *s, char except)
+{
+    const char *start = s->s + s->pos, *p = start, *end = s->s + s->len;
+
+#ifdef SCANNER_VEC_SIZE
+    while (end - p >= SCANNER_VEC_SIZE) {
+        const scanner_vec v = vec_load(p);
+        const uint32_t mask = vec_mask(vec_in_range(v, '!', '~' - '!')) &
+                              ~vec_mask(vec_eq(v, vec_set1(except)));
+        if (mask != VEC_MASK_ALL)
+            return p - start + vec_span(mask);
+        p += SCANNER_VEC_SIZE;
+    }
+#endif
+    while (p < end && is_graph(*p) && *p != except)
+        p++;
+    return p - start;
+}
+
+/* The length of the run of [A-Za-z0-9_] at the position. */
+static inline size_t
+span_ident(const struct scanner *s)
+{
+    const char *start = s->s + s->pos, *p = start, *end = s->s + s->len;
+
+#ifdef SCANNER_VEC_SIZE
+    while (end - p >= SCANNER_VEC_SIZE) {
+        const scanner_vec v = vec_load(p);
+        /* Setting 0x20 lowercases the letters, and only them. */
+        const scanner_vec lower = vec_or(v, vec_set1(0x20));
+        const uint32_t mask = vec_mask(vec_or(
+            vec_or(vec_in_range(lower, 'a', 'z' - 'a'),
+                   vec_in_range(v, '0', '9' - '0')),
+            vec_eq(v, vec_set1('_'))));
+        if (mask != VEC_MASK_ALL)
+            return p - start + vec_span(mask);
+        p += SCANNER_VEC_SIZE;
+    }
+#endif
+    while (p < end && (is_alnum(*p) || *p == '_'))
+        p++;
+    return p - start;
+}
+
+/*
+ * The length of the run of plain string literal contents at the
+ * position, i.e. up to a quote, a backslash or a new line.
+ */
+static inline size_t
+span_string(const struct scanner *s)
+{
+    const char *start = s->s + s->pos, *p = start, *end = s->s + s->len;
+
+#ifdef SCANNER_VEC_SIZE
+    while (end - p >= SCANNER_VEC_SIZE) {
+        const scanner_vec v = vec_load(p);
+        const uint32_t mask = ~vec_mask(vec_or(
+            vec_or(vec_eq(v, vec_set1('"')), vec_eq(v, vec_set1('\\'))),
+            vec_eq(v, vec_set1('\n')))) & VEC_MASK_ALL;
+        if (mask != VEC_MASK_ALL)
+            return p - start + vec_span(mask);
+        p += SCANNER_VEC_SIZE;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && *p != '\n')
+        p++;
+    return p - start;
+}
+
+/*
+ * Append the @len bytes at the position to the buffer, and skip them. Like
+ * buf_append(), what doesn't fit is dropped, and the buffer is left full.
+ */
+static inline bool
+buf_append_span(struct scanner *s, size_t len)
+{
+    const size_t room = sizeof(s->buf) - 1 - s->buf_pos;
+    const size_t n = MIN(len, room);
+
+    /*
+     * Most spans are short, so copy a fixed 16 bytes when there's room on
+     * both sides, which the compiler inlines; the bytes past the span are
+     * overwritten later, or unused.
+     */
+    if (n <= 16 && s->len - s->pos >= 16 && sizeof(s->buf) - s->buf_pos >= 16)
+        memcpy(s->buf + s->buf_pos, s->s + s->pos, 16);
+    else
+        memcpy(s->buf + s->buf_pos, s->s + s->pos, n);
+    s->buf_pos += n;
+    s->pos += len;
+    return n == len;
+}
+
 static inline bool
 oct(struct scanner *s, uint8_t *out)
 {
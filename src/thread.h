@@ -0,0 +1,184 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef THREAD_H
+#define THREAD_H
+
+/*
+ * The little we need to share objects between threads: locks, reference
+ * counts, thread-local storage and threads. Without threads support, all
+ * of these degrade to their single-threaded equivalents, and the objects
+ * must not be shared between threads; the public documentation says so.
+ */
+
+#if defined(_WIN32)
+# include <windows.h>
+
+typedef SRWLOCK xkb_mutex_t;
+
+static inline void
+mutex_init(xkb_mutex_t *mutex)
+{
+    InitializeSRWLock(mutex);
+}
+
+static inline void
+mutex_destroy(xkb_mutex_t *mutex)
+{
+}
+
+static inline void
+mutex_lock(xkb_mutex_t *mutex)
+{
+    AcquireSRWLockExclusive(mutex);
+}
+
+static inline void
+mutex_unlock(xkb_mutex_t *mutex)
+{
+    ReleaseSRWLockExclusive(mutex);
+}
+#elif defined(HAVE_PTHREAD_H)
+# include <pthread.h>
+
+typedef pthread_mutex_t xkb_mutex_t;
+
+static inline void
+mutex_init(xkb_mutex_t *mutex)
+{
+    pthread_mutex_init(mutex, NULL);
+}
+
+static inline void
+mutex_destroy(xkb_mutex_t *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+static inline void
+mutex_lock(xkb_mutex_t *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+static inline void
+mutex_unlock(xkb_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+#else
+typedef int xkb_mutex_t;
+
+static inline void mutex_init(xkb_mutex_t *mutex) {}
+static inline void mutex_destroy(xkb_mutex_t *mutex) {}
+static inline void mutex_lock(xkb_mutex_t *mutex) {}
+static inline void mutex_unlock(xkb_mutex_t *mutex) {}
+#endif
+
+/*
+ * Reference counts. refcnt_dec() returns the new count, so the usual
+ * pattern is:
+ *      if (!obj || refcnt_dec(&obj->refcnt) > 0)
+ *          return;
+ */
+#if defined(HAVE___ATOMIC_BUILTINS)
+static inline void
+refcnt_inc(int *refcnt)
+{
+    __atomic_add_fetch(refcnt, 1, __ATOMIC_RELAXED);
+}
+
+static inline int
+refcnt_dec(int *refcnt)
+{
+    return __atomic_sub_fetch(refcnt, 1, __ATOMIC_ACQ_REL);
+}
+#elif defined(_MSC_VER)
+# include <intrin.h>
+
+static inline void
+refcnt_inc(int *refcnt)
+{
+    _InterlockedIncrement((volatile long *) refcnt);
+}
+
+static inline int
+refcnt_dec(int *refcnt)
+{
+    return _InterlockedDecrement((volatile long *) refcnt);
+}
+#else
+static inline void
+refcnt_inc(int *refcnt)
+{
+    ++*refcnt;
+}
+
+static inline int
+refcnt_dec(int *refcnt)
+{
+    return --*refcnt;
+}
+#endif
+
+#if defined(HAVE___THREAD)
+# define THREAD_LOCAL __thread
+# define HAVE_THREAD_LOCAL 1
+#elif defined(_MSC_VER)
+# define THREAD_LOCAL __declspec(thread)
+# define HAVE_THREAD_LOCAL 1
+#else
+# define THREAD_LOCAL
+#endif
+
+/*
+ * Threads, to spread work over several cores. Where there is no threads
+ * support (or no thread-local storage, which the library relies on when
+ * used from several threads), thread_create() fails, and the work should
+ * be done in the calling thread instead.
+ */
+#if defined(HAVE_PTHREAD_H) && defined(HAVE___THREAD)
+typedef pthread_t xkb_thread_t;
+
+static inline bool
+thread_create(xkb_thread_t *thread, void *(*fn)(void *), void *data)
+{
+    return pthread_create(thread, NULL, fn, data) == 0;
+}
+
+static inline void
+thread_join(xkb_thread_t thread)
+{
+    pthread_join(thread, NULL);
+}
+#else
+typedef int xkb_thread_t;
+
+static inline bool
+thread_create(xkb_thread_t *thread, void *(*fn)(void *), void *data)
+{
+    return false;
+}
+
+static inline void thread_join(xkb_thread_t thread) {}
+#endif
+
+#endif /* THREAD_H */
@@ -67,6 +67,14 @@ streq_not_null(const char *s1, const char *s2)
     return streq(s1, s2);
 }
 
+static inline bool
+streq_null(const char *s1, const char *s2)
+{
+    if (s1 == NULL || s2 == NULL)
+        return s1 == s2;
+    return streq(s1, s2);
+}
+
 static inline bool
 istreq(const char *s1, const char *s2)
 {
@@ -196,6 +204,44 @@ one_bit_set(uint32_t x)
     return x && (x & (x - 1)) == 0;
 }
 
+/*
+ * FNV-1a hash, for cache keys. Start with FNV1A_INIT, and feed the
+ * result back in to hash several buffers.
+ */
+#define FNV1A_INIT 2166136261u
+
+static inline uint32_t
+hash_fnv1a(uint32_t hash, const void *buf, size_t len)
+{
+    const unsigned char *s = buf;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ s[i]) * 0x01000193;
+    return hash;
+}
+
+/*
+ * A hash for keys as large as whole keymaps, where FNV-1a, a byte at a
+ * time, is slow: the words of @buf are mixed in 8 bytes at a time, with a
+ * multiply and a rotate each.
+ */
+static inline uint32_t
+hash_words(const void *buf, size_t len)
+{
+    const unsigned char *s = buf;
+    uint64_t hash = len * UINT64_C(0x9e3779b97f4a7c15), word;
+
+    for (; len >= 8; s += 8, len -= 8) {
+        memcpy(&word, s, 8);
+        hash = ((hash << 5 | hash >> 59) ^ word) * UINT64_C(0x517cc1b727220a95);
+    }
+
+    word = 0;
+    memcpy(&word, s, len);
+    hash = ((hash << 5 | hash >> 59) ^ word) * UINT64_C(0x517cc1b727220a95);
+
+    return (uint32_t) (hash ^ hash >> 32);
+}
+
 bool
 map_file(FILE *file, char **string_out, size_t *size_out);
 
@@ -1099,7 +1099,8 @@ get_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
         !get_vmod_names(keymap, conn, reply, &list) ||
         !get_group_names(keymap, conn, reply, &list) ||
         !get_key_names(keymap, conn, reply, &list) ||
-        !get_aliases(keymap, conn, reply, &list))
+        !get_aliases(keymap, conn, reply, &list) ||
+        !XkbKeymapIndexKeyNames(keymap))
         goto fail;
 
     XkbEscapeMapName(keymap->keycodes_section_name);
@@ -1170,10 +1171,12 @@ xkb_x11_keymap_new_from_device(struct xkb_context *ctx,
         !get_indicator_map(keymap, conn, device_id) ||
         !get_compat_map(keymap, conn, device_id) ||
         !get_names(keymap, conn, device_id) ||
-        !get_controls(keymap, conn, device_id)) {
+        !get_controls(keymap, conn, device_id) ||
+        !XkbKeymapPackKeys(keymap)) {
         xkb_keymap_unref(keymap);
         return NULL;
     }
 
+    XkbKeymapFingerprint(keymap);
     return keymap;
 }
@@ -145,6 +145,8 @@ expr_op_type_to_string(enum expr_op_type type);
 const char *
 expr_value_type_to_string(enum expr_value_type type);
 
+struct arena;
+
 typedef struct _ParseCommon  {
     struct _ParseCommon *next;
     enum stmt_type type;
@@ -234,6 +236,7 @@ typedef struct {
     ExprDef *actions;
 } ExprActionList;
 
+/* The items of these arrays are allocated from the arena of the file. */
 typedef struct {
     ExprCommon expr;
     darray(xkb_keysym_t) syms;
@@ -355,6 +358,9 @@ typedef struct {
     char *name;
     ParseCommon *defs;
     enum xkb_map_flags flags;
+    int refcnt;
+    /* All of the tree is allocated from this; only set on the root. */
+    struct arena *arena;
 } XkbFile;
 
 #endif
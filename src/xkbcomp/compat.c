@@ -55,6 +55,7 @@
 #include "action.h"
 #include "vmod.h"
 #include "include.h"
+#include "hash-index.h"
 
 enum si_field {
     SI_FIELD_VIRTUAL_MOD = (1 << 0),
@@ -88,6 +89,8 @@ typedef struct {
     int errorCount;
     SymInterpInfo default_interp;
     darray(SymInterpInfo) interps;
+    /* The interps by keysym, for FindMatchingInterp(). */
+    struct hash_index interps_index;
     LedInfo default_led;
     LedInfo leds[XKB_MAX_LEDS];
     unsigned int num_leds;
@@ -155,6 +158,7 @@ InitCompatInfo(CompatInfo *info, struct xkb_context *ctx,
     info->default_interp.merge = MERGE_OVERRIDE;
     info->default_interp.interp.virtual_mod = XKB_MOD_INVALID;
     info->default_led.merge = MERGE_OVERRIDE;
+    hash_index_init(&info->interps_index);
 }
 
 static void
@@ -162,18 +166,21 @@ ClearCompatInfo(CompatInfo *info)
 {
     free(info->name);
     darray_free(info->interps);
+    hash_index_free(&info->interps_index);
 }
 
 static SymInterpInfo *
 FindMatchingInterp(CompatInfo *info, SymInterpInfo *new)
 {
-    SymInterpInfo *old;
+    uint32_t pos;
 
-    darray_foreach(old, info->interps)
-        if (old->interp.sym == new->interp.sym &&
-            old->interp.mods == new->interp.mods &&
+    hash_index_foreach(pos, &info->interps_index, new->interp.sym) {
+        SymInterpInfo *old =
+            &darray_item(info->interps, info->interps_index.entries[pos].item);
+        if (old->interp.mods == new->interp.mods &&
             old->interp.match == new->interp.match)
             return old;
+    }
 
     return NULL;
 }
@@ -247,6 +254,10 @@ AddInterp(CompatInfo *info, SymInterpInfo *new, bool same_file)
         return true;
     }
 
+    if (!hash_index_add(&info->interps_index, new->interp.sym,
+                        darray_size(info->interps)))
+        return false;
+
     darray_append(info->interps, *new);
     return true;
 }
@@ -395,6 +406,7 @@ MergeIncludedCompatMaps(CompatInfo *into, CompatInfo *from,
     if (darray_empty(into->interps)) {
         into->interps = from->interps;
         darray_init(from->interps);
+        hash_index_steal(&into->interps_index, &from->interps_index);
     }
     else {
         SymInterpInfo *si;
@@ -429,8 +441,7 @@ HandleIncludeCompatMap(CompatInfo *info, IncludeStmt *include)
     CompatInfo included;
 
     InitCompatInfo(&included, info->ctx, info->actions, &info->mods);
-    included.name = include->stmt;
-    include->stmt = NULL;
+    included.name = strdup_safe(include->stmt);
 
     for (IncludeStmt *stmt = include; stmt; stmt = stmt->next_incl) {
         CompatInfo next_incl;
@@ -454,7 +465,7 @@ HandleIncludeCompatMap(CompatInfo *info, IncludeStmt *include)
         MergeIncludedCompatMaps(&included, &next_incl, stmt->merge);
 
         ClearCompatInfo(&next_incl);
-        FreeXkbFile(file);
+        XkbFileUnref(file);
     }
 
     MergeIncludedCompatMaps(info, &included, include->merge);
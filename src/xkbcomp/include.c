@@ -49,11 +49,15 @@
 
 #include "config.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <errno.h>
 #include <limits.h>
 #include <stdio.h>
 
 #include "xkbcomp-priv.h"
+#include "thread.h"
+#include "hash-index.h"
 #include "include.h"
 
 /**
@@ -272,19 +276,341 @@ FindFileInXkbPath(struct xkb_context *ctx, const char *name,
     return file;
 }
 
+/*
+ * Cache of parsed include files, enabled with XKB_CONTEXT_CACHE_INCLUDES.
+ *
+ * An entry is keyed by the resolved path of the file, the map which was
+ * requested from it (NULL for the default map), and the modification time
+ * and size of the file when it was parsed; if the file changes on disk,
+ * the entry is replaced the next time it is looked up. The cached ASTs
+ * are never modified once parsed, so they are shared by reference.
+ *
+ * The section indexes of the files are kept too, keyed by path only, so
+ * that including another map of a file doesn't need to index it again.
+ *
+ * Both are looked up through a hash index of the hash of their key.
+ *
+ * Entries are kept until xkb_context_clear_cache(), or until the context is
+ * freed.
+ */
+struct include_cache_entry {
+    char *path;
+    char *map;
+    time_t mtime;
+    off_t size;
+    XkbFile *file;
+};
+
+struct include_cache_index {
+    char *path;
+    time_t mtime;
+    off_t size;
+    struct section_index *index;
+};
+
+struct include_cache {
+    xkb_mutex_t mutex;
+    darray(struct include_cache_entry) entries;
+    darray(struct include_cache_index) indexes;
+    struct hash_index entries_index;
+    struct hash_index indexes_index;
+};
+
+struct include_cache *
+include_cache_new(void)
+{
+    struct include_cache *cache = calloc(1, sizeof(*cache));
+    if (!cache)
+        return NULL;
+
+    mutex_init(&cache->mutex);
+    darray_init(cache->entries);
+    darray_init(cache->indexes);
+    hash_index_init(&cache->entries_index);
+    hash_index_init(&cache->indexes_index);
+    return cache;
+}
+
+void
+include_cache_clear(struct include_cache *cache)
+{
+    struct include_cache_entry *entry;
+    struct include_cache_index *index;
+
+    mutex_lock(&cache->mutex);
+    darray_foreach(entry, cache->entries) {
+        free(entry->path);
+        free(entry->map);
+        XkbFileUnref(entry->file);
+    }
+    darray_free(cache->entries);
+    darray_foreach(index, cache->indexes) {
+        free(index->path);
+        XkbSectionIndexUnref(index->index);
+    }
+    darray_free(cache->indexes);
+    hash_index_free(&cache->entries_index);
+    hash_index_free(&cache->indexes_index);
+    mutex_unlock(&cache->mutex);
+}
+
+void
+include_cache_free(struct include_cache *cache)
+{
+    if (!cache)
+        return;
+
+    include_cache_clear(cache);
+    mutex_destroy(&cache->mutex);
+    free(cache);
+}
+
+static uint32_t
+include_cache_hash(const char *path, const char *map)
+{
+    uint32_t hash = hash_fnv1a(FNV1A_INIT, path, strlen(path) + 1);
+    return hash_fnv1a(hash, map ? map : "", strlen_safe(map));
+}
+
+/* Must be called with the cache locked. */
+static struct include_cache_entry *
+include_cache_find(struct include_cache *cache, uint32_t hash,
+                   const char *path, const char *map)
+{
+    uint32_t pos;
+
+    hash_index_foreach(pos, &cache->entries_index, hash) {
+        struct include_cache_entry *entry =
+            &darray_item(cache->entries, cache->entries_index.entries[pos].item);
+        if (streq(entry->path, path) && streq_null(entry->map, map))
+            return entry;
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns a new reference to the cached AST of @map in the file at @path,
+ * or NULL if it is not cached or the file changed since.
+ */
+static XkbFile *
+include_cache_lookup(struct include_cache *cache, const char *path,
+                     const char *map, const struct stat *st)
+{
+    uint32_t hash = include_cache_hash(path, map);
+    struct include_cache_entry *entry;
+    XkbFile *file = NULL;
+
+    mutex_lock(&cache->mutex);
+    entry = include_cache_find(cache, hash, path, map);
+    if (entry && entry->mtime == st->st_mtime && entry->size == st->st_size)
+        file = XkbFileRef(entry->file);
+    mutex_unlock(&cache->mutex);
+
+    return file;
+}
+
+/*
+ * Add a freshly parsed @file to the cache, replacing a stale entry if
+ * there is one. Returns the file the caller should use: if another thread
+ * cached the same file in the meantime, @file is released in favor of the
+ * cached one.
+ */
+static XkbFile *
+include_cache_insert(struct include_cache *cache, const char *path,
+                     const char *map, const struct stat *st, XkbFile *file)
+{
+    uint32_t hash = include_cache_hash(path, map);
+    struct include_cache_entry *entry;
+    char *path_copy, *map_copy;
+
+    mutex_lock(&cache->mutex);
+
+    entry = include_cache_find(cache, hash, path, map);
+    if (entry && entry->mtime == st->st_mtime && entry->size == st->st_size) {
+        XkbFileUnref(file);
+        file = XkbFileRef(entry->file);
+        goto out;
+    }
+
+    if (entry) {
+        XkbFileUnref(entry->file);
+    }
+    else {
+        path_copy = strdup(path);
+        map_copy = strdup_safe(map);
+        if (!path_copy || (map && !map_copy) ||
+            !hash_index_add(&cache->entries_index, hash,
+                            darray_size(cache->entries))) {
+            free(path_copy);
+            free(map_copy);
+            goto out;
+        }
+
+        darray_append(cache->entries, (struct include_cache_entry) {
+            .path = path_copy,
+            .map = map_copy,
+        });
+        entry = &darray_item(cache->entries, darray_size(cache->entries) - 1);
+    }
+
+    entry->mtime = st->st_mtime;
+    entry->size = st->st_size;
+    entry->file = XkbFileRef(file);
+
+out:
+    mutex_unlock(&cache->mutex);
+    return file;
+}
+
+/* Must be called with the cache locked. */
+static struct include_cache_index *
+include_cache_find_index(struct include_cache *cache, uint32_t hash,
+                         const char *path)
+{
+    uint32_t pos;
+
+    hash_index_foreach(pos, &cache->indexes_index, hash) {
+        struct include_cache_index *entry =
+            &darray_item(cache->indexes, cache->indexes_index.entries[pos].item);
+        if (streq(entry->path, path))
+            return entry;
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns a new reference to the section index of the file at @path, with
+ * contents @string, indexing it if it is not cached or the file changed
+ * since. Returns NULL if the file can't be indexed.
+ */
+static struct section_index *
+include_cache_get_index(struct include_cache *cache, const char *path,
+                        const struct stat *st, const char *string,
+                        size_t size)
+{
+    uint32_t hash = include_cache_hash(path, NULL);
+    struct include_cache_index *entry;
+    struct section_index *index = NULL;
+    char *path_copy;
+
+    mutex_lock(&cache->mutex);
+    entry = include_cache_find_index(cache, hash, path);
+    if (entry && entry->mtime == st->st_mtime && entry->size == st->st_size)
+        index = XkbSectionIndexRef(entry->index);
+    mutex_unlock(&cache->mutex);
+
+    if (index)
+        return index;
+
+    index = XkbSectionIndexNew(string, size);
+    if (!index)
+        return NULL;
+
+    mutex_lock(&cache->mutex);
+    entry = include_cache_find_index(cache, hash, path);
+    if (entry) {
+        XkbSectionIndexUnref(entry->index);
+    }
+    else {
+        path_copy = strdup(path);
+        if (!path_copy ||
+            !hash_index_add(&cache->indexes_index, hash,
+                            darray_size(cache->indexes))) {
+            free(path_copy);
+            goto out;
+        }
+
+        darray_append(cache->indexes, (struct include_cache_index) {
+            .path = path_copy,
+        });
+        entry = &darray_item(cache->indexes, darray_size(cache->indexes) - 1);
+    }
+
+    entry->mtime = st->st_mtime;
+    entry->size = st->st_size;
+    entry->index = XkbSectionIndexRef(index);
+
+out:
+    mutex_unlock(&cache->mutex);
+    return index;
+}
+
+/*
+ * Parse @map in the include @file, found at @path, going through the cache
+ * if the context has one (and @path is known). Only the section of @map is
+ * parsed, if the file can be indexed.
+ */
+static XkbFile *
+parse_include_file(struct xkb_context *ctx, FILE *file, const char *path,
+                   const char *name, const char *map)
+{
+    XkbFile *xkb_file;
+    struct section_index *index;
+    struct stat st;
+    bool cacheable;
+    char *string;
+    size_t size;
+
+    cacheable = (path && fstat(fileno(file), &st) == 0);
+    if (cacheable) {
+        xkb_file = include_cache_lookup(ctx->include_cache, path, map, &st);
+        if (xkb_file)
+            return xkb_file;
+    }
+
+    if (!map_file(file, &string, &size)) {
+        log_err(ctx, "Couldn't read XKB file %s: %s\n",
+                name, strerror(errno));
+        return NULL;
+    }
+
+    /*
+     * Indexing all of the file is only worth it if the index is kept for
+     * the other maps; otherwise, XkbParseStringIndexed() only looks as far
+     * as the section it needs.
+     */
+    if (cacheable)
+        index = include_cache_get_index(ctx->include_cache, path, &st,
+                                        string, size);
+    else
+        index = NULL;
+
+    xkb_file = XkbParseStringIndexed(ctx, string, size, name, map, index);
+    XkbSectionIndexUnref(index);
+    unmap_file(string, size);
+
+    if (xkb_file && cacheable)
+        xkb_file = include_cache_insert(ctx->include_cache, path, map, &st,
+                                        xkb_file);
+
+    return xkb_file;
+}
+
+/**
+ * Find, parse and return the file included by @stmt. The returned file
+ * must be released with XkbFileUnref(); it may be shared with other users
+ * of the context, and must not be modified.
+ */
 XkbFile *
 ProcessIncludeFile(struct xkb_context *ctx, IncludeStmt *stmt,
                    enum xkb_file_type file_type)
 {
     FILE *file;
     XkbFile *xkb_file;
+    char *path = NULL;
 
-    file = FindFileInXkbPath(ctx, stmt->file, file_type, NULL);
+    file = FindFileInXkbPath(ctx, stmt->file, file_type,
+                             ctx->include_cache ? &path : NULL);
     if (!file)
-        return false;
+        return NULL;
+
+    xkb_file = parse_include_file(ctx, file, path, stmt->file, stmt->map);
 
-    xkb_file = XkbParseFile(ctx, file, stmt->file, stmt->map);
     fclose(file);
+    free(path);
+
     if (!xkb_file) {
         if (stmt->map)
             log_err(ctx, "Couldn't process include statement for '%s(%s)'\n",
@@ -301,7 +627,7 @@ ProcessIncludeFile(struct xkb_context *ctx, IncludeStmt *stmt,
                 "Include file \"%s\" ignored\n",
                 xkb_file_type_to_string(file_type),
                 xkb_file_type_to_string(xkb_file->file_type), stmt->file);
-        FreeXkbFile(xkb_file);
+        XkbFileUnref(xkb_file);
         return NULL;
     }
 
@@ -309,3 +635,157 @@ ProcessIncludeFile(struct xkb_context *ctx, IncludeStmt *stmt,
 
     return xkb_file;
 }
+
+/*
+ * Parallel parsing of the files included by a keymap, for
+ * XKB_CONTEXT_PARALLEL_INCLUDES.
+ *
+ * This goes over the include tree level by level: the files of a level
+ * are parsed by a few threads, then the include statements found in them
+ * make up the next level. The parsed files are put in the include cache,
+ * where ProcessIncludeFile() finds them when the keymap is compiled.
+ *
+ * The messages logged while parsing a file are kept, and logged from the
+ * calling thread once the level is done. Those of the files which could
+ * not be parsed are dropped, since ProcessIncludeFile() tries these again
+ * and logs the same messages.
+ */
+#define PREFETCH_MAX_THREADS 4
+
+struct prefetch_item {
+    enum xkb_file_type file_type;
+    /* These point into the include statement. */
+    const char *file;
+    const char *map;
+    XkbFile *xkb_file;
+    darray_log_message log;
+};
+
+struct prefetch {
+    struct xkb_context *ctx;
+    xkb_mutex_t mutex;
+    darray(struct prefetch_item) items;
+    /* The items of the current level left to take, up to end. */
+    unsigned int next, end;
+};
+
+static bool
+prefetch_has_item(struct prefetch *pf, enum xkb_file_type file_type,
+                  const IncludeStmt *stmt)
+{
+    const struct prefetch_item *item;
+
+    darray_foreach(item, pf->items)
+        if (item->file_type == file_type && streq(item->file, stmt->file) &&
+            streq_null(item->map, stmt->map))
+            return true;
+
+    return false;
+}
+
+static void
+prefetch_add_includes(struct prefetch *pf, enum xkb_file_type file_type,
+                      const XkbFile *file)
+{
+    const ParseCommon *def;
+    const IncludeStmt *stmt;
+
+    for (def = file->defs; def; def = def->next) {
+        if (def->type != STMT_INCLUDE)
+            continue;
+
+        for (stmt = (const IncludeStmt *) def; stmt; stmt = stmt->next_incl)
+            if (stmt->file && !prefetch_has_item(pf, file_type, stmt))
+                darray_append(pf->items, (struct prefetch_item) {
+                    .file_type = file_type,
+                    .file = stmt->file,
+                    .map = stmt->map,
+                });
+    }
+}
+
+static void *
+prefetch_run(void *data)
+{
+    struct prefetch *pf = data;
+    struct prefetch_item *item;
+    darray_log_message *capture;
+    FILE *file;
+    char *path;
+
+    while (true) {
+        mutex_lock(&pf->mutex);
+        item = (pf->next < pf->end ? &darray_item(pf->items, pf->next++) :
+                NULL);
+        mutex_unlock(&pf->mutex);
+
+        if (!item)
+            break;
+
+        capture = xkb_log_capture_start(pf->ctx, &item->log);
+        path = NULL;
+        file = FindFileInXkbPath(pf->ctx, item->file, item->file_type,
+                                 pf->ctx->include_cache ? &path : NULL);
+        if (file) {
+            item->xkb_file = parse_include_file(pf->ctx, file, path,
+                                                item->file, item->map);
+            fclose(file);
+            free(path);
+        }
+        xkb_log_capture_stop(pf->ctx, capture);
+    }
+
+    return NULL;
+}
+
+void
+XkbPrefetchIncludes(struct xkb_context *ctx, const XkbFile *keymap)
+{
+    struct prefetch pf = { .ctx = ctx };
+    xkb_thread_t threads[PREFETCH_MAX_THREADS];
+    const ParseCommon *def;
+    struct prefetch_item *item;
+
+    mutex_init(&pf.mutex);
+    darray_init(pf.items);
+
+    for (def = keymap->defs; def; def = def->next) {
+        const XkbFile *section = (const XkbFile *) def;
+        if (section->file_type >= FIRST_KEYMAP_FILE_TYPE &&
+            section->file_type <= LAST_KEYMAP_FILE_TYPE)
+            prefetch_add_includes(&pf, section->file_type, section);
+    }
+
+    while (pf.next < darray_size(pf.items)) {
+        unsigned int start = pf.next, num_threads = 0;
+
+        pf.end = darray_size(pf.items);
+
+        /* The calling thread takes its share too. */
+        while (num_threads < PREFETCH_MAX_THREADS &&
+               num_threads + 1 < pf.end - start &&
+               thread_create(&threads[num_threads], prefetch_run, &pf))
+            num_threads++;
+        prefetch_run(&pf);
+        for (unsigned i = 0; i < num_threads; i++)
+            thread_join(threads[i]);
+
+        for (unsigned i = start; i < pf.end; i++) {
+            item = &darray_item(pf.items, i);
+            if (!item->xkb_file) {
+                xkb_log_discard(&item->log);
+                continue;
+            }
+
+            xkb_log_replay(ctx, &item->log);
+            /* This may move the items. */
+            if (item->xkb_file->file_type == item->file_type)
+                prefetch_add_includes(&pf, item->file_type, item->xkb_file);
+        }
+    }
+
+    darray_foreach(item, pf.items)
+        XkbFileUnref(item->xkb_file);
+    darray_free(pf.items);
+    mutex_destroy(&pf.mutex);
+}
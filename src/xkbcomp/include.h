@@ -39,4 +39,7 @@ XkbFile *
 ProcessIncludeFile(struct xkb_context *ctx, IncludeStmt *stmt,
                    enum xkb_file_type file_type);
 
+void
+XkbPrefetchIncludes(struct xkb_context *ctx, const XkbFile *keymap);
+
 #endif
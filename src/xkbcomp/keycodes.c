@@ -30,6 +30,7 @@
 #include "text.h"
 #include "expr.h"
 #include "include.h"
+#include "hash-index.h"
 
 typedef struct {
     enum merge_mode merge;
@@ -51,6 +52,8 @@ typedef struct {
     xkb_keycode_t min_key_code;
     xkb_keycode_t max_key_code;
     darray(xkb_atom_t) key_names;
+    /* The keycodes in key_names by name, for FindKeyByName(). */
+    struct hash_index key_names_index;
     LedNameInfo led_names[XKB_MAX_LEDS];
     unsigned int num_led_names;
     darray(AliasInfo) aliases;
@@ -150,6 +153,7 @@ ClearKeyNamesInfo(KeyNamesInfo *info)
 {
     free(info->name);
     darray_free(info->key_names);
+    hash_index_free(&info->key_names_index);
     darray_free(info->aliases);
 }
 
@@ -159,6 +163,7 @@ InitKeyNamesInfo(KeyNamesInfo *info, struct xkb_context *ctx)
     memset(info, 0, sizeof(*info));
     info->ctx = ctx;
     info->min_key_code = XKB_KEYCODE_INVALID;
+    hash_index_init(&info->key_names_index);
 #if XKB_KEYCODE_INVALID < XKB_KEYCODE_MAX
 #error "Hey, you can't be changing stuff like that."
 #endif
@@ -167,11 +172,14 @@ InitKeyNamesInfo(KeyNamesInfo *info, struct xkb_context *ctx)
 static xkb_keycode_t
 FindKeyByName(KeyNamesInfo *info, xkb_atom_t name)
 {
-    xkb_keycode_t i;
+    uint32_t pos;
 
-    for (i = info->min_key_code; i <= info->max_key_code; i++)
-        if (darray_item(info->key_names, i) == name)
-            return i;
+    /* The name may have been taken off the key since. */
+    hash_index_foreach(pos, &info->key_names_index, name) {
+        xkb_keycode_t kc = info->key_names_index.entries[pos].item;
+        if (darray_item(info->key_names, kc) == name)
+            return kc;
+    }
 
     return XKB_KEYCODE_INVALID;
 }
@@ -244,7 +252,7 @@ AddKeyName(KeyNamesInfo *info, xkb_keycode_t kc, xkb_atom_t name,
     }
 
     darray_item(info->key_names, kc) = name;
-    return true;
+    return hash_index_add(&info->key_names_index, name, kc);
 }
 
 /***====================================================================***/
@@ -270,6 +278,7 @@ MergeIncludedKeycodes(KeyNamesInfo *into, KeyNamesInfo *from,
     if (darray_empty(into->key_names)) {
         into->key_names = from->key_names;
         darray_init(from->key_names);
+        hash_index_steal(&into->key_names_index, &from->key_names_index);
         into->min_key_code = from->min_key_code;
         into->max_key_code = from->max_key_code;
     }
@@ -337,8 +346,7 @@ HandleIncludeKeycodes(KeyNamesInfo *info, IncludeStmt *include)
     KeyNamesInfo included;
 
     InitKeyNamesInfo(&included, info->ctx);
-    included.name = include->stmt;
-    include->stmt = NULL;
+    included.name = strdup_safe(include->stmt);
 
     for (IncludeStmt *stmt = include; stmt; stmt = stmt->next_incl) {
         KeyNamesInfo next_incl;
@@ -358,7 +366,7 @@ HandleIncludeKeycodes(KeyNamesInfo *info, IncludeStmt *include)
         MergeIncludedKeycodes(&included, &next_incl, stmt->merge);
 
         ClearKeyNamesInfo(&next_incl);
-        FreeXkbFile(file);
+        XkbFileUnref(file);
     }
 
     MergeIncludedKeycodes(info, &included, include->merge);
@@ -570,7 +578,7 @@ CopyKeyAliasesToKeymap(struct xkb_keymap *keymap, KeyNamesInfo *info)
     num_key_aliases = 0;
     darray_foreach(alias, info->aliases) {
         /* Check that ->real is a key. */
-        if (!XkbKeyByName(keymap, alias->real, false)) {
+        if (FindKeyByName(info, alias->real) == XKB_KEYCODE_INVALID) {
             log_vrb(info->ctx, 5,
                     "Attempt to alias %s to non-existent key %s; Ignored\n",
                     KeyNameText(info->ctx, alias->alias),
@@ -580,7 +588,7 @@ CopyKeyAliasesToKeymap(struct xkb_keymap *keymap, KeyNamesInfo *info)
         }
 
         /* Check that ->alias is not a key. */
-        if (XkbKeyByName(keymap, alias->alias, false)) {
+        if (FindKeyByName(info, alias->alias) != XKB_KEYCODE_INVALID) {
             log_vrb(info->ctx, 5,
                     "Attempt to create alias with the name of a real key; "
                     "Alias \"%s = %s\" ignored\n",
@@ -637,7 +645,8 @@ CopyKeyNamesInfoToKeymap(struct xkb_keymap *keymap, KeyNamesInfo *info)
     /* This function trashes keymap on error, but that's OK. */
     if (!CopyKeyNamesToKeymap(keymap, info) ||
         !CopyKeyAliasesToKeymap(keymap, info) ||
-        !CopyLedNamesToKeymap(keymap, info))
+        !CopyLedNamesToKeymap(keymap, info) ||
+        !XkbKeymapIndexKeyNames(keymap))
         return false;
 
     keymap->keycodes_section_name = strdup_safe(info->name);
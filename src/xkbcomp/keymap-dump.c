@@ -56,72 +56,231 @@
 
 #define BUF_CHUNK_SIZE 4096
 
+/*
+ * The text is appended piece by piece, without going through printf:
+ * serializing is done for every client of a compositor, so it adds up.
+ */
 struct buf {
     char *buf;
     size_t size;
     size_t alloc;
+    /* XKB_KEYMAP_SERIALIZE_COMPACT. */
+    bool compact;
 };
 
+/* Make room for @len more bytes, and the terminating NUL. */
 static bool
-do_realloc(struct buf *buf, size_t at_least)
+buf_reserve(struct buf *buf, size_t len)
 {
+    size_t alloc;
     char *new;
 
-    buf->alloc += BUF_CHUNK_SIZE;
-    if (at_least >= BUF_CHUNK_SIZE)
-        buf->alloc += at_least;
+    if (buf->size + len < buf->alloc)
+        return true;
+
+    alloc = MAX(buf->alloc * 2, BUF_CHUNK_SIZE);
+    while (buf->size + len >= alloc)
+        alloc *= 2;
 
-    new = realloc(buf->buf, buf->alloc);
+    new = realloc(buf->buf, alloc);
     if (!new)
         return false;
 
     buf->buf = new;
+    buf->alloc = alloc;
+    return true;
+}
+
+static bool
+buf_append(struct buf *buf, const char *str, size_t len)
+{
+    if (!buf_reserve(buf, len))
+        return false;
+
+    memcpy(buf->buf + buf->size, str, len);
+    buf->size += len;
     return true;
 }
 
-ATTR_PRINTF(2, 3) static bool
-check_write_buf(struct buf *buf, const char *fmt, ...)
+static bool
+buf_append_str(struct buf *buf, const char *str)
+{
+    return buf_append(buf, str, strlen(str));
+}
+
+/* Like "%*s". */
+static bool
+buf_append_padded(struct buf *buf, const char *str, size_t len, size_t width)
 {
-    va_list args;
-    int printed;
-    size_t available;
+    const size_t pad = (len < width ? width - len : 0);
 
-    available = buf->alloc - buf->size;
-    va_start(args, fmt);
-    printed = vsnprintf(buf->buf + buf->size, available, fmt, args);
-    va_end(args);
+    if (!buf_reserve(buf, len + pad))
+        return false;
+
+    memset(buf->buf + buf->size, ' ', pad);
+    memcpy(buf->buf + buf->size + pad, str, len);
+    buf->size += pad + len;
+    return true;
+}
+
+/* Like "%u". */
+static bool
+buf_append_uint(struct buf *buf, unsigned long value)
+{
+    char digits[24];
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    return buf_append(buf, digits + pos, sizeof(digits) - pos);
+}
+
+/* Like "%d". */
+static bool
+buf_append_int(struct buf *buf, long value)
+{
+    if (value < 0)
+        return (buf_append(buf, "-", 1) &&
+                buf_append_uint(buf, 0ul - (unsigned long) value));
+
+    return buf_append_uint(buf, (unsigned long) value);
+}
 
-    if (printed < 0)
-        goto err;
+/* Like "0x%02x". */
+static bool
+buf_append_hex(struct buf *buf, unsigned int value)
+{
+    static const char hex[] = "0123456789abcdef";
+    char digits[2 + 2 * sizeof(value)];
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = hex[value & 0xf];
+        value >>= 4;
+    } while (value > 0 || pos > sizeof(digits) - 2);
+    digits[--pos] = 'x';
+    digits[--pos] = '0';
+
+    return buf_append(buf, digits + pos, sizeof(digits) - pos);
+}
 
-    if ((size_t) printed >= available)
-        if (!do_realloc(buf, printed))
-            goto err;
+/* Like "%*s" with KeysymText(). */
+static bool
+buf_append_keysym(struct buf *buf, xkb_keysym_t sym, size_t width)
+{
+    char name[64];
 
-    /* The buffer has enough space now. */
+    xkb_keysym_get_name(sym, name, sizeof(name));
+    return buf_append_padded(buf, name, strlen(name), width);
+}
 
-    available = buf->alloc - buf->size;
-    va_start(args, fmt);
-    printed = vsnprintf(buf->buf + buf->size, available, fmt, args);
-    va_end(args);
+/* Like "%-*s" with KeyNameText(). */
+static bool
+buf_append_key_name(struct buf *buf, struct xkb_context *ctx,
+                    xkb_atom_t name, size_t width)
+{
+    const char *text = strempty(xkb_atom_text(ctx, name));
+    const size_t len = strlen(text);
+    const size_t pad = (len + 2 < width ? width - len - 2 : 0);
 
-    if (printed < 0 || (size_t) printed >= available)
-        goto err;
+    if (!buf_reserve(buf, len + 2 + pad))
+        return false;
 
-    buf->size += printed;
+    buf->buf[buf->size++] = '<';
+    memcpy(buf->buf + buf->size, text, len);
+    buf->size += len;
+    buf->buf[buf->size++] = '>';
+    memset(buf->buf + buf->size, ' ', pad);
+    buf->size += pad;
     return true;
+}
 
-err:
-    free(buf->buf);
-    buf->buf = NULL;
-    return false;
+/* Like ModMaskText(). */
+static bool
+buf_append_mod_mask(struct buf *buf, struct xkb_context *ctx,
+                    const struct xkb_mod_set *mods, xkb_mod_mask_t mask)
+{
+    xkb_mod_index_t i;
+    const struct xkb_mod *mod;
+    bool first = true;
+
+    if (mask == 0)
+        return buf_append(buf, "none", 4);
+
+    if (mask == MOD_REAL_MASK_ALL)
+        return buf_append(buf, "all", 3);
+
+    xkb_mods_enumerate(i, mod, mods) {
+        if (!(mask & (1u << i)))
+            continue;
+
+        if (!first && !buf_append(buf, "+", 1))
+            return false;
+        if (!buf_append_str(buf, strempty(xkb_atom_text(ctx, mod->name))))
+            return false;
+        first = false;
+    }
+
+    return true;
 }
 
-#define write_buf(buf, ...) do { \
-    if (!check_write_buf(buf, __VA_ARGS__)) \
+#define write_buf(buf, str) do { \
+    if (!buf_append(buf, str, sizeof(str "") - 1)) \
+        return false; \
+} while (0)
+
+/* Write @str, or @compact_str in the compact form. */
+#define write_either(buf, str, compact_str) do { \
+    if ((buf)->compact) \
+        write_buf(buf, compact_str); \
+    else \
+        write_buf(buf, str); \
+} while (0)
+
+/* The compact form is not aligned. */
+#define WIDTH(buf, width) ((buf)->compact ? 0 : (width))
+
+#define write_str(buf, str) do { \
+    if (!buf_append_str(buf, str)) \
         return false; \
 } while (0)
 
+#define write_uint(buf, value) do { \
+    if (!buf_append_uint(buf, value)) \
+        return false; \
+} while (0)
+
+#define write_int(buf, value) do { \
+    if (!buf_append_int(buf, value)) \
+        return false; \
+} while (0)
+
+#define write_hex(buf, value) do { \
+    if (!buf_append_hex(buf, value)) \
+        return false; \
+} while (0)
+
+#define write_keysym(buf, sym, width) do { \
+    if (!buf_append_keysym(buf, sym, width)) \
+        return false; \
+} while (0)
+
+#define write_key_name(buf, keymap, name, width) do { \
+    if (!buf_append_key_name(buf, (keymap)->ctx, name, width)) \
+        return false; \
+} while (0)
+
+#define write_mod_mask(buf, keymap, mask) do { \
+    if (!buf_append_mod_mask(buf, (keymap)->ctx, &(keymap)->mods, mask)) \
+        return false; \
+} while (0)
+
+#define write_atom(buf, keymap, atom) \
+    write_str(buf, strempty(xkb_atom_text((keymap)->ctx, atom)))
+
 static bool
 write_vmods(struct xkb_keymap *keymap, struct buf *buf)
 {
@@ -133,19 +292,32 @@ write_vmods(struct xkb_keymap *keymap, struct buf *buf)
             continue;
 
         if (num_vmods == 0)
-            write_buf(buf, "\tvirtual_modifiers ");
+            write_either(buf, "\tvirtual_modifiers ", "virtual_modifiers ");
         else
             write_buf(buf, ",");
-        write_buf(buf, "%s", xkb_atom_text(keymap->ctx, mod->name));
+        write_atom(buf, keymap, mod->name);
         num_vmods++;
     }
 
     if (num_vmods > 0)
-        write_buf(buf, ";\n\n");
+        write_either(buf, ";\n\n", ";\n");
 
     return true;
 }
 
+static bool
+write_section_name(struct buf *buf, const char *section, const char *name)
+{
+    write_str(buf, section);
+    if (name) {
+        write_buf(buf, " \"");
+        write_str(buf, name);
+        write_buf(buf, "\"");
+    }
+    write_either(buf, " {\n", "{\n");
+    return true;
+}
+
 static bool
 write_keycodes(struct xkb_keymap *keymap, struct buf *buf)
 {
@@ -153,64 +325,94 @@ write_keycodes(struct xkb_keymap *keymap, struct buf *buf)
     xkb_led_index_t idx;
     const struct xkb_led *led;
 
-    if (keymap->keycodes_section_name)
-        write_buf(buf, "xkb_keycodes \"%s\" {\n",
-                  keymap->keycodes_section_name);
-    else
-        write_buf(buf, "xkb_keycodes {\n");
+    if (!write_section_name(buf, "xkb_keycodes",
+                            keymap->keycodes_section_name))
+        return false;
 
     /* xkbcomp and X11 really want to see keymaps with a minimum of 8, and
      * a maximum of at least 255, else XWayland really starts hating life.
      * If this is a problem and people really need strictly bounded keymaps,
      * we should probably control this with a flag. */
-    write_buf(buf, "\tminimum = %u;\n", MIN(keymap->min_key_code, 8));
-    write_buf(buf, "\tmaximum = %u;\n", MAX(keymap->max_key_code, 255));
+    write_either(buf, "\tminimum = ", "minimum=");
+    write_uint(buf, MIN(keymap->min_key_code, 8));
+    write_either(buf, ";\n\tmaximum = ", ";\nmaximum=");
+    write_uint(buf, MAX(keymap->max_key_code, 255));
+    write_buf(buf, ";\n");
 
     xkb_keys_foreach(key, keymap) {
         if (key->name == XKB_ATOM_NONE)
             continue;
 
-        write_buf(buf, "\t%-20s = %u;\n",
-                  KeyNameText(keymap->ctx, key->name), key->keycode);
+        write_either(buf, "\t", "");
+        write_key_name(buf, keymap, key->name, WIDTH(buf, 20));
+        write_either(buf, " = ", "=");
+        write_uint(buf, key->keycode);
+        write_buf(buf, ";\n");
     }
 
-    xkb_leds_enumerate(idx, led, keymap)
-        if (led->name != XKB_ATOM_NONE)
-            write_buf(buf, "\tindicator %u = \"%s\";\n",
-                      idx + 1, xkb_atom_text(keymap->ctx, led->name));
+    xkb_leds_enumerate(idx, led, keymap) {
+        if (led->name != XKB_ATOM_NONE) {
+            write_either(buf, "\tindicator ", "indicator ");
+            write_uint(buf, idx + 1);
+            write_either(buf, " = \"", "=\"");
+            write_atom(buf, keymap, led->name);
+            write_buf(buf, "\";\n");
+        }
+    }
 
 
-    for (unsigned i = 0; i < keymap->num_key_aliases; i++)
-        write_buf(buf, "\talias %-14s = %s;\n",
-                  KeyNameText(keymap->ctx, keymap->key_aliases[i].alias),
-                  KeyNameText(keymap->ctx, keymap->key_aliases[i].real));
+    for (unsigned i = 0; i < keymap->num_key_aliases; i++) {
+        write_either(buf, "\talias ", "alias ");
+        write_key_name(buf, keymap, keymap->key_aliases[i].alias,
+                       WIDTH(buf, 14));
+        write_either(buf, " = ", "=");
+        write_key_name(buf, keymap, keymap->key_aliases[i].real, 0);
+        write_buf(buf, ";\n");
+    }
 
-    write_buf(buf, "};\n\n");
+    write_either(buf, "};\n\n", "};\n");
     return true;
 }
 
+/* Whether the type has anything to write besides its modifiers. */
+static bool
+type_has_body(const struct xkb_key_type *type)
+{
+    for (unsigned i = 0; i < type->num_entries; i++)
+        if (type->entries[i].level != 0 || type->entries[i].preserve.mods)
+            return true;
+
+    for (xkb_level_index_t n = 0; n < type->num_level_names; n++)
+        if (type->level_names[n])
+            return true;
+
+    return false;
+}
+
 static bool
 write_types(struct xkb_keymap *keymap, struct buf *buf)
 {
-    if (keymap->types_section_name)
-        write_buf(buf, "xkb_types \"%s\" {\n",
-                  keymap->types_section_name);
-    else
-        write_buf(buf, "xkb_types {\n");
+    if (!write_section_name(buf, "xkb_types", keymap->types_section_name))
+        return false;
 
-    write_vmods(keymap, buf);
+    if (!write_vmods(keymap, buf))
+        return false;
 
     for (unsigned i = 0; i < keymap->num_types; i++) {
         const struct xkb_key_type *type = &keymap->types[i];
 
-        write_buf(buf, "\ttype \"%s\" {\n",
-                  xkb_atom_text(keymap->ctx, type->name));
+        write_either(buf, "\ttype \"", "type \"");
+        write_atom(buf, keymap, type->name);
+        write_either(buf, "\" {\n", "\"{");
 
-        write_buf(buf, "\t\tmodifiers= %s;\n",
-                  ModMaskText(keymap->ctx, &keymap->mods, type->mods.mods));
+        /* A type needs at least one statement. */
+        if (!buf->compact || type->mods.mods || !type_has_body(type)) {
+            write_either(buf, "\t\tmodifiers= ", "modifiers=");
+            write_mod_mask(buf, keymap, type->mods.mods);
+            write_either(buf, ";\n", ";");
+        }
 
         for (unsigned j = 0; j < type->num_entries; j++) {
-            const char *str;
             const struct xkb_key_type_entry *entry = &type->entries[j];
 
             /*
@@ -220,25 +422,35 @@ write_types(struct xkb_keymap *keymap, struct buf *buf)
             if (entry->level == 0 && entry->preserve.mods == 0)
                 continue;
 
-            str = ModMaskText(keymap->ctx, &keymap->mods, entry->mods.mods);
-            write_buf(buf, "\t\tmap[%s]= %u;\n",
-                      str, entry->level + 1);
-
-            if (entry->preserve.mods)
-                write_buf(buf, "\t\tpreserve[%s]= %s;\n",
-                          str, ModMaskText(keymap->ctx, &keymap->mods,
-                                           entry->preserve.mods));
+            write_either(buf, "\t\tmap[", "map[");
+            write_mod_mask(buf, keymap, entry->mods.mods);
+            write_either(buf, "]= ", "]=");
+            write_uint(buf, entry->level + 1);
+            write_either(buf, ";\n", ";");
+
+            if (entry->preserve.mods) {
+                write_either(buf, "\t\tpreserve[", "preserve[");
+                write_mod_mask(buf, keymap, entry->mods.mods);
+                write_either(buf, "]= ", "]=");
+                write_mod_mask(buf, keymap, entry->preserve.mods);
+                write_either(buf, ";\n", ";");
+            }
         }
 
-        for (xkb_level_index_t n = 0; n < type->num_level_names; n++)
-            if (type->level_names[n])
-                write_buf(buf, "\t\tlevel_name[%u]= \"%s\";\n", n + 1,
-                          xkb_atom_text(keymap->ctx, type->level_names[n]));
+        for (xkb_level_index_t n = 0; n < type->num_level_names; n++) {
+            if (type->level_names[n]) {
+                write_either(buf, "\t\tlevel_name[", "level_name[");
+                write_uint(buf, n + 1);
+                write_either(buf, "]= \"", "]=\"");
+                write_atom(buf, keymap, type->level_names[n]);
+                write_either(buf, "\";\n", "\";");
+            }
+        }
 
-        write_buf(buf, "\t};\n");
+        write_either(buf, "\t};\n", "};\n");
     }
 
-    write_buf(buf, "};\n\n");
+    write_either(buf, "};\n\n", "};\n");
     return true;
 }
 
@@ -246,33 +458,39 @@ static bool
 write_led_map(struct xkb_keymap *keymap, struct buf *buf,
               const struct xkb_led *led)
 {
-    write_buf(buf, "\tindicator \"%s\" {\n",
-              xkb_atom_text(keymap->ctx, led->name));
+    write_either(buf, "\tindicator \"", "indicator \"");
+    write_atom(buf, keymap, led->name);
+    write_either(buf, "\" {\n", "\"{");
 
     if (led->which_groups) {
         if (led->which_groups != XKB_STATE_LAYOUT_EFFECTIVE) {
-            write_buf(buf, "\t\twhichGroupState= %s;\n",
-                      LedStateMaskText(keymap->ctx, led->which_groups));
+            write_either(buf, "\t\twhichGroupState= ", "whichGroupState=");
+            write_str(buf, LedStateMaskText(keymap->ctx, led->which_groups));
+            write_either(buf, ";\n", ";");
         }
-        write_buf(buf, "\t\tgroups= 0x%02x;\n",
-                  led->groups);
+        write_either(buf, "\t\tgroups= ", "groups=");
+        write_hex(buf, led->groups);
+        write_either(buf, ";\n", ";");
     }
 
     if (led->which_mods) {
         if (led->which_mods != XKB_STATE_MODS_EFFECTIVE) {
-            write_buf(buf, "\t\twhichModState= %s;\n",
-                      LedStateMaskText(keymap->ctx, led->which_mods));
+            write_either(buf, "\t\twhichModState= ", "whichModState=");
+            write_str(buf, LedStateMaskText(keymap->ctx, led->which_mods));
+            write_either(buf, ";\n", ";");
         }
-        write_buf(buf, "\t\tmodifiers= %s;\n",
-                  ModMaskText(keymap->ctx, &keymap->mods, led->mods.mods));
+        write_either(buf, "\t\tmodifiers= ", "modifiers=");
+        write_mod_mask(buf, keymap, led->mods.mods);
+        write_either(buf, ";\n", ";");
     }
 
     if (led->ctrls) {
-        write_buf(buf, "\t\tcontrols= %s;\n",
-                  ControlMaskText(keymap->ctx, led->ctrls));
+        write_either(buf, "\t\tcontrols= ", "controls=");
+        write_str(buf, ControlMaskText(keymap->ctx, led->ctrls));
+        write_either(buf, ";\n", ";");
     }
 
-    write_buf(buf, "\t};\n");
+    write_either(buf, "\t};\n", "};\n");
     return true;
 }
 
@@ -290,203 +508,294 @@ affect_lock_text(enum xkb_action_flags flags)
     return "";
 }
 
+/* A number with an explicit sign if it is relative, e.g. "+1". */
 static bool
-write_action(struct xkb_keymap *keymap, struct buf *buf,
-             const union xkb_action *action,
-             const char *prefix, const char *suffix)
+write_relative(struct buf *buf, bool absolute, int value, bool plus_zero)
 {
-    const char *type;
-    const char *args = NULL;
+    if (!absolute && (value > 0 || (plus_zero && value == 0)))
+        write_buf(buf, "+");
+    write_int(buf, value);
+    return true;
+}
 
-    if (!prefix)
-        prefix = "";
-    if (!suffix)
-        suffix = "";
+static bool
+write_action(struct xkb_keymap *keymap, struct buf *buf,
+             const union xkb_action *action)
+{
+    const char *type = ActionTypeText(action->type);
 
-    type = ActionTypeText(action->type);
+    if (action->type != ACTION_TYPE_NONE)
+        write_str(buf, type);
 
     switch (action->type) {
     case ACTION_TYPE_MOD_SET:
     case ACTION_TYPE_MOD_LATCH:
     case ACTION_TYPE_MOD_LOCK:
+        write_buf(buf, "(modifiers=");
         if (action->mods.flags & ACTION_MODS_LOOKUP_MODMAP)
-            args = "modMapMods";
+            write_buf(buf, "modMapMods");
         else
-            args = ModMaskText(keymap->ctx, &keymap->mods,
-                               action->mods.mods.mods);
-        write_buf(buf, "%s%s(modifiers=%s%s%s%s)%s", prefix, type, args,
-                  (action->type != ACTION_TYPE_MOD_LOCK && (action->mods.flags & ACTION_LOCK_CLEAR)) ? ",clearLocks" : "",
-                  (action->type != ACTION_TYPE_MOD_LOCK && (action->mods.flags & ACTION_LATCH_TO_LOCK)) ? ",latchToLock" : "",
-                  (action->type == ACTION_TYPE_MOD_LOCK) ? affect_lock_text(action->mods.flags) : "",
-                  suffix);
+            write_mod_mask(buf, keymap, action->mods.mods.mods);
+        if (action->type != ACTION_TYPE_MOD_LOCK) {
+            if (action->mods.flags & ACTION_LOCK_CLEAR)
+                write_buf(buf, ",clearLocks");
+            if (action->mods.flags & ACTION_LATCH_TO_LOCK)
+                write_buf(buf, ",latchToLock");
+        }
+        else {
+            write_str(buf, affect_lock_text(action->mods.flags));
+        }
+        write_buf(buf, ")");
         break;
 
     case ACTION_TYPE_GROUP_SET:
     case ACTION_TYPE_GROUP_LATCH:
     case ACTION_TYPE_GROUP_LOCK:
-        write_buf(buf, "%s%s(group=%s%d%s%s)%s", prefix, type,
-                  (!(action->group.flags & ACTION_ABSOLUTE_SWITCH) && action->group.group > 0) ? "+" : "",
-                  (action->group.flags & ACTION_ABSOLUTE_SWITCH) ? action->group.group + 1 : action->group.group,
-                  (action->type != ACTION_TYPE_GROUP_LOCK && (action->group.flags & ACTION_LOCK_CLEAR)) ? ",clearLocks" : "",
-                  (action->type != ACTION_TYPE_GROUP_LOCK && (action->group.flags & ACTION_LATCH_TO_LOCK)) ? ",latchToLock" : "",
-                  suffix);
+        write_buf(buf, "(group=");
+        if (action->group.flags & ACTION_ABSOLUTE_SWITCH)
+            write_int(buf, action->group.group + 1);
+        else if (!write_relative(buf, false, action->group.group, false))
+            return false;
+        if (action->type != ACTION_TYPE_GROUP_LOCK) {
+            if (action->group.flags & ACTION_LOCK_CLEAR)
+                write_buf(buf, ",clearLocks");
+            if (action->group.flags & ACTION_LATCH_TO_LOCK)
+                write_buf(buf, ",latchToLock");
+        }
+        write_buf(buf, ")");
         break;
 
     case ACTION_TYPE_TERMINATE:
-        write_buf(buf, "%s%s()%s", prefix, type, suffix);
+        write_buf(buf, "()");
         break;
 
     case ACTION_TYPE_PTR_MOVE:
-        write_buf(buf, "%s%s(x=%s%d,y=%s%d%s)%s", prefix, type,
-                  (!(action->ptr.flags & ACTION_ABSOLUTE_X) && action->ptr.x >= 0) ? "+" : "",
-                  action->ptr.x,
-                  (!(action->ptr.flags & ACTION_ABSOLUTE_Y) && action->ptr.y >= 0) ? "+" : "",
-                  action->ptr.y,
-                  (action->ptr.flags & ACTION_ACCEL) ? "" : ",!accel",
-                  suffix);
+        write_buf(buf, "(x=");
+        if (!write_relative(buf, action->ptr.flags & ACTION_ABSOLUTE_X,
+                            action->ptr.x, true))
+            return false;
+        write_buf(buf, ",y=");
+        if (!write_relative(buf, action->ptr.flags & ACTION_ABSOLUTE_Y,
+                            action->ptr.y, true))
+            return false;
+        if (!(action->ptr.flags & ACTION_ACCEL))
+            write_buf(buf, ",!accel");
+        write_buf(buf, ")");
         break;
 
     case ACTION_TYPE_PTR_LOCK:
-        args = affect_lock_text(action->btn.flags);
-        /* fallthrough */
     case ACTION_TYPE_PTR_BUTTON:
-        write_buf(buf, "%s%s(button=", prefix, type);
+        write_buf(buf, "(button=");
         if (action->btn.button > 0 && action->btn.button <= 5)
-            write_buf(buf, "%d", action->btn.button);
+            write_int(buf, action->btn.button);
         else
             write_buf(buf, "default");
-        if (action->btn.count)
-            write_buf(buf, ",count=%d", action->btn.count);
-        if (args)
-            write_buf(buf, "%s", args);
-        write_buf(buf, ")%s", suffix);
+        if (action->btn.count) {
+            write_buf(buf, ",count=");
+            write_int(buf, action->btn.count);
+        }
+        if (action->type == ACTION_TYPE_PTR_LOCK)
+            write_str(buf, affect_lock_text(action->btn.flags));
+        write_buf(buf, ")");
         break;
 
     case ACTION_TYPE_PTR_DEFAULT:
-        write_buf(buf, "%s%s(", prefix, type);
-        write_buf(buf, "affect=button,button=%s%d",
-                  (!(action->dflt.flags & ACTION_ABSOLUTE_SWITCH) && action->dflt.value >= 0) ? "+" : "",
-                  action->dflt.value);
-        write_buf(buf, ")%s", suffix);
+        write_buf(buf, "(affect=button,button=");
+        if (!write_relative(buf, action->dflt.flags & ACTION_ABSOLUTE_SWITCH,
+                            action->dflt.value, true))
+            return false;
+        write_buf(buf, ")");
         break;
 
     case ACTION_TYPE_SWITCH_VT:
-        write_buf(buf, "%s%s(screen=%s%d,%ssame)%s", prefix, type,
-                  (!(action->screen.flags & ACTION_ABSOLUTE_SWITCH) && action->screen.screen >= 0) ? "+" : "",
-                  action->screen.screen,
-                  (action->screen.flags & ACTION_SAME_SCREEN) ? "" : "!",
-                  suffix);
+        write_buf(buf, "(screen=");
+        if (!write_relative(buf, action->screen.flags & ACTION_ABSOLUTE_SWITCH,
+                            action->screen.screen, true))
+            return false;
+        if (action->screen.flags & ACTION_SAME_SCREEN)
+            write_buf(buf, ",same)");
+        else
+            write_buf(buf, ",!same)");
         break;
 
     case ACTION_TYPE_CTRL_SET:
     case ACTION_TYPE_CTRL_LOCK:
-        write_buf(buf, "%s%s(controls=%s%s)%s", prefix, type,
-                  ControlMaskText(keymap->ctx, action->ctrls.ctrls),
-                  (action->type == ACTION_TYPE_CTRL_LOCK) ? affect_lock_text(action->ctrls.flags) : "",
-                  suffix);
+        write_buf(buf, "(controls=");
+        write_str(buf, ControlMaskText(keymap->ctx, action->ctrls.ctrls));
+        if (action->type == ACTION_TYPE_CTRL_LOCK)
+            write_str(buf, affect_lock_text(action->ctrls.flags));
+        write_buf(buf, ")");
         break;
 
     case ACTION_TYPE_NONE:
-        write_buf(buf, "%sNoAction()%s", prefix, suffix);
+        write_buf(buf, "NoAction()");
         break;
 
     default:
-        write_buf(buf,
-                  "%s%s(type=0x%02x,data[0]=0x%02x,data[1]=0x%02x,data[2]=0x%02x,data[3]=0x%02x,data[4]=0x%02x,data[5]=0x%02x,data[6]=0x%02x)%s",
-                  prefix, type, action->type, action->priv.data[0],
-                  action->priv.data[1], action->priv.data[2],
-                  action->priv.data[3], action->priv.data[4],
-                  action->priv.data[5], action->priv.data[6],
-                  suffix);
+        write_buf(buf, "(type=");
+        write_hex(buf, action->type);
+        for (unsigned i = 0; i < 7; i++) {
+            write_buf(buf, ",data[");
+            write_uint(buf, i);
+            write_buf(buf, "]=");
+            write_hex(buf, action->priv.data[i]);
+        }
+        write_buf(buf, ")");
         break;
     }
 
     return true;
 }
 
+static bool
+write_interp_match(struct xkb_keymap *keymap, struct buf *buf,
+                   const struct xkb_sym_interpret *si)
+{
+    if (buf->compact) {
+        /* The defaults of "interpret <sym>" and "interpret <sym>+<mods>". */
+        if (si->match == MATCH_ANY_OR_NONE && si->mods == MOD_REAL_MASK_ALL)
+            return true;
+
+        if (si->match == MATCH_EXACTLY) {
+            write_buf(buf, "+");
+            write_mod_mask(buf, keymap, si->mods);
+            return true;
+        }
+    }
+
+    write_buf(buf, "+");
+    write_str(buf, SIMatchText(si->match));
+    write_buf(buf, "(");
+    write_mod_mask(buf, keymap, si->mods);
+    write_buf(buf, ")");
+    return true;
+}
+
 static bool
 write_compat(struct xkb_keymap *keymap, struct buf *buf)
 {
     const struct xkb_led *led;
 
-    if (keymap->compat_section_name)
-        write_buf(buf, "xkb_compatibility \"%s\" {\n",
-                  keymap->compat_section_name);
-    else
-        write_buf(buf, "xkb_compatibility {\n");
+    if (!write_section_name(buf, "xkb_compatibility",
+                            keymap->compat_section_name))
+        return false;
 
-    write_vmods(keymap, buf);
+    /*
+     * The compact form leaves out the defaults, and the virtual modifiers
+     * which the types section already declared.
+     */
+    if (!buf->compact) {
+        if (!write_vmods(keymap, buf))
+            return false;
 
-    write_buf(buf, "\tinterpret.useModMapMods= AnyLevel;\n");
-    write_buf(buf, "\tinterpret.repeat= False;\n");
+        write_buf(buf, "\tinterpret.useModMapMods= AnyLevel;\n");
+        write_buf(buf, "\tinterpret.repeat= False;\n");
+    }
 
     for (unsigned i = 0; i < keymap->num_sym_interprets; i++) {
         const struct xkb_sym_interpret *si = &keymap->sym_interprets[i];
+        bool has_body = false;
 
-        write_buf(buf, "\tinterpret %s+%s(%s) {\n",
-                  si->sym ? KeysymText(keymap->ctx, si->sym) : "Any",
-                  SIMatchText(si->match),
-                  ModMaskText(keymap->ctx, &keymap->mods, si->mods));
-
-        if (si->virtual_mod != XKB_MOD_INVALID)
-            write_buf(buf, "\t\tvirtualModifier= %s;\n",
-                      ModIndexText(keymap->ctx, &keymap->mods,
-                                   si->virtual_mod));
+        write_either(buf, "\tinterpret ", "interpret ");
+        if (si->sym)
+            write_keysym(buf, si->sym, 0);
+        else
+            write_buf(buf, "Any");
+        if (!write_interp_match(keymap, buf, si))
+            return false;
+        write_either(buf, " {\n", "{");
+
+        if (si->virtual_mod != XKB_MOD_INVALID) {
+            write_either(buf, "\t\tvirtualModifier= ", "virtualModifier=");
+            write_str(buf, ModIndexText(keymap->ctx, &keymap->mods,
+                                        si->virtual_mod));
+            write_either(buf, ";\n", ";");
+            has_body = true;
+        }
 
-        if (si->level_one_only)
-            write_buf(buf, "\t\tuseModMapMods=level1;\n");
+        if (si->level_one_only) {
+            write_either(buf, "\t\tuseModMapMods=level1;\n",
+                         "useModMapMods=level1;");
+            has_body = true;
+        }
 
-        if (si->repeat)
-            write_buf(buf, "\t\trepeat= True;\n");
+        if (si->repeat) {
+            write_either(buf, "\t\trepeat= True;\n", "repeat=True;");
+            has_body = true;
+        }
 
-        write_action(keymap, buf, &si->action, "\t\taction= ", ";\n");
-        write_buf(buf, "\t};\n");
+        /* An interpret needs at least one statement. */
+        if (!buf->compact || si->action.type != ACTION_TYPE_NONE ||
+            !has_body) {
+            write_either(buf, "\t\taction= ", "action=");
+            if (!write_action(keymap, buf, &si->action))
+                return false;
+            write_either(buf, ";\n", ";");
+        }
+        write_either(buf, "\t};\n", "};\n");
     }
 
     xkb_leds_foreach(led, keymap)
         if (led->which_groups || led->groups || led->which_mods ||
             led->mods.mods || led->ctrls)
-            write_led_map(keymap, buf, led);
+            if (!write_led_map(keymap, buf, led))
+                return false;
 
-    write_buf(buf, "};\n\n");
+    write_either(buf, "};\n\n", "};\n");
 
     return true;
 }
 
 static bool
 write_keysyms(struct xkb_keymap *keymap, struct buf *buf,
-              const struct xkb_key *key, xkb_layout_index_t group)
+              const struct xkb_key *key, xkb_layout_index_t group,
+              xkb_level_index_t num_levels)
 {
-    for (xkb_level_index_t level = 0; level < XkbKeyNumLevels(key, group);
-         level++) {
+    for (xkb_level_index_t level = 0; level < num_levels; level++) {
         const xkb_keysym_t *syms;
         int num_syms;
 
         if (level != 0)
-            write_buf(buf, ", ");
+            write_either(buf, ", ", ",");
 
         num_syms = xkb_keymap_key_get_syms_by_level(keymap, key->keycode,
                                                     group, level, &syms);
         if (num_syms == 0) {
-            write_buf(buf, "%15s", "NoSymbol");
+            write_either(buf, "       NoSymbol", "NoSymbol");
         }
         else if (num_syms == 1) {
-            write_buf(buf, "%15s", KeysymText(keymap->ctx, syms[0]));
+            write_keysym(buf, syms[0], WIDTH(buf, 15));
         }
         else {
-            write_buf(buf, "{ ");
+            write_either(buf, "{ ", "{");
             for (int s = 0; s < num_syms; s++) {
                 if (s != 0)
-                    write_buf(buf, ", ");
-                write_buf(buf, "%s", KeysymText(keymap->ctx, syms[s]));
+                    write_either(buf, ", ", ",");
+                write_keysym(buf, syms[s], 0);
             }
-            write_buf(buf, " }");
+            write_either(buf, " }", "}");
         }
     }
 
     return true;
 }
 
+static bool
+write_actions(struct xkb_keymap *keymap, struct buf *buf,
+              const struct xkb_key *key, xkb_layout_index_t group,
+              xkb_level_index_t num_levels)
+{
+    for (xkb_level_index_t level = 0; level < num_levels; level++) {
+        if (level != 0)
+            write_either(buf, ", ", ",");
+        if (!write_action(keymap, buf,
+                          &key->groups[group].levels[level].action))
+            return false;
+    }
+
+    return true;
+}
+
 static bool
 write_key(struct xkb_keymap *keymap, struct buf *buf,
           const struct xkb_key *key)
@@ -497,7 +806,9 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
     bool multi_type = false;
     bool show_actions;
 
-    write_buf(buf, "\tkey %-20s {", KeyNameText(keymap->ctx, key->name));
+    write_buf(buf, "\tkey ");
+    write_key_name(buf, keymap, key->name, 20);
+    write_buf(buf, " {");
 
     for (group = 0; group < key->num_groups; group++) {
         if (key->groups[group].explicit_type)
@@ -517,15 +828,18 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
                     continue;
 
                 type = key->groups[group].type;
-                write_buf(buf, "\n\t\ttype[Group%u]= \"%s\",",
-                            group + 1,
-                            xkb_atom_text(keymap->ctx, type->name));
+                write_buf(buf, "\n\t\ttype[Group");
+                write_uint(buf, group + 1);
+                write_buf(buf, "]= \"");
+                write_atom(buf, keymap, type->name);
+                write_buf(buf, "\",");
             }
         }
         else {
             type = key->groups[0].type;
-            write_buf(buf, "\n\t\ttype= \"%s\",",
-                        xkb_atom_text(keymap->ctx, type->name));
+            write_buf(buf, "\n\t\ttype= \"");
+            write_atom(buf, keymap, type->name);
+            write_buf(buf, "\",");
         }
     }
 
@@ -537,9 +851,11 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
         simple = false;
     }
 
-    if (key->vmodmap && (key->explicit & EXPLICIT_VMODMAP))
-        write_buf(buf, "\n\t\tvirtualMods= %s,",
-                  ModMaskText(keymap->ctx, &keymap->mods, key->vmodmap));
+    if (key->vmodmap && (key->explicit & EXPLICIT_VMODMAP)) {
+        write_buf(buf, "\n\t\tvirtualMods= ");
+        write_mod_mask(buf, keymap, key->vmodmap);
+        write_buf(buf, ",");
+    }
 
     switch (key->out_of_range_group_action) {
     case RANGE_SATURATE:
@@ -547,8 +863,9 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
         break;
 
     case RANGE_REDIRECT:
-        write_buf(buf, "\n\t\tgroupsRedirect= Group%u,",
-                    key->out_of_range_group_number + 1);
+        write_buf(buf, "\n\t\tgroupsRedirect= Group");
+        write_uint(buf, key->out_of_range_group_number + 1);
+        write_buf(buf, ",");
         break;
 
     default:
@@ -562,29 +879,28 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
 
     if (simple) {
         write_buf(buf, "\t[ ");
-        if (!write_keysyms(keymap, buf, key, 0))
+        if (!write_keysyms(keymap, buf, key, 0, XkbKeyNumLevels(key, 0)))
             return false;
         write_buf(buf, " ] };\n");
     }
     else {
-        xkb_level_index_t level;
-
         for (group = 0; group < key->num_groups; group++) {
             if (group != 0)
                 write_buf(buf, ",");
-            write_buf(buf, "\n\t\tsymbols[Group%u]= [ ", group + 1);
-            if (!write_keysyms(keymap, buf, key, group))
+            write_buf(buf, "\n\t\tsymbols[Group");
+            write_uint(buf, group + 1);
+            write_buf(buf, "]= [ ");
+            if (!write_keysyms(keymap, buf, key, group,
+                               XkbKeyNumLevels(key, group)))
                 return false;
             write_buf(buf, " ]");
             if (show_actions) {
-                write_buf(buf, ",\n\t\tactions[Group%u]= [ ", group + 1);
-                for (level = 0; level < XkbKeyNumLevels(key, group); level++) {
-                    if (level != 0)
-                        write_buf(buf, ", ");
-                    write_action(keymap, buf,
-                                    &key->groups[group].levels[level].action,
-                                    NULL, NULL);
-                }
+                write_buf(buf, ",\n\t\tactions[Group");
+                write_uint(buf, group + 1);
+                write_buf(buf, "]= [ ");
+                if (!write_actions(keymap, buf, key, group,
+                                   XkbKeyNumLevels(key, group)))
+                    return false;
                 write_buf(buf, " ]");
             }
         }
@@ -594,6 +910,187 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
     return true;
 }
 
+/*
+ * How many levels of a group to write in the compact form, and whether
+ * its type must be written: the compiler pads the levels up to the
+ * number of levels of the type, and infers the type from the keysyms of
+ * the levels it is given.
+ */
+static xkb_level_index_t
+compact_group_width(struct xkb_keymap *keymap, const struct xkb_key *key,
+                    xkb_layout_index_t group, bool *write_type)
+{
+    const struct xkb_group *g = &key->groups[group];
+    const xkb_level_index_t num_levels = XkbKeyNumLevels(key, group);
+    const bool show_actions = (key->explicit & EXPLICIT_INTERP);
+    xkb_keysym_t syms[4] = { XKB_KEY_NoSymbol };
+    xkb_level_index_t width = 1;
+
+    for (xkb_level_index_t level = 0; level < num_levels; level++) {
+        if (g->levels[level].num_syms > 0 ||
+            (show_actions && g->levels[level].action.type != ACTION_TYPE_NONE))
+            width = level + 1;
+        if (level < ARRAY_SIZE(syms))
+            syms[level] = XkbLevelFirstSym(&g->levels[level]);
+    }
+
+    *write_type = false;
+    for (xkb_level_index_t w = width; w <= num_levels; w++) {
+        /* The first keysyms of the levels past w are NoSymbol anyway. */
+        if (FindAutomaticType(keymap->ctx, w, syms) == g->type->name)
+            return w;
+    }
+
+    *write_type = true;
+    return width;
+}
+
+/*
+ * The compact form of a key. Besides the types and levels the compiler
+ * fills in by itself, it leaves out the groups between others which are
+ * the same as the first one: the compiler copies the first group into
+ * them. The group indexes are only written where they do not follow from
+ * the order of the groups.
+ */
+static bool
+write_key_compact(struct xkb_keymap *keymap, struct buf *buf,
+                  const struct xkb_key *key)
+{
+    const bool show_actions = (key->explicit & EXPLICIT_INTERP);
+    xkb_level_index_t widths[XKB_MAX_GROUPS];
+    bool write_type[XKB_MAX_GROUPS];
+    bool write_acts[XKB_MAX_GROUPS];
+    bool skip[XKB_MAX_GROUPS];
+    bool any_acts = false, first = true;
+    xkb_layout_index_t next_syms = 0, next_acts = 0;
+
+    for (xkb_layout_index_t group = 0; group < key->num_groups; group++) {
+        const struct xkb_group *g = &key->groups[group];
+
+        skip[group] = (group > 0 && group + 1 < key->num_groups &&
+                       XkbGroupsSame(g, &key->groups[0],
+                                     XkbKeyNumLevels(key, group)));
+        if (skip[group])
+            continue;
+
+        widths[group] = compact_group_width(keymap, key, group,
+                                            &write_type[group]);
+
+        write_acts[group] = false;
+        if (show_actions)
+            for (xkb_level_index_t level = 0; level < widths[group]; level++)
+                if (g->levels[level].action.type != ACTION_TYPE_NONE)
+                    write_acts[group] = true;
+        any_acts = any_acts || write_acts[group];
+    }
+
+    /* Some actions must be there, or the interprets would apply. */
+    if (show_actions && !any_acts)
+        write_acts[0] = true;
+
+#define write_separator(buf) do { \
+    if (!first) \
+        write_buf(buf, ","); \
+    first = false; \
+} while (0)
+
+    write_buf(buf, "key ");
+    write_key_name(buf, keymap, key->name, 0);
+    write_buf(buf, "{");
+
+    for (xkb_layout_index_t group = 0; group < key->num_groups; group++) {
+        if (skip[group] || !write_type[group])
+            continue;
+
+        write_separator(buf);
+        if (key->num_groups == 1) {
+            write_buf(buf, "type=\"");
+        }
+        else {
+            write_buf(buf, "type[Group");
+            write_uint(buf, group + 1);
+            write_buf(buf, "]=\"");
+        }
+        write_atom(buf, keymap, key->groups[group].type->name);
+        write_buf(buf, "\"");
+    }
+
+    if (key->explicit & EXPLICIT_REPEAT) {
+        write_separator(buf);
+        if (key->repeats)
+            write_buf(buf, "repeat=Yes");
+        else
+            write_buf(buf, "repeat=No");
+    }
+
+    if (key->vmodmap && (key->explicit & EXPLICIT_VMODMAP)) {
+        write_separator(buf);
+        write_buf(buf, "virtualMods=");
+        write_mod_mask(buf, keymap, key->vmodmap);
+    }
+
+    switch (key->out_of_range_group_action) {
+    case RANGE_SATURATE:
+        write_separator(buf);
+        write_buf(buf, "groupsClamp");
+        break;
+
+    case RANGE_REDIRECT:
+        write_separator(buf);
+        write_buf(buf, "groupsRedirect=Group");
+        write_uint(buf, key->out_of_range_group_number + 1);
+        break;
+
+    default:
+        break;
+    }
+
+    /*
+     * A list without a group index goes to the first group which doesn't
+     * have one yet.
+     */
+    for (xkb_layout_index_t group = 0; group < key->num_groups; group++) {
+        if (skip[group])
+            continue;
+
+        write_separator(buf);
+        if (next_syms == group) {
+            next_syms++;
+        }
+        else {
+            write_buf(buf, "symbols[Group");
+            write_uint(buf, group + 1);
+            write_buf(buf, "]=");
+        }
+        write_buf(buf, "[");
+        if (!write_keysyms(keymap, buf, key, group, widths[group]))
+            return false;
+        write_buf(buf, "]");
+
+        if (!write_acts[group])
+            continue;
+
+        write_buf(buf, ",");
+        if (next_acts == group) {
+            next_acts++;
+        }
+        else {
+            write_buf(buf, "actions[Group");
+            write_uint(buf, group + 1);
+            write_buf(buf, "]=");
+        }
+        write_buf(buf, "[");
+        if (!write_actions(keymap, buf, key, group, widths[group]))
+            return false;
+        write_buf(buf, "]");
+    }
+
+#undef write_separator
+
+    write_buf(buf, "};\n");
+    return true;
+}
+
 static bool
 write_symbols(struct xkb_keymap *keymap, struct buf *buf)
 {
@@ -602,65 +1099,108 @@ write_symbols(struct xkb_keymap *keymap, struct buf *buf)
     xkb_mod_index_t i;
     const struct xkb_mod *mod;
 
-    if (keymap->symbols_section_name)
-        write_buf(buf, "xkb_symbols \"%s\" {\n",
-                  keymap->symbols_section_name);
-    else
-        write_buf(buf, "xkb_symbols {\n");
-
-    for (group = 0; group < keymap->num_group_names; group++)
-        if (keymap->group_names[group])
-            write_buf(buf,
-                      "\tname[Group%u]=\"%s\";\n", group + 1,
-                      xkb_atom_text(keymap->ctx, keymap->group_names[group]));
-    if (group > 0)
+    if (!write_section_name(buf, "xkb_symbols",
+                            keymap->symbols_section_name))
+        return false;
+
+    for (group = 0; group < keymap->num_group_names; group++) {
+        if (keymap->group_names[group]) {
+            write_either(buf, "\tname[Group", "name[Group");
+            write_uint(buf, group + 1);
+            write_buf(buf, "]=\"");
+            write_atom(buf, keymap, keymap->group_names[group]);
+            write_buf(buf, "\";\n");
+        }
+    }
+    if (group > 0 && !buf->compact)
         write_buf(buf, "\n");
 
-    xkb_keys_foreach(key, keymap)
-        if (key->num_groups > 0)
-            write_key(keymap, buf, key);
+    xkb_keys_foreach(key, keymap) {
+        if (key->num_groups == 0)
+            continue;
+
+        if (buf->compact ? !write_key_compact(keymap, buf, key) :
+                           !write_key(keymap, buf, key))
+            return false;
+    }
 
     xkb_mods_enumerate(i, mod, &keymap->mods) {
         bool had_any = false;
         xkb_keys_foreach(key, keymap) {
             if (key->modmap & (1u << i)) {
-                if (!had_any)
-                    write_buf(buf, "\tmodifier_map %s { ",
-                              xkb_atom_text(keymap->ctx, mod->name));
-                write_buf(buf, "%s%s",
-                          had_any ? ", " : "",
-                          KeyNameText(keymap->ctx, key->name));
+                if (!had_any) {
+                    write_either(buf, "\tmodifier_map ", "modifier_map ");
+                    write_atom(buf, keymap, mod->name);
+                    write_either(buf, " { ", "{");
+                }
+                else {
+                    write_either(buf, ", ", ",");
+                }
+                write_key_name(buf, keymap, key->name, 0);
                 had_any = true;
             }
         }
         if (had_any)
-            write_buf(buf, " };\n");
+            write_either(buf, " };\n", "};\n");
     }
 
-    write_buf(buf, "};\n\n");
+    write_either(buf, "};\n\n", "};\n");
     return true;
 }
 
+/*
+ * A guess at the size of the text, from the size of the keymap, so that
+ * the buffer is usually allocated only once.
+ */
+static size_t
+estimate_size(struct xkb_keymap *keymap)
+{
+    const struct xkb_key *key;
+    size_t size = 4096;
+
+    size += keymap->num_key_aliases * 32;
+    size += keymap->num_types * 256;
+    size += keymap->num_sym_interprets * 96;
+
+    xkb_keys_foreach(key, keymap) {
+        size += 48;
+        for (xkb_layout_index_t i = 0; i < key->num_groups; i++)
+            size += 32 + XkbKeyNumLevels(key, i) * 20;
+        if (key->explicit & EXPLICIT_INTERP)
+            size += key->num_groups * 128;
+    }
+
+    return size;
+}
+
 static bool
 write_keymap(struct xkb_keymap *keymap, struct buf *buf)
 {
-    return (check_write_buf(buf, "xkb_keymap {\n") &&
-            write_keycodes(keymap, buf) &&
-            write_types(keymap, buf) &&
-            write_compat(keymap, buf) &&
-            write_symbols(keymap, buf) &&
-            check_write_buf(buf, "};\n"));
+    write_buf(buf, "xkb_keymap {\n");
+    if (!write_keycodes(keymap, buf) ||
+        !write_types(keymap, buf) ||
+        !write_compat(keymap, buf) ||
+        !write_symbols(keymap, buf))
+        return false;
+    write_buf(buf, "};\n");
+    return true;
 }
 
 char *
-text_v1_keymap_get_as_string(struct xkb_keymap *keymap)
+text_v1_keymap_get_as_string(struct xkb_keymap *keymap,
+                             enum xkb_keymap_serialize_flags flags)
 {
-    struct buf buf = { NULL, 0, 0 };
+    struct buf buf = {
+        .compact = (flags & XKB_KEYMAP_SERIALIZE_COMPACT),
+    };
 
-    if (!write_keymap(keymap, &buf)) {
+    if (!buf_reserve(&buf, estimate_size(keymap)) ||
+        !write_keymap(keymap, &buf)) {
         free(buf.buf);
         return NULL;
     }
 
+    /* buf_reserve() always leaves room for it. */
+    buf.buf[buf.size] = '\0';
     return buf.buf;
 }
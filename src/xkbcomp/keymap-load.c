@@ -0,0 +1,1808 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * A fast path for loading keymaps in the form xkb_keymap_get_as_string()
+ * writes them: a single keymap without includes, the sections in order,
+ * and everything spelled out, e.g. the keys by their real names and the
+ * types of their groups.
+ *
+ * Such text is read in one pass straight into a keymap, without the AST
+ * and the *Info structures of the compiler. The statements mean what
+ * they mean to the compiler; the loader just doesn't take anything the
+ * compiler would merge or warn about, nor anything the dumper doesn't
+ * write. On anything it doesn't take, it gives up, and the text goes
+ * through the parser and the compiler as usual. So the loader only has
+ * to be right about what it accepts.
+ *
+ * The interprets are still applied to the keys: the text doesn't tell
+ * which actions of a key come from them, so it can't be done without.
+ */
+
+#include "config.h"
+
+#include "xkbcomp-priv.h"
+#include "arena.h"
+#include "text.h"
+#include "action.h"
+#include "ast-build.h"
+#include "hash-index.h"
+#include "parser-priv.h"
+#include "scanner-utils.h"
+
+enum group_field {
+    GROUP_FIELD_SYMS = (1 << 0),
+    GROUP_FIELD_ACTS = (1 << 1),
+    GROUP_FIELD_TYPE = (1 << 2),
+};
+
+struct group_def {
+    enum group_field defined;
+    xkb_atom_t type;
+    darray(struct xkb_level) levels;
+};
+
+struct key_def {
+    struct xkb_key *key;
+    darray(struct group_def) groups;
+    xkb_atom_t default_type;
+    enum key_repeat repeat;
+    bool have_vmodmap;
+    xkb_mod_mask_t vmodmap;
+    enum xkb_range_exceed_type out_of_range_group_action;
+    xkb_layout_index_t out_of_range_group_number;
+};
+
+struct loader {
+    struct scanner s;
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    struct arena *arena;
+    ActionsInfo *actions;
+    darray(struct xkb_key_type) types;
+    darray(struct xkb_sym_interpret) interps;
+    /* What "interpret.field = value;" statements set. */
+    struct xkb_sym_interpret default_interp;
+    darray(xkb_keysym_t) syms;
+};
+
+/* The keywords which the parser takes as field names, see Element. */
+static const struct {
+    int tok;
+    const char *name;
+} elements[] = {
+    { ACTION_TOK, "action" },
+    { INTERPRET, "interpret" },
+    { TYPE, "type" },
+    { KEY, "key" },
+    { GROUP, "group" },
+    { MODIFIER_MAP, "modifier_map" },
+    { INDICATOR, "indicator" },
+    { SHAPE, "shape" },
+    { ROW, "row" },
+    { SECTION, "section" },
+    { TEXT, "text" },
+};
+
+/***====================================================================***/
+
+static void
+skip_space(struct loader *l)
+{
+    l->s.pos += span_space(&l->s, true);
+}
+
+static bool
+punct(struct loader *l, char ch)
+{
+    skip_space(l);
+    return chr(&l->s, ch);
+}
+
+static bool
+next_is(struct loader *l, char ch)
+{
+    skip_space(l);
+    return peek(&l->s) == ch;
+}
+
+static bool
+next_is_number(struct loader *l)
+{
+    skip_space(l);
+    return is_digit(peek(&l->s));
+}
+
+/* An identifier or a keyword, as long as the lexer takes them. */
+static bool
+word(struct loader *l, struct sval *sv)
+{
+    struct scanner *s = &l->s;
+
+    skip_space(l);
+    if (!is_alpha(peek(s)) && peek(s) != '_')
+        return false;
+
+    sv->start = s->s + s->pos;
+    sv->len = span_ident(s);
+    s->pos += sv->len;
+    return sv->len < sizeof(s->buf) - 1;
+}
+
+/*
+ * The keyword that @sv is, or -1. The lookup wants it terminated, so it's
+ * copied to the buffer, like the lexer has it.
+ */
+static int
+word_token(struct loader *l, struct sval sv)
+{
+    memcpy(l->s.buf, sv.start, sv.len);
+    l->s.buf[sv.len] = '\0';
+    return keyword_to_token(l->s.buf, sv.len);
+}
+
+#define word_is(sv, literal) \
+    ((sv).len == sizeof(literal) - 1 && \
+     istrncmp((sv).start, (literal), (sv).len) == 0)
+
+/* The keyword at the position; or -1, and then nothing is read. */
+static int
+keyword(struct loader *l)
+{
+    const size_t pos = l->s.pos;
+    struct sval sv;
+    int tok;
+
+    if (!word(l, &sv) || (tok = word_token(l, sv)) == -1) {
+        l->s.pos = pos;
+        return -1;
+    }
+
+    return tok;
+}
+
+/*
+ * An identifier, interned like the parser does with its Ident rule, or
+ * with @elements, with its FieldSpec rule.
+ */
+static bool
+ident(struct loader *l, bool elements_too, xkb_atom_t *atom)
+{
+    struct sval sv;
+    const char *name = NULL;
+    int tok;
+
+    if (!word(l, &sv))
+        return false;
+
+    tok = word_token(l, sv);
+    if (tok == -1) {
+        *atom = xkb_atom_intern(l->ctx, sv.start, sv.len);
+        return *atom != XKB_ATOM_NONE;
+    }
+
+    if (tok == DEFAULT)
+        name = "default";
+    else if (elements_too)
+        for (size_t i = 0; i < ARRAY_SIZE(elements); i++)
+            if (elements[i].tok == tok)
+                name = elements[i].name;
+    if (!name)
+        return false;
+
+    *atom = xkb_atom_intern(l->ctx, name, strlen(name));
+    return *atom != XKB_ATOM_NONE;
+}
+
+/* An integer which fits in an int, like the parser's expressions keep. */
+static bool
+integer(struct loader *l, int *out)
+{
+    struct scanner *s = &l->s;
+    int64_t val = 0;
+    size_t start;
+
+    skip_space(l);
+    if (lit(s, "0x")) {
+        start = s->pos;
+        while (is_xdigit(peek(s))) {
+            const char ch = next(s);
+            val = val * 16 + (is_digit(ch) ? ch - '0' : (ch | 0x20) - 'a' + 10);
+            if (val > INT_MAX)
+                return false;
+        }
+    }
+    else {
+        start = s->pos;
+        while (is_digit(peek(s))) {
+            val = val * 10 + (next(s) - '0');
+            if (val > INT_MAX)
+                return false;
+        }
+        /* A float. */
+        if (peek(s) == '.')
+            return false;
+    }
+
+    *out = (int) val;
+    return s->pos > start;
+}
+
+/* A string, without escapes, which the lexer deals with. */
+static bool
+string(struct loader *l, struct sval *sv)
+{
+    struct scanner *s = &l->s;
+
+    if (!punct(l, '"'))
+        return false;
+
+    sv->start = s->s + s->pos;
+    sv->len = span_string(s);
+    s->pos += sv->len;
+    return chr(s, '"') && sv->len < sizeof(s->buf) - 1 &&
+           !memchr(sv->start, '\0', sv->len);
+}
+
+static bool
+string_atom(struct loader *l, xkb_atom_t *atom)
+{
+    struct sval sv;
+
+    if (!string(l, &sv))
+        return false;
+
+    *atom = xkb_atom_intern(l->ctx, sv.start, sv.len);
+    return *atom != XKB_ATOM_NONE;
+}
+
+static bool
+key_name(struct loader *l, xkb_atom_t *atom)
+{
+    struct scanner *s = &l->s;
+    const char *start;
+    size_t len;
+
+    if (!punct(l, '<'))
+        return false;
+
+    start = s->s + s->pos;
+    len = span_graph(s, '>');
+    s->pos += len;
+    if (!chr(s, '>') || len >= sizeof(s->buf) - 1)
+        return false;
+
+    *atom = xkb_atom_intern(l->ctx, start, len);
+    return *atom != XKB_ATOM_NONE;
+}
+
+/***====================================================================***/
+
+static bool
+keysym(struct loader *l, xkb_keysym_t *sym)
+{
+    struct sval sv;
+
+    if (next_is_number(l)) {
+        char buf[32];
+        int val;
+
+        if (!integer(l, &val))
+            return false;
+
+        if (val < 10) {
+            *sym = XKB_KEY_0 + (xkb_keysym_t) val;
+            return true;
+        }
+
+        snprintf(buf, sizeof(buf), "0x%x", (unsigned int) val);
+        return resolve_keysym(buf, sym);
+    }
+
+    if (!word(l, &sv))
+        return false;
+
+    switch (word_token(l, sv)) {
+    case -1:
+        break;
+    case SECTION:
+        *sym = XKB_KEY_section;
+        return true;
+    default:
+        return false;
+    }
+
+    return resolve_keysym(l->s.buf, sym);
+}
+
+static bool
+lookup_mask_name(struct loader *l, const LookupEntry *table,
+                 enum mod_type mod_type, xkb_atom_t atom, unsigned int *val)
+{
+    const char *name = xkb_atom_text(l->ctx, atom);
+    xkb_mod_index_t ndx;
+
+    if (table)
+        return LookupString(table, name, val);
+
+    if (istreq(name, "all")) {
+        *val = MOD_REAL_MASK_ALL;
+        return true;
+    }
+
+    if (istreq(name, "none")) {
+        *val = 0;
+        return true;
+    }
+
+    ndx = XkbModNameToIndex(&l->keymap->mods, atom, mod_type);
+    if (ndx == XKB_MOD_INVALID)
+        return false;
+
+    *val = 1u << ndx;
+    return true;
+}
+
+/*
+ * Names and numbers joined with '+'; the names are looked up in @table,
+ * or without one, they are the modifiers of @mod_type.
+ */
+static bool
+mask(struct loader *l, const LookupEntry *table, enum mod_type mod_type,
+     unsigned int *out)
+{
+    *out = 0;
+
+    do {
+        unsigned int val;
+
+        if (next_is_number(l)) {
+            int ival;
+
+            if (!integer(l, &ival))
+                return false;
+            val = (unsigned int) ival;
+        }
+        else {
+            xkb_atom_t atom;
+
+            if (!ident(l, true, &atom) ||
+                !lookup_mask_name(l, table, mod_type, atom, &val))
+                return false;
+        }
+
+        *out |= val;
+    } while (punct(l, '+'));
+
+    return true;
+}
+
+static bool
+mod_mask(struct loader *l, enum mod_type mod_type, xkb_mod_mask_t *out)
+{
+    return mask(l, NULL, mod_type, out);
+}
+
+static bool
+enum_value(struct loader *l, const LookupEntry *table, unsigned int *out)
+{
+    xkb_atom_t atom;
+
+    return ident(l, true, &atom) &&
+           LookupString(table, xkb_atom_text(l->ctx, atom), out);
+}
+
+static bool
+boolean(struct loader *l, bool *out)
+{
+    xkb_atom_t atom;
+    const char *name;
+
+    if (!ident(l, true, &atom))
+        return false;
+
+    name = xkb_atom_text(l->ctx, atom);
+    if (istreq(name, "true") || istreq(name, "yes") || istreq(name, "on"))
+        *out = true;
+    else if (istreq(name, "false") || istreq(name, "no") ||
+             istreq(name, "off"))
+        *out = false;
+    else
+        return false;
+
+    return true;
+}
+
+/* An integer, or a name from @table, like ExprResolveIntegerLookup(). */
+static bool
+integer_lookup(struct loader *l, const LookupEntry *table, int *out)
+{
+    unsigned int val;
+
+    if (next_is_number(l))
+        return integer(l, out);
+
+    if (!enum_value(l, table, &val))
+        return false;
+
+    *out = (int) val;
+    return true;
+}
+
+static bool
+group_index(struct loader *l, xkb_layout_index_t *group)
+{
+    int val;
+
+    if (!integer_lookup(l, groupNames, &val) ||
+        val <= 0 || val > XKB_MAX_GROUPS)
+        return false;
+
+    *group = (xkb_layout_index_t) (val - 1);
+    return true;
+}
+
+static bool
+level_index(struct loader *l, xkb_level_index_t *level)
+{
+    int val;
+
+    if (!integer_lookup(l, levelNames, &val) || val < 1)
+        return false;
+
+    *level = (xkb_level_index_t) (val - 1);
+    return true;
+}
+
+/***====================================================================***/
+
+/*
+ * The arguments of actions are built as expressions for HandleActionDef(),
+ * the way the parser builds them; only the kinds the dumper writes are
+ * taken: identifiers, array references, integers, unary operators, sums
+ * and assignments.
+ */
+
+static ExprDef *
+action_expr(struct loader *l);
+
+static ExprDef *
+action_term(struct loader *l)
+{
+    ExprDef *term;
+    xkb_atom_t field;
+    enum expr_op_type op;
+
+    skip_space(l);
+    switch (peek(&l->s)) {
+    case '-': op = EXPR_NEGATE; break;
+    case '+': op = EXPR_UNARY_PLUS; break;
+    case '!': op = EXPR_NOT; break;
+    case '~': op = EXPR_INVERT; break;
+    default: op = EXPR_VALUE; break;
+    }
+
+    if (op != EXPR_VALUE) {
+        next(&l->s);
+        term = action_term(l);
+        if (!term)
+            return NULL;
+        return ExprCreateUnary(l->arena, op,
+                               op == EXPR_NOT ? EXPR_TYPE_BOOLEAN :
+                               term->expr.value_type, term);
+    }
+
+    if (next_is_number(l)) {
+        int val;
+
+        if (!integer(l, &val))
+            return NULL;
+        return ExprCreateInteger(l->arena, val);
+    }
+
+    if (!ident(l, true, &field))
+        return NULL;
+
+    if (punct(l, '[')) {
+        ExprDef *entry = action_expr(l);
+
+        if (!entry || !punct(l, ']'))
+            return NULL;
+        return ExprCreateArrayRef(l->arena, XKB_ATOM_NONE, field, entry);
+    }
+
+    /* Nested actions and field references. */
+    if (next_is(l, '(') || next_is(l, '.'))
+        return NULL;
+
+    return ExprCreateIdent(l->arena, field);
+}
+
+static ExprDef *
+action_expr(struct loader *l)
+{
+    ExprDef *left = action_term(l);
+
+    if (!left)
+        return NULL;
+
+    if ((left->expr.op == EXPR_IDENT || left->expr.op == EXPR_ARRAY_REF) &&
+        punct(l, '=')) {
+        ExprDef *right = action_expr(l);
+
+        if (!right)
+            return NULL;
+        return ExprCreateBinary(l->arena, EXPR_ASSIGN, left, right);
+    }
+
+    while (next_is(l, '+') || next_is(l, '-')) {
+        const enum expr_op_type op =
+            (next(&l->s) == '+' ? EXPR_ADD : EXPR_SUBTRACT);
+        ExprDef *right = action_term(l);
+
+        if (!right)
+            return NULL;
+        left = ExprCreateBinary(l->arena, op, left, right);
+        if (!left)
+            return NULL;
+    }
+
+    return left;
+}
+
+static ExprDef *
+action(struct loader *l)
+{
+    ExprDef *args = NULL, *last = NULL;
+    xkb_atom_t name;
+
+    if (!ident(l, true, &name) || !punct(l, '('))
+        return NULL;
+
+    if (!next_is(l, ')')) {
+        do {
+            ExprDef *arg = action_expr(l);
+
+            if (!arg)
+                return NULL;
+            if (last)
+                last->common.next = &arg->common;
+            else
+                args = arg;
+            last = arg;
+        } while (punct(l, ','));
+    }
+
+    if (!punct(l, ')'))
+        return NULL;
+
+    return ExprCreateAction(l->arena, name, args);
+}
+
+/* Whether a list is of actions rather than keysyms; nothing is read. */
+static bool
+next_is_action(struct loader *l)
+{
+    const size_t pos = l->s.pos;
+    struct sval sv;
+    bool ret;
+
+    ret = word(l, &sv) && next_is(l, '(');
+    l->s.pos = pos;
+    return ret;
+}
+
+/***====================================================================***/
+
+static bool
+section_start(struct loader *l, int tok, char **name)
+{
+    struct sval sv;
+
+    if (keyword(l) != tok)
+        return false;
+
+    if (next_is(l, '"')) {
+        if (!string(l, &sv))
+            return false;
+        *name = strndup(sv.start, sv.len);
+    }
+    else {
+        *name = strdup("(unnamed)");
+    }
+    if (!*name)
+        return false;
+
+    XkbEscapeMapName(*name);
+    return punct(l, '{');
+}
+
+static bool
+section_end(struct loader *l)
+{
+    return punct(l, '}') && punct(l, ';');
+}
+
+/* Like HandleVModDef(), for declarations without a value. */
+static bool
+parse_vmods(struct loader *l)
+{
+    struct xkb_mod_set *mods = &l->keymap->mods;
+
+    do {
+        xkb_atom_t name;
+        xkb_mod_index_t i;
+        struct xkb_mod *mod;
+
+        if (!ident(l, false, &name))
+            return false;
+
+        xkb_mods_enumerate(i, mod, mods)
+            if (mod->name == name)
+                break;
+
+        if (i < mods->num_mods) {
+            if (mod->type != MOD_VIRT || mod->mapping != 0)
+                return false;
+            continue;
+        }
+
+        if (mods->num_mods >= XKB_MAX_MODS)
+            return false;
+
+        mods->mods[mods->num_mods].name = name;
+        mods->mods[mods->num_mods].type = MOD_VIRT;
+        mods->mods[mods->num_mods].mapping = 0;
+        mods->num_mods++;
+    } while (punct(l, ','));
+
+    return punct(l, ';');
+}
+
+/***====================================================================***/
+
+struct keycode_def {
+    xkb_keycode_t keycode;
+    xkb_atom_t name;
+};
+
+static bool
+parse_keycodes(struct loader *l)
+{
+    struct xkb_keymap *keymap = l->keymap;
+    struct hash_index *index = &keymap->key_names_index;
+    darray(struct keycode_def) keycodes = darray_new();
+    darray(struct xkb_key_alias) aliases = darray_new();
+    struct keycode_def *kd;
+    struct xkb_key_alias *alias;
+    xkb_keycode_t min_key_code, max_key_code;
+    unsigned int i;
+    bool ok = false;
+
+    if (!section_start(l, XKB_KEYCODES, &keymap->keycodes_section_name))
+        goto out;
+
+    while (true) {
+        const size_t pos = l->s.pos;
+        struct sval sv;
+        int tok, val;
+
+        if (next_is(l, '<')) {
+            xkb_atom_t name;
+
+            if (!key_name(l, &name) || !punct(l, '=') ||
+                !integer(l, &val) || !punct(l, ';'))
+                goto out;
+
+            /* In order, so that no keycode is taken twice. */
+            if (!darray_empty(keycodes) &&
+                (xkb_keycode_t) val <= darray_item(keycodes,
+                                                   darray_size(keycodes) - 1).keycode)
+                goto out;
+
+            darray_append(keycodes, (struct keycode_def) {
+                .keycode = (xkb_keycode_t) val, .name = name,
+            });
+        }
+        else if ((tok = keyword(l)) == INDICATOR) {
+            xkb_atom_t name;
+            xkb_led_index_t idx;
+
+            if (!integer(l, &val) || !punct(l, '=') ||
+                !string_atom(l, &name) || !punct(l, ';'))
+                goto out;
+
+            if (val < 1 || val > (int) XKB_MAX_LEDS)
+                goto out;
+
+            /* Neither the index nor the name may be taken. */
+            for (idx = 0; idx < keymap->num_leds; idx++)
+                if (keymap->leds[idx].name == name)
+                    goto out;
+            idx = (xkb_led_index_t) val - 1;
+            if (keymap->leds[idx].name != XKB_ATOM_NONE)
+                goto out;
+
+            keymap->leds[idx].name = name;
+            keymap->num_leds = MAX(keymap->num_leds, idx + 1);
+        }
+        else if (tok == ALIAS) {
+            xkb_atom_t name, real;
+
+            if (!key_name(l, &name) || !punct(l, '=') ||
+                !key_name(l, &real) || !punct(l, ';'))
+                goto out;
+
+            darray_append(aliases, (struct xkb_key_alias) {
+                .real = real, .alias = name,
+            });
+        }
+        else if (tok == -1 && word(l, &sv) &&
+                 (word_is(sv, "minimum") || word_is(sv, "maximum"))) {
+            /* Ignored, as by the compiler. */
+            if (!punct(l, '=') || !integer(l, &val) || !punct(l, ';'))
+                goto out;
+        }
+        else {
+            l->s.pos = pos;
+            break;
+        }
+    }
+
+    if (!section_end(l))
+        goto out;
+
+    if (darray_empty(keycodes)) {
+        min_key_code = 8;
+        max_key_code = 255;
+    }
+    else {
+        min_key_code = darray_item(keycodes, 0).keycode;
+        max_key_code = darray_item(keycodes, darray_size(keycodes) - 1).keycode;
+    }
+
+    keymap->keys = calloc(max_key_code + 1, sizeof(*keymap->keys));
+    if (!keymap->keys)
+        goto out;
+
+    keymap->min_key_code = min_key_code;
+    keymap->max_key_code = max_key_code;
+    for (xkb_keycode_t kc = min_key_code; kc <= max_key_code; kc++)
+        keymap->keys[kc].keycode = kc;
+
+    /*
+     * Index the names like XkbKeymapIndexKeyNames() does, on the way
+     * checking that no name is taken twice, and that the aliases are of
+     * keys; otherwise the compiler drops some with messages.
+     */
+    darray_foreach(kd, keycodes) {
+        if (hash_index_first(index, kd->name) != HASH_INDEX_END ||
+            !hash_index_add(index, kd->name, kd->keycode))
+            goto out;
+        keymap->keys[kd->keycode].name = kd->name;
+    }
+
+    darray_enumerate(i, alias, aliases) {
+        const uint32_t pos = hash_index_first(index, alias->real);
+
+        if (pos == HASH_INDEX_END ||
+            (index->entries[pos].item & KEY_NAMES_INDEX_ALIAS) ||
+            hash_index_first(index, alias->alias) != HASH_INDEX_END ||
+            !hash_index_add(index, alias->alias, i | KEY_NAMES_INDEX_ALIAS))
+            goto out;
+    }
+
+    darray_steal(aliases, &keymap->key_aliases, &keymap->num_key_aliases);
+    ok = true;
+
+out:
+    darray_free(keycodes);
+    darray_free(aliases);
+    return ok;
+}
+
+/***====================================================================***/
+
+static struct xkb_key_type_entry *
+find_entry(struct xkb_key_type_entry *entries, size_t num_entries,
+           xkb_mod_mask_t mods)
+{
+    for (size_t i = 0; i < num_entries; i++)
+        if (entries[i].mods.mods == mods)
+            return &entries[i];
+
+    return NULL;
+}
+
+static bool
+parse_type(struct loader *l)
+{
+    struct xkb_key_type type = { .num_levels = 1 };
+    darray(struct xkb_key_type_entry) entries = darray_new();
+    darray(xkb_atom_t) level_names = darray_new();
+    const struct xkb_key_type *other;
+    bool first = true, ok = false;
+
+    if (!string_atom(l, &type.name) || !punct(l, '{'))
+        goto out;
+
+    darray_foreach(other, l->types)
+        if (other->name == type.name)
+            goto out;
+
+    /*
+     * Statements which the compiler warns about are not taken: map and
+     * preserve entries for other modifiers than the type's (which is why
+     * these must come first), and repeated entries and names.
+     */
+    do {
+        struct sval field;
+
+        if (!word(l, &field))
+            goto out;
+
+        if (word_is(field, "modifiers")) {
+            if (!first || !punct(l, '=') ||
+                !mod_mask(l, MOD_BOTH, &type.mods.mods))
+                goto out;
+        }
+        else if (word_is(field, "map")) {
+            struct xkb_key_type_entry entry = { 0 };
+
+            if (!punct(l, '[') || !mod_mask(l, MOD_BOTH, &entry.mods.mods) ||
+                !punct(l, ']') || !punct(l, '=') ||
+                !level_index(l, &entry.level))
+                goto out;
+
+            if ((entry.mods.mods & ~type.mods.mods) ||
+                find_entry(entries.item, darray_size(entries),
+                           entry.mods.mods))
+                goto out;
+
+            type.num_levels = MAX(type.num_levels, entry.level + 1);
+            darray_append(entries, entry);
+        }
+        else if (word_is(field, "preserve")) {
+            struct xkb_key_type_entry *entry;
+            xkb_mod_mask_t mods, preserve;
+
+            if (!punct(l, '[') || !mod_mask(l, MOD_BOTH, &mods) ||
+                !punct(l, ']') || !punct(l, '=') ||
+                !mod_mask(l, MOD_BOTH, &preserve))
+                goto out;
+
+            if ((mods & ~type.mods.mods) || (preserve & ~mods))
+                goto out;
+
+            /* A preserve without a map maps to the first level. */
+            entry = find_entry(entries.item, darray_size(entries), mods);
+            if (!entry) {
+                darray_append(entries, (struct xkb_key_type_entry) {
+                    .level = 0, .mods.mods = mods,
+                    .preserve.mods = preserve,
+                });
+            }
+            else if (entry->preserve.mods == 0) {
+                entry->preserve.mods = preserve;
+            }
+            else {
+                goto out;
+            }
+        }
+        else if (word_is(field, "level_name") || word_is(field, "levelname")) {
+            xkb_level_index_t level;
+            xkb_atom_t name;
+
+            if (!punct(l, '[') || !level_index(l, &level) ||
+                !punct(l, ']') || !punct(l, '=') || !string_atom(l, &name))
+                goto out;
+
+            if (level >= darray_size(level_names))
+                darray_resize0(level_names, level + 1);
+            else if (darray_item(level_names, level) != XKB_ATOM_NONE)
+                goto out;
+
+            darray_item(level_names, level) = name;
+        }
+        else {
+            goto out;
+        }
+
+        if (!punct(l, ';'))
+            goto out;
+        first = false;
+    } while (!next_is(l, '}'));
+
+    if (!section_end(l))
+        goto out;
+
+    darray_steal(entries, &type.entries, &type.num_entries);
+    darray_steal(level_names, &type.level_names, &type.num_level_names);
+    darray_append(l->types, type);
+    ok = true;
+
+out:
+    darray_free(entries);
+    darray_free(level_names);
+    return ok;
+}
+
+static bool
+parse_types(struct loader *l)
+{
+    struct xkb_keymap *keymap = l->keymap;
+
+    if (!section_start(l, XKB_TYPES, &keymap->types_section_name))
+        return false;
+
+    while (true) {
+        const int tok = keyword(l);
+
+        if (tok == VIRTUAL_MODS) {
+            if (!parse_vmods(l))
+                return false;
+        }
+        else if (tok == TYPE) {
+            if (!parse_type(l))
+                return false;
+        }
+        else if (tok == -1) {
+            break;
+        }
+        else {
+            return false;
+        }
+    }
+
+    /* Without types, the compiler makes up one. */
+    if (darray_empty(l->types))
+        return false;
+
+    darray_steal(l->types, &keymap->types, &keymap->num_types);
+    return section_end(l);
+}
+
+/***====================================================================***/
+
+/* The match of an interpret, like ResolveStateAndPredicate(). */
+static bool
+parse_interp_match(struct loader *l, struct xkb_sym_interpret *si)
+{
+    const size_t pos = l->s.pos;
+    xkb_atom_t name;
+
+    si->match = MATCH_EXACTLY;
+
+    if (!next_is_number(l) && ident(l, true, &name)) {
+        const char *text = xkb_atom_text(l->ctx, name);
+        unsigned int match;
+
+        if (punct(l, '(')) {
+            if (!LookupString(symInterpretMatchMaskNames, text, &match))
+                return false;
+            si->match = match;
+            return mod_mask(l, MOD_REAL, &si->mods) && punct(l, ')');
+        }
+
+        if (istreq(text, "any") && !next_is(l, '+')) {
+            si->match = MATCH_ANY;
+            si->mods = MOD_REAL_MASK_ALL;
+            return true;
+        }
+    }
+
+    l->s.pos = pos;
+    return mod_mask(l, MOD_REAL, &si->mods);
+}
+
+/* A field of an interpret, like SetInterpField(). */
+static bool
+parse_interp_field(struct loader *l, struct sval field,
+                   struct xkb_sym_interpret *si)
+{
+    unsigned int val;
+
+    if (word_is(field, "action")) {
+        ExprDef *def = action(l);
+
+        return def && HandleActionDef(l->ctx, l->actions, &l->keymap->mods,
+                                      def, &si->action);
+    }
+    else if (word_is(field, "virtualmodifier") ||
+             word_is(field, "virtualmod")) {
+        xkb_atom_t name;
+
+        if (!ident(l, true, &name))
+            return false;
+
+        si->virtual_mod = XkbModNameToIndex(&l->keymap->mods, name, MOD_VIRT);
+        return si->virtual_mod != XKB_MOD_INVALID;
+    }
+    else if (word_is(field, "repeat")) {
+        return boolean(l, &si->repeat);
+    }
+    else if (word_is(field, "usemodmap") || word_is(field, "usemodmapmods")) {
+        if (!enum_value(l, useModMapValueNames, &val))
+            return false;
+        si->level_one_only = val;
+        return true;
+    }
+
+    return false;
+}
+
+static bool
+parse_interp(struct loader *l, struct hash_index *index)
+{
+    struct xkb_sym_interpret si = l->default_interp;
+    uint32_t pos;
+
+    if (!keysym(l, &si.sym))
+        return false;
+
+    if (punct(l, '+')) {
+        if (!parse_interp_match(l, &si))
+            return false;
+    }
+    else {
+        si.match = MATCH_ANY_OR_NONE;
+        si.mods = MOD_REAL_MASK_ALL;
+    }
+
+    /* Repeated interprets are merged by the compiler. */
+    hash_index_foreach(pos, index, si.sym) {
+        const struct xkb_sym_interpret *old =
+            &darray_item(l->interps, index->entries[pos].item);
+        if (old->mods == si.mods && old->match == si.match)
+            return false;
+    }
+
+    if (!punct(l, '{'))
+        return false;
+
+    do {
+        struct sval field;
+
+        if (!word(l, &field) || !punct(l, '=') ||
+            !parse_interp_field(l, field, &si) || !punct(l, ';'))
+            return false;
+    } while (!next_is(l, '}'));
+
+    if (!section_end(l) ||
+        !hash_index_add(index, si.sym, darray_size(l->interps)))
+        return false;
+
+    darray_append(l->interps, si);
+    return true;
+}
+
+/* The "interpret.field = value;" statements. */
+static bool
+parse_interp_default(struct loader *l)
+{
+    struct sval field;
+
+    if (!word(l, &field) || !punct(l, '='))
+        return false;
+
+    if (!word_is(field, "repeat") && !word_is(field, "usemodmap") &&
+        !word_is(field, "usemodmapmods"))
+        return false;
+
+    return parse_interp_field(l, field, &l->default_interp) &&
+           punct(l, ';');
+}
+
+/* A LED map, which must be of a LED named by the keycodes. */
+static bool
+parse_led_map(struct loader *l, uint32_t *mapped)
+{
+    struct xkb_keymap *keymap = l->keymap;
+    struct xkb_led led = { 0 };
+    xkb_led_index_t i;
+
+    if (!string_atom(l, &led.name) || !punct(l, '{'))
+        return false;
+
+    do {
+        struct sval field;
+        unsigned int val;
+
+        if (!word(l, &field) || !punct(l, '='))
+            return false;
+
+        if (word_is(field, "modifiers") || word_is(field, "mods")) {
+            if (!mod_mask(l, MOD_BOTH, &led.mods.mods))
+                return false;
+        }
+        else if (word_is(field, "groups")) {
+            if (!mask(l, groupMaskNames, 0, &val))
+                return false;
+            led.groups = val;
+        }
+        else if (word_is(field, "controls") || word_is(field, "ctrls")) {
+            if (!mask(l, ctrlMaskNames, 0, &val))
+                return false;
+            led.ctrls = val;
+        }
+        else if (word_is(field, "whichmodstate") ||
+                 word_is(field, "whichmodifierstate")) {
+            if (!mask(l, modComponentMaskNames, 0, &val))
+                return false;
+            led.which_mods = val;
+        }
+        else if (word_is(field, "whichgroupstate")) {
+            if (!mask(l, groupComponentMaskNames, 0, &val))
+                return false;
+            led.which_groups = val;
+        }
+        else {
+            return false;
+        }
+
+        if (!punct(l, ';'))
+            return false;
+    } while (!next_is(l, '}'));
+
+    if (!section_end(l))
+        return false;
+
+    for (i = 0; i < keymap->num_leds; i++)
+        if (keymap->leds[i].name == led.name)
+            break;
+    if (i >= keymap->num_leds || (*mapped & (1u << i)))
+        return false;
+    *mapped |= 1u << i;
+
+    if (led.groups != 0 && led.which_groups == 0)
+        led.which_groups = XKB_STATE_LAYOUT_EFFECTIVE;
+    if (led.mods.mods != 0 && led.which_mods == 0)
+        led.which_mods = XKB_STATE_MODS_EFFECTIVE;
+    keymap->leds[i] = led;
+    return true;
+}
+
+static bool
+parse_compat(struct loader *l)
+{
+    /* Most specific to least specific, as CopyCompatToKeymap() has them. */
+    static const enum xkb_match_operation order[] = {
+        MATCH_EXACTLY, MATCH_ALL, MATCH_NONE, MATCH_ANY, MATCH_ANY_OR_NONE,
+    };
+    struct xkb_keymap *keymap = l->keymap;
+    struct hash_index index;
+    struct xkb_sym_interpret *si;
+    uint32_t mapped = 0;
+    unsigned int n;
+    bool ok = false;
+
+    hash_index_init(&index);
+
+    if (!section_start(l, XKB_COMPATMAP, &keymap->compat_section_name))
+        goto out;
+
+    while (true) {
+        const int tok = keyword(l);
+
+        if (tok == VIRTUAL_MODS) {
+            if (!parse_vmods(l))
+                goto out;
+        }
+        else if (tok == INTERPRET) {
+            if (punct(l, '.') ? !parse_interp_default(l) :
+                                !parse_interp(l, &index))
+                goto out;
+        }
+        else if (tok == INDICATOR) {
+            if (!parse_led_map(l, &mapped))
+                goto out;
+        }
+        else if (tok == -1) {
+            break;
+        }
+        else {
+            goto out;
+        }
+    }
+
+    if (!section_end(l))
+        goto out;
+
+    if (!darray_empty(l->interps)) {
+        keymap->sym_interprets = calloc(darray_size(l->interps),
+                                        sizeof(*keymap->sym_interprets));
+        if (!keymap->sym_interprets)
+            goto out;
+
+        n = 0;
+        for (int need_symbol = 1; need_symbol >= 0; need_symbol--)
+            for (size_t i = 0; i < ARRAY_SIZE(order); i++)
+                darray_foreach(si, l->interps)
+                    if (si->match == order[i] &&
+                        (si->sym != XKB_KEY_NoSymbol) == need_symbol)
+                        keymap->sym_interprets[n++] = *si;
+        keymap->num_sym_interprets = n;
+    }
+
+    ok = true;
+
+out:
+    hash_index_free(&index);
+    return ok;
+}
+
+/***====================================================================***/
+
+static void
+clear_key_def(struct key_def *def)
+{
+    struct group_def *group;
+    struct xkb_level *level;
+
+    darray_foreach(group, def->groups) {
+        darray_foreach(level, group->levels)
+            if (level->num_syms > 1)
+                free(level->u.syms);
+        darray_free(group->levels);
+    }
+    darray_free(def->groups);
+}
+
+static bool
+parse_syms(struct loader *l, struct group_def *group)
+{
+    xkb_level_index_t i = 0;
+
+    do {
+        struct xkb_level *level;
+        xkb_keysym_t sym;
+
+        if (i >= darray_size(group->levels))
+            darray_resize0(group->levels, i + 1);
+        level = &darray_item(group->levels, i++);
+
+        if (!punct(l, '{')) {
+            if (!keysym(l, &sym))
+                return false;
+            level->num_syms = (sym != XKB_KEY_NoSymbol);
+            level->u.sym = sym;
+            continue;
+        }
+
+        darray_resize(l->syms, 0);
+        do {
+            if (!keysym(l, &sym))
+                return false;
+            darray_append(l->syms, sym);
+        } while (punct(l, ','));
+
+        if (!punct(l, '}'))
+            return false;
+
+        /* Unlike alone, NoSymbol counts in a list of more. */
+        if (darray_size(l->syms) == 1) {
+            level->num_syms = (sym != XKB_KEY_NoSymbol);
+            level->u.sym = sym;
+        }
+        else {
+            level->u.syms = memdup(l->syms.item, darray_size(l->syms),
+                                   sizeof(xkb_keysym_t));
+            if (!level->u.syms)
+                return false;
+            level->num_syms = darray_size(l->syms);
+        }
+    } while (punct(l, ','));
+
+    return punct(l, ']');
+}
+
+static bool
+parse_actions(struct loader *l, const struct key_def *def,
+              xkb_layout_index_t group_index, struct group_def *group)
+{
+    xkb_level_index_t i = 0;
+
+    do {
+        ExprDef *act = action(l);
+
+        if (!act)
+            return false;
+
+        if (i >= darray_size(group->levels))
+            darray_resize0(group->levels, i + 1);
+
+        /* As in AddActionsToKey(), a bad action is dropped. */
+        if (!HandleActionDef(l->ctx, l->actions, &l->keymap->mods, act,
+                             &darray_item(group->levels, i).action))
+            log_err(l->ctx,
+                    "Illegal action definition for %s; "
+                    "Action for group %u/level %u ignored\n",
+                    KeyNameText(l->ctx, def->key->name),
+                    group_index + 1, i + 1);
+        i++;
+    } while (punct(l, ','));
+
+    return punct(l, ']');
+}
+
+/*
+ * The symbols or actions, as @what says, or whichever the list has with
+ * @what 0, of the group @index if @indexed, or else of the first group
+ * without them, like GetGroupIndex().
+ */
+static bool
+parse_group_list(struct loader *l, struct key_def *def, bool indexed,
+                 xkb_layout_index_t index, enum group_field what)
+{
+    struct group_def *group;
+
+    if (!punct(l, '['))
+        return false;
+
+    if (what == 0)
+        what = (next_is_action(l) ? GROUP_FIELD_ACTS : GROUP_FIELD_SYMS);
+
+    if (!indexed) {
+        for (index = 0; index < darray_size(def->groups); index++)
+            if (!(darray_item(def->groups, index).defined & what))
+                break;
+        if (index >= XKB_MAX_GROUPS)
+            return false;
+    }
+
+    if (index >= darray_size(def->groups))
+        darray_resize0(def->groups, index + 1);
+
+    group = &darray_item(def->groups, index);
+    if (group->defined & what)
+        return false;
+    group->defined |= what;
+
+    if (punct(l, ']'))
+        return true;
+
+    if (what == GROUP_FIELD_SYMS)
+        return parse_syms(l, group);
+    else
+        return parse_actions(l, def, index, group);
+}
+
+/* A field of a key, like SetSymbolsField(). */
+static bool
+parse_key_field(struct loader *l, struct key_def *def)
+{
+    struct sval field;
+    xkb_layout_index_t group = 0;
+    bool indexed = false, set;
+    unsigned int val;
+
+    if (next_is(l, '['))
+        return parse_group_list(l, def, false, 0, 0);
+
+    if (!word(l, &field))
+        return false;
+
+    if (punct(l, '[')) {
+        if (!group_index(l, &group) || !punct(l, ']'))
+            return false;
+        indexed = true;
+    }
+
+    if (!punct(l, '=')) {
+        /* A bare field is set to true. */
+        if (indexed)
+            return false;
+        else if (word_is(field, "groupswrap") || word_is(field, "wrapgroups"))
+            def->out_of_range_group_action = RANGE_WRAP;
+        else if (word_is(field, "groupsclamp") || word_is(field, "clampgroups"))
+            def->out_of_range_group_action = RANGE_SATURATE;
+        else
+            return false;
+        return true;
+    }
+
+    if (word_is(field, "symbols"))
+        return parse_group_list(l, def, indexed, group, GROUP_FIELD_SYMS);
+
+    if (word_is(field, "actions"))
+        return parse_group_list(l, def, indexed, group, GROUP_FIELD_ACTS);
+
+    if (word_is(field, "type")) {
+        xkb_atom_t type;
+
+        if (!string_atom(l, &type))
+            return false;
+
+        if (!indexed) {
+            def->default_type = type;
+            return true;
+        }
+
+        if (group >= darray_size(def->groups))
+            darray_resize0(def->groups, group + 1);
+        darray_item(def->groups, group).type = type;
+        darray_item(def->groups, group).defined |= GROUP_FIELD_TYPE;
+        return true;
+    }
+
+    if (indexed)
+        return false;
+
+    if (word_is(field, "vmods") || word_is(field, "virtualmods") ||
+        word_is(field, "virtualmodifiers")) {
+        if (!mod_mask(l, MOD_VIRT, &def->vmodmap))
+            return false;
+        def->have_vmodmap = true;
+    }
+    else if (word_is(field, "repeat") || word_is(field, "repeats") ||
+             word_is(field, "repeating")) {
+        if (!enum_value(l, repeatEntries, &val))
+            return false;
+        def->repeat = val;
+    }
+    else if (word_is(field, "groupswrap") || word_is(field, "wrapgroups")) {
+        if (!boolean(l, &set))
+            return false;
+        def->out_of_range_group_action = (set ? RANGE_WRAP : RANGE_SATURATE);
+    }
+    else if (word_is(field, "groupsclamp") || word_is(field, "clampgroups")) {
+        if (!boolean(l, &set))
+            return false;
+        def->out_of_range_group_action = (set ? RANGE_SATURATE : RANGE_WRAP);
+    }
+    else if (word_is(field, "groupsredirect") ||
+             word_is(field, "redirectgroups")) {
+        if (!group_index(l, &group))
+            return false;
+        def->out_of_range_group_action = RANGE_REDIRECT;
+        def->out_of_range_group_number = group;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+/* Like FindTypeForGroup(), without falling back to the first type. */
+static const struct xkb_key_type *
+find_group_type(struct loader *l, const struct key_def *def,
+                const struct group_def *group, bool *explicit_type)
+{
+    const struct xkb_keymap *keymap = l->keymap;
+    xkb_atom_t name = group->type;
+
+    *explicit_type = true;
+
+    if (name == XKB_ATOM_NONE)
+        name = def->default_type;
+
+    if (name == XKB_ATOM_NONE) {
+        const xkb_level_index_t width = darray_size(group->levels);
+        xkb_keysym_t syms[4];
+
+        for (xkb_level_index_t i = 0; i < 4; i++)
+            syms[i] = (i < width ?
+                       XkbLevelFirstSym(&darray_item(group->levels, i)) :
+                       XKB_KEY_NoSymbol);
+
+        name = FindAutomaticType(l->ctx, width, syms);
+        *explicit_type = false;
+    }
+
+    for (unsigned i = 0; i < keymap->num_types; i++)
+        if (keymap->types[i].name == name)
+            return &keymap->types[i];
+
+    return NULL;
+}
+
+/* Like CopySymbolsDefToKeymap(). */
+static bool
+copy_key(struct loader *l, struct key_def *def)
+{
+    struct xkb_key *key = def->key;
+    const struct xkb_key_type *types[XKB_MAX_GROUPS];
+    bool explicit_types[XKB_MAX_GROUPS];
+    xkb_layout_index_t i, num_groups = 0;
+    struct group_def *group;
+
+    darray_enumerate(i, group, def->groups)
+        if (group->defined)
+            num_groups = i + 1;
+
+    /* A key without groups is left alone. */
+    if (num_groups == 0)
+        return true;
+
+    darray_resize(def->groups, num_groups);
+
+    /* Fill the gaps with the first group. */
+    darray_foreach_from(group, def->groups, 1) {
+        const struct group_def *group0 = &darray_item(def->groups, 0);
+        struct xkb_level *level;
+
+        if (group->defined)
+            continue;
+
+        group->defined = group0->defined;
+        group->type = group0->type;
+        darray_copy(group->levels, group0->levels);
+        darray_foreach(level, group->levels) {
+            if (level->num_syms <= 1)
+                continue;
+            level->u.syms = memdup(level->u.syms, level->num_syms,
+                                   sizeof(*level->u.syms));
+            if (!level->u.syms) {
+                level->num_syms = 0;
+                return false;
+            }
+        }
+    }
+
+    /* Extra levels are dropped by the compiler, with a message. */
+    darray_enumerate(i, group, def->groups) {
+        types[i] = find_group_type(l, def, group, &explicit_types[i]);
+        if (!types[i] || types[i]->num_levels < darray_size(group->levels))
+            return false;
+    }
+
+    key->groups = calloc(num_groups, sizeof(*key->groups));
+    if (!key->groups)
+        return false;
+    key->num_groups = num_groups;
+
+    darray_enumerate(i, group, def->groups) {
+        darray_resize0(group->levels, types[i]->num_levels);
+        key->groups[i].type = types[i];
+        key->groups[i].explicit_type = explicit_types[i];
+        darray_steal(group->levels, &key->groups[i].levels, NULL);
+        if (group->defined & GROUP_FIELD_ACTS)
+            key->explicit |= EXPLICIT_INTERP;
+    }
+
+    key->out_of_range_group_number = def->out_of_range_group_number;
+    key->out_of_range_group_action = def->out_of_range_group_action;
+
+    if (def->have_vmodmap) {
+        key->vmodmap = def->vmodmap;
+        key->explicit |= EXPLICIT_VMODMAP;
+    }
+
+    if (def->repeat != KEY_REPEAT_UNDEFINED) {
+        key->repeats = (def->repeat == KEY_REPEAT_YES);
+        key->explicit |= EXPLICIT_REPEAT;
+    }
+
+    return true;
+}
+
+static bool
+parse_key(struct loader *l, bool *defined)
+{
+    struct key_def def = {
+        .repeat = KEY_REPEAT_UNDEFINED,
+        .out_of_range_group_action = RANGE_WRAP,
+    };
+    xkb_atom_t name;
+    bool ok = false;
+
+    /* Keys by their aliases, and repeated keys, are merged by the compiler. */
+    if (!key_name(l, &name))
+        return false;
+    def.key = XkbKeyByName(l->keymap, name, false);
+    if (!def.key || defined[def.key->keycode])
+        return false;
+    defined[def.key->keycode] = true;
+
+    if (!punct(l, '{'))
+        goto out;
+
+    if (!next_is(l, '}')) {
+        do {
+            if (!parse_key_field(l, &def))
+                goto out;
+        } while (punct(l, ','));
+    }
+
+    ok = section_end(l) && copy_key(l, &def);
+
+out:
+    clear_key_def(&def);
+    return ok;
+}
+
+/*
+ * Keys named by their aliases, and keys in more than one map, are only
+ * for the compiler; so every key gets one modifier, the one it's mapped
+ * to, as the compiler has it for a single map.
+ */
+static bool
+parse_modmap(struct loader *l)
+{
+    struct xkb_keymap *keymap = l->keymap;
+    xkb_mod_index_t ndx;
+    xkb_atom_t name;
+
+    if (!ident(l, false, &name))
+        return false;
+
+    ndx = XkbModNameToIndex(&keymap->mods, name, MOD_REAL);
+    if (ndx == XKB_MOD_INVALID || !punct(l, '{'))
+        return false;
+
+    do {
+        struct xkb_key *key;
+
+        if (!key_name(l, &name))
+            return false;
+
+        key = XkbKeyByName(keymap, name, false);
+        if (!key || key->modmap != 0)
+            return false;
+
+        key->modmap = 1u << ndx;
+    } while (punct(l, ','));
+
+    return section_end(l);
+}
+
+static bool
+parse_symbols(struct loader *l)
+{
+    struct xkb_keymap *keymap = l->keymap;
+    darray(xkb_atom_t) group_names = darray_new();
+    bool *defined;
+    bool ok = false;
+
+    defined = calloc(keymap->max_key_code + 1, sizeof(*defined));
+    if (!defined)
+        return false;
+
+    if (!section_start(l, XKB_SYMBOLS, &keymap->symbols_section_name))
+        goto out;
+
+    while (true) {
+        const size_t pos = l->s.pos;
+        const int tok = keyword(l);
+        struct sval sv;
+
+        if (tok == KEY) {
+            if (!parse_key(l, defined))
+                goto out;
+        }
+        else if (tok == MODIFIER_MAP) {
+            if (!parse_modmap(l))
+                goto out;
+        }
+        else if (tok == -1 && word(l, &sv) &&
+                 (word_is(sv, "name") || word_is(sv, "groupname"))) {
+            xkb_layout_index_t group;
+            xkb_atom_t name;
+
+            if (!punct(l, '[') || !group_index(l, &group) ||
+                !punct(l, ']') || !punct(l, '=') ||
+                !string_atom(l, &name) || !punct(l, ';'))
+                goto out;
+
+            if (group >= darray_size(group_names))
+                darray_resize0(group_names, group + 1);
+            darray_item(group_names, group) = name;
+        }
+        else if (tok == -1) {
+            l->s.pos = pos;
+            break;
+        }
+        else {
+            goto out;
+        }
+    }
+
+    if (!section_end(l))
+        goto out;
+
+    darray_steal(group_names, &keymap->group_names, &keymap->num_group_names);
+    ok = true;
+
+out:
+    darray_free(group_names);
+    free(defined);
+    return ok;
+}
+
+/***====================================================================***/
+
+static bool
+parse_keymap(struct loader *l)
+{
+    struct sval sv;
+
+    if (keyword(l) != XKB_KEYMAP)
+        return false;
+
+    /* The name of the keymap goes nowhere. */
+    if (next_is(l, '"') && !string(l, &sv))
+        return false;
+
+    if (!punct(l, '{') ||
+        !parse_keycodes(l) || !parse_types(l) ||
+        !parse_compat(l) || !parse_symbols(l) ||
+        !section_end(l))
+        return false;
+
+    skip_space(l);
+    return eof(&l->s);
+}
+
+bool
+XkbLoadKeymapText(struct xkb_keymap *keymap, const char *string, size_t len)
+{
+    struct loader l = { 0 };
+    struct xkb_keymap *loaded, tmp;
+    struct xkb_key_type *type;
+    bool ok = false;
+
+    loaded = xkb_keymap_new(keymap->ctx, keymap->format, keymap->flags);
+    if (!loaded)
+        return false;
+
+    scanner_init(&l.s, keymap->ctx, string, len, "(input string)", NULL);
+    l.ctx = keymap->ctx;
+    l.keymap = loaded;
+    l.default_interp.virtual_mod = XKB_MOD_INVALID;
+    l.arena = arena_new();
+    l.actions = NewActionsInfo();
+    if (!l.arena || !l.actions)
+        goto out;
+
+    if (!parse_keymap(&l)) {
+        scanner_token_start(&l.s);
+        scanner_log(&l.s, XKB_LOG_LEVEL_DEBUG,
+                    "Keymap is not in its canonical text form; compiling it");
+        goto out;
+    }
+
+    if (!UpdateDerivedKeymapFields(loaded) || !XkbKeymapPackKeys(loaded))
+        goto out;
+
+    /* Nothing points into the keymaps themselves, so they can be swapped. */
+    tmp = *keymap;
+    *keymap = *loaded;
+    *loaded = tmp;
+
+    log_dbg(keymap->ctx, "Loaded keymap from its canonical text form\n");
+    ok = true;
+
+out:
+    darray_foreach(type, l.types) {
+        free(type->entries);
+        free(type->level_names);
+    }
+    darray_free(l.types);
+    darray_free(l.interps);
+    darray_free(l.syms);
+    if (l.actions)
+        FreeActionsInfo(l.actions);
+    if (l.arena)
+        arena_free(l.arena);
+    xkb_keymap_unref(loaded);
+    return ok;
+}
@@ -29,7 +29,10 @@
 
 #include "config.h"
 
+#include <limits.h>
+
 #include "xkbcomp-priv.h"
+#include "hash-index.h"
 
 static void
 ComputeEffectiveMask(struct xkb_keymap *keymap, struct xkb_mods *mods)
@@ -63,71 +66,128 @@ static const struct xkb_sym_interpret default_interpret = {
     .action = { .type = ACTION_TYPE_NONE },
 };
 
+/*
+ * The interprets which may apply to a level: those for its keysym, and
+ * the XKB_KEY_NoSymbol ones, which apply to any level. Each of these is
+ * in the order of keymap->sym_interprets.
+ */
+struct interp_index {
+    struct hash_index by_sym;
+    darray_uint wildcards;
+};
+
+static bool
+InitInterpIndex(struct interp_index *index, const struct xkb_keymap *keymap)
+{
+    hash_index_init(&index->by_sym);
+    darray_init(index->wildcards);
+
+    for (unsigned i = 0; i < keymap->num_sym_interprets; i++) {
+        const struct xkb_sym_interpret *interp = &keymap->sym_interprets[i];
+
+        if (interp->sym == XKB_KEY_NoSymbol)
+            darray_append(index->wildcards, i);
+        else if (!hash_index_add(&index->by_sym, interp->sym, i))
+            return false;
+    }
+
+    return true;
+}
+
+static void
+ClearInterpIndex(struct interp_index *index)
+{
+    hash_index_free(&index->by_sym);
+    darray_free(index->wildcards);
+}
+
+static bool
+InterpMatches(const struct xkb_sym_interpret *interp,
+              const struct xkb_key *key, xkb_level_index_t level)
+{
+    xkb_mod_mask_t mods;
+
+    if (interp->level_one_only && level != 0)
+        mods = 0;
+    else
+        mods = key->modmap;
+
+    switch (interp->match) {
+    case MATCH_NONE:
+        return !(interp->mods & mods);
+    case MATCH_ANY_OR_NONE:
+        return (!mods || (interp->mods & mods));
+    case MATCH_ANY:
+        return (interp->mods & mods);
+    case MATCH_ALL:
+        return ((interp->mods & mods) == interp->mods);
+    case MATCH_EXACTLY:
+        return (interp->mods == mods);
+    }
+
+    return false;
+}
+
 /**
  * Find an interpretation which applies to this particular level, either by
  * finding an exact match for the symbol and modifier combination, or a
  * generic XKB_KEY_NoSymbol match.
  */
 static const struct xkb_sym_interpret *
-FindInterpForKey(struct xkb_keymap *keymap, const struct xkb_key *key,
+FindInterpForKey(struct xkb_keymap *keymap, const struct interp_index *index,
+                 const struct xkb_key *key,
                  xkb_layout_index_t group, xkb_level_index_t level)
 {
     const xkb_keysym_t *syms;
     int num_syms;
+    uint32_t pos = HASH_INDEX_END;
+    unsigned int i, w = 0;
 
     num_syms = xkb_keymap_key_get_syms_by_level(keymap, key->keycode, group,
                                                 level, &syms);
     if (num_syms == 0)
         return NULL;
 
+    /* Only the wildcards apply to levels with several keysyms. */
+    if (num_syms == 1)
+        pos = hash_index_first(&index->by_sym, syms[0]);
+
     /*
      * There may be multiple matchings interprets; we should always return
      * the most specific. Here we rely on compat.c to set up the
      * sym_interprets array from the most specific to the least specific,
-     * such that when we find a match we return immediately.
+     * such that when we find a match we return immediately. So go through
+     * the interprets for the keysym and the wildcards together, in that
+     * order.
      */
-    for (unsigned i = 0; i < keymap->num_sym_interprets; i++) {
-        const struct xkb_sym_interpret *interp = &keymap->sym_interprets[i];
-
-        xkb_mod_mask_t mods;
-        bool found = false;
-
-        if ((num_syms > 1 || interp->sym != syms[0]) &&
-            interp->sym != XKB_KEY_NoSymbol)
-            continue;
-
-        if (interp->level_one_only && level != 0)
-            mods = 0;
-        else
-            mods = key->modmap;
-
-        switch (interp->match) {
-        case MATCH_NONE:
-            found = !(interp->mods & mods);
-            break;
-        case MATCH_ANY_OR_NONE:
-            found = (!mods || (interp->mods & mods));
-            break;
-        case MATCH_ANY:
-            found = (interp->mods & mods);
-            break;
-        case MATCH_ALL:
-            found = ((interp->mods & mods) == interp->mods);
-            break;
-        case MATCH_EXACTLY:
-            found = (interp->mods == mods);
+    for (;;) {
+        const unsigned int wildcard = (w < darray_size(index->wildcards) ?
+                                       darray_item(index->wildcards, w) :
+                                       UINT_MAX);
+
+        if (pos != HASH_INDEX_END &&
+            index->by_sym.entries[pos].item < wildcard) {
+            i = index->by_sym.entries[pos].item;
+            pos = hash_index_next(&index->by_sym, syms[0], pos);
+        }
+        else if (wildcard != UINT_MAX) {
+            i = wildcard;
+            w++;
+        }
+        else {
             break;
         }
 
-        if (found)
-            return interp;
+        if (InterpMatches(&keymap->sym_interprets[i], key, level))
+            return &keymap->sym_interprets[i];
     }
 
     return &default_interpret;
 }
 
 static bool
-ApplyInterpsToKey(struct xkb_keymap *keymap, struct xkb_key *key)
+ApplyInterpsToKey(struct xkb_keymap *keymap, const struct interp_index *index,
+                  struct xkb_key *key)
 {
     xkb_mod_mask_t vmodmap = 0;
     xkb_layout_index_t group;
@@ -141,7 +201,7 @@ ApplyInterpsToKey(struct xkb_keymap *keymap, struct xkb_key *key)
         for (level = 0; level < XkbKeyNumLevels(key, group); level++) {
             const struct xkb_sym_interpret *interp;
 
-            interp = FindInterpForKey(keymap, key, group, level);
+            interp = FindInterpForKey(keymap, index, key, group, level);
             if (!interp)
                 continue;
 
@@ -171,19 +231,28 @@ ApplyInterpsToKey(struct xkb_keymap *keymap, struct xkb_key *key)
  * your actions and types are a lot more useful when any of your modifiers
  * other than Shift actually do something ...
  */
-static bool
+bool
 UpdateDerivedKeymapFields(struct xkb_keymap *keymap)
 {
     struct xkb_key *key;
     struct xkb_mod *mod;
     struct xkb_led *led;
+    struct interp_index index;
     unsigned int i, j;
 
     /* Find all the interprets for the key and bind them to actions,
      * which will also update the vmodmap. */
-    xkb_keys_foreach(key, keymap)
-        if (!ApplyInterpsToKey(keymap, key))
+    if (!InitInterpIndex(&index, keymap)) {
+        ClearInterpIndex(&index);
+        return false;
+    }
+    xkb_keys_foreach(key, keymap) {
+        if (!ApplyInterpsToKey(keymap, &index, key)) {
+            ClearInterpIndex(&index);
             return false;
+        }
+    }
+    ClearInterpIndex(&index);
 
     /* Update keymap->mods, the virtual -> real mod mapping. */
     xkb_keys_foreach(key, keymap)
@@ -296,5 +365,5 @@ CompileKeymap(XkbFile *file, struct xkb_keymap *keymap, enum merge_mode merge)
         }
     }
 
-    return UpdateDerivedKeymapFields(keymap);
+    return UpdateDerivedKeymapFields(keymap) && XkbKeymapPackKeys(keymap);
 }
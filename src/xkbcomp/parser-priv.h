@@ -41,4 +41,8 @@ parse(struct xkb_context *ctx, struct scanner *scanner, const char *map);
 int
 keyword_to_token(const char *string, size_t len);
 
+/* Also used by the keymap loader, which must read keysyms the same way. */
+bool
+resolve_keysym(const char *name, xkb_keysym_t *sym_rtrn);
+
 #endif
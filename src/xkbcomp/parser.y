@@ -37,10 +37,12 @@
 #include "xkbcomp/ast-build.h"
 #include "xkbcomp/parser-priv.h"
 #include "scanner-utils.h"
+#include "arena.h"
 
 struct parser_param {
     struct xkb_context *ctx;
     struct scanner *scanner;
+    struct arena *arena;
     XkbFile *rtrn;
     bool more_maps;
 };
@@ -57,7 +59,7 @@ _xkbcommon_error(struct parser_param *param, const char *msg)
     parser_err(param, "%s", msg);
 }
 
-static bool
+bool
 resolve_keysym(const char *name, xkb_keysym_t *sym_rtrn)
 {
     xkb_keysym_t sym;
@@ -226,15 +228,7 @@ resolve_keysym(const char *name, xkb_keysym_t *sym_rtrn)
 %type <fileList> XkbMapConfigList
 %type <file>    XkbCompositeMap
 
-%destructor { FreeStmt((ParseCommon *) $$); }
-    <any> <expr> <var> <vmod> <interp> <keyType> <syms> <modMask> <groupCompat>
-    <ledMap> <ledName> <keyCode> <keyAlias>
-%destructor { FreeStmt((ParseCommon *) $$.head); }
-    <anyList> <exprList> <varList> <vmodList>
-/* The destructor also runs on the start symbol when the parser *succeeds*.
- * The `if` here catches this case. */
-%destructor { if (!param->rtrn) FreeXkbFile($$); } <file>
-%destructor { FreeXkbFile($$.head); } <fileList>
+/* The AST is allocated from param->arena, so it needs no destructors. */
 %destructor { free($$); } <str>
 
 %%
@@ -262,7 +256,7 @@ XkbFile         :       XkbCompositeMap
 XkbCompositeMap :       OptFlags XkbCompositeType OptMapName OBRACE
                             XkbMapConfigList
                         CBRACE SEMI
-                        { $$ = XkbFileCreate($2, $3, (ParseCommon *) $5.head, $1); }
+                        { $$ = XkbFileCreate(param->arena, $2, $3, (ParseCommon *) $5.head, $1); }
                 ;
 
 XkbCompositeType:       XKB_KEYMAP      { $$ = FILE_TYPE_KEYMAP; }
@@ -280,7 +274,7 @@ XkbMapConfig    :       OptFlags FileType OptMapName OBRACE
                             DeclList
                         CBRACE SEMI
                         {
-                            $$ = XkbFileCreate($2, $3, $5.head, $1);
+                            $$ = XkbFileCreate(param->arena, $2, $3, $5.head, $1);
                         }
                 ;
 
@@ -393,25 +387,25 @@ Decl            :       OptMergeMode VarDecl
                 |       OptMergeMode DoodadDecl         { $$ = NULL; }
                 |       MergeMode STRING
                         {
-                            $$ = (ParseCommon *) IncludeCreate(param->ctx, $2, $1);
+                            $$ = (ParseCommon *) IncludeCreate(param->ctx, param->arena, $2, $1);
                             free($2);
                         }
                 ;
 
 VarDecl         :       Lhs EQUALS Expr SEMI
-                        { $$ = VarCreate($1, $3); }
+                        { $$ = VarCreate(param->arena, $1, $3); }
                 |       Ident SEMI
-                        { $$ = BoolVarCreate($1, true); }
+                        { $$ = BoolVarCreate(param->arena, $1, true); }
                 |       EXCLAM Ident SEMI
-                        { $$ = BoolVarCreate($2, false); }
+                        { $$ = BoolVarCreate(param->arena, $2, false); }
                 ;
 
 KeyNameDecl     :       KEYNAME EQUALS KeyCode SEMI
-                        { $$ = KeycodeCreate($1, $3); }
+                        { $$ = KeycodeCreate(param->arena, $1, $3); }
                 ;
 
 KeyAliasDecl    :       ALIAS KEYNAME EQUALS KEYNAME SEMI
-                        { $$ = KeyAliasCreate($2, $4); }
+                        { $$ = KeyAliasCreate(param->arena, $2, $4); }
                 ;
 
 VModDecl        :       VIRTUAL_MODS VModDefList SEMI
@@ -425,9 +419,9 @@ VModDefList     :       VModDefList COMMA VModDef
                 ;
 
 VModDef         :       Ident
-                        { $$ = VModCreate($1, NULL); }
+                        { $$ = VModCreate(param->arena, $1, NULL); }
                 |       Ident EQUALS Expr
-                        { $$ = VModCreate($1, $3); }
+                        { $$ = VModCreate(param->arena, $1, $3); }
                 ;
 
 InterpretDecl   :       INTERPRET InterpretMatch OBRACE
@@ -437,9 +431,9 @@ InterpretDecl   :       INTERPRET InterpretMatch OBRACE
                 ;
 
 InterpretMatch  :       KeySym PLUS Expr
-                        { $$ = InterpCreate($1, $3); }
+                        { $$ = InterpCreate(param->arena, $1, $3); }
                 |       KeySym
-                        { $$ = InterpCreate($1, NULL); }
+                        { $$ = InterpCreate(param->arena, $1, NULL); }
                 ;
 
 VarDeclList     :       VarDeclList VarDecl
@@ -451,13 +445,13 @@ VarDeclList     :       VarDeclList VarDecl
 KeyTypeDecl     :       TYPE String OBRACE
                             VarDeclList
                         CBRACE SEMI
-                        { $$ = KeyTypeCreate($2, $4.head); }
+                        { $$ = KeyTypeCreate(param->arena, $2, $4.head); }
                 ;
 
 SymbolsDecl     :       KEY KEYNAME OBRACE
                             SymbolsBody
                         CBRACE SEMI
-                        { $$ = SymbolsCreate($2, $4.head); }
+                        { $$ = SymbolsCreate(param->arena, $2, $4.head); }
                 ;
 
 SymbolsBody     :       SymbolsBody COMMA SymbolsVarDecl
@@ -467,35 +461,35 @@ SymbolsBody     :       SymbolsBody COMMA SymbolsVarDecl
                 |       { $$.head = $$.last = NULL; }
                 ;
 
-SymbolsVarDecl  :       Lhs EQUALS Expr         { $$ = VarCreate($1, $3); }
-                |       Lhs EQUALS ArrayInit    { $$ = VarCreate($1, $3); }
-                |       Ident                   { $$ = BoolVarCreate($1, true); }
-                |       EXCLAM Ident            { $$ = BoolVarCreate($2, false); }
-                |       ArrayInit               { $$ = VarCreate(NULL, $1); }
+SymbolsVarDecl  :       Lhs EQUALS Expr         { $$ = VarCreate(param->arena, $1, $3); }
+                |       Lhs EQUALS ArrayInit    { $$ = VarCreate(param->arena, $1, $3); }
+                |       Ident                   { $$ = BoolVarCreate(param->arena, $1, true); }
+                |       EXCLAM Ident            { $$ = BoolVarCreate(param->arena, $2, false); }
+                |       ArrayInit               { $$ = VarCreate(param->arena, NULL, $1); }
                 ;
 
 ArrayInit       :       OBRACKET OptKeySymList CBRACKET
                         { $$ = $2; }
                 |       OBRACKET ActionList CBRACKET
-                        { $$ = ExprCreateActionList($2.head); }
+                        { $$ = ExprCreateActionList(param->arena, $2.head); }
                 ;
 
 GroupCompatDecl :       GROUP Integer EQUALS Expr SEMI
-                        { $$ = GroupCompatCreate($2, $4); }
+                        { $$ = GroupCompatCreate(param->arena, $2, $4); }
                 ;
 
 ModMapDecl      :       MODIFIER_MAP Ident OBRACE ExprList CBRACE SEMI
-                        { $$ = ModMapCreate($2, $4.head); }
+                        { $$ = ModMapCreate(param->arena, $2, $4.head); }
                 ;
 
 LedMapDecl:             INDICATOR String OBRACE VarDeclList CBRACE SEMI
-                        { $$ = LedMapCreate($2, $4.head); }
+                        { $$ = LedMapCreate(param->arena, $2, $4.head); }
                 ;
 
 LedNameDecl:            INDICATOR Integer EQUALS Expr SEMI
-                        { $$ = LedNameCreate($2, $4, false); }
+                        { $$ = LedNameCreate(param->arena, $2, $4, false); }
                 |       VIRTUAL INDICATOR Integer EQUALS Expr SEMI
-                        { $$ = LedNameCreate($3, $5, true); }
+                        { $$ = LedNameCreate(param->arena, $3, $5, true); }
                 ;
 
 ShapeDecl       :       SHAPE String OBRACE OutlineList CBRACE SEMI
@@ -515,11 +509,11 @@ SectionBody     :       SectionBody SectionBodyItem     { $$ = NULL;}
 SectionBodyItem :       ROW OBRACE RowBody CBRACE SEMI
                         { $$ = NULL; }
                 |       VarDecl
-                        { FreeStmt((ParseCommon *) $1); $$ = NULL; }
+                        { (void) $1; $$ = NULL; }
                 |       DoodadDecl
                         { $$ = NULL; }
                 |       LedMapDecl
-                        { FreeStmt((ParseCommon *) $1); $$ = NULL; }
+                        { (void) $1; $$ = NULL; }
                 |       OverlayDecl
                         { $$ = NULL; }
                 ;
@@ -530,7 +524,7 @@ RowBody         :       RowBody RowBodyItem     { $$ = NULL;}
 
 RowBodyItem     :       KEYS OBRACE Keys CBRACE SEMI { $$ = NULL; }
                 |       VarDecl
-                        { FreeStmt((ParseCommon *) $1); $$ = NULL; }
+                        { (void) $1; $$ = NULL; }
                 ;
 
 Keys            :       Keys COMMA Key          { $$ = NULL; }
@@ -540,7 +534,7 @@ Keys            :       Keys COMMA Key          { $$ = NULL; }
 Key             :       KEYNAME
                         { $$ = NULL; }
                 |       OBRACE ExprList CBRACE
-                        { FreeStmt((ParseCommon *) $2.head); $$ = NULL; }
+                        { (void) $2.head; $$ = NULL; }
                 ;
 
 OverlayDecl     :       OVERLAY String OBRACE OverlayKeyList CBRACE SEMI
@@ -565,7 +559,7 @@ OutlineInList   :       OBRACE CoordList CBRACE
                 |       Ident EQUALS OBRACE CoordList CBRACE
                         { (void) $4; $$ = NULL; }
                 |       Ident EQUALS Expr
-                        { FreeStmt((ParseCommon *) $3); $$ = NULL; }
+                        { (void) $3; $$ = NULL; }
                 ;
 
 CoordList       :       CoordList COMMA Coord
@@ -579,7 +573,7 @@ Coord           :       OBRACKET SignedNumber COMMA SignedNumber CBRACKET
                 ;
 
 DoodadDecl      :       DoodadType String OBRACE VarDeclList CBRACE SEMI
-                        { FreeStmt((ParseCommon *) $4.head); $$ = NULL; }
+                        { (void) $4.head; $$ = NULL; }
                 ;
 
 DoodadType      :       TEXT    { $$ = 0; }
@@ -645,31 +639,31 @@ ExprList        :       ExprList COMMA Expr
                 ;
 
 Expr            :       Expr DIVIDE Expr
-                        { $$ = ExprCreateBinary(EXPR_DIVIDE, $1, $3); }
+                        { $$ = ExprCreateBinary(param->arena, EXPR_DIVIDE, $1, $3); }
                 |       Expr PLUS Expr
-                        { $$ = ExprCreateBinary(EXPR_ADD, $1, $3); }
+                        { $$ = ExprCreateBinary(param->arena, EXPR_ADD, $1, $3); }
                 |       Expr MINUS Expr
-                        { $$ = ExprCreateBinary(EXPR_SUBTRACT, $1, $3); }
+                        { $$ = ExprCreateBinary(param->arena, EXPR_SUBTRACT, $1, $3); }
                 |       Expr TIMES Expr
-                        { $$ = ExprCreateBinary(EXPR_MULTIPLY, $1, $3); }
+                        { $$ = ExprCreateBinary(param->arena, EXPR_MULTIPLY, $1, $3); }
                 |       Lhs EQUALS Expr
-                        { $$ = ExprCreateBinary(EXPR_ASSIGN, $1, $3); }
+                        { $$ = ExprCreateBinary(param->arena, EXPR_ASSIGN, $1, $3); }
                 |       Term
                         { $$ = $1; }
                 ;
 
 Term            :       MINUS Term
-                        { $$ = ExprCreateUnary(EXPR_NEGATE, $2->expr.value_type, $2); }
+                        { $$ = ExprCreateUnary(param->arena, EXPR_NEGATE, $2->expr.value_type, $2); }
                 |       PLUS Term
-                        { $$ = ExprCreateUnary(EXPR_UNARY_PLUS, $2->expr.value_type, $2); }
+                        { $$ = ExprCreateUnary(param->arena, EXPR_UNARY_PLUS, $2->expr.value_type, $2); }
                 |       EXCLAM Term
-                        { $$ = ExprCreateUnary(EXPR_NOT, EXPR_TYPE_BOOLEAN, $2); }
+                        { $$ = ExprCreateUnary(param->arena, EXPR_NOT, EXPR_TYPE_BOOLEAN, $2); }
                 |       INVERT Term
-                        { $$ = ExprCreateUnary(EXPR_INVERT, $2->expr.value_type, $2); }
+                        { $$ = ExprCreateUnary(param->arena, EXPR_INVERT, $2->expr.value_type, $2); }
                 |       Lhs
                         { $$ = $1;  }
                 |       FieldSpec OPAREN OptExprList CPAREN %prec OPAREN
-                        { $$ = ExprCreateAction($1, $3.head); }
+                        { $$ = ExprCreateAction(param->arena, $1, $3.head); }
                 |       Terminal
                         { $$ = $1;  }
                 |       OPAREN Expr CPAREN
@@ -683,27 +677,27 @@ ActionList      :       ActionList COMMA Action
                 ;
 
 Action          :       FieldSpec OPAREN OptExprList CPAREN
-                        { $$ = ExprCreateAction($1, $3.head); }
+                        { $$ = ExprCreateAction(param->arena, $1, $3.head); }
                 ;
 
 Lhs             :       FieldSpec
-                        { $$ = ExprCreateIdent($1); }
+                        { $$ = ExprCreateIdent(param->arena, $1); }
                 |       FieldSpec DOT FieldSpec
-                        { $$ = ExprCreateFieldRef($1, $3); }
+                        { $$ = ExprCreateFieldRef(param->arena, $1, $3); }
                 |       FieldSpec OBRACKET Expr CBRACKET
-                        { $$ = ExprCreateArrayRef(XKB_ATOM_NONE, $1, $3); }
+                        { $$ = ExprCreateArrayRef(param->arena, XKB_ATOM_NONE, $1, $3); }
                 |       FieldSpec DOT FieldSpec OBRACKET Expr CBRACKET
-                        { $$ = ExprCreateArrayRef($1, $3, $5); }
+                        { $$ = ExprCreateArrayRef(param->arena, $1, $3, $5); }
                 ;
 
 Terminal        :       String
-                        { $$ = ExprCreateString($1); }
+                        { $$ = ExprCreateString(param->arena, $1); }
                 |       Integer
-                        { $$ = ExprCreateInteger($1); }
+                        { $$ = ExprCreateInteger(param->arena, $1); }
                 |       Float
-                        { $$ = ExprCreateFloat(/* Discard $1 */); }
+                        { $$ = ExprCreateFloat(param->arena); /* Discard $1 */ }
                 |       KEYNAME
-                        { $$ = ExprCreateKeyName($1); }
+                        { $$ = ExprCreateKeyName(param->arena, $1); }
                 ;
 
 OptKeySymList   :       KeySymList      { $$ = $1; }
@@ -711,11 +705,11 @@ OptKeySymList   :       KeySymList      { $$ = $1; }
                 ;
 
 KeySymList      :       KeySymList COMMA KeySym
-                        { $$ = ExprAppendKeysymList($1, $3); }
+                        { $$ = ExprAppendKeysymList(param->arena, $1, $3); }
                 |       KeySymList COMMA KeySyms
-                        { $$ = ExprAppendMultiKeysymList($1, $3); }
+                        { $$ = ExprAppendMultiKeysymList(param->arena, $1, $3); }
                 |       KeySym
-                        { $$ = ExprCreateKeysymList($1); }
+                        { $$ = ExprCreateKeysymList(param->arena, $1); }
                 |       KeySyms
                         { $$ = ExprCreateMultiKeysymList($1); }
                 ;
@@ -802,9 +796,26 @@ parse(struct xkb_context *ctx, struct scanner *scanner, const char *map)
      * default map. If we find a map marked as default, we return it
      * immediately. If there are no maps marked as default, we return
      * the first map in the file.
+     *
+     * Each map is allocated from an arena of its own, which the map
+     * takes once it's parsed.
      */
 
-    while ((ret = yyparse(&param)) == 0 && param.more_maps) {
+    while (true) {
+        param.arena = arena_new();
+        if (!param.arena) {
+            ret = -1;
+            break;
+        }
+
+        ret = yyparse(&param);
+        if (ret != 0 || !param.more_maps) {
+            arena_free(param.arena);
+            break;
+        }
+
+        param.rtrn->arena = param.arena;
+
         if (map) {
             if (streq_not_null(map, param.rtrn->name))
                 return param.rtrn;
@@ -831,11 +842,5 @@ parse(struct xkb_context *ctx, struct scanner *scanner, const char *map)
         return NULL;
     }
 
-    if (first)
-        log_vrb(ctx, 5,
-                "No map in include statement, but \"%s\" contains several; "
-                "Using first defined map, \"%s\"\n",
-                scanner->file_name, first->name);
-
     return first;
 }
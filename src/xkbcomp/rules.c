@@ -49,7 +49,12 @@
 
 #include "config.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include "xkbcomp-priv.h"
+#include "thread.h"
+#include "hash-index.h"
 #include "rules.h"
 #include "include.h"
 #include "scanner-utils.h"
@@ -115,8 +120,7 @@ skip_more_whitespace_and_comments:
     if (eof(s)) return TOK_END_OF_FILE;
 
     /* New token. */
-    s->token_line = s->line;
-    s->token_column = s->column;
+    scanner_token_start(s);
 
     /* Operators and punctuation. */
     if (chr(s, '!')) return TOK_BANG;
@@ -126,11 +130,8 @@ skip_more_whitespace_and_comments:
     /* Group name. */
     if (chr(s, '$')) {
         val->string.start = s->s + s->pos;
-        val->string.len = 0;
-        while (is_ident(peek(s))) {
-            next(s);
-            val->string.len++;
-        }
+        val->string.len = span_graph(s, '\\');
+        s->pos += val->string.len;
         if (val->string.len == 0) {
             scanner_err(s, "unexpected character after \'$\'; expected name");
             return TOK_ERROR;
@@ -145,11 +146,8 @@ skip_more_whitespace_and_comments:
     /* Identifier. */
     if (is_ident(peek(s))) {
         val->string.start = s->s + s->pos;
-        val->string.len = 0;
-        while (is_ident(peek(s))) {
-            next(s);
-            val->string.len++;
-        }
+        val->string.len = span_graph(s, '\\');
+        s->pos += val->string.len;
         return TOK_IDENTIFIER;
     }
 
@@ -193,6 +191,7 @@ static const struct sval rules_kccgst_svals[_KCCGST_NUM_ENTRIES] = {
     [KCCGST_GEOMETRY] = SVAL_LIT("geometry"),
 };
 
+
 /* We use this to keep score whether an mlvo was matched or not; if not,
  * we warn the user that his preference was ignored. */
 struct matched_sval {
@@ -214,6 +213,7 @@ struct rule_names {
 
 struct group {
     struct sval name;
+    /* Sorted with svalcmp(), once the whole file is read. */
     darray_sval elements;
 };
 
@@ -237,32 +237,129 @@ enum mlvo_match_type {
 struct rule {
     struct sval mlvo_value_at_pos[_MLVO_NUM_ENTRIES];
     enum mlvo_match_type match_type_at_pos[_MLVO_NUM_ENTRIES];
+    /* For MLVO_MATCH_GROUP, the index of the group in the rules_db. */
+    unsigned int group_at_pos[_MLVO_NUM_ENTRIES];
     unsigned int num_mlvo_values;
     struct sval kccgst_value_at_pos[_KCCGST_NUM_ENTRIES];
     unsigned int num_kccgst_values;
+    /*
+     * Where the rule is, for reporting bad %-expansions: the line/column
+     * is only worked out then, from the contents of the file.
+     */
+    const char *file_name;
+    const char *file_string;
+    size_t pos;
     bool skip;
 };
 
+struct index_entry {
+    struct sval value;
+    unsigned int rule;
+};
+
+/* A mapping line, with the rules following it. */
+struct rule_set {
+    struct mapping mapping;
+    darray(struct rule) rules;
+    /*
+     * The rules by their value in the index_pos column, which is the
+     * column with the fewest wildcards. Rules with a group there are
+     * found under each of the group's elements; rules with a wildcard
+     * there are only in wildcard_rules.
+     */
+    unsigned int index_pos;
+    darray(struct index_entry) index;
+    darray_uint wildcard_rules;
+};
+
+struct rules_file {
+    char *path;
+    char *string;
+    size_t len;
+    /* To tell whether the file changed since it was read. */
+    time_t mtime;
+    off_t size;
+};
+
 /*
- * This is the main object used to match a given RMLVO against a rules
- * file and aggragate the results in a KcCGST. It goes through a simple
- * matching state machine, with tokens as transitions (see
- * matcher_match()).
+ * A rules file, together with the files it includes, in a form which can
+ * be matched against many RMLVOs without reading the files again. Once
+ * built it is never modified, so it can be shared between threads; see
+ * rules_cache.
+ *
+ * The svals point into the contents of the files, which are kept.
  */
-struct matcher {
+struct rules_db {
+    int refcnt;
+    darray(struct rules_file) files;
+    darray(struct group) groups;
+    darray(struct rule_set) rule_sets;
+};
+
+/*
+ * This is the object used to build a rules_db from a rules file. It goes
+ * through a simple state machine, with tokens as transitions (see
+ * parser_parse()).
+ */
+struct parser {
     struct xkb_context *ctx;
-    /* Input.*/
-    struct rule_names rmlvo;
+    struct rules_db *db;
     union lvalue val;
-    darray(struct group) groups;
     /* Current mapping. */
     struct mapping mapping;
     /* Current rule. */
     struct rule rule;
+};
+
+/*
+ * This is the main object used to match a given RMLVO against a rules
+ * database and aggregate the results in a KcCGST (see matcher_match()).
+ */
+struct matcher {
+    struct xkb_context *ctx;
+    const struct rules_db *db;
+    /* Input.*/
+    struct rule_names rmlvo;
+    /* The rules of the current rule set which may match. */
+    darray_uint candidates;
     /* Output. */
     darray_char kccgst[_KCCGST_NUM_ENTRIES];
+    /* Whether anything was logged while matching. */
+    bool logged;
 };
 
+static int
+svalcmp(const struct sval *s1, const struct sval *s2)
+{
+    if (s1->len != s2->len)
+        return s1->len < s2->len ? -1 : 1;
+    return memcmp(s1->start, s2->start, s1->len);
+}
+
+static int
+svalcmp_qsort(const void *a, const void *b)
+{
+    return svalcmp(a, b);
+}
+
+static int
+index_entry_cmp(const void *a, const void *b)
+{
+    const struct index_entry *e1 = a, *e2 = b;
+    int ret = svalcmp(&e1->value, &e2->value);
+    if (ret != 0)
+        return ret;
+    return e1->rule < e2->rule ? -1 : e1->rule > e2->rule;
+}
+
+static int
+uint_cmp(const void *a, const void *b)
+{
+    unsigned int u1 = *(const unsigned int *) a;
+    unsigned int u2 = *(const unsigned int *) b;
+    return u1 < u2 ? -1 : u1 > u2;
+}
+
 static struct sval
 strip_spaces(struct sval v)
 {
@@ -299,75 +396,161 @@ split_comma_separated_mlvo(const char *s)
     return arr;
 }
 
-static struct matcher *
-matcher_new(struct xkb_context *ctx,
-            const struct xkb_rule_names *rmlvo)
-{
-    struct matcher *m = calloc(1, sizeof(*m));
-    if (!m)
-        return NULL;
-
-    m->ctx = ctx;
-    m->rmlvo.model.sval.start = rmlvo->model;
-    m->rmlvo.model.sval.len = strlen_safe(rmlvo->model);
-    m->rmlvo.layouts = split_comma_separated_mlvo(rmlvo->layout);
-    m->rmlvo.variants = split_comma_separated_mlvo(rmlvo->variant);
-    m->rmlvo.options = split_comma_separated_mlvo(rmlvo->options);
+/***====================================================================***/
 
-    return m;
+static struct rules_db *
+rules_db_ref(struct rules_db *db)
+{
+    refcnt_inc(&db->refcnt);
+    return db;
 }
 
 static void
-matcher_free(struct matcher *m)
+rules_db_unref(struct rules_db *db)
 {
+    struct rules_file *file;
     struct group *group;
-    if (!m)
+    struct rule_set *rule_set;
+
+    if (!db || refcnt_dec(&db->refcnt) > 0)
         return;
-    darray_free(m->rmlvo.layouts);
-    darray_free(m->rmlvo.variants);
-    darray_free(m->rmlvo.options);
-    darray_foreach(group, m->groups)
+
+    darray_foreach(file, db->files) {
+        free(file->path);
+        free(file->string);
+    }
+    darray_free(db->files);
+    darray_foreach(group, db->groups)
         darray_free(group->elements);
-    for (int i = 0; i < _KCCGST_NUM_ENTRIES; i++)
-        darray_free(m->kccgst[i]);
-    darray_free(m->groups);
-    free(m);
+    darray_free(db->groups);
+    darray_foreach(rule_set, db->rule_sets) {
+        darray_free(rule_set->rules);
+        darray_free(rule_set->index);
+        darray_free(rule_set->wildcard_rules);
+    }
+    darray_free(db->rule_sets);
+    free(db);
+}
+
+/* Whether none of the files the database was built from changed since. */
+static bool
+rules_db_is_current(const struct rules_db *db)
+{
+    const struct rules_file *file;
+    struct stat st;
+
+    darray_foreach(file, db->files)
+        if (stat(file->path, &st) != 0 ||
+            st.st_mtime != file->mtime || st.st_size != file->size)
+            return false;
+
+    return true;
 }
 
 static void
-matcher_group_start_new(struct matcher *m, struct sval name)
+rule_set_build_index(struct rule_set *rule_set, const struct rules_db *db)
 {
-    struct group group = { .name = name, .elements = darray_new() };
-    darray_append(m->groups, group);
+    unsigned int num_wildcards[_MLVO_NUM_ENTRIES] = { 0 };
+    struct rule *rule;
+    unsigned int idx, pos;
+
+    pos = 0;
+    for (unsigned i = 0; i < rule_set->mapping.num_mlvo; i++) {
+        darray_foreach(rule, rule_set->rules)
+            if (rule->match_type_at_pos[i] == MLVO_MATCH_WILDCARD)
+                num_wildcards[i]++;
+        if (num_wildcards[i] < num_wildcards[pos])
+            pos = i;
+    }
+    rule_set->index_pos = pos;
+
+    darray_enumerate(idx, rule, rule_set->rules) {
+        const struct group *group;
+        const struct sval *element;
+
+        switch (rule->match_type_at_pos[pos]) {
+        case MLVO_MATCH_NORMAL:
+            darray_append(rule_set->index, (struct index_entry) {
+                .value = rule->mlvo_value_at_pos[pos],
+                .rule = idx,
+            });
+            break;
+        case MLVO_MATCH_GROUP:
+            group = &darray_item(db->groups, rule->group_at_pos[pos]);
+            darray_foreach(element, group->elements)
+                darray_append(rule_set->index, (struct index_entry) {
+                    .value = *element,
+                    .rule = idx,
+                });
+            break;
+        case MLVO_MATCH_WILDCARD:
+            darray_append(rule_set->wildcard_rules, idx);
+            break;
+        }
+    }
+
+    if (!darray_empty(rule_set->index))
+        qsort(rule_set->index.item, darray_size(rule_set->index),
+              sizeof(struct index_entry), index_entry_cmp);
 }
 
+/* Called once all the files are read. */
 static void
-matcher_group_add_element(struct matcher *m, struct scanner *s,
-                          struct sval element)
+rules_db_finish(struct rules_db *db)
 {
-    darray_append(darray_item(m->groups, darray_size(m->groups) - 1).elements,
-                  element);
+    struct group *group;
+    struct rule_set *rule_set;
+
+    darray_foreach(group, db->groups)
+        if (!darray_empty(group->elements))
+            qsort(group->elements.item, darray_size(group->elements),
+                  sizeof(struct sval), svalcmp_qsort);
+
+    darray_foreach(rule_set, db->rule_sets)
+        rule_set_build_index(rule_set, db);
 }
 
+/***====================================================================***/
+
 static bool
-read_rules_file(struct xkb_context *ctx,
-                struct matcher *matcher,
+read_rules_file(struct parser *p,
                 unsigned include_depth,
                 FILE *file,
                 const char *path);
 
 static void
-matcher_include(struct matcher *m, struct scanner *parent_scanner,
-                unsigned include_depth,
-                struct sval inc)
+parser_group_start_new(struct parser *p, struct sval name)
+{
+    struct group group = { .name = name, .elements = darray_new() };
+    darray_append(p->db->groups, group);
+}
+
+static void
+parser_group_add_element(struct parser *p, struct scanner *s,
+                         struct sval element)
+{
+    darray_append(darray_item(p->db->groups,
+                              darray_size(p->db->groups) - 1).elements,
+                  element);
+}
+
+static void
+parser_include(struct parser *p, struct scanner *parent_scanner,
+               unsigned include_depth,
+               struct sval inc)
 {
     struct scanner s; /* parses the !include value */
     FILE *file;
 
-    scanner_init(&s, m->ctx, inc.start, inc.len,
+    /*
+     * The value is in the parent's string; scan only it, but report errors
+     * at the include statement.
+     */
+    scanner_init(&s, p->ctx, parent_scanner->s,
+                 inc.start + inc.len - parent_scanner->s,
                  parent_scanner->file_name, NULL);
-    s.token_line = parent_scanner->token_line;
-    s.token_column = parent_scanner->token_column;
+    s.pos = inc.start - parent_scanner->s;
+    s.token_pos = parent_scanner->token_pos;
     s.buf_pos = 0;
 
     if (include_depth >= MAX_INCLUDE_DEPTH) {
@@ -393,7 +576,7 @@ matcher_include(struct matcher *m, struct scanner *parent_scanner,
                 }
             }
             else if (chr(&s, 'S')) {
-                const char *default_root = xkb_context_include_path_get_system_path(m->ctx);
+                const char *default_root = xkb_context_include_path_get_system_path(p->ctx);
                 if (!buf_appends(&s, default_root) || !buf_appends(&s, "/rules")) {
                     scanner_err(&s, "include path after expanding %%S is too long");
                     return;
@@ -415,27 +598,27 @@ matcher_include(struct matcher *m, struct scanner *parent_scanner,
 
     file = fopen(s.buf, "rb");
     if (file) {
-        bool ret = read_rules_file(m->ctx, m, include_depth + 1, file, s.buf);
+        bool ret = read_rules_file(p, include_depth + 1, file, s.buf);
         if (!ret)
-            log_err(m->ctx, "No components returned from included XKB rules \"%s\"\n", s.buf);
+            log_err(p->ctx, "No components returned from included XKB rules \"%s\"\n", s.buf);
         fclose(file);
     } else {
-        log_err(m->ctx, "Failed to open included XKB rules \"%s\"\n", s.buf);
+        log_err(p->ctx, "Failed to open included XKB rules \"%s\"\n", s.buf);
     }
 }
 
 static void
-matcher_mapping_start_new(struct matcher *m)
+parser_mapping_start_new(struct parser *p)
 {
     for (unsigned i = 0; i < _MLVO_NUM_ENTRIES; i++)
-        m->mapping.mlvo_at_pos[i] = -1;
+        p->mapping.mlvo_at_pos[i] = -1;
     for (unsigned i = 0; i < _KCCGST_NUM_ENTRIES; i++)
-        m->mapping.kccgst_at_pos[i] = -1;
-    m->mapping.layout_idx = m->mapping.variant_idx = XKB_LAYOUT_INVALID;
-    m->mapping.num_mlvo = m->mapping.num_kccgst = 0;
-    m->mapping.defined_mlvo_mask = 0;
-    m->mapping.defined_kccgst_mask = 0;
-    m->mapping.skip = false;
+        p->mapping.kccgst_at_pos[i] = -1;
+    p->mapping.layout_idx = p->mapping.variant_idx = XKB_LAYOUT_INVALID;
+    p->mapping.num_mlvo = p->mapping.num_kccgst = 0;
+    p->mapping.defined_mlvo_mask = 0;
+    p->mapping.defined_kccgst_mask = 0;
+    p->mapping.skip = false;
 }
 
 static int
@@ -455,8 +638,8 @@ extract_layout_index(const char *s, size_t max_len, xkb_layout_index_t *out)
 }
 
 static void
-matcher_mapping_set_mlvo(struct matcher *m, struct scanner *s,
-                         struct sval ident)
+parser_mapping_set_mlvo(struct parser *p, struct scanner *s,
+                        struct sval ident)
 {
     enum rules_mlvo mlvo;
     struct sval mlvo_sval;
@@ -472,14 +655,14 @@ matcher_mapping_set_mlvo(struct matcher *m, struct scanner *s,
     if (mlvo >= _MLVO_NUM_ENTRIES) {
         scanner_err(s, "invalid mapping: %.*s is not a valid value here; ignoring rule set",
                     ident.len, ident.start);
-        m->mapping.skip = true;
+        p->mapping.skip = true;
         return;
     }
 
-    if (m->mapping.defined_mlvo_mask & (1u << mlvo)) {
+    if (p->mapping.defined_mlvo_mask & (1u << mlvo)) {
         scanner_err(s, "invalid mapping: %.*s appears twice on the same line; ignoring rule set",
                     mlvo_sval.len, mlvo_sval.start);
-        m->mapping.skip = true;
+        p->mapping.skip = true;
         return;
     }
 
@@ -491,31 +674,32 @@ matcher_mapping_set_mlvo(struct matcher *m, struct scanner *s,
         if ((int) (ident.len - mlvo_sval.len) != consumed) {
             scanner_err(s, "invalid mapping: \"%.*s\" may only be followed by a valid group index; ignoring rule set",
                         mlvo_sval.len, mlvo_sval.start);
-            m->mapping.skip = true;
+            p->mapping.skip = true;
             return;
         }
 
         if (mlvo == MLVO_LAYOUT) {
-            m->mapping.layout_idx = idx;
+            p->mapping.layout_idx = idx;
         }
         else if (mlvo == MLVO_VARIANT) {
-            m->mapping.variant_idx = idx;
+            p->mapping.variant_idx = idx;
         }
         else {
             scanner_err(s, "invalid mapping: \"%.*s\" cannot be followed by a group index; ignoring rule set",
                         mlvo_sval.len, mlvo_sval.start);
-            m->mapping.skip = true;
+            p->mapping.skip = true;
             return;
         }
     }
 
-    m->mapping.mlvo_at_pos[m->mapping.num_mlvo] = mlvo;
-    m->mapping.defined_mlvo_mask |= 1u << mlvo;
-    m->mapping.num_mlvo++;
+    p->mapping.mlvo_at_pos[p->mapping.num_mlvo] = mlvo;
+    p->mapping.defined_mlvo_mask |= 1u << mlvo;
+    p->mapping.num_mlvo++;
 }
 
 static void
-matcher_mapping_set_kccgst(struct matcher *m, struct scanner *s, struct sval ident)
+parser_mapping_set_kccgst(struct parser *p, struct scanner *s,
+                          struct sval ident)
 {
     enum rules_kccgst kccgst;
     struct sval kccgst_sval;
@@ -531,234 +715,857 @@ matcher_mapping_set_kccgst(struct matcher *m, struct scanner *s, struct sval ide
     if (kccgst >= _KCCGST_NUM_ENTRIES) {
         scanner_err(s, "invalid mapping: %.*s is not a valid value here; ignoring rule set",
                     ident.len, ident.start);
-        m->mapping.skip = true;
+        p->mapping.skip = true;
         return;
     }
 
-    if (m->mapping.defined_kccgst_mask & (1u << kccgst)) {
+    if (p->mapping.defined_kccgst_mask & (1u << kccgst)) {
         scanner_err(s, "invalid mapping: %.*s appears twice on the same line; ignoring rule set",
                     kccgst_sval.len, kccgst_sval.start);
-        m->mapping.skip = true;
+        p->mapping.skip = true;
         return;
     }
 
-    m->mapping.kccgst_at_pos[m->mapping.num_kccgst] = kccgst;
-    m->mapping.defined_kccgst_mask |= 1u << kccgst;
-    m->mapping.num_kccgst++;
+    p->mapping.kccgst_at_pos[p->mapping.num_kccgst] = kccgst;
+    p->mapping.defined_kccgst_mask |= 1u << kccgst;
+    p->mapping.num_kccgst++;
 }
 
 static void
-matcher_mapping_verify(struct matcher *m, struct scanner *s)
+parser_mapping_verify(struct parser *p, struct scanner *s)
 {
-    if (m->mapping.num_mlvo == 0) {
+    struct rule_set rule_set = { .mapping = p->mapping };
+
+    if (p->mapping.num_mlvo == 0) {
         scanner_err(s, "invalid mapping: must have at least one value on the left hand side; ignoring rule set");
         goto skip;
     }
 
-    if (m->mapping.num_kccgst == 0) {
+    if (p->mapping.num_kccgst == 0) {
         scanner_err(s, "invalid mapping: must have at least one value on the right hand side; ignoring rule set");
         goto skip;
     }
 
-    /*
-     * This following is very stupid, but this is how it works.
-     * See the "Notes" section in the overview above.
-     */
-
-    if (m->mapping.defined_mlvo_mask & (1u << MLVO_LAYOUT)) {
-        if (m->mapping.layout_idx == XKB_LAYOUT_INVALID) {
-            if (darray_size(m->rmlvo.layouts) > 1)
-                goto skip;
-        }
-        else {
-            if (darray_size(m->rmlvo.layouts) == 1 ||
-                m->mapping.layout_idx >= darray_size(m->rmlvo.layouts))
-                goto skip;
-        }
-    }
-
-    if (m->mapping.defined_mlvo_mask & (1u << MLVO_VARIANT)) {
-        if (m->mapping.variant_idx == XKB_LAYOUT_INVALID) {
-            if (darray_size(m->rmlvo.variants) > 1)
-                goto skip;
-        }
-        else {
-            if (darray_size(m->rmlvo.variants) == 1 ||
-                m->mapping.variant_idx >= darray_size(m->rmlvo.variants))
-                goto skip;
-        }
-    }
-
+    darray_append(p->db->rule_sets, rule_set);
     return;
 
 skip:
-    m->mapping.skip = true;
+    p->mapping.skip = true;
 }
 
 static void
-matcher_rule_start_new(struct matcher *m)
+parser_rule_start_new(struct parser *p)
 {
-    memset(&m->rule, 0, sizeof(m->rule));
-    m->rule.skip = m->mapping.skip;
+    memset(&p->rule, 0, sizeof(p->rule));
+    p->rule.skip = p->mapping.skip;
 }
 
 static void
-matcher_rule_set_mlvo_common(struct matcher *m, struct scanner *s,
-                             struct sval ident,
-                             enum mlvo_match_type match_type)
+parser_rule_set_mlvo_common(struct parser *p, struct scanner *s,
+                            struct sval ident,
+                            enum mlvo_match_type match_type)
 {
-    if (m->rule.num_mlvo_values + 1 > m->mapping.num_mlvo) {
+    if (p->rule.num_mlvo_values + 1 > p->mapping.num_mlvo) {
         scanner_err(s, "invalid rule: has more values than the mapping line; ignoring rule");
-        m->rule.skip = true;
+        p->rule.skip = true;
         return;
     }
-    m->rule.match_type_at_pos[m->rule.num_mlvo_values] = match_type;
-    m->rule.mlvo_value_at_pos[m->rule.num_mlvo_values] = ident;
-    m->rule.num_mlvo_values++;
+    p->rule.match_type_at_pos[p->rule.num_mlvo_values] = match_type;
+    p->rule.mlvo_value_at_pos[p->rule.num_mlvo_values] = ident;
+    p->rule.num_mlvo_values++;
 }
 
 static void
-matcher_rule_set_mlvo_wildcard(struct matcher *m, struct scanner *s)
+parser_rule_set_mlvo_wildcard(struct parser *p, struct scanner *s)
 {
     struct sval dummy = { NULL, 0 };
-    matcher_rule_set_mlvo_common(m, s, dummy, MLVO_MATCH_WILDCARD);
+    parser_rule_set_mlvo_common(p, s, dummy, MLVO_MATCH_WILDCARD);
 }
 
 static void
-matcher_rule_set_mlvo_group(struct matcher *m, struct scanner *s,
-                            struct sval ident)
+parser_rule_set_mlvo_group(struct parser *p, struct scanner *s,
+                           struct sval ident)
 {
-    matcher_rule_set_mlvo_common(m, s, ident, MLVO_MATCH_GROUP);
+    struct group *group;
+    unsigned int idx;
+
+    /* Only the groups defined so far count, and the first one wins. */
+    darray_enumerate(idx, group, p->db->groups) {
+        if (svaleq(group->name, ident)) {
+            parser_rule_set_mlvo_common(p, s, ident, MLVO_MATCH_GROUP);
+            if (!p->rule.skip)
+                p->rule.group_at_pos[p->rule.num_mlvo_values - 1] = idx;
+            return;
+        }
+    }
+
+    /*
+     * rules/evdev intentionally uses some undeclared group names
+     * in rules (e.g. commented group definitions which may be
+     * uncommented if needed). Such rules can never match, so they
+     * are dropped silently.
+     */
+    p->rule.skip = true;
 }
 
 static void
-matcher_rule_set_mlvo(struct matcher *m, struct scanner *s,
-                      struct sval ident)
+parser_rule_set_mlvo(struct parser *p, struct scanner *s,
+                     struct sval ident)
 {
-    matcher_rule_set_mlvo_common(m, s, ident, MLVO_MATCH_NORMAL);
+    parser_rule_set_mlvo_common(p, s, ident, MLVO_MATCH_NORMAL);
 }
 
 static void
-matcher_rule_set_kccgst(struct matcher *m, struct scanner *s,
-                        struct sval ident)
+parser_rule_set_kccgst(struct parser *p, struct scanner *s,
+                       struct sval ident)
 {
-    if (m->rule.num_kccgst_values + 1 > m->mapping.num_kccgst) {
+    if (p->rule.num_kccgst_values + 1 > p->mapping.num_kccgst) {
         scanner_err(s, "invalid rule: has more values than the mapping line; ignoring rule");
-        m->rule.skip = true;
+        p->rule.skip = true;
         return;
     }
-    m->rule.kccgst_value_at_pos[m->rule.num_kccgst_values] = ident;
-    m->rule.num_kccgst_values++;
+    p->rule.kccgst_value_at_pos[p->rule.num_kccgst_values] = ident;
+    p->rule.num_kccgst_values++;
 }
 
-static bool
-match_group(struct matcher *m, struct sval group_name, struct sval to)
+static void
+parser_rule_verify(struct parser *p, struct scanner *s)
 {
-    struct group *group;
-    struct sval *element;
-    bool found = false;
-
-    darray_foreach(group, m->groups) {
-        if (svaleq(group->name, group_name)) {
-            found = true;
-            break;
-        }
-    }
-
-    if (!found) {
-        /*
-         * rules/evdev intentionally uses some undeclared group names
-         * in rules (e.g. commented group definitions which may be
-         * uncommented if needed). So we continue silently.
-         */
-        return false;
+    if (p->rule.num_mlvo_values != p->mapping.num_mlvo ||
+        p->rule.num_kccgst_values != p->mapping.num_kccgst) {
+        scanner_err(s, "invalid rule: must have same number of values as mapping line; ignoring rule");
+        p->rule.skip = true;
     }
-
-    darray_foreach(element, group->elements)
-        if (svaleq(to, *element))
-            return true;
-
-    return false;
 }
 
-static bool
-match_value(struct matcher *m, struct sval val, struct sval to,
-            enum mlvo_match_type match_type)
+static void
+parser_rule_add(struct parser *p, struct scanner *s)
 {
-    if (match_type == MLVO_MATCH_WILDCARD)
-        return true;
-    if (match_type == MLVO_MATCH_GROUP)
-        return match_group(m, val, to);
-    return svaleq(val, to);
+    struct rule_set *rule_set =
+        &darray_item(p->db->rule_sets, darray_size(p->db->rule_sets) - 1);
+
+    p->rule.file_name = s->file_name;
+    p->rule.file_string = s->s;
+    p->rule.pos = s->token_pos;
+    darray_append(rule_set->rules, p->rule);
 }
 
-static bool
-match_value_and_mark(struct matcher *m, struct sval val,
-                     struct matched_sval *to, enum mlvo_match_type match_type)
+static enum rules_token
+gettok(struct parser *p, struct scanner *s)
 {
-    bool matched = match_value(m, val, to->sval, match_type);
-    if (matched)
-        to->matched = true;
-    return matched;
+    return lex(s, &p->val);
 }
 
-/*
- * This function performs %-expansion on @value (see overview above),
- * and appends the result to @to.
- */
 static bool
-append_expanded_kccgst_value(struct matcher *m, struct scanner *s,
-                             darray_char *to, struct sval value)
+parser_parse(struct parser *p, struct scanner *s,
+             unsigned include_depth)
 {
-    const char *str = value.start;
-    darray_char expanded = darray_new();
-    char ch;
-    bool expanded_plus, to_plus;
+    enum rules_token tok;
 
-    /*
-     * Some ugly hand-lexing here, but going through the scanner is more
-     * trouble than it's worth, and the format is ugly on its own merit.
-     */
-    for (unsigned i = 0; i < value.len; ) {
-        enum rules_mlvo mlv;
-        xkb_layout_index_t idx;
-        char pfx, sfx;
-        struct matched_sval *expanded_value;
+initial:
+    switch (tok = gettok(p, s)) {
+    case TOK_BANG:
+        goto bang;
+    case TOK_END_OF_LINE:
+        goto initial;
+    case TOK_END_OF_FILE:
+        goto finish;
+    default:
+        goto unexpected;
+    }
 
-        /* Check if that's a start of an expansion. */
-        if (str[i] != '%') {
-            /* Just a normal character. */
-            darray_appends_nullterminate(expanded, &str[i++], 1);
-            continue;
-        }
-        if (++i >= value.len) goto error;
+bang:
+    switch (tok = gettok(p, s)) {
+    case TOK_GROUP_NAME:
+        parser_group_start_new(p, p->val.string);
+        goto group_name;
+    case TOK_INCLUDE:
+        goto include_statement;
+    case TOK_IDENTIFIER:
+        parser_mapping_start_new(p);
+        parser_mapping_set_mlvo(p, s, p->val.string);
+        goto mapping_mlvo;
+    default:
+        goto unexpected;
+    }
 
-        pfx = sfx = 0;
+group_name:
+    switch (tok = gettok(p, s)) {
+    case TOK_EQUALS:
+        goto group_element;
+    default:
+        goto unexpected;
+    }
 
-        /* Check for prefix. */
-        if (str[i] == '(' || str[i] == '+' || str[i] == '|' ||
-            str[i] == '_' || str[i] == '-') {
-            pfx = str[i];
-            if (str[i] == '(') sfx = ')';
-            if (++i >= value.len) goto error;
-        }
+group_element:
+    switch (tok = gettok(p, s)) {
+    case TOK_IDENTIFIER:
+        parser_group_add_element(p, s, p->val.string);
+        goto group_element;
+    case TOK_END_OF_LINE:
+        goto initial;
+    default:
+        goto unexpected;
+    }
 
-        /* Mandatory model/layout/variant specifier. */
-        switch (str[i++]) {
-        case 'm': mlv = MLVO_MODEL; break;
-        case 'l': mlv = MLVO_LAYOUT; break;
-        case 'v': mlv = MLVO_VARIANT; break;
-        default: goto error;
-        }
+include_statement:
+    switch (tok = gettok(p, s)) {
+    case TOK_IDENTIFIER:
+        parser_include(p, s, include_depth, p->val.string);
+        goto initial;
+    default:
+        goto unexpected;
+    }
 
-        /* Check for index. */
-        idx = XKB_LAYOUT_INVALID;
-        if (i < value.len && str[i] == '[') {
-            int consumed;
+mapping_mlvo:
+    switch (tok = gettok(p, s)) {
+    case TOK_IDENTIFIER:
+        if (!p->mapping.skip)
+            parser_mapping_set_mlvo(p, s, p->val.string);
+        goto mapping_mlvo;
+    case TOK_EQUALS:
+        goto mapping_kccgst;
+    default:
+        goto unexpected;
+    }
 
-            if (mlv != MLVO_LAYOUT && mlv != MLVO_VARIANT) {
-                scanner_err(s, "invalid index in %%-expansion; may only index layout or variant");
-                goto error;
+mapping_kccgst:
+    switch (tok = gettok(p, s)) {
+    case TOK_IDENTIFIER:
+        if (!p->mapping.skip)
+            parser_mapping_set_kccgst(p, s, p->val.string);
+        goto mapping_kccgst;
+    case TOK_END_OF_LINE:
+        if (!p->mapping.skip)
+            parser_mapping_verify(p, s);
+        goto rule_mlvo_first;
+    default:
+        goto unexpected;
+    }
+
+rule_mlvo_first:
+    switch (tok = gettok(p, s)) {
+    case TOK_BANG:
+        goto bang;
+    case TOK_END_OF_LINE:
+        goto rule_mlvo_first;
+    case TOK_END_OF_FILE:
+        goto finish;
+    default:
+        parser_rule_start_new(p);
+        goto rule_mlvo_no_tok;
+    }
+
+rule_mlvo:
+    tok = gettok(p, s);
+rule_mlvo_no_tok:
+    switch (tok) {
+    case TOK_IDENTIFIER:
+        if (!p->rule.skip)
+            parser_rule_set_mlvo(p, s, p->val.string);
+        goto rule_mlvo;
+    case TOK_STAR:
+        if (!p->rule.skip)
+            parser_rule_set_mlvo_wildcard(p, s);
+        goto rule_mlvo;
+    case TOK_GROUP_NAME:
+        if (!p->rule.skip)
+            parser_rule_set_mlvo_group(p, s, p->val.string);
+        goto rule_mlvo;
+    case TOK_EQUALS:
+        goto rule_kccgst;
+    default:
+        goto unexpected;
+    }
+
+rule_kccgst:
+    switch (tok = gettok(p, s)) {
+    case TOK_IDENTIFIER:
+        if (!p->rule.skip)
+            parser_rule_set_kccgst(p, s, p->val.string);
+        goto rule_kccgst;
+    case TOK_END_OF_LINE:
+        if (!p->rule.skip)
+            parser_rule_verify(p, s);
+        if (!p->rule.skip)
+            parser_rule_add(p, s);
+        goto rule_mlvo_first;
+    default:
+        goto unexpected;
+    }
+
+unexpected:
+    switch (tok) {
+    case TOK_ERROR:
+        goto error;
+    default:
+        goto state_error;
+    }
+
+finish:
+    return true;
+
+state_error:
+    scanner_err(s, "unexpected token");
+error:
+    return false;
+}
+
+static bool
+read_rules_file(struct parser *p,
+                unsigned include_depth,
+                FILE *file,
+                const char *path)
+{
+    struct rules_file rules_file = { 0 };
+    struct scanner scanner;
+    struct stat st;
+    char *string;
+    size_t size;
+    bool ret;
+
+    if (fstat(fileno(file), &st) != 0 || !map_file(file, &string, &size)) {
+        log_err(p->ctx, "Couldn't read rules file \"%s\": %s\n",
+                path, strerror(errno));
+        return false;
+    }
+
+    /* The rules point into the file, so keep a copy around. */
+    rules_file.path = strdup(path);
+    rules_file.string = malloc(size + 1);
+    if (!rules_file.path || !rules_file.string) {
+        log_err(p->ctx, "Couldn't allocate memory for rules file \"%s\"\n",
+                path);
+        free(rules_file.path);
+        free(rules_file.string);
+        unmap_file(string, size);
+        return false;
+    }
+    memcpy(rules_file.string, string, size);
+    rules_file.len = size;
+    rules_file.mtime = st.st_mtime;
+    rules_file.size = st.st_size;
+    unmap_file(string, size);
+    darray_append(p->db->files, rules_file);
+
+    scanner_init(&scanner, p->ctx, rules_file.string, rules_file.len,
+                 rules_file.path, NULL);
+
+    ret = parser_parse(p, &scanner, include_depth);
+
+    return ret;
+}
+
+static struct rules_db *
+rules_db_new_from_file(struct xkb_context *ctx, FILE *file, const char *path)
+{
+    struct parser parser = { .ctx = ctx };
+
+    parser.db = calloc(1, sizeof(*parser.db));
+    if (!parser.db)
+        return NULL;
+    parser.db->refcnt = 1;
+
+    if (!read_rules_file(&parser, 0, file, path)) {
+        rules_db_unref(parser.db);
+        return NULL;
+    }
+
+    rules_db_finish(parser.db);
+    return parser.db;
+}
+
+/***====================================================================***/
+
+/*
+ * The rules files read from a context, one per path, enabled with any of
+ * the context's caching flags. They are read again when they, or a file
+ * they include, changed on disk.
+ *
+ * The cache also remembers the KcCGST of the most recently resolved
+ * RMLVOs, keyed by xkb_context_rule_names_key(). Each of these holds the
+ * database it was matched against, and is only used while that is
+ * current. RMLVOs which logged anything while matching, e.g. unrecognized
+ * names, are not remembered, so that the messages are logged every time.
+ * When the memo is full, the least recently used entry is dropped, and
+ * the new one takes its slot.
+ *
+ * The memo is looked up through a hash index of the hashes of the keys,
+ * which is rebuilt once there are too many stale slots in it, as for the
+ * keymap cache.
+ */
+#define RULES_MEMO_MAX_ENTRIES 64
+#define RULES_MEMO_MAX_INDEXED (4 * RULES_MEMO_MAX_ENTRIES)
+
+struct rules_memo_entry {
+    uint32_t hash;
+    char *key;
+    size_t key_len;
+    unsigned long last_used;
+    struct rules_db *db;
+    struct xkb_component_names kccgst;
+};
+
+struct rules_cache {
+    xkb_mutex_t mutex;
+    darray(struct rules_db *) dbs;
+    darray(struct rules_memo_entry) memo;
+    struct hash_index memo_index;
+    unsigned long clock;
+};
+
+static void
+components_free(struct xkb_component_names *kccgst)
+{
+    free(kccgst->keycodes);
+    free(kccgst->types);
+    free(kccgst->compat);
+    free(kccgst->symbols);
+}
+
+static bool
+components_copy(struct xkb_component_names *to,
+                const struct xkb_component_names *from)
+{
+    to->keycodes = strdup(from->keycodes);
+    to->types = strdup(from->types);
+    to->compat = strdup(from->compat);
+    to->symbols = strdup(from->symbols);
+    if (!to->keycodes || !to->types || !to->compat || !to->symbols) {
+        components_free(to);
+        return false;
+    }
+    return true;
+}
+
+struct rules_cache *
+rules_cache_new(void)
+{
+    struct rules_cache *cache = calloc(1, sizeof(*cache));
+    if (!cache)
+        return NULL;
+
+    mutex_init(&cache->mutex);
+    darray_init(cache->dbs);
+    darray_init(cache->memo);
+    hash_index_init(&cache->memo_index);
+    return cache;
+}
+
+void
+rules_cache_clear(struct rules_cache *cache)
+{
+    struct rules_db **db;
+    struct rules_memo_entry *entry;
+
+    mutex_lock(&cache->mutex);
+    darray_foreach(db, cache->dbs)
+        rules_db_unref(*db);
+    darray_free(cache->dbs);
+    darray_foreach(entry, cache->memo) {
+        free(entry->key);
+        rules_db_unref(entry->db);
+        components_free(&entry->kccgst);
+    }
+    darray_free(cache->memo);
+    hash_index_free(&cache->memo_index);
+    mutex_unlock(&cache->mutex);
+}
+
+void
+rules_cache_free(struct rules_cache *cache)
+{
+    if (!cache)
+        return;
+
+    rules_cache_clear(cache);
+    mutex_destroy(&cache->mutex);
+    free(cache);
+}
+
+/* Must be called with the cache locked. */
+static struct rules_db **
+rules_cache_find(struct rules_cache *cache, const char *path)
+{
+    struct rules_db **db;
+
+    darray_foreach(db, cache->dbs)
+        if (streq(darray_item((*db)->files, 0).path, path))
+            return db;
+
+    return NULL;
+}
+
+/*
+ * Returns a new reference to the rules database of the file at @path,
+ * reading it from @file if it is not cached or is out of date.
+ */
+static struct rules_db *
+rules_cache_get(struct rules_cache *cache, struct xkb_context *ctx,
+                FILE *file, const char *path)
+{
+    struct rules_db **entry, *db = NULL;
+
+    mutex_lock(&cache->mutex);
+    entry = rules_cache_find(cache, path);
+    if (entry)
+        db = rules_db_ref(*entry);
+    mutex_unlock(&cache->mutex);
+
+    if (db) {
+        if (rules_db_is_current(db))
+            return db;
+        rules_db_unref(db);
+    }
+
+    db = rules_db_new_from_file(ctx, file, path);
+    if (!db)
+        return NULL;
+
+    mutex_lock(&cache->mutex);
+    entry = rules_cache_find(cache, path);
+    if (entry) {
+        rules_db_unref(*entry);
+        *entry = rules_db_ref(db);
+    }
+    else {
+        darray_append(cache->dbs, rules_db_ref(db));
+    }
+    mutex_unlock(&cache->mutex);
+
+    return db;
+}
+
+/* Must be called with the cache locked. */
+static struct rules_memo_entry *
+rules_memo_find(struct rules_cache *cache, uint32_t hash,
+                const darray_char *key)
+{
+    uint32_t pos;
+
+    hash_index_foreach(pos, &cache->memo_index, hash) {
+        struct rules_memo_entry *entry =
+            &darray_item(cache->memo, cache->memo_index.entries[pos].item);
+        if (entry->hash == hash && entry->key_len == darray_size(*key) &&
+            memcmp(entry->key, key->item, entry->key_len) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+/* Must be called with the cache locked. */
+static void
+rules_memo_reindex(struct rules_cache *cache)
+{
+    struct hash_index index;
+    struct rules_memo_entry *entry;
+    unsigned i;
+
+    /* On failure, keep the old index: it's bigger, but still right. */
+    hash_index_init(&index);
+    if (!hash_index_reserve(&index, darray_size(cache->memo)))
+        return;
+    darray_enumerate(i, entry, cache->memo)
+        hash_index_add(&index, entry->hash, i);
+    hash_index_steal(&cache->memo_index, &index);
+}
+
+/*
+ * Copies the remembered KcCGST for @key to @out, if there is one and the
+ * rules it came from did not change since.
+ */
+static bool
+rules_memo_lookup(struct rules_cache *cache, uint32_t hash,
+                  const darray_char *key, struct xkb_component_names *out)
+{
+    struct rules_memo_entry *entry;
+    struct rules_db *db = NULL;
+    bool ok = false;
+
+    mutex_lock(&cache->mutex);
+    entry = rules_memo_find(cache, hash, key);
+    if (entry) {
+        entry->last_used = ++cache->clock;
+        db = rules_db_ref(entry->db);
+        ok = components_copy(out, &entry->kccgst);
+    }
+    mutex_unlock(&cache->mutex);
+
+    if (!db)
+        return false;
+
+    if (ok && !rules_db_is_current(db)) {
+        components_free(out);
+        ok = false;
+    }
+    rules_db_unref(db);
+    return ok;
+}
+
+static void
+rules_memo_insert(struct rules_cache *cache, uint32_t hash,
+                  darray_char *key, struct rules_db *db,
+                  const struct xkb_component_names *kccgst)
+{
+    struct rules_memo_entry *entry;
+    struct xkb_component_names copy;
+    unsigned i, slot;
+
+    if (!components_copy(&copy, kccgst))
+        return;
+
+    mutex_lock(&cache->mutex);
+
+    entry = rules_memo_find(cache, hash, key);
+    if (entry) {
+        rules_db_unref(entry->db);
+        components_free(&entry->kccgst);
+        goto set;
+    }
+
+    if (darray_size(cache->memo) >= RULES_MEMO_MAX_ENTRIES) {
+        slot = 0;
+        darray_enumerate(i, entry, cache->memo)
+            if (entry->last_used < darray_item(cache->memo, slot).last_used)
+                slot = i;
+    }
+    else {
+        slot = darray_size(cache->memo);
+    }
+
+    if (!hash_index_add(&cache->memo_index, hash, slot)) {
+        components_free(&copy);
+        mutex_unlock(&cache->mutex);
+        return;
+    }
+
+    if (slot < darray_size(cache->memo)) {
+        entry = &darray_item(cache->memo, slot);
+        free(entry->key);
+        rules_db_unref(entry->db);
+        components_free(&entry->kccgst);
+    }
+    else {
+        darray_resize(cache->memo, slot + 1);
+        entry = &darray_item(cache->memo, slot);
+    }
+
+    entry->hash = hash;
+    entry->key_len = darray_size(*key);
+    darray_steal(*key, &entry->key, NULL);
+
+    if (cache->memo_index.count > RULES_MEMO_MAX_INDEXED)
+        rules_memo_reindex(cache);
+
+set:
+    entry->last_used = ++cache->clock;
+    entry->db = rules_db_ref(db);
+    entry->kccgst = copy;
+    mutex_unlock(&cache->mutex);
+}
+
+/***====================================================================***/
+
+static struct matcher *
+matcher_new(struct xkb_context *ctx, const struct rules_db *db,
+            const struct xkb_rule_names *rmlvo)
+{
+    struct matcher *m = calloc(1, sizeof(*m));
+    if (!m)
+        return NULL;
+
+    m->ctx = ctx;
+    m->db = db;
+    m->rmlvo.model.sval.start = rmlvo->model;
+    m->rmlvo.model.sval.len = strlen_safe(rmlvo->model);
+    m->rmlvo.layouts = split_comma_separated_mlvo(rmlvo->layout);
+    m->rmlvo.variants = split_comma_separated_mlvo(rmlvo->variant);
+    m->rmlvo.options = split_comma_separated_mlvo(rmlvo->options);
+
+    return m;
+}
+
+static void
+matcher_free(struct matcher *m)
+{
+    if (!m)
+        return;
+    darray_free(m->rmlvo.layouts);
+    darray_free(m->rmlvo.variants);
+    darray_free(m->rmlvo.options);
+    darray_free(m->candidates);
+    for (int i = 0; i < _KCCGST_NUM_ENTRIES; i++)
+        darray_free(m->kccgst[i]);
+    free(m);
+}
+
+#define matcher_err(m, fmt, ...) do { \
+    log_err((m)->ctx, fmt, ##__VA_ARGS__); \
+    (m)->logged = true; \
+} while (0)
+
+#define rule_err(m, rule, fmt, ...) do { \
+    size_t lines_ = 0, line_start_ = 0; \
+    count_lines((rule)->file_string, 0, (rule)->pos, &lines_, &line_start_); \
+    matcher_err((m), "%s:%zu:%zu: " fmt "\n", \
+                (rule)->file_name, lines_ + 1, (rule)->pos - line_start_ + 1, \
+                ##__VA_ARGS__); \
+} while (0)
+
+/*
+ * Whether the rule set applies to the RMLVO at all.
+ *
+ * This following is very stupid, but this is how it works.
+ * See the "Notes" section in the overview above.
+ */
+static bool
+matcher_mapping_applies(struct matcher *m, const struct mapping *mapping)
+{
+    if (mapping->defined_mlvo_mask & (1u << MLVO_LAYOUT)) {
+        if (mapping->layout_idx == XKB_LAYOUT_INVALID) {
+            if (darray_size(m->rmlvo.layouts) > 1)
+                return false;
+        }
+        else {
+            if (darray_size(m->rmlvo.layouts) == 1 ||
+                mapping->layout_idx >= darray_size(m->rmlvo.layouts))
+                return false;
+        }
+    }
+
+    if (mapping->defined_mlvo_mask & (1u << MLVO_VARIANT)) {
+        if (mapping->variant_idx == XKB_LAYOUT_INVALID) {
+            if (darray_size(m->rmlvo.variants) > 1)
+                return false;
+        }
+        else {
+            if (darray_size(m->rmlvo.variants) == 1 ||
+                mapping->variant_idx >= darray_size(m->rmlvo.variants))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The values of the RMLVO which the column of @mapping at @pos is matched
+ * against; any of them may match.
+ */
+static struct matched_sval *
+matcher_values_at_pos(struct matcher *m, const struct mapping *mapping,
+                      unsigned int pos, unsigned int *num_values)
+{
+    xkb_layout_index_t idx;
+
+    switch (mapping->mlvo_at_pos[pos]) {
+    case MLVO_MODEL:
+        *num_values = 1;
+        return &m->rmlvo.model;
+    case MLVO_LAYOUT:
+        idx = mapping->layout_idx;
+        idx = (idx == XKB_LAYOUT_INVALID ? 0 : idx);
+        *num_values = 1;
+        return &darray_item(m->rmlvo.layouts, idx);
+    case MLVO_VARIANT:
+        idx = mapping->layout_idx;
+        idx = (idx == XKB_LAYOUT_INVALID ? 0 : idx);
+        *num_values = 1;
+        return &darray_item(m->rmlvo.variants, idx);
+    case MLVO_OPTION:
+        *num_values = darray_size(m->rmlvo.options);
+        return m->rmlvo.options.item;
+    }
+
+    *num_values = 0;
+    return NULL;
+}
+
+static bool
+match_group(struct matcher *m, unsigned int group_idx, struct sval to)
+{
+    const struct group *group = &darray_item(m->db->groups, group_idx);
+
+    if (darray_empty(group->elements))
+        return false;
+
+    return bsearch(&to, group->elements.item, darray_size(group->elements),
+                   sizeof(struct sval), svalcmp_qsort) != NULL;
+}
+
+static bool
+match_value(struct matcher *m, const struct rule *rule, unsigned int pos,
+            struct sval to)
+{
+    switch (rule->match_type_at_pos[pos]) {
+    case MLVO_MATCH_WILDCARD:
+        return true;
+    case MLVO_MATCH_GROUP:
+        return match_group(m, rule->group_at_pos[pos], to);
+    case MLVO_MATCH_NORMAL:
+        break;
+    }
+    return svaleq(rule->mlvo_value_at_pos[pos], to);
+}
+
+/*
+ * This function performs %-expansion on @value (see overview above),
+ * and appends the result to @to.
+ */
+static bool
+append_expanded_kccgst_value(struct matcher *m, const struct rule *rule,
+                             darray_char *to, struct sval value)
+{
+    const char *str = value.start;
+    darray_char expanded = darray_new();
+    char ch;
+    bool expanded_plus, to_plus;
+
+    /*
+     * Some ugly hand-lexing here, but going through the scanner is more
+     * trouble than it's worth, and the format is ugly on its own merit.
+     */
+    for (unsigned i = 0; i < value.len; ) {
+        enum rules_mlvo mlv;
+        xkb_layout_index_t idx;
+        char pfx, sfx;
+        struct matched_sval *expanded_value;
+
+        /* Check if that's a start of an expansion. */
+        if (str[i] != '%') {
+            /* Just a normal character. */
+            darray_appends_nullterminate(expanded, &str[i++], 1);
+            continue;
+        }
+        if (++i >= value.len) goto error;
+
+        pfx = sfx = 0;
+
+        /* Check for prefix. */
+        if (str[i] == '(' || str[i] == '+' || str[i] == '|' ||
+            str[i] == '_' || str[i] == '-') {
+            pfx = str[i];
+            if (str[i] == '(') sfx = ')';
+            if (++i >= value.len) goto error;
+        }
+
+        /* Mandatory model/layout/variant specifier. */
+        switch (str[i++]) {
+        case 'm': mlv = MLVO_MODEL; break;
+        case 'l': mlv = MLVO_LAYOUT; break;
+        case 'v': mlv = MLVO_VARIANT; break;
+        default: goto error;
+        }
+
+        /* Check for index. */
+        idx = XKB_LAYOUT_INVALID;
+        if (i < value.len && str[i] == '[') {
+            int consumed;
+
+            if (mlv != MLVO_LAYOUT && mlv != MLVO_VARIANT) {
+                rule_err(m, rule, "invalid index in %%-expansion; may only index layout or variant");
+                goto error;
             }
 
             consumed = extract_layout_index(str + i, value.len - i, &idx);
@@ -833,265 +1640,123 @@ append_expanded_kccgst_value(struct matcher *m, struct scanner *s,
 
 error:
     darray_free(expanded);
-    scanner_err(s, "invalid %%-expansion in value; not used");
+    rule_err(m, rule, "invalid %%-expansion in value; not used");
     return false;
 }
 
-static void
-matcher_rule_verify(struct matcher *m, struct scanner *s)
-{
-    if (m->rule.num_mlvo_values != m->mapping.num_mlvo ||
-        m->rule.num_kccgst_values != m->mapping.num_kccgst) {
-        scanner_err(s, "invalid rule: must have same number of values as mapping line; ignoring rule");
-        m->rule.skip = true;
-    }
-}
-
-static void
-matcher_rule_apply_if_matches(struct matcher *m, struct scanner *s)
+/*
+ * Applies @rule if it matches. The RMLVO values are only marked as
+ * matched when the whole rule matches.
+ */
+static bool
+matcher_rule_apply_if_matches(struct matcher *m, const struct mapping *mapping,
+                              const struct rule *rule)
 {
-    for (unsigned i = 0; i < m->mapping.num_mlvo; i++) {
-        enum rules_mlvo mlvo = m->mapping.mlvo_at_pos[i];
-        struct sval value = m->rule.mlvo_value_at_pos[i];
-        enum mlvo_match_type match_type = m->rule.match_type_at_pos[i];
-        struct matched_sval *to;
-        bool matched = false;
-
-        if (mlvo == MLVO_MODEL) {
-            to = &m->rmlvo.model;
-            matched = match_value_and_mark(m, value, to, match_type);
-        }
-        else if (mlvo == MLVO_LAYOUT) {
-            xkb_layout_index_t idx = m->mapping.layout_idx;
-            idx = (idx == XKB_LAYOUT_INVALID ? 0 : idx);
-            to = &darray_item(m->rmlvo.layouts, idx);
-            matched = match_value_and_mark(m, value, to, match_type);
-        }
-        else if (mlvo == MLVO_VARIANT) {
-            xkb_layout_index_t idx = m->mapping.layout_idx;
-            idx = (idx == XKB_LAYOUT_INVALID ? 0 : idx);
-            to = &darray_item(m->rmlvo.variants, idx);
-            matched = match_value_and_mark(m, value, to, match_type);
-        }
-        else if (mlvo == MLVO_OPTION) {
-            darray_foreach(to, m->rmlvo.options) {
-                matched = match_value_and_mark(m, value, to, match_type);
-                if (matched)
-                    break;
+    struct matched_sval *matched[_MLVO_NUM_ENTRIES];
+
+    for (unsigned i = 0; i < mapping->num_mlvo; i++) {
+        unsigned int num_values;
+        struct matched_sval *values =
+            matcher_values_at_pos(m, mapping, i, &num_values);
+
+        matched[i] = NULL;
+        for (unsigned j = 0; j < num_values; j++) {
+            if (match_value(m, rule, i, values[j].sval)) {
+                matched[i] = &values[j];
+                break;
             }
         }
 
-        if (!matched)
-            return;
+        if (!matched[i])
+            return false;
     }
 
-    for (unsigned i = 0; i < m->mapping.num_kccgst; i++) {
-        enum rules_kccgst kccgst = m->mapping.kccgst_at_pos[i];
-        struct sval value = m->rule.kccgst_value_at_pos[i];
-        append_expanded_kccgst_value(m, s, &m->kccgst[kccgst], value);
-    }
+    for (unsigned i = 0; i < mapping->num_mlvo; i++)
+        matched[i]->matched = true;
 
-    /*
-     * If a rule matches in a rule set, the rest of the set should be
-     * skipped. However, rule sets matching against options may contain
-     * several legitimate rules, so they are processed entirely.
-     */
-    if (!(m->mapping.defined_mlvo_mask & (1 << MLVO_OPTION)))
-        m->mapping.skip = true;
-}
+    for (unsigned i = 0; i < mapping->num_kccgst; i++) {
+        enum rules_kccgst kccgst = mapping->kccgst_at_pos[i];
+        struct sval value = rule->kccgst_value_at_pos[i];
+        append_expanded_kccgst_value(m, rule, &m->kccgst[kccgst], value);
+    }
 
-static enum rules_token
-gettok(struct matcher *m, struct scanner *s)
-{
-    return lex(s, &m->val);
+    return true;
 }
 
-static bool
-matcher_match(struct matcher *m, struct scanner *s,
-              unsigned include_depth,
-              const char *string, size_t len,
-              const char *file_name)
+/*
+ * Finds the rules of @rule_set which may match, in the order they appear
+ * in the file, using the index.
+ */
+static void
+matcher_find_candidates(struct matcher *m, const struct rule_set *rule_set)
 {
-    enum rules_token tok;
-
-    if (!m)
-        return false;
-
-initial:
-    switch (tok = gettok(m, s)) {
-    case TOK_BANG:
-        goto bang;
-    case TOK_END_OF_LINE:
-        goto initial;
-    case TOK_END_OF_FILE:
-        goto finish;
-    default:
-        goto unexpected;
-    }
-
-bang:
-    switch (tok = gettok(m, s)) {
-    case TOK_GROUP_NAME:
-        matcher_group_start_new(m, m->val.string);
-        goto group_name;
-    case TOK_INCLUDE:
-        goto include_statement;
-    case TOK_IDENTIFIER:
-        matcher_mapping_start_new(m);
-        matcher_mapping_set_mlvo(m, s, m->val.string);
-        goto mapping_mlvo;
-    default:
-        goto unexpected;
-    }
-
-group_name:
-    switch (tok = gettok(m, s)) {
-    case TOK_EQUALS:
-        goto group_element;
-    default:
-        goto unexpected;
-    }
-
-group_element:
-    switch (tok = gettok(m, s)) {
-    case TOK_IDENTIFIER:
-        matcher_group_add_element(m, s, m->val.string);
-        goto group_element;
-    case TOK_END_OF_LINE:
-        goto initial;
-    default:
-        goto unexpected;
-    }
-
-include_statement:
-    switch (tok = gettok(m, s)) {
-    case TOK_IDENTIFIER:
-        matcher_include(m, s, include_depth, m->val.string);
-        goto initial;
-    default:
-        goto unexpected;
-    }
-
-mapping_mlvo:
-    switch (tok = gettok(m, s)) {
-    case TOK_IDENTIFIER:
-        if (!m->mapping.skip)
-            matcher_mapping_set_mlvo(m, s, m->val.string);
-        goto mapping_mlvo;
-    case TOK_EQUALS:
-        goto mapping_kccgst;
-    default:
-        goto unexpected;
-    }
-
-mapping_kccgst:
-    switch (tok = gettok(m, s)) {
-    case TOK_IDENTIFIER:
-        if (!m->mapping.skip)
-            matcher_mapping_set_kccgst(m, s, m->val.string);
-        goto mapping_kccgst;
-    case TOK_END_OF_LINE:
-        if (!m->mapping.skip)
-            matcher_mapping_verify(m, s);
-        goto rule_mlvo_first;
-    default:
-        goto unexpected;
-    }
+    unsigned int num_values;
+    struct matched_sval *values =
+        matcher_values_at_pos(m, &rule_set->mapping, rule_set->index_pos,
+                              &num_values);
+    const struct index_entry *entries = rule_set->index.item;
+    unsigned int num_entries = darray_size(rule_set->index);
+
+    darray_resize(m->candidates, 0);
+
+    for (unsigned i = 0; i < num_values; i++) {
+        unsigned int lo = 0, hi = num_entries;
+
+        /* Find the first entry for the value. */
+        while (lo < hi) {
+            unsigned int mid = lo + (hi - lo) / 2;
+            if (svalcmp(&entries[mid].value, &values[i].sval) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
 
-rule_mlvo_first:
-    switch (tok = gettok(m, s)) {
-    case TOK_BANG:
-        goto bang;
-    case TOK_END_OF_LINE:
-        goto rule_mlvo_first;
-    case TOK_END_OF_FILE:
-        goto finish;
-    default:
-        matcher_rule_start_new(m);
-        goto rule_mlvo_no_tok;
+        for (; lo < num_entries && svaleq(entries[lo].value, values[i].sval);
+             lo++)
+            darray_append(m->candidates, entries[lo].rule);
     }
 
-rule_mlvo:
-    tok = gettok(m, s);
-rule_mlvo_no_tok:
-    switch (tok) {
-    case TOK_IDENTIFIER:
-        if (!m->rule.skip)
-            matcher_rule_set_mlvo(m, s, m->val.string);
-        goto rule_mlvo;
-    case TOK_STAR:
-        if (!m->rule.skip)
-            matcher_rule_set_mlvo_wildcard(m, s);
-        goto rule_mlvo;
-    case TOK_GROUP_NAME:
-        if (!m->rule.skip)
-            matcher_rule_set_mlvo_group(m, s, m->val.string);
-        goto rule_mlvo;
-    case TOK_EQUALS:
-        goto rule_kccgst;
-    default:
-        goto unexpected;
-    }
+    if (!darray_empty(rule_set->wildcard_rules))
+        darray_concat(m->candidates, rule_set->wildcard_rules);
 
-rule_kccgst:
-    switch (tok = gettok(m, s)) {
-    case TOK_IDENTIFIER:
-        if (!m->rule.skip)
-            matcher_rule_set_kccgst(m, s, m->val.string);
-        goto rule_kccgst;
-    case TOK_END_OF_LINE:
-        if (!m->rule.skip)
-            matcher_rule_verify(m, s);
-        if (!m->rule.skip)
-            matcher_rule_apply_if_matches(m, s);
-        goto rule_mlvo_first;
-    default:
-        goto unexpected;
-    }
+    if (darray_size(m->candidates) > 1) {
+        unsigned int *rules = m->candidates.item;
+        unsigned int num_rules = 1;
 
-unexpected:
-    switch (tok) {
-    case TOK_ERROR:
-        goto error;
-    default:
-        goto state_error;
+        qsort(rules, darray_size(m->candidates), sizeof(*rules), uint_cmp);
+        for (unsigned i = 1; i < darray_size(m->candidates); i++)
+            if (rules[i] != rules[num_rules - 1])
+                rules[num_rules++] = rules[i];
+        darray_resize(m->candidates, num_rules);
     }
-
-finish:
-    return true;
-
-state_error:
-    scanner_err(s, "unexpected token");
-error:
-    return false;
 }
 
-static bool
-read_rules_file(struct xkb_context *ctx,
-                struct matcher *matcher,
-                unsigned include_depth,
-                FILE *file,
-                const char *path)
+static void
+matcher_match(struct matcher *m)
 {
-    bool ret = false;
-    char *string;
-    size_t size;
-    struct scanner scanner;
+    const struct rule_set *rule_set;
+    const unsigned int *idx;
 
-    ret = map_file(file, &string, &size);
-    if (!ret) {
-        log_err(ctx, "Couldn't read rules file \"%s\": %s\n",
-                path, strerror(errno));
-        goto out;
-    }
+    darray_foreach(rule_set, m->db->rule_sets) {
+        if (!matcher_mapping_applies(m, &rule_set->mapping))
+            continue;
 
-    scanner_init(&scanner, matcher->ctx, string, size, path, NULL);
+        matcher_find_candidates(m, rule_set);
 
-    ret = matcher_match(matcher, &scanner, include_depth, string, size, path);
+        darray_foreach(idx, m->candidates) {
+            const struct rule *rule = &darray_item(rule_set->rules, *idx);
 
-    unmap_file(string, size);
-out:
-    return ret;
+            /*
+             * If a rule matches in a rule set, the rest of the set should
+             * be skipped. However, rule sets matching against options may
+             * contain several legitimate rules, so they are processed
+             * entirely.
+             */
+            if (matcher_rule_apply_if_matches(m, &rule_set->mapping, rule) &&
+                !(rule_set->mapping.defined_mlvo_mask & (1 << MLVO_OPTION)))
+                break;
+        }
+    }
 }
 
 bool
@@ -1102,24 +1767,42 @@ xkb_components_from_rules(struct xkb_context *ctx,
     bool ret = false;
     FILE *file;
     char *path = NULL;
+    struct rules_db *db = NULL;
     struct matcher *matcher = NULL;
     struct matched_sval *mval;
+    darray_char key = darray_new();
+    uint32_t hash = 0;
+
+    if (ctx->rules_cache) {
+        xkb_context_rule_names_key(ctx, rmlvo, &key);
+        hash = hash_fnv1a(FNV1A_INIT, key.item, darray_size(key));
+        if (rules_memo_lookup(ctx->rules_cache, hash, &key, out)) {
+            darray_free(key);
+            return true;
+        }
+    }
 
     file = FindFileInXkbPath(ctx, rmlvo->rules, FILE_TYPE_RULES, &path);
     if (!file)
         goto err_out;
 
-    matcher = matcher_new(ctx, rmlvo);
+    if (ctx->rules_cache)
+        db = rules_cache_get(ctx->rules_cache, ctx, file, path);
+    else
+        db = rules_db_new_from_file(ctx, file, path);
+    if (db) {
+        matcher = matcher_new(ctx, db, rmlvo);
+        if (matcher)
+            matcher_match(matcher);
+    }
 
-    ret = read_rules_file(ctx, matcher, 0, file, path);
-    if (!ret ||
+    if (!matcher ||
         darray_empty(matcher->kccgst[KCCGST_KEYCODES]) ||
         darray_empty(matcher->kccgst[KCCGST_TYPES]) ||
         darray_empty(matcher->kccgst[KCCGST_COMPAT]) ||
         /* darray_empty(matcher->kccgst[KCCGST_GEOMETRY]) || */
         darray_empty(matcher->kccgst[KCCGST_SYMBOLS])) {
         log_err(ctx, "No components returned from XKB rules \"%s\"\n", path);
-        ret = false;
         goto err_out;
     }
 
@@ -1128,28 +1811,35 @@ xkb_components_from_rules(struct xkb_context *ctx,
     darray_steal(matcher->kccgst[KCCGST_COMPAT], &out->compat, NULL);
     darray_steal(matcher->kccgst[KCCGST_SYMBOLS], &out->symbols, NULL);
     darray_free(matcher->kccgst[KCCGST_GEOMETRY]);
+    ret = true;
 
     mval = &matcher->rmlvo.model;
     if (!mval->matched && mval->sval.len > 0)
-        log_err(matcher->ctx, "Unrecognized RMLVO model \"%.*s\" was ignored\n",
-                mval->sval.len, mval->sval.start);
+        matcher_err(matcher, "Unrecognized RMLVO model \"%.*s\" was ignored\n",
+                    mval->sval.len, mval->sval.start);
     darray_foreach(mval, matcher->rmlvo.layouts)
         if (!mval->matched && mval->sval.len > 0)
-            log_err(matcher->ctx, "Unrecognized RMLVO layout \"%.*s\" was ignored\n",
-                    mval->sval.len, mval->sval.start);
+            matcher_err(matcher, "Unrecognized RMLVO layout \"%.*s\" was ignored\n",
+                        mval->sval.len, mval->sval.start);
     darray_foreach(mval, matcher->rmlvo.variants)
         if (!mval->matched && mval->sval.len > 0)
-            log_err(matcher->ctx, "Unrecognized RMLVO variant \"%.*s\" was ignored\n",
-                    mval->sval.len, mval->sval.start);
+            matcher_err(matcher, "Unrecognized RMLVO variant \"%.*s\" was ignored\n",
+                        mval->sval.len, mval->sval.start);
     darray_foreach(mval, matcher->rmlvo.options)
         if (!mval->matched && mval->sval.len > 0)
-            log_err(matcher->ctx, "Unrecognized RMLVO option \"%.*s\" was ignored\n",
-                    mval->sval.len, mval->sval.start);
+            matcher_err(matcher, "Unrecognized RMLVO option \"%.*s\" was ignored\n",
+                        mval->sval.len, mval->sval.start);
+
+    /* Remember only clean resolutions, so the messages are never lost. */
+    if (ctx->rules_cache && !matcher->logged)
+        rules_memo_insert(ctx->rules_cache, hash, &key, db, out);
 
 err_out:
     if (file)
         fclose(file);
     matcher_free(matcher);
+    rules_db_unref(db);
+    darray_free(key);
     free(path);
     return ret;
 }
@@ -26,6 +26,7 @@
 #include "xkbcomp-priv.h"
 #include "parser-priv.h"
 #include "scanner-utils.h"
+#include "thread.h"
 
 static bool
 number(struct scanner *s, int64_t *out, int *out_tok)
@@ -69,7 +70,7 @@ _xkbcommon_lex(YYSTYPE *yylval, struct scanner *s)
 
 skip_more_whitespace_and_comments:
     /* Skip spaces. */
-    while (is_space(peek(s))) next(s);
+    s->pos += span_space(s, true);
 
     /* Skip comments. */
     if (lit(s, "//") || chr(s, '#')) {
@@ -81,30 +82,27 @@ skip_more_whitespace_and_comments:
     if (eof(s)) return END_OF_FILE;
 
     /* New token. */
-    s->token_line = s->line;
-    s->token_column = s->column;
+    scanner_token_start(s);
     s->buf_pos = 0;
 
     /* String literal. */
     if (chr(s, '\"')) {
-        while (!eof(s) && !eol(s) && peek(s) != '\"') {
-            if (chr(s, '\\')) {
-                uint8_t o;
-                if      (chr(s, '\\')) buf_append(s, '\\');
-                else if (chr(s, 'n'))  buf_append(s, '\n');
-                else if (chr(s, 't'))  buf_append(s, '\t');
-                else if (chr(s, 'r'))  buf_append(s, '\r');
-                else if (chr(s, 'b'))  buf_append(s, '\b');
-                else if (chr(s, 'f'))  buf_append(s, '\f');
-                else if (chr(s, 'v'))  buf_append(s, '\v');
-                else if (chr(s, 'e'))  buf_append(s, '\033');
-                else if (oct(s, &o))   buf_append(s, (char) o);
-                else {
-                    scanner_warn(s, "unknown escape sequence in string literal");
-                    /* Ignore. */
-                }
-            } else {
-                buf_append(s, next(s));
+        uint8_t o;
+
+        /* Copy up to the end of the string or the next escape. */
+        while (buf_append_span(s, span_string(s)), chr(s, '\\')) {
+            if      (chr(s, '\\')) buf_append(s, '\\');
+            else if (chr(s, 'n'))  buf_append(s, '\n');
+            else if (chr(s, 't'))  buf_append(s, '\t');
+            else if (chr(s, 'r'))  buf_append(s, '\r');
+            else if (chr(s, 'b'))  buf_append(s, '\b');
+            else if (chr(s, 'f'))  buf_append(s, '\f');
+            else if (chr(s, 'v'))  buf_append(s, '\v');
+            else if (chr(s, 'e'))  buf_append(s, '\033');
+            else if (oct(s, &o))   buf_append(s, (char) o);
+            else {
+                scanner_warn(s, "unknown escape sequence in string literal");
+                /* Ignore. */
             }
         }
         if (!buf_append(s, '\0') || !chr(s, '\"')) {
@@ -119,8 +117,7 @@ skip_more_whitespace_and_comments:
 
     /* Key name literal. */
     if (chr(s, '<')) {
-        while (is_graph(peek(s)) && peek(s) != '>')
-            buf_append(s, next(s));
+        buf_append_span(s, span_graph(s, '>'));
         if (!buf_append(s, '\0') || !chr(s, '>')) {
             scanner_err(s, "unterminated key name literal");
             return ERROR_TOK;
@@ -151,9 +148,7 @@ skip_more_whitespace_and_comments:
     /* Identifier. */
     if (is_alpha(peek(s)) || peek(s) == '_') {
         s->buf_pos = 0;
-        while (is_alnum(peek(s)) || peek(s) == '_')
-            buf_append(s, next(s));
-        if (!buf_append(s, '\0')) {
+        if (!buf_append_span(s, span_ident(s)) || !buf_append(s, '\0')) {
             scanner_err(s, "identifier too long");
             return ERROR_TOK;
         }
@@ -181,13 +176,53 @@ skip_more_whitespace_and_comments:
     return ERROR_TOK;
 }
 
+/* Without a map to look for, the first one is used if none is default. */
+static void
+log_first_map(struct xkb_context *ctx, const char *file_name,
+              const XkbFile *file)
+{
+    if (file && !(file->flags & MAP_IS_DEFAULT))
+        log_vrb(ctx, 5,
+                "No map in include statement, but \"%s\" contains several; "
+                "Using first defined map, \"%s\"\n",
+                file_name, file->name);
+}
+
 XkbFile *
 XkbParseString(struct xkb_context *ctx, const char *string, size_t len,
                const char *file_name, const char *map)
 {
     struct scanner scanner;
+    XkbFile *file;
+
+    scanner_init(&scanner, ctx, string, len, file_name, NULL);
+    file = parse(ctx, &scanner, map);
+    if (!map)
+        log_first_map(ctx, file_name, file);
+    return file;
+}
+
+/*
+ * Lex all of @string, without parsing it. This is only for measuring the
+ * lexer on its own; returns the number of tokens, or -1 on a lexing error.
+ */
+int
+XkbLexString(struct xkb_context *ctx, const char *string, size_t len,
+             const char *file_name)
+{
+    struct scanner scanner;
+    YYSTYPE val;
+    int tok, num_tokens = 0;
+
     scanner_init(&scanner, ctx, string, len, file_name, NULL);
-    return parse(ctx, &scanner, map);
+    while ((tok = _xkbcommon_lex(&val, &scanner)) != END_OF_FILE) {
+        if (tok == ERROR_TOK)
+            return -1;
+        if (tok == STRING || tok == IDENT)
+            free(val.str);
+        num_tokens++;
+    }
+    return num_tokens;
 }
 
 XkbFile *
@@ -210,3 +245,351 @@ XkbParseFile(struct xkb_context *ctx, FILE *file,
     unmap_file(string, size);
     return xkb_file;
 }
+
+/*
+ * An index of the sections of a file, e.g. the
+ *     partial alphanumeric_keys xkb_symbols "intl" { ... };
+ * blocks of symbols/us, found without lexing and parsing it, so that only
+ * the section an include statement asks for is handed to the parser.
+ *
+ * Strings, key names and comments are skipped like the lexer does, so
+ * that braces in them are not counted. If the file doesn't look like a
+ * sequence of sections, it's not indexed, and all of it is parsed.
+ */
+struct section {
+    /* As escaped by XkbFileCreate(). */
+    char *name;
+    bool is_default;
+    size_t start, end;
+    size_t line, column;
+};
+
+struct section_index {
+    int refcnt;
+    darray(struct section) sections;
+};
+
+/*
+ * This goes over every byte of the file, so it doesn't use the scanner,
+ * which does more work per byte than needed here.
+ */
+struct section_scanner {
+    const char *s;
+    size_t pos, len;
+    size_t line, line_start;
+    bool escaped;
+};
+
+static void
+section_skip_to_eol(struct section_scanner *s)
+{
+    const char *nl = memchr(s->s + s->pos, '\n', s->len - s->pos);
+    s->pos = (nl ? (size_t) (nl - s->s) : s->len);
+}
+
+static void
+section_skip_space_and_comments(struct section_scanner *s)
+{
+    while (s->pos < s->len) {
+        const char c = s->s[s->pos];
+
+        if (c == '\n') {
+            s->pos++;
+            s->line++;
+            s->line_start = s->pos;
+        }
+        else if (is_space(c)) {
+            s->pos++;
+        }
+        else if (c == '#' ||
+                 (c == '/' && s->pos + 1 < s->len && s->s[s->pos + 1] == '/')) {
+            section_skip_to_eol(s);
+        }
+        else {
+            break;
+        }
+    }
+}
+
+/* Skip a string literal, after its opening quote, like the lexer does. */
+static bool
+section_skip_string(struct section_scanner *s)
+{
+    while (s->pos < s->len) {
+        const char c = s->s[s->pos++];
+
+        if (c == '\"')
+            return true;
+        if (c == '\n')
+            return false;
+        if (c == '\\') {
+            s->escaped = true;
+            if (s->pos < s->len && s->s[s->pos] == '\\')
+                s->pos++;
+        }
+    }
+
+    return false;
+}
+
+/* Skip a key name literal, after its opening angle bracket. */
+static bool
+section_skip_key_name(struct section_scanner *s)
+{
+    while (s->pos < s->len && is_graph(s->s[s->pos]) && s->s[s->pos] != '>')
+        s->pos++;
+
+    if (s->pos >= s->len || s->s[s->pos] != '>')
+        return false;
+
+    s->pos++;
+    return true;
+}
+
+/* The bytes section_skip_body() needs to look at. */
+static const bool section_special[256] = {
+    ['\n'] = true, ['{'] = true, ['}'] = true, ['\"'] = true,
+    ['<'] = true, ['#'] = true, ['/'] = true,
+};
+
+/* Skip the body of a section, after its opening brace. */
+static bool
+section_skip_body(struct section_scanner *s)
+{
+    unsigned int depth = 1;
+
+    while (s->pos < s->len) {
+        if (!section_special[(unsigned char) s->s[s->pos]]) {
+            s->pos++;
+            continue;
+        }
+
+        switch (s->s[s->pos++]) {
+        case '\n':
+            s->line++;
+            s->line_start = s->pos;
+            break;
+        case '{':
+            depth++;
+            break;
+        case '}':
+            if (--depth == 0)
+                return true;
+            break;
+        case '\"':
+            if (!section_skip_string(s))
+                return false;
+            break;
+        case '<':
+            if (!section_skip_key_name(s))
+                return false;
+            break;
+        case '#':
+            section_skip_to_eol(s);
+            break;
+        case '/':
+            if (s->pos < s->len && s->s[s->pos] == '/')
+                section_skip_to_eol(s);
+            break;
+        }
+    }
+
+    return false;
+}
+
+static bool
+index_section(struct section_scanner *s, struct section *section)
+{
+    const char *ident;
+    size_t ident_len;
+
+    section->start = s->pos;
+    section->line = s->line;
+    section->column = s->pos - s->line_start + 1;
+
+    /* The flags, then the type. */
+    while (true) {
+        if (s->pos >= s->len ||
+            !(is_alpha(s->s[s->pos]) || s->s[s->pos] == '_'))
+            return false;
+        ident = s->s + s->pos;
+        while (s->pos < s->len &&
+               (is_alnum(s->s[s->pos]) || s->s[s->pos] == '_'))
+            s->pos++;
+        ident_len = s->s + s->pos - ident;
+        section_skip_space_and_comments(s);
+
+        if (ident_len > 4 && istrncmp(ident, "xkb_", 4) == 0)
+            break;
+        if (ident_len == 7 && istrncmp(ident, "default", 7) == 0)
+            section->is_default = true;
+    }
+
+    /* The name, if any. */
+    if (s->pos < s->len && s->s[s->pos] == '\"') {
+        const char *name = s->s + ++s->pos;
+        s->escaped = false;
+        if (!section_skip_string(s) || s->escaped)
+            return false;
+        section->name = strndup(name, s->s + s->pos - 1 - name);
+        if (!section->name)
+            return false;
+        XkbEscapeMapName(section->name);
+        section_skip_space_and_comments(s);
+    }
+
+    if (s->pos >= s->len || s->s[s->pos] != '{')
+        return false;
+    s->pos++;
+    if (!section_skip_body(s))
+        return false;
+
+    section_skip_space_and_comments(s);
+    if (s->pos >= s->len || s->s[s->pos] != ';')
+        return false;
+    s->pos++;
+
+    section->end = s->pos;
+    return true;
+}
+
+struct section_index *
+XkbSectionIndexNew(const char *string, size_t len)
+{
+    struct section_index *index;
+    struct section *section;
+    struct section_scanner s = {
+        .s = string, .len = len, .line = 1,
+    };
+
+    index = calloc(1, sizeof(*index));
+    if (!index)
+        return NULL;
+
+    index->refcnt = 1;
+    darray_init(index->sections);
+
+    section_skip_space_and_comments(&s);
+    while (s.pos < s.len) {
+        darray_resize0(index->sections, darray_size(index->sections) + 1);
+        section = &darray_item(index->sections,
+                               darray_size(index->sections) - 1);
+        if (!index_section(&s, section)) {
+            XkbSectionIndexUnref(index);
+            return NULL;
+        }
+        section_skip_space_and_comments(&s);
+    }
+
+    return index;
+}
+
+struct section_index *
+XkbSectionIndexRef(struct section_index *index)
+{
+    refcnt_inc(&index->refcnt);
+    return index;
+}
+
+void
+XkbSectionIndexUnref(struct section_index *index)
+{
+    struct section *section;
+
+    if (!index || refcnt_dec(&index->refcnt) > 0)
+        return;
+
+    darray_foreach(section, index->sections)
+        free(section->name);
+    darray_free(index->sections);
+    free(index);
+}
+
+/* Pick the section the parser would: see parse(). */
+static const struct section *
+section_index_find(const struct section_index *index, const char *map)
+{
+    const struct section *section;
+
+    darray_foreach(section, index->sections)
+        if (map ? streq_not_null(map, section->name) : section->is_default)
+            return section;
+
+    if (!map && !darray_empty(index->sections))
+        return &darray_item(index->sections, 0);
+
+    return NULL;
+}
+
+/*
+ * Without an index, look for the section of @map, stopping as soon as it
+ * is found.
+ */
+static bool
+section_scan_for_map(const char *string, size_t len, const char *map,
+                     struct section *found)
+{
+    struct section_scanner s = {
+        .s = string, .len = len, .line = 1,
+    };
+    struct section section;
+    bool ok = false;
+
+    section_skip_space_and_comments(&s);
+    while (s.pos < s.len) {
+        section = (struct section) { .name = NULL };
+        if (!index_section(&s, &section)) {
+            free(section.name);
+            break;
+        }
+
+        if (streq_not_null(map, section.name)) {
+            *found = section;
+            found->name = NULL;
+            ok = true;
+        }
+
+        free(section.name);
+        if (ok)
+            break;
+
+        section_skip_space_and_comments(&s);
+    }
+
+    return ok;
+}
+
+XkbFile *
+XkbParseStringIndexed(struct xkb_context *ctx, const char *string,
+                      size_t len, const char *file_name, const char *map,
+                      const struct section_index *index)
+{
+    const struct section *section = NULL;
+    struct section scanned;
+    struct scanner scanner;
+    XkbFile *file;
+
+    if (index)
+        section = section_index_find(index, map);
+    else if (map && section_scan_for_map(string, len, map, &scanned))
+        section = &scanned;
+
+    /*
+     * If the section is not found, parse all of the file anyway, to get
+     * the same errors.
+     */
+    if (!section)
+        return XkbParseString(ctx, string, len, file_name, map);
+
+    scanner_init(&scanner, ctx, string + section->start,
+                 section->end - section->start, file_name, NULL);
+    scanner.line = section->line;
+    scanner.column = section->column;
+    file = parse(ctx, &scanner, map);
+
+    /* Only the index knows if the file has other maps. */
+    if (!map && darray_size(index->sections) > 1)
+        log_first_map(ctx, file_name, file);
+
+    return file;
+}
@@ -59,14 +59,9 @@
 #include "action.h"
 #include "vmod.h"
 #include "include.h"
+#include "hash-index.h"
 #include "keysym.h"
 
-enum key_repeat {
-    KEY_REPEAT_UNDEFINED = 0,
-    KEY_REPEAT_YES = 1,
-    KEY_REPEAT_NO = 2,
-};
-
 enum group_field {
     GROUP_FIELD_SYMS = (1 << 0),
     GROUP_FIELD_ACTS = (1 << 1),
@@ -175,6 +170,8 @@ typedef struct {
     enum merge_mode merge;
     xkb_layout_index_t explicit_group;
     darray(KeyInfo) keys;
+    /* The keys by name, for AddKeySymbols(). */
+    struct hash_index keys_index;
     KeyInfo default_key;
     ActionsInfo *actions;
     darray(xkb_atom_t) group_names;
@@ -198,6 +195,7 @@ InitSymbolsInfo(SymbolsInfo *info, const struct xkb_keymap *keymap,
     info->actions = actions;
     info->mods = *mods;
     info->explicit_group = XKB_LAYOUT_INVALID;
+    hash_index_init(&info->keys_index);
 }
 
 static void
@@ -208,6 +206,7 @@ ClearSymbolsInfo(SymbolsInfo *info)
     darray_foreach(keyi, info->keys)
         ClearKeyInfo(keyi);
     darray_free(info->keys);
+    hash_index_free(&info->keys_index);
     darray_free(info->group_names);
     darray_free(info->modmaps);
     ClearKeyInfo(&info->default_key);
@@ -421,21 +420,30 @@ static bool
 AddKeySymbols(SymbolsInfo *info, KeyInfo *keyi, bool same_file)
 {
     xkb_atom_t real_name;
-    KeyInfo *iter;
+    uint32_t pos;
 
     /*
      * Don't keep aliases in the keys array; this guarantees that
-     * searching for keys to merge with by straight comparison (see the
-     * following loop) is enough, and we won't get multiple KeyInfo's
-     * for the same key because of aliases.
+     * searching for keys to merge with by name (see the following
+     * lookup) is enough, and we won't get multiple KeyInfo's for the
+     * same key because of aliases.
      */
     real_name = XkbResolveKeyAlias(info->keymap, keyi->name);
     if (real_name != XKB_ATOM_NONE)
         keyi->name = real_name;
 
-    darray_foreach(iter, info->keys)
-        if (iter->name == keyi->name)
-            return MergeKeys(info, iter, keyi, same_file);
+    pos = hash_index_first(&info->keys_index, keyi->name);
+    if (pos != HASH_INDEX_END)
+        return MergeKeys(info,
+                         &darray_item(info->keys,
+                                      info->keys_index.entries[pos].item),
+                         keyi, same_file);
+
+    if (!hash_index_add(&info->keys_index, keyi->name,
+                        darray_size(info->keys))) {
+        ClearKeyInfo(keyi);
+        return false;
+    }
 
     darray_append(info->keys, *keyi);
     InitKeyInfo(info->ctx, keyi);
@@ -524,6 +532,7 @@ MergeIncludedSymbols(SymbolsInfo *into, SymbolsInfo *from,
     if (darray_empty(into->keys)) {
         into->keys = from->keys;
         darray_init(from->keys);
+        hash_index_steal(&into->keys_index, &from->keys_index);
     }
     else {
         KeyInfo *keyi;
@@ -557,8 +566,7 @@ HandleIncludeSymbols(SymbolsInfo *info, IncludeStmt *include)
     SymbolsInfo included;
 
     InitSymbolsInfo(&included, info->keymap, info->actions, &info->mods);
-    included.name = include->stmt;
-    include->stmt = NULL;
+    included.name = strdup_safe(include->stmt);
 
     for (IncludeStmt *stmt = include; stmt; stmt = stmt->next_incl) {
         SymbolsInfo next_incl;
@@ -592,7 +600,7 @@ HandleIncludeSymbols(SymbolsInfo *info, IncludeStmt *include)
         MergeIncludedSymbols(&included, &next_incl, stmt->merge);
 
         ClearSymbolsInfo(&next_incl);
-        FreeXkbFile(file);
+        XkbFileUnref(file);
     }
 
     MergeIncludedSymbols(info, &included, include->merge);
@@ -779,7 +787,7 @@ AddActionsToKey(SymbolsInfo *info, KeyInfo *keyi, ExprDef *arrayNdx,
     return true;
 }
 
-static const LookupEntry repeatEntries[] = {
+const LookupEntry repeatEntries[] = {
     { "true", KEY_REPEAT_YES },
     { "yes", KEY_REPEAT_YES },
     { "on", KEY_REPEAT_YES },
@@ -1286,26 +1294,22 @@ FindKeyForSymbol(struct xkb_keymap *keymap, xkb_keysym_t sym)
  * and the same for four level keys.
  *
  * FIXME: Decide how to handle multiple-syms-per-level, and do it.
+ *
+ * @syms holds the first keysym of each of the first MIN(width, 4) levels.
+ * The keymap dumper uses this too, to leave out the types the compiler
+ * would pick anyway.
  */
-static xkb_atom_t
-FindAutomaticType(struct xkb_context *ctx, GroupInfo *groupi)
+xkb_atom_t
+FindAutomaticType(struct xkb_context *ctx, xkb_level_index_t width,
+                  const xkb_keysym_t *syms)
 {
     xkb_keysym_t sym0, sym1;
-    const xkb_level_index_t width = darray_size(groupi->levels);
-
-#define GET_SYM(level) \
-    (darray_item(groupi->levels, level).num_syms == 0 ? \
-        XKB_KEY_NoSymbol : \
-     darray_item(groupi->levels, level).num_syms == 1 ? \
-        darray_item(groupi->levels, level).u.sym : \
-     /* num_syms > 1 */ \
-        darray_item(groupi->levels, level).u.syms[0])
 
-    if (width == 1 || width <= 0)
+    if (width <= 1)
         return xkb_atom_intern_literal(ctx, "ONE_LEVEL");
 
-    sym0 = GET_SYM(0);
-    sym1 = GET_SYM(1);
+    sym0 = syms[0];
+    sym1 = syms[1];
 
     if (width == 2) {
         if (xkb_keysym_is_lower(sym0) && xkb_keysym_is_upper(sym1))
@@ -1320,8 +1324,8 @@ FindAutomaticType(struct xkb_context *ctx, GroupInfo *groupi)
     if (width <= 4) {
         if (xkb_keysym_is_lower(sym0) && xkb_keysym_is_upper(sym1)) {
             xkb_keysym_t sym2, sym3;
-            sym2 = GET_SYM(2);
-            sym3 = (width == 4 ? GET_SYM(3) : XKB_KEY_NoSymbol);
+            sym2 = syms[2];
+            sym3 = (width == 4 ? syms[3] : XKB_KEY_NoSymbol);
 
             if (xkb_keysym_is_lower(sym2) && xkb_keysym_is_upper(sym3))
                 return xkb_atom_intern_literal(ctx, "FOUR_LEVEL_ALPHABETIC");
@@ -1336,8 +1340,20 @@ FindAutomaticType(struct xkb_context *ctx, GroupInfo *groupi)
     }
 
     return XKB_ATOM_NONE;
+}
+
+static xkb_atom_t
+FindAutomaticTypeForGroup(struct xkb_context *ctx, const GroupInfo *groupi)
+{
+    const xkb_level_index_t width = darray_size(groupi->levels);
+    xkb_keysym_t syms[4];
+
+    for (xkb_level_index_t i = 0; i < 4; i++)
+        syms[i] = (i < width ?
+                   XkbLevelFirstSym(&darray_item(groupi->levels, i)) :
+                   XKB_KEY_NoSymbol);
 
-#undef GET_SYM
+    return FindAutomaticType(ctx, width, syms);
 }
 
 static const struct xkb_key_type *
@@ -1355,7 +1371,7 @@ FindTypeForGroup(struct xkb_keymap *keymap, KeyInfo *keyi,
             type_name  = keyi->default_type;
         }
         else {
-            type_name = FindAutomaticType(keymap->ctx, groupi);
+            type_name = FindAutomaticTypeForGroup(keymap->ctx, groupi);
             if (type_name != XKB_ATOM_NONE)
                 *explicit_type = false;
         }
@@ -31,6 +31,7 @@
 #include "vmod.h"
 #include "expr.h"
 #include "include.h"
+#include "hash-index.h"
 
 enum type_field {
     TYPE_FIELD_MASK = (1 << 0),
@@ -55,6 +56,8 @@ typedef struct {
     int errorCount;
 
     darray(KeyTypeInfo) types;
+    /* The types by name, for FindMatchingKeyType(). */
+    struct hash_index types_index;
     struct xkb_mod_set mods;
 
     struct xkb_context *ctx;
@@ -105,6 +108,7 @@ InitKeyTypesInfo(KeyTypesInfo *info, struct xkb_context *ctx,
     memset(info, 0, sizeof(*info));
     info->ctx = ctx;
     info->mods = *mods;
+    hash_index_init(&info->types_index);
 }
 
 static void
@@ -119,18 +123,18 @@ ClearKeyTypesInfo(KeyTypesInfo *info)
 {
     free(info->name);
     darray_free(info->types);
+    hash_index_free(&info->types_index);
 }
 
 static KeyTypeInfo *
 FindMatchingKeyType(KeyTypesInfo *info, xkb_atom_t name)
 {
-    KeyTypeInfo *old;
+    uint32_t pos = hash_index_first(&info->types_index, name);
 
-    darray_foreach(old, info->types)
-        if (old->name == name)
-            return old;
+    if (pos == HASH_INDEX_END)
+        return NULL;
 
-    return NULL;
+    return &darray_item(info->types, info->types_index.entries[pos].item);
 }
 
 static bool
@@ -166,6 +170,12 @@ AddKeyType(KeyTypesInfo *info, KeyTypeInfo *new, bool same_file)
         return true;
     }
 
+    if (!hash_index_add(&info->types_index, new->name,
+                        darray_size(info->types))) {
+        ClearKeyTypeInfo(new);
+        return false;
+    }
+
     darray_append(info->types, *new);
     return true;
 }
@@ -191,6 +201,7 @@ MergeIncludedKeyTypes(KeyTypesInfo *into, KeyTypesInfo *from,
     if (darray_empty(into->types)) {
         into->types = from->types;
         darray_init(from->types);
+        hash_index_steal(&into->types_index, &from->types_index);
     }
     else {
         KeyTypeInfo *type;
@@ -211,8 +222,7 @@ HandleIncludeKeyTypes(KeyTypesInfo *info, IncludeStmt *include)
     KeyTypesInfo included;
 
     InitKeyTypesInfo(&included, info->ctx, &info->mods);
-    included.name = include->stmt;
-    include->stmt = NULL;
+    included.name = strdup_safe(include->stmt);
 
     for (IncludeStmt *stmt = include; stmt; stmt = stmt->next_incl) {
         KeyTypesInfo next_incl;
@@ -232,7 +242,7 @@ HandleIncludeKeyTypes(KeyTypesInfo *info, IncludeStmt *include)
         MergeIncludedKeyTypes(&included, &next_incl, stmt->merge);
 
         ClearKeyTypesInfo(&next_incl);
-        FreeXkbFile(file);
+        XkbFileUnref(file);
     }
 
     MergeIncludedKeyTypes(info, &included, include->merge);
@@ -29,16 +29,11 @@
 
 #include "keymap.h"
 #include "ast.h"
-
-struct xkb_component_names {
-    char *keycodes;
-    char *types;
-    char *compat;
-    char *symbols;
-};
+#include "text.h"
 
 char *
-text_v1_keymap_get_as_string(struct xkb_keymap *keymap);
+text_v1_keymap_get_as_string(struct xkb_keymap *keymap,
+                             enum xkb_keymap_serialize_flags flags);
 
 XkbFile *
 XkbParseFile(struct xkb_context *ctx, FILE *file,
@@ -49,9 +44,35 @@ XkbParseString(struct xkb_context *ctx,
                const char *string, size_t len,
                const char *file_name, const char *map);
 
+int
+XkbLexString(struct xkb_context *ctx, const char *string, size_t len,
+             const char *file_name);
+
+struct section_index;
+
+struct section_index *
+XkbSectionIndexNew(const char *string, size_t len);
+
+struct section_index *
+XkbSectionIndexRef(struct section_index *index);
+
+void
+XkbSectionIndexUnref(struct section_index *index);
+
+XkbFile *
+XkbParseStringIndexed(struct xkb_context *ctx, const char *string,
+                      size_t len, const char *file_name, const char *map,
+                      const struct section_index *index);
+
 void
 FreeXkbFile(XkbFile *file);
 
+XkbFile *
+XkbFileRef(XkbFile *file);
+
+void
+XkbFileUnref(XkbFile *file);
+
 XkbFile *
 XkbFileFromComponents(struct xkb_context *ctx,
                       const struct xkb_component_names *kkctgs);
@@ -76,6 +97,29 @@ bool
 CompileKeymap(XkbFile *file, struct xkb_keymap *keymap,
               enum merge_mode merge);
 
+xkb_atom_t
+FindAutomaticType(struct xkb_context *ctx, xkb_level_index_t width,
+                  const xkb_keysym_t *syms);
+
+bool
+UpdateDerivedKeymapFields(struct xkb_keymap *keymap);
+
+/* The repeat field of keys; shared with the keymap loader. */
+enum key_repeat {
+    KEY_REPEAT_UNDEFINED = 0,
+    KEY_REPEAT_YES = 1,
+    KEY_REPEAT_NO = 2,
+};
+
+extern const LookupEntry repeatEntries[];
+
+/*
+ * Load a keymap in the form xkb_keymap_get_as_string() writes, without
+ * the compiler. Returns false, with @keymap untouched, on anything else.
+ */
+bool
+XkbLoadKeymapText(struct xkb_keymap *keymap, const char *string, size_t len);
+
 /***====================================================================***/
 
 static inline bool
@@ -30,6 +30,7 @@
 #include "config.h"
 
 #include "xkbcomp-priv.h"
+#include "include.h"
 #include "rules.h"
 
 static bool
@@ -42,6 +43,9 @@ compile_keymap_file(struct xkb_keymap *keymap, XkbFile *file)
         return false;
     }
 
+    if (keymap->ctx->parallel_includes)
+        XkbPrefetchIncludes(keymap->ctx, file);
+
     if (!CompileKeymap(file, keymap, MERGE_OVERRIDE)) {
         log_err(keymap->ctx,
                 "Failed to compile keymap\n");
@@ -105,6 +109,9 @@ text_v1_keymap_new_from_string(struct xkb_keymap *keymap,
     bool ok;
     XkbFile *xkb_file;
 
+    if (XkbLoadKeymapText(keymap, string, len))
+        return true;
+
     xkb_file = XkbParseString(keymap->ctx, string, len, "(input string)", NULL);
     if (!xkb_file) {
         log_err(keymap->ctx, "Failed to parse input xkb string\n");
@@ -150,6 +150,40 @@ test_random_strings(void)
     atom_table_free(table);
 }
 
+static void
+test_seeded_strings(void)
+{
+    struct atom_table *table1, *table2;
+    xkb_atom_t shift, dynamic1, dynamic2;
+
+    table1 = atom_table_new();
+    table2 = atom_table_new();
+    assert(table1 && table2);
+
+    /* Well-known names are there from the start, with the same atoms. */
+    shift = LOOKUP_LITERAL(table1, "Shift");
+    assert(shift != XKB_ATOM_NONE);
+    assert(LOOKUP_LITERAL(table2, "Shift") == shift);
+    assert(INTERN_LITERAL(table2, "Shift") == shift);
+    assert(atom_text(table1, shift) == atom_text(table2, shift));
+    assert(streq(atom_text(table1, shift), "Shift"));
+    assert(LOOKUP_LITERAL(table1, "TWO_LEVEL") != XKB_ATOM_NONE);
+    assert(LOOKUP_LITERAL(table1, "AE01") != XKB_ATOM_NONE);
+    assert(atom_intern(table1, "Shiftless", 5, false) == shift);
+
+    /* Other strings are per table. */
+    assert(LOOKUP_LITERAL(table1, "no-such-name") == XKB_ATOM_NONE);
+    dynamic1 = INTERN_LITERAL(table1, "no-such-name");
+    assert(dynamic1 != XKB_ATOM_NONE && dynamic1 != shift);
+    assert(LOOKUP_LITERAL(table2, "no-such-name") == XKB_ATOM_NONE);
+    dynamic2 = INTERN_LITERAL(table2, "no-such-name");
+    assert(streq(atom_text(table2, dynamic2), "no-such-name"));
+    assert(LOOKUP_LITERAL(table1, "no-such-name") == dynamic1);
+
+    atom_table_free(table1);
+    atom_table_free(table2);
+}
+
 int
 main(void)
 {
@@ -181,6 +215,7 @@ main(void)
 
     atom_table_free(table);
 
+    test_seeded_strings();
     test_random_strings();
 
     return 0;
@@ -0,0 +1,166 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test.h"
+
+/*
+ * Dump the keymap in the binary format, load it back, both from a buffer
+ * and from a file, and check that it's the same keymap as the original
+ * by comparing them as text, and their fingerprints.
+ */
+static void
+test_round_trip(struct xkb_context *ctx, struct xkb_keymap *keymap)
+{
+    struct xkb_keymap *loaded;
+    char *text, *loaded_text, *blob;
+    size_t size;
+    FILE *file;
+    uint8_t fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE];
+    uint8_t loaded_fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE];
+
+    text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(text);
+    blob = xkb_keymap_get_as_buffer(keymap, XKB_KEYMAP_FORMAT_BINARY_V1,
+                                    &size);
+    assert(blob);
+
+    loaded = xkb_keymap_new_from_buffer(ctx, blob, size,
+                                        XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+    assert(loaded);
+    loaded_text = xkb_keymap_get_as_string(loaded, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(loaded_text);
+    assert(streq(text, loaded_text));
+    free(loaded_text);
+    /* As a string, the original format of a binary keymap is text. */
+    loaded_text = xkb_keymap_get_as_string(loaded,
+                                           XKB_KEYMAP_USE_ORIGINAL_FORMAT);
+    assert(loaded_text);
+    assert(streq(text, loaded_text));
+    xkb_keymap_get_fingerprint(keymap, fingerprint);
+    xkb_keymap_get_fingerprint(loaded, loaded_fingerprint);
+    assert(memcmp(fingerprint, loaded_fingerprint, sizeof(fingerprint)) == 0);
+    free(loaded_text);
+    xkb_keymap_unref(loaded);
+
+    file = tmpfile();
+    assert(file);
+    assert(fwrite(blob, 1, size, file) == size);
+    fflush(file);
+    loaded = xkb_keymap_new_from_file(ctx, file,
+                                      XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+    assert(loaded);
+    loaded_text = xkb_keymap_get_as_string(loaded, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(loaded_text);
+    assert(streq(text, loaded_text));
+    free(loaded_text);
+    xkb_keymap_unref(loaded);
+    fclose(file);
+
+    /* A truncated blob is rejected. */
+    for (size_t len = 0; len < size; len += 1 + len / 2)
+        assert(!xkb_keymap_new_from_buffer(ctx, blob, len,
+                                           XKB_KEYMAP_FORMAT_BINARY_V1, 0));
+
+    free(text);
+    free(blob);
+}
+
+static void
+test_bad_blobs(struct xkb_context *ctx, struct xkb_keymap *keymap)
+{
+    char *blob;
+    size_t size;
+
+    blob = xkb_keymap_get_as_buffer(keymap, XKB_KEYMAP_FORMAT_BINARY_V1,
+                                    &size);
+    assert(blob);
+
+    /* Bad magic. */
+    blob[0] ^= 0xff;
+    assert(!xkb_keymap_new_from_buffer(ctx, blob, size,
+                                       XKB_KEYMAP_FORMAT_BINARY_V1, 0));
+    blob[0] ^= 0xff;
+
+    /* A text keymap is not a binary one, and vice versa. */
+    assert(!xkb_keymap_new_from_string(ctx, "xkb_keymap {};",
+                                       XKB_KEYMAP_FORMAT_BINARY_V1, 0));
+    assert(!xkb_keymap_new_from_buffer(ctx, blob, size,
+                                       XKB_KEYMAP_FORMAT_TEXT_V1, 0));
+
+    /* Corrupting any byte must not crash; the result may still load. */
+    for (size_t i = 0; i < size; i += 7) {
+        struct xkb_keymap *loaded;
+
+        blob[i] ^= 0x5a;
+        loaded = xkb_keymap_new_from_buffer(ctx, blob, size,
+                                            XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+        xkb_keymap_unref(loaded);
+        blob[i] ^= 0x5a;
+    }
+
+    /* There is no text form of the binary format. */
+    assert(!xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_BINARY_V1));
+
+    free(blob);
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const char *files[] = {
+        "keymaps/stringcomp.data", "keymaps/basic.xkb",
+        "keymaps/host.xkb", "keymaps/no-aliases.xkb",
+        "keymaps/no-types.xkb", "keymaps/quartz.xkb",
+        "keymaps/comprehensive-plus-geom.xkb",
+    };
+    struct xkb_context *ctx = test_get_context(0);
+    struct xkb_keymap *keymap;
+
+    assert(ctx);
+
+    /* Don't drown the output in errors from the corrupted blobs. */
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        keymap = test_compile_file(ctx, files[i]);
+        assert(keymap);
+        test_round_trip(ctx, keymap);
+        xkb_keymap_unref(keymap);
+    }
+
+    keymap = test_compile_rules(ctx, "evdev", "pc105", "us,il,ru,de",
+                                ",,phonetic,neo",
+                                "grp:alt_shift_toggle,grp:menu_toggle");
+    assert(keymap);
+    test_round_trip(ctx, keymap);
+    test_bad_blobs(ctx, keymap);
+    xkb_keymap_unref(keymap);
+
+    xkb_context_unref(ctx);
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test.h"
+
+static int num_loaded;
+
+static void
+log_fn(struct xkb_context *ctx, enum xkb_log_level level,
+       const char *fmt, va_list args)
+{
+    if (strstr(fmt, "Loaded keymap from its canonical text form"))
+        num_loaded++;
+}
+
+/*
+ * Compile @text the long way: the loader only takes a keymap without
+ * flags, so with one it's left to the compiler.
+ */
+static struct xkb_keymap *
+compile_slow(struct xkb_context *ctx, const char *text)
+{
+    struct xkb_keymap *keymap;
+    char *flagged;
+    int ret;
+
+    ret = asprintf(&flagged, "default %s", text);
+    assert(ret >= 0);
+    keymap = test_compile_string(ctx, flagged);
+    free(flagged);
+    return keymap;
+}
+
+/* The binary form has all of the keymap, so compare that. */
+static bool
+same_keymap(struct xkb_keymap *a, struct xkb_keymap *b)
+{
+    char *blob_a, *blob_b;
+    size_t size_a, size_b;
+    bool same;
+
+    blob_a = xkb_keymap_get_as_buffer(a, XKB_KEYMAP_FORMAT_BINARY_V1, &size_a);
+    blob_b = xkb_keymap_get_as_buffer(b, XKB_KEYMAP_FORMAT_BINARY_V1, &size_b);
+    assert(blob_a && blob_b);
+    same = (size_a == size_b && memcmp(blob_a, blob_b, size_a) == 0);
+    free(blob_a);
+    free(blob_b);
+    return same;
+}
+
+/*
+ * Whether loaded or compiled, @text must give the same keymap, or none.
+ * Returns whether it was loaded.
+ */
+static bool
+check_text(struct xkb_context *ctx, const char *text)
+{
+    struct xkb_keymap *keymap, *compiled;
+    const int before = num_loaded;
+    bool loaded;
+
+    keymap = test_compile_string(ctx, text);
+    loaded = (num_loaded > before);
+    compiled = compile_slow(ctx, text);
+    assert(num_loaded == before + loaded);
+
+    assert(!keymap == !compiled);
+    if (keymap)
+        assert(same_keymap(keymap, compiled));
+    else
+        assert(!loaded);
+
+    xkb_keymap_unref(keymap);
+    xkb_keymap_unref(compiled);
+    return loaded;
+}
+
+/*
+ * Change the text a line at a time: drop it, repeat it, or swap it with
+ * the next one. Whatever the loader makes of it must be what the compiler
+ * makes of it.
+ */
+static void
+check_changed_lines(struct xkb_context *ctx, const char *text, size_t step)
+{
+    const size_t len = strlen(text);
+    darray(size_t) lines = darray_new();
+    char *changed;
+
+    darray_append(lines, 0);
+    for (size_t i = 0; i < len; i++)
+        if (text[i] == '\n')
+            darray_append(lines, i + 1);
+
+    changed = malloc(2 * len + 1);
+    assert(changed);
+
+    for (size_t i = 1; i + 2 < darray_size(lines); i += step) {
+        const size_t start = darray_item(lines, i);
+        const size_t end = darray_item(lines, i + 1);
+        const size_t end2 = darray_item(lines, i + 2);
+        char *p;
+
+        p = changed;
+        memcpy(p, text, start); p += start;
+        memcpy(p, text + end, len - end + 1);
+        check_text(ctx, changed);
+
+        p = changed;
+        memcpy(p, text, end); p += end;
+        memcpy(p, text + start, len - start + 1);
+        check_text(ctx, changed);
+
+        p = changed;
+        memcpy(p, text, start); p += start;
+        memcpy(p, text + end, end2 - end); p += end2 - end;
+        memcpy(p, text + start, end - start); p += end - start;
+        memcpy(p, text + end2, len - end2 + 1);
+        check_text(ctx, changed);
+    }
+
+    free(changed);
+    darray_free(lines);
+}
+
+static void
+test_keymap(struct xkb_context *ctx, struct xkb_keymap *keymap, size_t step)
+{
+    char *text, *compact;
+
+    text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(text);
+    compact = xkb_keymap_get_as_string2(keymap, XKB_KEYMAP_FORMAT_TEXT_V1,
+                                        XKB_KEYMAP_SERIALIZE_COMPACT);
+    assert(compact);
+
+    assert(check_text(ctx, text));
+    assert(check_text(ctx, compact));
+
+    if (step > 0)
+        check_changed_lines(ctx, text, step);
+
+    free(compact);
+    free(text);
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const char *files[] = {
+        "keymaps/stringcomp.data", "keymaps/basic.xkb",
+        "keymaps/host.xkb", "keymaps/no-aliases.xkb",
+        "keymaps/quartz.xkb", "keymaps/comprehensive-plus-geom.xkb",
+    };
+    static const char *not_canonical[] = {
+        /* No types, which the compiler makes up. */
+        "xkb_keymap { xkb_keycodes { <A> = 9; }; xkb_types { };"
+        " xkb_compat { }; xkb_symbols { }; };",
+        /* Includes. */
+        "xkb_keymap { xkb_keycodes { include \"evdev\" }; xkb_types { };"
+        " xkb_compat { }; xkb_symbols { }; };",
+        /* A key by its alias. */
+        "xkb_keymap { xkb_keycodes { <A> = 9; alias <B> = <A>; };"
+        " xkb_types { type \"ONE_LEVEL\" { modifiers = none; }; };"
+        " xkb_compat { }; xkb_symbols { key <B> { [ a ] }; }; };",
+        /* Something else after the keymap. */
+        "xkb_keymap { xkb_keycodes { }; xkb_types { type \"T\" { }; };"
+        " xkb_compat { }; xkb_symbols { }; }; xkb_keymap { };",
+    };
+    struct xkb_context *ctx = test_get_context(0);
+    struct xkb_keymap *keymap;
+
+    assert(ctx);
+
+    xkb_context_set_log_fn(ctx, log_fn);
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_DEBUG);
+
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        keymap = test_compile_file(ctx, files[i]);
+        assert(keymap);
+        test_keymap(ctx, keymap, i == 1 ? 53 : 0);
+        xkb_keymap_unref(keymap);
+    }
+
+    keymap = test_compile_rules(ctx, "evdev", "pc105", "us,il,ru,de",
+                                ",,phonetic,neo",
+                                "grp:alt_shift_toggle,grp:menu_toggle");
+    assert(keymap);
+    test_keymap(ctx, keymap, 151);
+    xkb_keymap_unref(keymap);
+
+    for (size_t i = 0; i < ARRAY_SIZE(not_canonical); i++)
+        assert(!check_text(ctx, not_canonical[i]));
+
+    xkb_context_unref(ctx);
+
+    return 0;
+}
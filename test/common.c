@@ -248,6 +248,13 @@ test_get_context(enum test_context_flags test_flags)
         ctx_flags |= XKB_CONTEXT_NO_ENVIRONMENT_NAMES;
     }
 
+    if (test_flags & CONTEXT_CACHE_INCLUDES)
+        ctx_flags |= XKB_CONTEXT_CACHE_INCLUDES;
+    if (test_flags & CONTEXT_CACHE_KEYMAPS)
+        ctx_flags |= XKB_CONTEXT_CACHE_KEYMAPS;
+    if (test_flags & CONTEXT_PARALLEL_INCLUDES)
+        ctx_flags |= XKB_CONTEXT_PARALLEL_INCLUDES;
+
     ctx = xkb_context_new(ctx_flags);
     if (!ctx)
         return NULL;
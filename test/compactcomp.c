@@ -0,0 +1,238 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test.h"
+
+/*
+ * The compact form must compile to the same keymap. The public API
+ * doesn't show the actions, so compare what they do to a state instead.
+ */
+static void
+assert_same_keys(struct xkb_keymap *a, struct xkb_keymap *b)
+{
+    xkb_keycode_t min = xkb_keymap_min_keycode(a);
+    xkb_keycode_t max = xkb_keymap_max_keycode(a);
+
+    assert(min == xkb_keymap_min_keycode(b));
+    assert(max == xkb_keymap_max_keycode(b));
+
+    for (xkb_keycode_t kc = min; kc <= max; kc++) {
+        const xkb_layout_index_t num_layouts =
+            xkb_keymap_num_layouts_for_key(a, kc);
+
+        assert(streq_null(xkb_keymap_key_get_name(a, kc),
+                          xkb_keymap_key_get_name(b, kc)));
+        assert(xkb_keymap_key_repeats(a, kc) ==
+               xkb_keymap_key_repeats(b, kc));
+        assert(num_layouts == xkb_keymap_num_layouts_for_key(b, kc));
+
+        for (xkb_layout_index_t layout = 0; layout < num_layouts; layout++) {
+            const xkb_level_index_t num_levels =
+                xkb_keymap_num_levels_for_key(a, kc, layout);
+
+            assert(num_levels == xkb_keymap_num_levels_for_key(b, kc, layout));
+
+            for (xkb_level_index_t level = 0; level < num_levels; level++) {
+                const xkb_keysym_t *syms_a, *syms_b;
+                xkb_mod_mask_t masks_a[16], masks_b[16];
+                int num_syms;
+                size_t num_masks;
+
+                num_syms = xkb_keymap_key_get_syms_by_level(a, kc, layout,
+                                                            level, &syms_a);
+                assert(num_syms ==
+                       xkb_keymap_key_get_syms_by_level(b, kc, layout,
+                                                        level, &syms_b));
+                for (int i = 0; i < num_syms; i++)
+                    assert(syms_a[i] == syms_b[i]);
+
+                num_masks = xkb_keymap_key_get_mods_for_level(
+                    a, kc, layout, level, masks_a, ARRAY_SIZE(masks_a));
+                assert(num_masks ==
+                       xkb_keymap_key_get_mods_for_level(
+                           b, kc, layout, level, masks_b,
+                           ARRAY_SIZE(masks_b)));
+                for (size_t i = 0; i < num_masks; i++)
+                    assert(masks_a[i] == masks_b[i]);
+            }
+        }
+    }
+}
+
+static void
+assert_same_state(struct xkb_state *a, struct xkb_state *b)
+{
+    assert(xkb_state_serialize_mods(a, XKB_STATE_MODS_DEPRESSED) ==
+           xkb_state_serialize_mods(b, XKB_STATE_MODS_DEPRESSED));
+    assert(xkb_state_serialize_mods(a, XKB_STATE_MODS_LATCHED) ==
+           xkb_state_serialize_mods(b, XKB_STATE_MODS_LATCHED));
+    assert(xkb_state_serialize_mods(a, XKB_STATE_MODS_LOCKED) ==
+           xkb_state_serialize_mods(b, XKB_STATE_MODS_LOCKED));
+    assert(xkb_state_serialize_layout(a, XKB_STATE_LAYOUT_EFFECTIVE) ==
+           xkb_state_serialize_layout(b, XKB_STATE_LAYOUT_EFFECTIVE));
+}
+
+static void
+assert_same_actions(struct xkb_keymap *a, struct xkb_keymap *b)
+{
+    struct xkb_state *state_a = xkb_state_new(a);
+    struct xkb_state *state_b = xkb_state_new(b);
+
+    assert(state_a && state_b);
+
+    for (xkb_keycode_t kc = xkb_keymap_min_keycode(a);
+         kc <= xkb_keymap_max_keycode(a); kc++) {
+        xkb_state_update_key(state_a, kc, XKB_KEY_DOWN);
+        xkb_state_update_key(state_b, kc, XKB_KEY_DOWN);
+        assert_same_state(state_a, state_b);
+        xkb_state_update_key(state_a, kc, XKB_KEY_UP);
+        xkb_state_update_key(state_b, kc, XKB_KEY_UP);
+        assert_same_state(state_a, state_b);
+    }
+
+    xkb_state_unref(state_a);
+    xkb_state_unref(state_b);
+}
+
+static void
+assert_same_keymap(struct xkb_keymap *a, struct xkb_keymap *b)
+{
+    assert(xkb_keymap_num_mods(a) == xkb_keymap_num_mods(b));
+    for (xkb_mod_index_t i = 0; i < xkb_keymap_num_mods(a); i++)
+        assert(streq(xkb_keymap_mod_get_name(a, i),
+                     xkb_keymap_mod_get_name(b, i)));
+
+    assert(xkb_keymap_num_layouts(a) == xkb_keymap_num_layouts(b));
+    for (xkb_layout_index_t i = 0; i < xkb_keymap_num_layouts(a); i++)
+        assert(streq_null(xkb_keymap_layout_get_name(a, i),
+                          xkb_keymap_layout_get_name(b, i)));
+
+    assert(xkb_keymap_num_leds(a) == xkb_keymap_num_leds(b));
+    for (xkb_led_index_t i = 0; i < xkb_keymap_num_leds(a); i++)
+        assert(streq_null(xkb_keymap_led_get_name(a, i),
+                          xkb_keymap_led_get_name(b, i)));
+
+    assert_same_keys(a, b);
+    assert_same_actions(a, b);
+}
+
+/*
+ * The full text form drops a few things too, e.g. the level 1 entries of
+ * the types, so compare the compact form with it rather than with the
+ * original keymap.
+ */
+static void
+test_compact(struct xkb_context *ctx, struct xkb_keymap *keymap)
+{
+    struct xkb_keymap *full, *loaded;
+    char *text, *compact, *loaded_compact;
+    uint8_t fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE];
+    uint8_t full_fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE];
+    uint8_t loaded_fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE];
+
+    text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(text);
+    compact = xkb_keymap_get_as_string2(keymap, XKB_KEYMAP_FORMAT_TEXT_V1,
+                                        XKB_KEYMAP_SERIALIZE_COMPACT);
+    assert(compact);
+    assert(strlen(compact) < strlen(text));
+
+    full = test_compile_string(ctx, text);
+    assert(full);
+    loaded = test_compile_string(ctx, compact);
+    assert(loaded);
+    assert_same_keymap(full, loaded);
+
+    /* The fingerprint doesn't depend on the form either. */
+    xkb_keymap_get_fingerprint(keymap, fingerprint);
+    xkb_keymap_get_fingerprint(full, full_fingerprint);
+    xkb_keymap_get_fingerprint(loaded, loaded_fingerprint);
+    assert(memcmp(fingerprint, full_fingerprint, sizeof(fingerprint)) == 0);
+    assert(memcmp(fingerprint, loaded_fingerprint, sizeof(fingerprint)) == 0);
+
+    /* Nothing is lost, so the compact form of the result is the same. */
+    loaded_compact = xkb_keymap_get_as_string2(loaded,
+                                               XKB_KEYMAP_FORMAT_TEXT_V1,
+                                               XKB_KEYMAP_SERIALIZE_COMPACT);
+    assert(loaded_compact);
+    assert(streq(compact, loaded_compact));
+
+    free(loaded_compact);
+    xkb_keymap_unref(loaded);
+    xkb_keymap_unref(full);
+    free(compact);
+    free(text);
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const char *files[] = {
+        "keymaps/stringcomp.data", "keymaps/basic.xkb",
+        "keymaps/host.xkb", "keymaps/no-aliases.xkb",
+        "keymaps/no-types.xkb", "keymaps/quartz.xkb",
+        "keymaps/comprehensive-plus-geom.xkb",
+    };
+    static const struct {
+        const char *layout, *variant, *options;
+    } rmlvos[] = {
+        { "us", "", "" },
+        { "us,us,de", "", "grp:alt_shift_toggle" },
+        { "us,il,ru,de", ",,phonetic,neo",
+          "grp:alt_shift_toggle,grp:menu_toggle" },
+        { "ch,in", "fr,", "ctrl:nocaps,compose:ralt,lv3:ralt_switch" },
+    };
+    struct xkb_context *ctx = test_get_context(0);
+    struct xkb_keymap *keymap;
+
+    assert(ctx);
+
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        keymap = test_compile_file(ctx, files[i]);
+        assert(keymap);
+        test_compact(ctx, keymap);
+        xkb_keymap_unref(keymap);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(rmlvos); i++) {
+        keymap = test_compile_rules(ctx, "evdev", "pc105", rmlvos[i].layout,
+                                    rmlvos[i].variant, rmlvos[i].options);
+        assert(keymap);
+        test_compact(ctx, keymap);
+        xkb_keymap_unref(keymap);
+    }
+
+    keymap = test_compile_rules(ctx, "evdev", "pc105", "us", "", "");
+    assert(keymap);
+    assert(!xkb_keymap_get_as_string2(keymap, XKB_KEYMAP_FORMAT_TEXT_V1,
+                                      0x100));
+    xkb_keymap_unref(keymap);
+
+    xkb_context_unref(ctx);
+
+    return 0;
+}
@@ -310,6 +310,520 @@ test_include_order(void)
     restore_env();
 }
 
+static char *
+writefile(const char *dir, const char *name, const char *content)
+{
+    char *path;
+    FILE *file;
+    int err;
+
+    err = asprintf(&path, "%s/%s", dir, name);
+    assert(err >= 0);
+    file = fopen(path, "w");
+    assert(file);
+    fputs(content, file);
+    fclose(file);
+
+    return path;
+}
+
+static struct xkb_keymap *
+compile_cached_keymap(struct xkb_context *ctx)
+{
+    const char *keymap_str =
+        "xkb_keymap {\n"
+        "    xkb_keycodes { include \"test\" };\n"
+        "    xkb_types { include \"test\" };\n"
+        "    xkb_compat { include \"test\" };\n"
+        "    xkb_symbols { include \"test\" };\n"
+        "};\n";
+
+    return xkb_keymap_new_from_string(ctx, keymap_str,
+                                      XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+}
+
+static void
+test_include_cache(void)
+{
+    struct xkb_context *ctx, *ctx_uncached;
+    struct xkb_keymap *keymap;
+    const char *tmpdir;
+    char *files[4];
+    char *dumped, *dumped_uncached;
+    const xkb_keysym_t *syms;
+
+    tmpdir = maketmpdir();
+    files[0] = writefile(makedir(tmpdir, "keycodes"), "test",
+                         "xkb_keycodes { <AE01> = 10; };\n");
+    files[1] = writefile(makedir(tmpdir, "types"), "test",
+                         "xkb_types { };\n");
+    files[2] = writefile(makedir(tmpdir, "compat"), "test",
+                         "xkb_compat { };\n");
+    files[3] = writefile(makedir(tmpdir, "symbols"), "test",
+                         "xkb_symbols { key <AE01> { [ a ] }; };\n");
+
+    ctx = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES |
+                          XKB_CONTEXT_NO_ENVIRONMENT_NAMES |
+                          XKB_CONTEXT_CACHE_INCLUDES);
+    assert(ctx);
+    assert(xkb_context_include_path_append(ctx, tmpdir));
+    ctx_uncached = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES |
+                                   XKB_CONTEXT_NO_ENVIRONMENT_NAMES);
+    assert(ctx_uncached);
+    assert(xkb_context_include_path_append(ctx_uncached, tmpdir));
+
+    /* Cached files compile to the same keymap, again and again. */
+    keymap = compile_cached_keymap(ctx_uncached);
+    assert(keymap);
+    dumped_uncached = xkb_keymap_get_as_string(keymap,
+                                               XKB_KEYMAP_FORMAT_TEXT_V1);
+    xkb_keymap_unref(keymap);
+    for (int i = 0; i < 3; i++) {
+        keymap = compile_cached_keymap(ctx);
+        assert(keymap);
+        assert(xkb_keymap_key_get_syms_by_level(keymap, 10, 0, 0, &syms) == 1);
+        assert(syms[0] == XKB_KEY_a);
+        dumped = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+        assert(streq(dumped, dumped_uncached));
+        free(dumped);
+        xkb_keymap_unref(keymap);
+    }
+    free(dumped_uncached);
+
+    /* A file which changed is parsed again. */
+    free(writefile(tmpdir, "symbols/test",
+                   "xkb_symbols { key <AE01> { [ BackSpace ] }; };\n"));
+    keymap = compile_cached_keymap(ctx);
+    assert(keymap);
+    assert(xkb_keymap_key_get_syms_by_level(keymap, 10, 0, 0, &syms) == 1);
+    assert(syms[0] == XKB_KEY_BackSpace);
+    xkb_keymap_unref(keymap);
+
+    xkb_context_unref(ctx);
+    xkb_context_unref(ctx_uncached);
+
+    for (int i = 0; i < 4; i++) {
+        unlink(files[i]);
+        free(files[i]);
+    }
+    unmakedirs();
+}
+
+static int unrecognized_names;
+
+static void
+count_unrecognized_names(struct xkb_context *ctx, enum xkb_log_level level,
+                         const char *fmt, va_list args)
+{
+    char buf[1024];
+
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    if (strstr(buf, "Unrecognized RMLVO"))
+        unrecognized_names++;
+}
+
+static void
+test_rules_cache(void)
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    struct xkb_rule_names names = { .rules = "test" };
+    struct xkb_rule_names unknown_names = { .rules = "test", .layout = "xx" };
+    const char *tmpdir;
+    char *files[7], *include;
+    const xkb_keysym_t *syms;
+    int err;
+
+    tmpdir = maketmpdir();
+    files[0] = writefile(makedir(tmpdir, "keycodes"), "test",
+                         "xkb_keycodes { <AE01> = 10; };\n");
+    files[1] = writefile(makedir(tmpdir, "types"), "test",
+                         "xkb_types { };\n");
+    files[2] = writefile(makedir(tmpdir, "compat"), "test",
+                         "xkb_compat { };\n");
+    files[3] = writefile(makedir(tmpdir, "symbols"), "a",
+                         "xkb_symbols { key <AE01> { [ a ] }; };\n");
+    files[4] = writefile(tmpdir, "symbols/b",
+                         "xkb_symbols { key <AE01> { [ BackSpace ] }; };\n");
+    files[5] = writefile(makedir(tmpdir, "rules"), "included",
+                         "! model = keycodes types compat symbols\n"
+                         "  *     = test     test  test   a\n");
+    err = asprintf(&include, "! include %s\n", files[5]);
+    assert(err >= 0);
+    files[6] = writefile(tmpdir, "rules/test", include);
+    free(include);
+
+    ctx = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES |
+                          XKB_CONTEXT_NO_ENVIRONMENT_NAMES |
+                          XKB_CONTEXT_CACHE_INCLUDES);
+    assert(ctx);
+    assert(xkb_context_include_path_append(ctx, tmpdir));
+
+    for (int i = 0; i < 3; i++) {
+        keymap = xkb_keymap_new_from_names(ctx, &names, 0);
+        assert(keymap);
+        assert(xkb_keymap_key_get_syms_by_level(keymap, 10, 0, 0, &syms) == 1);
+        assert(syms[0] == XKB_KEY_a);
+        xkb_keymap_unref(keymap);
+    }
+
+    /* Warnings are logged every time, not just the first. */
+    xkb_context_set_log_fn(ctx, count_unrecognized_names);
+    for (int i = 0; i < 3; i++) {
+        keymap = xkb_keymap_new_from_names(ctx, &unknown_names, 0);
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+    }
+    assert(unrecognized_names == 3);
+    xkb_context_set_log_fn(ctx, NULL);
+
+    /* A change to an included rules file is picked up. */
+    free(writefile(tmpdir, "rules/included",
+                   "! model = keycodes types compat symbols\n"
+                   "  *     = test     test  test   b\n"
+                   "\n"));
+    keymap = xkb_keymap_new_from_names(ctx, &names, 0);
+    assert(keymap);
+    assert(xkb_keymap_key_get_syms_by_level(keymap, 10, 0, 0, &syms) == 1);
+    assert(syms[0] == XKB_KEY_BackSpace);
+    xkb_keymap_unref(keymap);
+
+    xkb_context_unref(ctx);
+
+    for (int i = 0; i < 7; i++) {
+        unlink(files[i]);
+        free(files[i]);
+    }
+    unmakedirs();
+}
+
+static void
+test_keymap_cache(void)
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *us, *us2, *de, *keymap;
+    struct xkb_rule_names us_names = { .layout = "us" };
+    struct xkb_rule_names de_names = { .layout = "de" };
+    /* Options which make other keymaps, without any warnings. */
+    static const char *options[] = {
+        "altwin:menu", "altwin:meta_alt", "altwin:alt_win",
+        "altwin:ctrl_win", "altwin:ctrl_alt_win", "altwin:meta_win",
+        "altwin:left_meta_win", "altwin:hyper_win", "altwin:alt_super_win",
+        "altwin:swap_lalt_lwin", "altwin:swap_alt_win", "altwin:prtsc_rwin",
+        "grp:switch", "grp:lswitch", "grp:win_switch", "grp:lwin_switch",
+        "grp:rwin_switch", "grp:menu_switch", "grp:toggle",
+        "grp:shifts_toggle",
+    };
+    char *text, *blob;
+    size_t size;
+    enum xkb_log_level level;
+
+    ctx = test_get_context(CONTEXT_CACHE_KEYMAPS);
+    assert(ctx);
+    /* Keymaps which log warnings aren't cached; see below. */
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_ERROR);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    /* The same names get the same keymap. */
+    us = xkb_keymap_new_from_names(ctx, &us_names, 0);
+    us2 = xkb_keymap_new_from_names(ctx, &us_names, 0);
+    assert(us && us == us2);
+    xkb_keymap_unref(us2);
+    de = xkb_keymap_new_from_names(ctx, &de_names, 0);
+    assert(de && de != us);
+    xkb_keymap_unref(de);
+
+    /* Clearing the cache doesn't affect the keymaps in use. */
+    xkb_context_clear_cache(ctx);
+    us2 = xkb_keymap_new_from_names(ctx, &us_names, 0);
+    assert(us2 && us2 != us);
+    assert(streq(xkb_keymap_layout_get_name(us, 0), "English (US)"));
+    xkb_keymap_unref(us2);
+
+    /* Filling up the cache evicts the least recently used keymap. */
+    us2 = xkb_keymap_new_from_names(ctx, &us_names, 0);
+    for (int i = 0; i < 16; i++) {
+        struct xkb_rule_names names = {
+            .layout = "us", .options = options[i],
+        };
+        keymap = xkb_keymap_new_from_names(ctx, &names, 0);
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+    }
+    keymap = xkb_keymap_new_from_names(ctx, &us_names, 0);
+    assert(keymap && keymap != us2);
+    xkb_keymap_unref(keymap);
+    xkb_keymap_unref(us2);
+
+    /* Lookups keep working after many evictions. */
+    us2 = xkb_keymap_new_from_names(ctx, &us_names, 0);
+    for (int i = 0; i < 80; i++) {
+        struct xkb_rule_names names = {
+            .layout = "us", .options = options[i % ARRAY_SIZE(options)],
+        };
+        keymap = xkb_keymap_new_from_names(ctx, &names, 0);
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+        keymap = xkb_keymap_new_from_names(ctx, &us_names, 0);
+        assert(keymap == us2);
+        xkb_keymap_unref(keymap);
+    }
+    xkb_keymap_unref(us2);
+
+    /* Keymaps with warnings aren't cached, to log them every time. */
+    xkb_context_set_log_fn(ctx, count_unrecognized_names);
+    unrecognized_names = 0;
+    for (int i = 0; i < 3; i++) {
+        struct xkb_rule_names names = {
+            .layout = "us", .options = "bogus:option",
+        };
+        keymap = xkb_keymap_new_from_names(ctx, &names, 0);
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+        assert(unrecognized_names == i + 1);
+    }
+    xkb_context_set_log_fn(ctx, NULL);
+
+    /* The same buffer gets the same keymap, whichever way it's passed. */
+    text = xkb_keymap_get_as_string(us, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(text);
+    us2 = xkb_keymap_new_from_string(ctx, text, XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+    assert(us2 && us2 != us);
+    keymap = xkb_keymap_new_from_buffer(ctx, text, strlen(text),
+                                        XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+    assert(keymap == us2);
+    xkb_keymap_unref(keymap);
+
+    /* But not another buffer, even if only by a byte. */
+    keymap = xkb_keymap_new_from_buffer(ctx, text, strlen(text) - 1,
+                                        XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+    assert(keymap && keymap != us2);
+    xkb_keymap_unref(keymap);
+    xkb_keymap_unref(us2);
+    free(text);
+
+    /* Nor the same buffer in another format. */
+    blob = xkb_keymap_get_as_buffer(us, XKB_KEYMAP_FORMAT_BINARY_V1, &size);
+    assert(blob);
+    us2 = xkb_keymap_new_from_buffer(ctx, blob, size,
+                                     XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+    assert(us2);
+    keymap = xkb_keymap_new_from_buffer(ctx, blob, size,
+                                        XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+    assert(keymap == us2);
+    xkb_keymap_unref(keymap);
+    level = xkb_context_get_log_level(ctx);
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    assert(!xkb_keymap_new_from_buffer(ctx, blob, size,
+                                       XKB_KEYMAP_FORMAT_TEXT_V1, 0));
+    xkb_context_set_log_level(ctx, level);
+    xkb_keymap_unref(us2);
+    free(blob);
+
+    /* The cache doesn't keep the context alive, the keymaps in use do. */
+    xkb_context_unref(ctx);
+    assert(xkb_keymap_num_layouts(us) == 1);
+    xkb_keymap_unref(us);
+}
+
+static int include_errors;
+
+static void
+count_include_errors(struct xkb_context *ctx, enum xkb_log_level level,
+                     const char *fmt, va_list args)
+{
+    char buf[1024];
+
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    if (strstr(buf, "Couldn't find file"))
+        include_errors++;
+}
+
+static void
+test_parallel_includes(void)
+{
+    struct xkb_context *ctx, *ctx_parallel;
+    struct xkb_keymap *keymap;
+    char *dumped, *dumped_parallel;
+    const char *missing_include =
+        "xkb_keymap {\n"
+        "    xkb_keycodes { include \"evdev+aliases(qwerty)\" };\n"
+        "    xkb_types { include \"complete\" };\n"
+        "    xkb_compat { include \"complete\" };\n"
+        "    xkb_symbols { include \"pc+us+nonexistent\" };\n"
+        "};\n";
+
+    ctx = test_get_context(0);
+    assert(ctx);
+    ctx_parallel = test_get_context(CONTEXT_PARALLEL_INCLUDES);
+    assert(ctx_parallel);
+
+    /* Prefetching the includes doesn't change the result. */
+    keymap = test_compile_rules(ctx, "evdev", "pc105", "us,il,ru,de",
+                                ",,phonetic,neo",
+                                "grp:alt_shift_toggle,grp:menu_toggle");
+    assert(keymap);
+    dumped = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    xkb_keymap_unref(keymap);
+    for (int i = 0; i < 2; i++) {
+        keymap = test_compile_rules(ctx_parallel, "evdev", "pc105",
+                                    "us,il,ru,de", ",,phonetic,neo",
+                                    "grp:alt_shift_toggle,grp:menu_toggle");
+        assert(keymap);
+        dumped_parallel = xkb_keymap_get_as_string(keymap,
+                                                   XKB_KEYMAP_FORMAT_TEXT_V1);
+        assert(streq(dumped, dumped_parallel));
+        free(dumped_parallel);
+        xkb_keymap_unref(keymap);
+    }
+    free(dumped);
+
+    /* An include which can't be found is reported once. */
+    xkb_context_set_log_fn(ctx_parallel, count_include_errors);
+    keymap = xkb_keymap_new_from_string(ctx_parallel, missing_include,
+                                        XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+    assert(!keymap);
+    assert(include_errors == 1);
+
+    xkb_context_unref(ctx);
+    xkb_context_unref(ctx_parallel);
+}
+
+static char last_error[1024];
+
+static void
+keep_last_error(struct xkb_context *ctx, enum xkb_log_level level,
+                const char *fmt, va_list args)
+{
+    if (level <= XKB_LOG_LEVEL_ERROR && !last_error[0])
+        vsnprintf(last_error, sizeof(last_error), fmt, args);
+}
+
+static int first_map_notes;
+
+static void
+count_first_map_notes(struct xkb_context *ctx, enum xkb_log_level level,
+                      const char *fmt, va_list args)
+{
+    char buf[1024];
+
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    if (strstr(buf, "\"nodefault\" contains several"))
+        first_map_notes++;
+}
+
+static struct xkb_keymap *
+compile_symbols_map(struct xkb_context *ctx, const char *map)
+{
+    char *keymap_str;
+    struct xkb_keymap *keymap;
+    int err;
+
+    err = asprintf(&keymap_str,
+                   "xkb_keymap {\n"
+                   "    xkb_keycodes { include \"test\" };\n"
+                   "    xkb_types { include \"test\" };\n"
+                   "    xkb_compat { include \"test\" };\n"
+                   "    xkb_symbols { include \"%s\" };\n"
+                   "};\n", map);
+    assert(err >= 0);
+    keymap = xkb_keymap_new_from_string(ctx, keymap_str,
+                                        XKB_KEYMAP_FORMAT_TEXT_V1, 0);
+    free(keymap_str);
+    return keymap;
+}
+
+static void
+test_section_index(void)
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    const char *tmpdir;
+    char *files[5];
+    const xkb_keysym_t *syms;
+    static const struct {
+        const char *map;
+        xkb_keysym_t sym;
+    } maps[] = {
+        { "test", XKB_KEY_b },
+        { "test(first)", XKB_KEY_a },
+        { "test(braces)", XKB_KEY_b },
+        { "test(last)", XKB_KEY_c },
+    };
+
+    tmpdir = maketmpdir();
+    files[0] = writefile(makedir(tmpdir, "keycodes"), "test",
+                         "xkb_keycodes { <AE01> = 10; };\n");
+    files[1] = writefile(makedir(tmpdir, "types"), "test",
+                         "xkb_types { };\n");
+    files[2] = writefile(makedir(tmpdir, "compat"), "test",
+                         "xkb_compat { };\n");
+    files[3] = writefile(makedir(tmpdir, "symbols"), "test",
+                         "// A comment with a brace {\n"
+                         "xkb_symbols \"first\" { key <AE01> { [ a ] }; };\n"
+                         "\n"
+                         "default partial\n"
+                         "xkb_symbols \"braces\" {\n"
+                         "    name[Group1] = \"} {\\\\\"; # }\n"
+                         "    key <AE01> { [ b ] };\n"
+                         "};\n"
+                         "xkb_symbols \"bad\" {\n"
+                         "    key <AE01> { [ a ] ] };\n"
+                         "};\n"
+                         "xkb_symbols \"last\" { key <AE01> { [ c ] }; };\n");
+    files[4] = writefile(tmpdir, "symbols/nodefault",
+                         "xkb_symbols \"one\" { key <AE01> { [ a ] }; };\n"
+                         "xkb_symbols \"two\" { key <AE01> { [ b ] }; };\n");
+
+    for (int cached = 0; cached <= 1; cached++) {
+        ctx = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES |
+                              XKB_CONTEXT_NO_ENVIRONMENT_NAMES |
+                              (cached ? XKB_CONTEXT_CACHE_INCLUDES : 0));
+        assert(ctx);
+        assert(xkb_context_include_path_append(ctx, tmpdir));
+        xkb_context_set_log_fn(ctx, keep_last_error);
+
+        /* Braces in strings and comments don't get in the way. */
+        for (size_t i = 0; i < ARRAY_SIZE(maps); i++) {
+            keymap = compile_symbols_map(ctx, maps[i].map);
+            assert(keymap);
+            assert(xkb_keymap_key_get_syms_by_level(keymap, 10, 0, 0,
+                                                    &syms) == 1);
+            assert(syms[0] == maps[i].sym);
+            xkb_keymap_unref(keymap);
+        }
+
+        /* Errors in a section have the lines of the file. */
+        last_error[0] = '\0';
+        assert(!compile_symbols_map(ctx, "test(bad)"));
+        assert(strstr(last_error, "test:10:"));
+
+        /* A map which is not there. */
+        assert(!compile_symbols_map(ctx, "test(none)"));
+
+        /* Falling back to the first map is noted either way. */
+        xkb_context_set_log_fn(ctx, count_first_map_notes);
+        xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_WARNING);
+        xkb_context_set_log_verbosity(ctx, 5);
+        first_map_notes = 0;
+        keymap = compile_symbols_map(ctx, "nodefault");
+        assert(keymap);
+        assert(xkb_keymap_key_get_syms_by_level(keymap, 10, 0, 0,
+                                                &syms) == 1);
+        assert(syms[0] == XKB_KEY_a);
+        xkb_keymap_unref(keymap);
+        assert(first_map_notes == 1);
+
+        xkb_context_unref(ctx);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        unlink(files[i]);
+        free(files[i]);
+    }
+    unmakedirs();
+}
+
 int
 main(void)
 {
@@ -338,6 +852,11 @@ main(void)
     test_xdg_include_path();
     test_xdg_include_path_fallback();
     test_include_order();
+    test_include_cache();
+    test_rules_cache();
+    test_keymap_cache();
+    test_parallel_includes();
+    test_section_index();
 
     return 0;
 }
@@ -0,0 +1,178 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "test.h"
+
+#ifdef HAVE_MEMFD_CREATE
+static char *
+read_fd(int fd, size_t *size)
+{
+    struct stat st;
+    char *map, *data;
+
+    assert(fstat(fd, &st) == 0);
+    *size = st.st_size;
+
+    map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    assert(map != MAP_FAILED);
+    data = malloc(*size);
+    assert(data);
+    memcpy(data, map, *size);
+    munmap(map, *size);
+
+    return data;
+}
+
+/*
+ * The file holds the same thing as xkb_keymap_get_as_buffer(), with the
+ * NUL of text keymaps, every call gets its own descriptor, and nobody can
+ * change the file.
+ */
+static void
+test_fd(struct xkb_context *ctx, struct xkb_keymap *keymap,
+        enum xkb_keymap_format format)
+{
+    int fd1, fd2;
+    char *expected, *data;
+    size_t expected_size, size;
+    struct xkb_keymap *loaded;
+    struct stat st1, st2;
+
+    expected = xkb_keymap_get_as_buffer(keymap, format, &expected_size);
+    assert(expected);
+    if (format == XKB_KEYMAP_FORMAT_TEXT_V1)
+        expected_size++;
+
+    fd1 = xkb_keymap_get_as_fd(keymap, format, XKB_KEYMAP_SERIALIZE_NO_FLAGS);
+    assert(fd1 >= 0);
+    fd2 = xkb_keymap_get_as_fd(keymap, format, XKB_KEYMAP_SERIALIZE_NO_FLAGS);
+    assert(fd2 >= 0 && fd2 != fd1);
+    assert(fcntl(fd1, F_GETFD) & FD_CLOEXEC);
+
+    /* The keymap is only serialized once. */
+    assert(fstat(fd1, &st1) == 0 && fstat(fd2, &st2) == 0);
+    assert(st1.st_ino == st2.st_ino);
+
+    data = read_fd(fd1, &size);
+    assert(size == expected_size);
+    assert(memcmp(data, expected, size) == 0);
+
+    /* It loads back, as a Wayland client would load it. */
+    if (format == XKB_KEYMAP_FORMAT_TEXT_V1)
+        loaded = xkb_keymap_new_from_string(ctx, data, format, 0);
+    else
+        loaded = xkb_keymap_new_from_buffer(ctx, data, size, format, 0);
+    assert(loaded);
+    xkb_keymap_unref(loaded);
+    free(data);
+
+    /* The descriptors have their own offsets. */
+    assert(lseek(fd1, 10, SEEK_SET) == 10);
+    assert(lseek(fd2, 0, SEEK_CUR) == 0);
+
+    assert(write(fd1, "x", 1) < 0);
+    assert(ftruncate(fd1, 0) < 0);
+    assert(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd2, 0) == MAP_FAILED);
+    assert(fcntl(fd2, F_GET_SEALS) & F_SEAL_WRITE);
+
+    close(fd1);
+    close(fd2);
+    free(expected);
+}
+
+/* The compact form is in a file of its own. */
+static void
+test_compact_fd(struct xkb_keymap *keymap)
+{
+    int fd, compact_fd;
+    char *expected, *data;
+    size_t size;
+    struct stat st, compact_st;
+
+    expected = xkb_keymap_get_as_string2(keymap, XKB_KEYMAP_FORMAT_TEXT_V1,
+                                         XKB_KEYMAP_SERIALIZE_COMPACT);
+    assert(expected);
+
+    fd = xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_FORMAT_TEXT_V1,
+                              XKB_KEYMAP_SERIALIZE_NO_FLAGS);
+    assert(fd >= 0);
+    compact_fd = xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_FORMAT_TEXT_V1,
+                                      XKB_KEYMAP_SERIALIZE_COMPACT);
+    assert(compact_fd >= 0);
+    assert(fstat(fd, &st) == 0 && fstat(compact_fd, &compact_st) == 0);
+    assert(st.st_ino != compact_st.st_ino);
+    assert(compact_st.st_size < st.st_size);
+
+    data = read_fd(compact_fd, &size);
+    assert(size == strlen(expected) + 1);
+    assert(memcmp(data, expected, size) == 0);
+
+    free(data);
+    close(fd);
+    close(compact_fd);
+    free(expected);
+}
+#endif
+
+int
+main(void)
+{
+    struct xkb_context *ctx = test_get_context(0);
+    struct xkb_keymap *keymap;
+
+    assert(ctx);
+
+    keymap = test_compile_rules(ctx, "evdev", "pc105", "us,il,ru,de",
+                                ",,phonetic,neo",
+                                "grp:alt_shift_toggle,grp:menu_toggle");
+    assert(keymap);
+
+    assert(xkb_keymap_get_as_fd(keymap, 0, 0) < 0);
+    assert(xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_FORMAT_TEXT_V1, 0x100) < 0);
+
+#ifdef HAVE_MEMFD_CREATE
+    test_fd(ctx, keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    test_fd(ctx, keymap, XKB_KEYMAP_FORMAT_BINARY_V1);
+    test_compact_fd(keymap);
+#else
+    assert(xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_FORMAT_TEXT_V1, 0) < 0);
+#endif
+
+    xkb_keymap_unref(keymap);
+    xkb_context_unref(ctx);
+
+    return 0;
+}
@@ -31,6 +31,149 @@
 
 #include "test.h"
 
+/* Every key is found by its name, and aliases by theirs. */
+static void
+check_key_names(struct xkb_keymap *keymap)
+{
+    xkb_keycode_t min = xkb_keymap_min_keycode(keymap);
+    xkb_keycode_t max = xkb_keymap_max_keycode(keymap);
+
+    for (xkb_keycode_t kc = min; kc <= max; kc++) {
+        const char *name = xkb_keymap_key_get_name(keymap, kc);
+        if (name)
+            assert(xkb_keymap_key_by_name(keymap, name) == kc);
+    }
+
+    assert(xkb_keymap_key_by_name(keymap, "MENU") ==
+           xkb_keymap_key_by_name(keymap, "COMP"));
+    assert(xkb_keymap_key_by_name(keymap, "NOPE") == XKB_KEYCODE_INVALID);
+    assert(xkb_keymap_key_by_name(keymap, "") == XKB_KEYCODE_INVALID);
+}
+
+static bool
+same_fingerprint(struct xkb_keymap *a, struct xkb_keymap *b)
+{
+    uint8_t fingerprint_a[XKB_KEYMAP_FINGERPRINT_SIZE];
+    uint8_t fingerprint_b[XKB_KEYMAP_FINGERPRINT_SIZE];
+
+    xkb_keymap_get_fingerprint(a, fingerprint_a);
+    xkb_keymap_get_fingerprint(b, fingerprint_b);
+    return memcmp(fingerprint_a, fingerprint_b, sizeof(fingerprint_a)) == 0;
+}
+
+static void
+test_fingerprint(struct xkb_context *context)
+{
+    const char *keymap_str =
+        "xkb_keymap {\n"
+        "    xkb_keycodes { <A> = 38; <LCTL> = 37; indicator 1 = \"Caps Lock\"; };\n"
+        "    xkb_types { include \"basic\" };\n"
+        "    xkb_compat { include \"basic\" };\n"
+        "    xkb_symbols {\n"
+        "        key <A> { [ a, A ] };\n"
+        "        key <LCTL> { [ Control_L ], actions = [ SetMods(mods=Control) ] };\n"
+        "    };\n"
+        "};\n";
+    /* The same, written otherwise. */
+    const char *same_str =
+        "xkb_keymap \"same\" {\n"
+        "    xkb_keycodes \"other\" {\n"
+        "        <LCTL> = 37; <A> = 38;\n"
+        "        indicator 1 = \"Caps Lock\";\n"
+        "    };\n"
+        "    xkb_types { include \"basic\" };\n"
+        "    xkb_compat { include \"basic\" };\n"
+        "    xkb_symbols {\n"
+        "        key <LCTL> { symbols[1] = [ Control_L ],\n"
+        "                     actions[1] = [ SetMods(modifiers=Control) ] };\n"
+        "        key <A> { [ a, A ] };\n"
+        "    };\n"
+        "};\n";
+    /* A keysym, an action and an LED name differ. */
+    const char *other_strs[] = {
+        "xkb_keymap {\n"
+        "    xkb_keycodes { <A> = 38; <LCTL> = 37; indicator 1 = \"Caps Lock\"; };\n"
+        "    xkb_types { include \"basic\" };\n"
+        "    xkb_compat { include \"basic\" };\n"
+        "    xkb_symbols {\n"
+        "        key <A> { [ b, A ] };\n"
+        "        key <LCTL> { [ Control_L ], actions = [ SetMods(mods=Control) ] };\n"
+        "    };\n"
+        "};\n",
+        "xkb_keymap {\n"
+        "    xkb_keycodes { <A> = 38; <LCTL> = 37; indicator 1 = \"Caps Lock\"; };\n"
+        "    xkb_types { include \"basic\" };\n"
+        "    xkb_compat { include \"basic\" };\n"
+        "    xkb_symbols {\n"
+        "        key <A> { [ a, A ] };\n"
+        "        key <LCTL> { [ Control_L ], actions = [ LatchMods(mods=Control) ] };\n"
+        "    };\n"
+        "};\n",
+        "xkb_keymap {\n"
+        "    xkb_keycodes { <A> = 38; <LCTL> = 37; indicator 1 = \"Num Lock\"; };\n"
+        "    xkb_types { include \"basic\" };\n"
+        "    xkb_compat { include \"basic\" };\n"
+        "    xkb_symbols {\n"
+        "        key <A> { [ a, A ] };\n"
+        "        key <LCTL> { [ Control_L ], actions = [ SetMods(mods=Control) ] };\n"
+        "    };\n"
+        "};\n",
+    };
+    struct xkb_context *other_context;
+    struct xkb_keymap *keymap, *other;
+    char *text, *blob;
+    size_t size;
+    uint32_t ctrls;
+
+    keymap = test_compile_string(context, keymap_str);
+    assert(keymap);
+
+    other = test_compile_string(context, same_str);
+    assert(other);
+    assert(same_fingerprint(keymap, other));
+    xkb_keymap_unref(other);
+
+    /* Atoms differ between contexts, the fingerprint doesn't. */
+    other_context = test_get_context(0);
+    assert(other_context);
+    text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(text);
+    other = test_compile_string(other_context, text);
+    assert(other);
+    assert(same_fingerprint(keymap, other));
+    xkb_keymap_unref(other);
+    free(text);
+    xkb_context_unref(other_context);
+
+    for (size_t i = 0; i < ARRAY_SIZE(other_strs); i++) {
+        other = test_compile_string(context, other_strs[i]);
+        assert(other);
+        assert(!same_fingerprint(keymap, other));
+        xkb_keymap_unref(other);
+    }
+
+    /*
+     * So do the enabled controls, which only keymaps from the X server
+     * have. The binary format has them in its header, after the magic,
+     * the byte order, the version and the size.
+     */
+    blob = xkb_keymap_get_as_buffer(keymap, XKB_KEYMAP_FORMAT_BINARY_V1,
+                                    &size);
+    assert(blob && size > 24);
+    memcpy(&ctrls, blob + 20, sizeof(ctrls));
+    assert(ctrls == 0);
+    ctrls = 1;
+    memcpy(blob + 20, &ctrls, sizeof(ctrls));
+    other = xkb_keymap_new_from_buffer(context, blob, size,
+                                       XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+    assert(other);
+    assert(!same_fingerprint(keymap, other));
+    xkb_keymap_unref(other);
+    free(blob);
+
+    xkb_keymap_unref(keymap);
+}
+
 int
 main(void)
 {
@@ -43,6 +186,8 @@ main(void)
     xkb_mod_mask_t shift_mask;
     xkb_mod_mask_t lock_mask;
     xkb_mod_mask_t mod2_mask;
+    char *blob;
+    size_t blob_size;
 
     assert(context);
 
@@ -102,6 +247,21 @@ main(void)
     assert(mask_count == 1);
     assert(masks_out[0] == 0);
 
+    check_key_names(keymap);
+
+    /* Also when the keymap is loaded back, rather than compiled. */
+    blob = xkb_keymap_get_as_buffer(keymap, XKB_KEYMAP_FORMAT_BINARY_V1,
+                                    &blob_size);
+    assert(blob);
+    xkb_keymap_unref(keymap);
+    keymap = xkb_keymap_new_from_buffer(context, blob, blob_size,
+                                        XKB_KEYMAP_FORMAT_BINARY_V1, 0);
+    assert(keymap);
+    check_key_names(keymap);
+    free(blob);
     xkb_keymap_unref(keymap);
+
+    test_fingerprint(context);
+
     xkb_context_unref(context);
 }
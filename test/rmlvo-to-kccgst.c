@@ -27,8 +27,6 @@
 #include <getopt.h>
 
 #include "test.h"
-#include "xkbcomp/xkbcomp-priv.h"
-#include "xkbcomp/rules.h"
 
 int
 main(int argc, char *argv[])
@@ -86,9 +84,7 @@ main(int argc, char *argv[])
         return 1;
     }
 
-    xkb_context_sanitize_rule_names(ctx, &rmlvo);
-
-    if (!xkb_components_from_rules(ctx, &rmlvo, &kccgst))
+    if (!xkb_components_names_from_rules(ctx, &rmlvo, &kccgst))
         return 1;
 
     printf("keycodes: %s\n", kccgst.keycodes);
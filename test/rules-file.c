@@ -86,10 +86,44 @@ test_rules(struct xkb_context *ctx, struct test_data *data)
     return passed;
 }
 
+static void
+test_components_names_from_rules(struct xkb_context *ctx)
+{
+    const struct xkb_rule_names rmlvo = {
+        "simple", "my_model", "my_layout", "my_variant", "my_option",
+    };
+    const struct xkb_rule_names bad_rmlvo = { .rules = "does-not-exist" };
+    struct xkb_component_names kccgst;
+
+    /* With a caching flag, the second lookup is remembered. */
+    for (int i = 0; i < 2; i++) {
+        assert(xkb_components_names_from_rules(ctx, &rmlvo, &kccgst));
+        assert(streq(kccgst.keycodes, "my_keycodes"));
+        assert(streq(kccgst.types, "my_types"));
+        assert(streq(kccgst.compat, "my_compat|some:compat"));
+        assert(streq(kccgst.symbols, "my_symbols+extra_variant"));
+        free(kccgst.keycodes);
+        free(kccgst.types);
+        free(kccgst.compat);
+        free(kccgst.symbols);
+    }
+
+    /* Missing names get the defaults. */
+    assert(xkb_components_names_from_rules(ctx, NULL, &kccgst));
+    assert(streq(kccgst.keycodes, "evdev+aliases(qwerty)"));
+    assert(streq(kccgst.symbols, "pc+us+inet(evdev)"));
+    free(kccgst.keycodes);
+    free(kccgst.types);
+    free(kccgst.compat);
+    free(kccgst.symbols);
+
+    assert(!xkb_components_names_from_rules(ctx, &bad_rmlvo, &kccgst));
+}
+
 int
 main(int argc, char *argv[])
 {
-    struct xkb_context *ctx;
+    struct xkb_context *ctx, *ctx_cached;
 
     ctx = test_get_context(0);
     assert(ctx);
@@ -170,6 +204,13 @@ main(int argc, char *argv[])
     };
     assert(test_rules(ctx, &test7));
 
+    test_components_names_from_rules(ctx);
+
+    ctx_cached = test_get_context(CONTEXT_CACHE_INCLUDES);
+    assert(ctx_cached);
+    test_components_names_from_rules(ctx_cached);
+    xkb_context_unref(ctx_cached);
+
     xkb_context_unref(ctx);
     return 0;
 }
@@ -0,0 +1,175 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Share one keymap between many threads, each with its own state, then one
+ * context with a keymap cache, which the threads release concurrently.
+ * This is mostly useful when run under a thread sanitizer (meson configure
+ * -Db_sanitize=thread), or an address sanitizer for leaks.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+
+#include "evdev-scancodes.h"
+#include "test.h"
+
+#define NUM_THREADS 8
+#define NUM_ITERATIONS 200
+
+static void
+check_key(struct xkb_state *state, xkb_keycode_t kc,
+          xkb_keysym_t expected_sym, const char *expected_utf8)
+{
+    const xkb_keysym_t *syms;
+    char utf8[16];
+    int nsyms;
+
+    nsyms = xkb_state_key_get_syms(state, kc, &syms);
+    assert(nsyms == 1 && syms[0] == expected_sym);
+    assert(xkb_state_key_get_one_sym(state, kc) == expected_sym);
+    xkb_state_key_get_utf8(state, kc, utf8, sizeof(utf8));
+    assert(streq(utf8, expected_utf8));
+}
+
+static void *
+worker_run(void *data)
+{
+    struct xkb_keymap *keymap = data;
+    const xkb_keycode_t kc_a = KEY_A + EVDEV_OFFSET;
+    const xkb_keycode_t kc_shift = KEY_LEFTSHIFT + EVDEV_OFFSET;
+    const xkb_keycode_t kc_caps = KEY_CAPSLOCK + EVDEV_OFFSET;
+
+    for (int i = 0; i < NUM_ITERATIONS; i++) {
+        struct xkb_state *state = xkb_state_new(keymap);
+        char name[64];
+        xkb_mod_index_t shift;
+
+        assert(state);
+
+        /* Keymap queries. */
+        assert(xkb_keymap_key_by_name(keymap, "AC01") == kc_a);
+        assert(streq(xkb_keymap_key_get_name(keymap, kc_a), "AC01"));
+        assert(streq(xkb_keymap_layout_get_name(keymap, 0), "English (US)"));
+        shift = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_SHIFT);
+        assert(shift != XKB_MOD_INVALID);
+        assert(xkb_keymap_led_get_index(keymap, XKB_LED_NAME_CAPS) !=
+               XKB_LED_INVALID);
+        assert(xkb_keymap_key_repeats(keymap, kc_a));
+        xkb_keysym_get_name(XKB_KEY_a, name, sizeof(name));
+        assert(streq(name, "a"));
+
+        /* State updates and queries. */
+        check_key(state, kc_a, XKB_KEY_a, "a");
+
+        xkb_state_update_key(state, kc_shift, XKB_KEY_DOWN);
+        assert(xkb_state_mod_name_is_active(state, XKB_MOD_NAME_SHIFT,
+                                            XKB_STATE_MODS_EFFECTIVE) > 0);
+        assert(xkb_state_mod_index_is_consumed(state, kc_a, shift) > 0);
+        check_key(state, kc_a, XKB_KEY_A, "A");
+        xkb_state_update_key(state, kc_shift, XKB_KEY_UP);
+
+        xkb_state_update_key(state, kc_caps, XKB_KEY_DOWN);
+        xkb_state_update_key(state, kc_caps, XKB_KEY_UP);
+        assert(xkb_state_led_name_is_active(state, XKB_LED_NAME_CAPS) > 0);
+        check_key(state, kc_a, XKB_KEY_A, "A");
+
+        xkb_state_update_mask(state, 0, 0, 0, 0, 0, 1);
+        assert(xkb_state_serialize_layout(state,
+                                          XKB_STATE_LAYOUT_EFFECTIVE) == 1);
+        check_key(state, kc_a, XKB_KEY_a, "a");
+
+        xkb_state_unref(state);
+    }
+
+    /* Serializing uses the thread's scratch buffer. */
+    free(xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1));
+
+    xkb_keymap_unref(keymap);
+    return NULL;
+}
+
+static void *
+cache_worker_run(void *data)
+{
+    struct xkb_context *ctx = data;
+    struct xkb_rule_names names = { .layout = "us" };
+
+    for (int i = 0; i < NUM_ITERATIONS / 20; i++) {
+        struct xkb_keymap *keymap = xkb_keymap_new_from_names(ctx, &names, 0);
+        assert(keymap);
+        xkb_keymap_unref(keymap);
+    }
+
+    /* The cached keymap goes with the last reference on the context. */
+    xkb_context_unref(ctx);
+    return NULL;
+}
+
+int
+main(void)
+{
+    struct xkb_context *ctx;
+    struct xkb_keymap *keymap;
+    pthread_t threads[NUM_THREADS];
+    int ret;
+
+    ctx = test_get_context(0);
+    assert(ctx);
+
+    keymap = test_compile_rules(ctx, "evdev", "", "us,de", "", "");
+    assert(keymap);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        ret = pthread_create(&threads[i], NULL, worker_run,
+                             xkb_keymap_ref(keymap));
+        assert(ret == 0);
+    }
+
+    /* The threads hold their own references. */
+    xkb_keymap_unref(keymap);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    xkb_context_unref(ctx);
+
+    ctx = test_get_context(CONTEXT_CACHE_KEYMAPS);
+    assert(ctx);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        ret = pthread_create(&threads[i], NULL, cache_worker_run,
+                             xkb_context_ref(ctx));
+        assert(ret == 0);
+    }
+
+    xkb_context_unref(ctx);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    return 0;
+}
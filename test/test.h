@@ -62,6 +62,9 @@ test_read_file(const char *path_rel);
 enum test_context_flags {
     CONTEXT_NO_FLAG = 0,
     CONTEXT_ALLOW_ENVIRONMENT_NAMES = (1 << 0),
+    CONTEXT_CACHE_INCLUDES = (1 << 1),
+    CONTEXT_CACHE_KEYMAPS = (1 << 2),
+    CONTEXT_PARALLEL_INCLUDES = (1 << 3),
 };
 
 struct xkb_context *
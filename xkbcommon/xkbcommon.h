@@ -107,6 +107,17 @@ extern "C" {
  * Objects are created in a specific context, and multiple contexts may
  * coexist simultaneously.  Objects from different contexts are completely
  * separated and do not share any memory or state.
+ *
+ * A context may be used by several threads at once, e.g. to compile
+ * keymaps concurrently, as long as it is not modified at the same time:
+ * the include paths, log function, log level and verbosity and user data
+ * should be set up before the context is shared.  The log function may be
+ * called from any thread which uses the context.  Taking and dropping
+ * references is always thread-safe.
+ *
+ * All of the above requires the library to be built with threads support
+ * (POSIX threads or Windows).  Otherwise the internal locks do nothing, and
+ * a context, together with its keymaps, must only be used from one thread.
  */
 struct xkb_context;
 
@@ -119,6 +130,11 @@ struct xkb_context;
  *
  * A keymap is immutable after it is created (besides reference counts, etc.);
  * if you need to change it, you must create a new one.
+ *
+ * Since it is immutable, a keymap may be shared between threads: all of
+ * the functions which take a keymap, and creating and using states for
+ * it, may be called concurrently.  As for the context, this requires the
+ * library to be built with threads support.
  */
 struct xkb_keymap;
 
@@ -130,6 +146,9 @@ struct xkb_keymap;
  * as the currently effective layout and the active modifiers.  It acts as a
  * simple state machine, wherein key presses and releases are the input, and
  * key symbols (keysyms) are the output.
+ *
+ * A state object must not be used by several threads at once; give each
+ * thread its own state instead, possibly for the same keymap.
  */
 struct xkb_state;
 
@@ -366,6 +385,26 @@ struct xkb_rule_names {
     const char *options;
 };
 
+/**
+ * Names of the keymap components (KcCGST) which RMLVO names resolve to.
+ *
+ * Each field is a string which can be used in an include statement of the
+ * respective section of a keymap file, e.g. "pc+us+inet(evdev)" for the
+ * symbols.  See xkb_components_names_from_rules().
+ *
+ * @since 0.11.0
+ */
+struct xkb_component_names {
+    /** The keycodes component. */
+    char *keycodes;
+    /** The types component. */
+    char *types;
+    /** The compat component. */
+    char *compat;
+    /** The symbols component. */
+    char *symbols;
+};
+
 /**
  * @defgroup keysyms Keysyms
  * Utility functions related to keysyms.
@@ -570,7 +609,60 @@ enum xkb_context_flags {
      * Don't take RMLVO names from the environment.
      * @since 0.3.0
      */
-    XKB_CONTEXT_NO_ENVIRONMENT_NAMES = (1 << 1)
+    XKB_CONTEXT_NO_ENVIRONMENT_NAMES = (1 << 1),
+    /**
+     * Keep the parsed form of the files included while compiling keymaps,
+     * and reuse it for later keymaps compiled from this context.
+     *
+     * This speeds up compiling many keymaps which share files, at the cost
+     * of keeping the parsed files in memory until the context is freed or
+     * xkb_context_clear_cache() is called.  A file which changed on disk
+     * (judging by its modification time and size) is parsed again.
+     *
+     * The rules files, and the components most recently resolved from
+     * them, are kept likewise; this costs a stat() of each rules file
+     * every time RMLVO names are resolved.  This flag, and the other
+     * caching flags below, enable it.
+     *
+     * @since 0.11.0
+     */
+    XKB_CONTEXT_CACHE_INCLUDES = (1 << 2),
+    /**
+     * Keep the keymaps compiled with xkb_keymap_new_from_names(), and
+     * return a new reference to the same keymap when it is asked again
+     * for the same names and include path.
+     *
+     * Likewise for xkb_keymap_new_from_string() and
+     * xkb_keymap_new_from_buffer(), when asked again for the same buffer,
+     * byte for byte, in the same format and with the same include path.
+     * This helps clients which get the same keymap over and over, e.g.
+     * for every new seat.
+     *
+     * Keymaps are immutable, so sharing them is safe.  Only a few of the
+     * most recently used keymaps are kept, along with a copy of the
+     * buffers they came from.  Changes to the files on disk are not
+     * detected; use xkb_context_clear_cache() to pick them up.  Keymaps
+     * whose compilation logged warnings or errors are not kept, so that
+     * these are logged every time.
+     *
+     * @since 0.11.0
+     */
+    XKB_CONTEXT_CACHE_KEYMAPS = (1 << 3),
+    /**
+     * When compiling a keymap, first read and parse the files it includes,
+     * and the files these include in turn, with a few worker threads.  The
+     * keymap is then compiled from the parsed files as usual.
+     *
+     * This helps when reading the files is slow, e.g. on a cold start from
+     * slow storage.  It implies XKB_CONTEXT_CACHE_INCLUDES, which keeps
+     * the parsed files.  The messages logged while parsing are still
+     * passed to the log function from the thread compiling the keymap.
+     * Without threads support in the library, this only has the effect of
+     * XKB_CONTEXT_CACHE_INCLUDES.
+     *
+     * @since 0.11.0
+     */
+    XKB_CONTEXT_PARALLEL_INCLUDES = (1 << 4)
 };
 
 /**
@@ -605,6 +697,21 @@ xkb_context_ref(struct xkb_context *context);
 void
 xkb_context_unref(struct xkb_context *context);
 
+/**
+ * Drop everything the context has cached.
+ *
+ * This releases the keymaps kept with XKB_CONTEXT_CACHE_KEYMAPS, and the
+ * files and rules files kept with XKB_CONTEXT_CACHE_INCLUDES; keymaps
+ * still referenced elsewhere are not affected.
+ * Call this when the files on the include path changed.
+ *
+ * @since 0.11.0
+ *
+ * @memberof xkb_context
+ */
+void
+xkb_context_clear_cache(struct xkb_context *context);
+
 /**
  * Store custom user data in the context.
  *
@@ -825,6 +932,40 @@ enum xkb_keymap_compile_flags {
     XKB_KEYMAP_COMPILE_NO_FLAGS = 0
 };
 
+/**
+ * Resolve RMLVO names to the keymap components they stand for.
+ *
+ * This is the first step of xkb_keymap_new_from_names(): the rules file
+ * is matched against the model, layouts, variants and options, without
+ * compiling a keymap.  The result identifies the keymap, so it can be used
+ * e.g. as a cache key, or to tell whether two sets of names give the same
+ * keymap.
+ *
+ * With XKB_CONTEXT_CACHE_INCLUDES, or another of the caching context
+ * flags, the context keeps the rules files and remembers the most
+ * recently resolved names, so resolving them again is cheap; a rules file
+ * which changed on disk (judging by its modification time and size) is
+ * read again.  Otherwise, the rules file is read every time.
+ *
+ * @param context    The context in which to resolve the names.
+ * @param names      The RMLVO names to use.  Empty or NULL fields, or a
+ * NULL struct, get the same defaults as with xkb_keymap_new_from_names().
+ * @param components The resolved components.  On success, each field is
+ * set to a newly allocated string, which the caller must free with free().
+ * On failure, it is left untouched.
+ *
+ * @returns 1 on success, or 0 if the names could not be resolved.
+ *
+ * @sa xkb_rule_names
+ * @sa xkb_component_names
+ * @since 0.11.0
+ * @memberof xkb_context
+ */
+int
+xkb_components_names_from_rules(struct xkb_context *context,
+                                const struct xkb_rule_names *names,
+                                struct xkb_component_names *components);
+
 /**
  * Create a keymap from RMLVO names.
  *
@@ -849,7 +990,22 @@ xkb_keymap_new_from_names(struct xkb_context *context,
 /** The possible keymap formats. */
 enum xkb_keymap_format {
     /** The current/classic XKB text format, as generated by xkbcomp -xkb. */
-    XKB_KEYMAP_FORMAT_TEXT_V1 = 1
+    XKB_KEYMAP_FORMAT_TEXT_V1 = 1,
+    /**
+     * A compiled keymap in binary form, as returned by
+     * xkb_keymap_get_as_buffer().
+     *
+     * Loading it is much faster than compiling a text keymap, so it is
+     * suited to keymaps compiled ahead of time.  It is meant for caching
+     * keymaps locally, not for exchanging them: it is only loaded on the
+     * same kind of machine it was produced on, and by versions of
+     * xkbcommon which support the same revision of the format.
+     * Use xkb_keymap_new_from_buffer() or xkb_keymap_new_from_file() to
+     * load it.
+     *
+     * @since 0.11.0
+     */
+    XKB_KEYMAP_FORMAT_BINARY_V1 = 2
 };
 
 /**
@@ -936,7 +1092,8 @@ xkb_keymap_unref(struct xkb_keymap *keymap);
  * @param keymap The keymap to get as a string.
  * @param format The keymap format to use for the string.  You can pass
  * in the special value XKB_KEYMAP_USE_ORIGINAL_FORMAT to use the format
- * from which the keymap was originally created.
+ * from which the keymap was originally created; for a keymap created from
+ * the binary format, this is XKB_KEYMAP_FORMAT_TEXT_V1.
  *
  * @returns The keymap as a NUL-terminated string, or NULL if unsuccessful.
  *
@@ -952,6 +1109,130 @@ char *
 xkb_keymap_get_as_string(struct xkb_keymap *keymap,
                          enum xkb_keymap_format format);
 
+/**
+ * Get the compiled keymap as a buffer.
+ *
+ * This is like xkb_keymap_get_as_string(), but also works for formats
+ * which are not text, such as XKB_KEYMAP_FORMAT_BINARY_V1.
+ *
+ * @param keymap The keymap to get as a buffer.
+ * @param format The keymap format to use for the buffer, or
+ * XKB_KEYMAP_USE_ORIGINAL_FORMAT.
+ * @param[out] length The length of the returned buffer.
+ *
+ * @returns The keymap in the given format, or NULL if unsuccessful.  The
+ * buffer may be fed back into xkb_keymap_new_from_buffer().  It is
+ * dynamically allocated and should be freed by the caller.
+ *
+ * @memberof xkb_keymap
+ * @since 0.11.0
+ */
+char *
+xkb_keymap_get_as_buffer(struct xkb_keymap *keymap,
+                         enum xkb_keymap_format format,
+                         size_t *length);
+
+/**
+ * Flags for xkb_keymap_get_as_string2() and xkb_keymap_get_as_fd().
+ *
+ * @since 0.11.0
+ */
+enum xkb_keymap_serialize_flags {
+    /** Do not apply any flags. */
+    XKB_KEYMAP_SERIALIZE_NO_FLAGS = 0,
+    /**
+     * Write a text keymap in a compact form, meant to be read by programs
+     * rather than by people: without indentation or alignment, and
+     * without the values which the compiler would infer by itself.  The
+     * result compiles to the same keymap.  Formats which are not text
+     * ignore this flag.
+     */
+    XKB_KEYMAP_SERIALIZE_COMPACT = (1 << 0)
+};
+
+/**
+ * Get the compiled keymap as a string, with serialization flags.
+ *
+ * This is like xkb_keymap_get_as_string(), with flags.
+ *
+ * @param keymap The keymap to get as a string.
+ * @param format The keymap format to use for the string, or
+ * XKB_KEYMAP_USE_ORIGINAL_FORMAT.
+ * @param flags Optional flags for the serialization, or 0.
+ *
+ * @returns The keymap as a NUL-terminated string, or NULL if unsuccessful.
+ * The string is dynamically allocated and should be freed by the caller.
+ *
+ * @memberof xkb_keymap
+ * @since 0.11.0
+ */
+char *
+xkb_keymap_get_as_string2(struct xkb_keymap *keymap,
+                          enum xkb_keymap_format format,
+                          enum xkb_keymap_serialize_flags flags);
+
+/**
+ * Get the compiled keymap in a sealed, read-only memory file.
+ *
+ * This is the form in which the Wayland wl_keyboard.keymap event sends
+ * keymaps to clients.  The keymap is serialized the first time the
+ * function is called for a format and flags; later calls return a new
+ * file descriptor to the same file, for as long as the keymap lives.  The file
+ * is sealed, so that clients cannot change it for each other.
+ *
+ * @param keymap The keymap.
+ * @param format The keymap format to use, or XKB_KEYMAP_USE_ORIGINAL_FORMAT.
+ * @param flags Optional flags for the serialization, or 0.
+ *
+ * @returns A file descriptor, or -1 if unsuccessful or if sealed memory
+ * files are not supported on this system.  The size of the keymap is the
+ * size of the file; a text keymap includes the terminating NUL byte.  The
+ * file descriptor has FD_CLOEXEC set, and should be closed by the caller.
+ *
+ * @memberof xkb_keymap
+ * @since 0.11.0
+ */
+int
+xkb_keymap_get_as_fd(struct xkb_keymap *keymap,
+                     enum xkb_keymap_format format,
+                     enum xkb_keymap_serialize_flags flags);
+
+/**
+ * The size of a keymap fingerprint, in bytes.
+ *
+ * @sa xkb_keymap_get_fingerprint()
+ * @since 0.11.0
+ */
+#define XKB_KEYMAP_FINGERPRINT_SIZE 16
+
+/**
+ * Get the fingerprint of a keymap: a 128-bit hash of what the keymap
+ * contains once compiled.
+ *
+ * The fingerprint covers the keys with their names, groups, levels,
+ * keysyms and actions, the key aliases, the key types, the modifiers,
+ * the layout names, the LEDs, the enabled controls of keymaps from the X
+ * server and the interpretations of the compatibility section.  It
+ * doesn't depend on how the keymap was written, e.g. with includes, in
+ * the compact form or in another format, nor on the names of its
+ * sections.  So keymaps with the same fingerprint behave the same, and a
+ * compositor may use it to find out that a new keymap is the same as the
+ * one it already sent, or as a key for caches.
+ *
+ * The fingerprint is only meant to be compared with others from the same
+ * version of the library.  It is computed when the keymap is compiled,
+ * so getting it is cheap.
+ *
+ * @param keymap The keymap.
+ * @param fingerprint The buffer to write the fingerprint to.
+ *
+ * @memberof xkb_keymap
+ * @since 0.11.0
+ */
+void
+xkb_keymap_get_fingerprint(struct xkb_keymap *keymap,
+                           uint8_t fingerprint[XKB_KEYMAP_FINGERPRINT_SIZE]);
+
 /** @} */
 
 /**